@@ -7,10 +7,20 @@
 #include "LogSessionData.hpp"
 #include "pal/PAL.hpp"
 #include "utils/StringUtils.hpp"
+#include "bond/All.hpp"
+#include "bond/generated/CsProtocol_writers.hpp"
 
 namespace MAT_NS_BEGIN
 {
 
+    void ContextFieldsSnapshot::WriteExtensions(::CsProtocol::Record& other) const
+    {
+        other.extApp = record.extApp;
+        other.extDevice = record.extDevice;
+        other.extOs = record.extOs;
+        other.extUser = record.extUser;
+    }
+
     ContextFieldsProvider::ContextFieldsProvider()
         : ContextFieldsProvider(nullptr)
     {
@@ -41,10 +51,76 @@ namespace MAT_NS_BEGIN
         m_customContextFields = copy.m_customContextFields;
         m_commonContextEventToConfigIds = copy.m_commonContextEventToConfigIds;
         m_ticketsMap = copy.m_ticketsMap;
+        m_version++;
+        m_snapshot.reset();
+        m_snapshotParent.reset();
         return *this;
     }
 
-    void ContextFieldsProvider::writeToRecord(::CsProtocol::Record& record, bool commonOnly)
+    std::shared_ptr<const ContextFieldsSnapshot> ContextFieldsProvider::writeToRecord(::CsProtocol::Record& record, bool commonOnly, bool deferExtensions)
+    {
+        if (!record.extApp.empty() || !record.extDevice.empty() || !record.extOs.empty() || !record.extUser.empty() ||
+            !record.extLoc.empty() || !record.extNet.empty() || !record.extM365a.empty())
+        {
+            // The record already carries Part A extensions: merge fields one by one
+            writeFieldsToRecord(record, commonOnly);
+            return nullptr;
+        }
+
+        auto snapshot = GetSnapshot();
+        auto const& source = snapshot->record;
+
+        bool ownExperimentIds = !record.name.empty() && (snapshot->eventsWithExperimentIds.count(record.name) != 0);
+        if (!deferExtensions || ownExperimentIds)
+        {
+            snapshot->WriteExtensions(record);
+        }
+        record.extLoc = source.extLoc;
+        record.extNet = source.extNet;
+        record.extM365a = source.extM365a;
+
+        if (record.extProtocol.empty())
+        {
+            record.extProtocol = source.extProtocol;
+        }
+        else
+        {
+            if (snapshot->hasDeviceMake)
+            {
+                record.extProtocol[0].devMake = source.extProtocol[0].devMake;
+            }
+            if (snapshot->hasDeviceModel)
+            {
+                record.extProtocol[0].devModel = source.extProtocol[0].devModel;
+            }
+            // Ticket keys of each context level follow the first element
+            record.extProtocol.insert(record.extProtocol.end(), source.extProtocol.begin() + 1, source.extProtocol.end());
+        }
+
+        auto const& properties = commonOnly ? snapshot->commonProperties : source.data[0].properties;
+        if (record.data.empty())
+        {
+            record.data.emplace_back();
+            record.data[0].properties = properties;
+        }
+        else
+        {
+            for (auto const& field : properties)
+            {
+                record.data[0].properties[field.first] = field.second;
+            }
+        }
+
+        LOG_TRACE("Record=%p decorated with SemanticContext=%p", &record, this);
+        if (ownExperimentIds)
+        {
+            applyEventExperimentIds(record);
+            return nullptr;
+        }
+        return snapshot;
+    }
+
+    void ContextFieldsProvider::writeFieldsToRecord(::CsProtocol::Record& record, bool commonOnly)
     {
         // Append parent scope context variables if not detached from parent
         if (m_parent)
@@ -52,6 +128,65 @@ namespace MAT_NS_BEGIN
             m_parent->writeToRecord(record);
         }
 
+        addExtensions(record);
+        {
+            LOCKGUARD(m_lock);
+            applyCommonFields(record);
+            if (!commonOnly)
+            {
+                applyCustomFields(record);
+            }
+            LOG_TRACE("Record=%p decorated with SemanticContext=%p", &record, this);
+        }
+    }
+
+    std::shared_ptr<const ContextFieldsSnapshot> ContextFieldsProvider::GetSnapshot()
+    {
+        std::shared_ptr<const ContextFieldsSnapshot> parentSnapshot;
+        if (m_parent)
+        {
+            parentSnapshot = m_parent->GetSnapshot();
+        }
+
+        LOCKGUARD(m_lock);
+        if (m_snapshot && m_snapshotVersion == m_version && m_snapshotParent == parentSnapshot)
+        {
+            return m_snapshot;
+        }
+
+        auto snapshot = std::make_shared<ContextFieldsSnapshot>();
+        if (parentSnapshot)
+        {
+            snapshot->record = parentSnapshot->record;
+            snapshot->hasDeviceMake = parentSnapshot->hasDeviceMake;
+            snapshot->hasDeviceModel = parentSnapshot->hasDeviceModel;
+            snapshot->eventsWithExperimentIds = parentSnapshot->eventsWithExperimentIds;
+        }
+        addExtensions(snapshot->record);
+        applyCommonFields(snapshot->record);
+        snapshot->commonProperties = snapshot->record.data[0].properties;
+        applyCustomFields(snapshot->record);
+
+        snapshot->hasDeviceMake |= (m_commonContextFields.find(COMMONFIELDS_DEVICE_MAKE) != m_commonContextFields.end());
+        snapshot->hasDeviceModel |= (m_commonContextFields.find(COMMONFIELDS_DEVICE_MODEL) != m_commonContextFields.end());
+        for (auto const& kv : m_commonContextEventToConfigIds)
+        {
+            snapshot->eventsWithExperimentIds.insert(kv.first);
+        }
+
+        {
+            bond_lite::CompactBinaryProtocolWriter writer(snapshot->encodedExtensions);
+            bond_lite::SerializeRecordContextExtensions(writer, snapshot->record);
+        }
+
+        m_snapshot = snapshot;
+        m_snapshotVersion = m_version;
+        m_snapshotParent = parentSnapshot;
+        return m_snapshot;
+    }
+
+    void ContextFieldsProvider::addExtensions(::CsProtocol::Record& record)
+    {
         if (record.data.size() == 0)
         {
             ::CsProtocol::Data data;
@@ -104,303 +239,321 @@ namespace MAT_NS_BEGIN
             ::CsProtocol::M365a m365a;
             record.extM365a.push_back(m365a);
         }
+    }
 
+    void ContextFieldsProvider::applyCommonFields(::CsProtocol::Record& record)
+    {
         std::map<std::string, ::CsProtocol::Value>& ext = record.data[0].properties;
-        {
-            LOCKGUARD(m_lock);
 
-            std::string value = m_commonContextFields[COMMONFIELDS_APP_EXPERIMENTIDS].as_string;
-            if (!value.empty())
-            {// for ECS set event specific config ids
-                std::string eventName = record.name;
-                if (!eventName.empty())
+        std::string value = m_commonContextFields[COMMONFIELDS_APP_EXPERIMENTIDS].as_string;
+        if (!value.empty())
+        {// for ECS set event specific config ids
+            std::string eventName = record.name;
+            if (!eventName.empty())
+            {
+                const auto& iter = m_commonContextEventToConfigIds.find(eventName);
+                if (iter != m_commonContextEventToConfigIds.end())
                 {
-                    const auto& iter = m_commonContextEventToConfigIds.find(eventName);
-                    if (iter != m_commonContextEventToConfigIds.end())
-                    {
-                        value = iter->second;
-                    }
+                    value = iter->second;
                 }
-
-                record.extApp[0].expId = value;
             }
 
-            if (!m_commonContextFields.empty())
+            record.extApp[0].expId = value;
+        }
+
+        if (!m_commonContextFields.empty())
+        {
+            if (m_commonContextFields.find(SESSION_IMPRESSION_ID) != m_commonContextFields.end())
             {
-                if (m_commonContextFields.find(SESSION_IMPRESSION_ID) != m_commonContextFields.end())
-                {
-                    CsProtocol::Value temp;
-                    EventProperty prop = m_commonContextFields[SESSION_IMPRESSION_ID];
-                    temp.stringValue = prop.as_string;
+                CsProtocol::Value temp;
+                EventProperty prop = m_commonContextFields[SESSION_IMPRESSION_ID];
+                temp.stringValue = prop.as_string;
 
-                    ext[SESSION_IMPRESSION_ID] = temp;
-                }
+                ext[SESSION_IMPRESSION_ID] = temp;
+            }
 
-                if (m_commonContextFields.find(COMMONFIELDS_APP_EXPERIMENTETAG) != m_commonContextFields.end())
-                {
-                    CsProtocol::Value temp;
-                    EventProperty prop = m_commonContextFields[COMMONFIELDS_APP_EXPERIMENTETAG];
-                    temp.stringValue = prop.as_string;
+            if (m_commonContextFields.find(COMMONFIELDS_APP_EXPERIMENTETAG) != m_commonContextFields.end())
+            {
+                CsProtocol::Value temp;
+                EventProperty prop = m_commonContextFields[COMMONFIELDS_APP_EXPERIMENTETAG];
+                temp.stringValue = prop.as_string;
 
-                    ext[COMMONFIELDS_APP_EXPERIMENTETAG] = temp;
-                }
+                ext[COMMONFIELDS_APP_EXPERIMENTETAG] = temp;
+            }
 
-                auto iter = m_commonContextFields.find(COMMONFIELDS_APP_ID);
-                bool hasAppId = (iter != m_commonContextFields.end());
-                if (hasAppId)
-                {
-                    record.extApp[0].id = iter->second.as_string;
-                }
+            auto iter = m_commonContextFields.find(COMMONFIELDS_APP_ID);
+            bool hasAppId = (iter != m_commonContextFields.end());
+            if (hasAppId)
+            {
+                record.extApp[0].id = iter->second.as_string;
+            }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_APP_ENV);
-                bool hasAppEnv = (iter != m_commonContextFields.end());
-                if (hasAppEnv)
-                {
-                    record.extApp[0].env = iter->second.as_string;
-                }
+            iter = m_commonContextFields.find(COMMONFIELDS_APP_ENV);
+            bool hasAppEnv = (iter != m_commonContextFields.end());
+            if (hasAppEnv)
+            {
+                record.extApp[0].env = iter->second.as_string;
+            }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_APP_NAME);
-                if (iter != m_commonContextFields.end())
-                {
-                    record.extApp[0].name = iter->second.as_string;
-                }
-                else if (hasAppId)
-                {
-                    // Backwards-compat: legacy Aria exporter maps CS3.0 ext.app.name to AppInfo.Id
-                    // TODO:
-                    // - consider resolving that protocol "wrinkle" backend-side
-                    // - consider parsing ext.app.id if it contains app hash!name:ver information
-                    record.extApp[0].name = record.extApp[0].id;
-                }
+            iter = m_commonContextFields.find(COMMONFIELDS_APP_NAME);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extApp[0].name = iter->second.as_string;
+            }
+            else if (hasAppId)
+            {
+                // Backwards-compat: legacy Aria exporter maps CS3.0 ext.app.name to AppInfo.Id
+                // TODO:
+                // - consider resolving that protocol "wrinkle" backend-side
+                // - consider parsing ext.app.id if it contains app hash!name:ver information
+                record.extApp[0].name = record.extApp[0].id;
+            }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_APP_VERSION);
-                if (iter != m_commonContextFields.end())
-                {
-                    record.extApp[0].ver = iter->second.as_string;
-                }
+            iter = m_commonContextFields.find(COMMONFIELDS_APP_VERSION);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extApp[0].ver = iter->second.as_string;
+            }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_APP_LANGUAGE);
-                if (iter != m_commonContextFields.end())
-                {
-                    record.extApp[0].locale = iter->second.as_string;
-                }
+            iter = m_commonContextFields.find(COMMONFIELDS_APP_LANGUAGE);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extApp[0].locale = iter->second.as_string;
+            }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_ID);
-                if (iter != m_commonContextFields.end())
+            iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_ID);
+            if (iter != m_commonContextFields.end())
+            {
+                // Use "c:" prefix
+                std::string temp("c:");
+                const char *deviceId = iter->second.as_string;
+                if (deviceId != nullptr)
                 {
-                    // Use "c:" prefix
-                    std::string temp("c:");
-                    const char *deviceId = iter->second.as_string;
-                    if (deviceId != nullptr)
+                    size_t len = strlen(deviceId);
+                    if (len >= 2 && deviceId[1] == ':' && (
+                        deviceId[0] == 'c' || // c: Custom identifier
+                        deviceId[0] == 'r' || // r: Randomized identifier
+                        deviceId[0] == 'u' || // u: Mac OS X UUID
+                        deviceId[0] == 'a' || // a: Android ID
+                        deviceId[0] == 's' || // s: SQM ID
+                        deviceId[0] == 'x' || // x: XBox One hardware ID
+                        deviceId[0] == 'i'))  // i: iOS ID
                     {
-                        size_t len = strlen(deviceId);
-                        if (len >= 2 && deviceId[1] == ':' && (
-                            deviceId[0] == 'c' || // c: Custom identifier
-                            deviceId[0] == 'r' || // r: Randomized identifier
-                            deviceId[0] == 'u' || // u: Mac OS X UUID
-                            deviceId[0] == 'a' || // a: Android ID
-                            deviceId[0] == 's' || // s: SQM ID
-                            deviceId[0] == 'x' || // x: XBox One hardware ID
-                            deviceId[0] == 'i'))  // i: iOS ID
-                        {
-                            // Remove "c:" prefix
-                            temp = "";
-                        }
-                        // Strip curly braces from GUID while populating localId.
-                        // Otherwise 1DS collector would not strip the prefix.
-                        if ((deviceId[0] == '{') && (deviceId[len - 1] == '}'))
-                        {
-                            temp.append(deviceId + 1, len - 2);
-                        }
-                        else
-                        {
-                            temp.append(deviceId);
-                        }
+                        // Remove "c:" prefix
+                        temp = "";
+                    }
+                    // Strip curly braces from GUID while populating localId.
+                    // Otherwise 1DS collector would not strip the prefix.
+                    if ((deviceId[0] == '{') && (deviceId[len - 1] == '}'))
+                    {
+                        temp.append(deviceId + 1, len - 2);
+                    }
+                    else
+                    {
+                        temp.append(deviceId);
                     }
-                    record.extDevice[0].localId = temp;
                 }
+                record.extDevice[0].localId = temp;
+            }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_ORGID);
-                if (iter != m_commonContextFields.end())
-                {
-                    record.extDevice[0].orgId = iter->second.as_string;
-                }
+            iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_ORGID);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extDevice[0].orgId = iter->second.as_string;
+            }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_MAKE);
-                if (iter != m_commonContextFields.end())
-                {
-                    record.extProtocol[0].devMake = iter->second.as_string;
-                }
+            iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_MAKE);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extProtocol[0].devMake = iter->second.as_string;
+            }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_MODEL);
-                if (iter != m_commonContextFields.end())
-                {
-                    record.extProtocol[0].devModel = iter->second.as_string;
-                }
+            iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_MODEL);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extProtocol[0].devModel = iter->second.as_string;
+            }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_CLASS);
-                if (iter != m_commonContextFields.end())
-                {
-                    record.extDevice[0].deviceClass = iter->second.as_string;
-                }
+            iter = m_commonContextFields.find(COMMONFIELDS_DEVICE_CLASS);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extDevice[0].deviceClass = iter->second.as_string;
+            }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_COMMERCIAL_ID);
-                if (iter != m_commonContextFields.end())
-                {
-                    record.extM365a[0].enrolledTenantId = iter->second.as_string;
-                }
+            iter = m_commonContextFields.find(COMMONFIELDS_COMMERCIAL_ID);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extM365a[0].enrolledTenantId = iter->second.as_string;
+            }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_OS_NAME);
-                if (iter != m_commonContextFields.end())
-                {
-                    record.extOs[0].name = iter->second.as_string;
-                }
+            iter = m_commonContextFields.find(COMMONFIELDS_OS_NAME);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extOs[0].name = iter->second.as_string;
+            }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_OS_BUILD);
-                if (iter != m_commonContextFields.end())
-                {
-                    //EventProperty prop = (*m_commonContextFieldsP)[COMMONFIELDS_OS_VERSION];
-                    record.extOs[0].ver = iter->second.as_string;
-                }
+            iter = m_commonContextFields.find(COMMONFIELDS_OS_BUILD);
+            if (iter != m_commonContextFields.end())
+            {
+                //EventProperty prop = (*m_commonContextFieldsP)[COMMONFIELDS_OS_VERSION];
+                record.extOs[0].ver = iter->second.as_string;
+            }
+
+            iter = m_commonContextFields.find(COMMONFIELDS_USER_ID);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extUser[0].localId = iter->second.as_string;
+            }
+
+            iter = m_commonContextFields.find(COMMONFIELDS_USER_LANGUAGE);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extUser[0].locale = iter->second.as_string;
+            }
 
-                iter = m_commonContextFields.find(COMMONFIELDS_USER_ID);
-                if (iter != m_commonContextFields.end())
+            iter = m_commonContextFields.find(COMMONFIELDS_USER_TIMEZONE);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extLoc[0].timezone = iter->second.as_string;
+            }
+
+            iter = m_commonContextFields.find(COMMONFIELDS_NETWORK_COST);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extNet[0].cost = iter->second.as_string;
+            }
+
+            iter = m_commonContextFields.find(COMMONFIELDS_NETWORK_PROVIDER);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extNet[0].provider = iter->second.as_string;
+            }
+
+            iter = m_commonContextFields.find(COMMONFIELDS_NETWORK_TYPE);
+            if (iter != m_commonContextFields.end())
+            {
+                record.extNet[0].type = iter->second.as_string;
+            }
+        }
+
+        if (m_ticketsMap.size() > 0)
+        {
+            std::vector<std::string> tickets;
+            for (auto const& field : m_ticketsMap)
+            {
+                tickets.push_back(field.second);
+            }
+            CsProtocol::Protocol temp;
+            temp.ticketKeys.push_back(tickets);
+            record.extProtocol.push_back(temp);
+        }
+    }
+
+    void ContextFieldsProvider::applyCustomFields(::CsProtocol::Record& record)
+    {
+        for (auto const& field : m_customContextFields)
+        {
+            if (field.second.piiKind != PiiKind_None)
+            {
+                CsProtocol::PII pii;
+                pii.Kind = static_cast<CsProtocol::PIIKind>(field.second.piiKind);
+                CsProtocol::Value temp;
+                CsProtocol::Attributes attrib;
+                attrib.pii.push_back(pii);
+
+
+                temp.attributes.push_back(attrib);
+
+                temp.stringValue = field.second.to_string();
+                record.data[0].properties[field.first] = temp;
+            }
+            else
+            {
+                std::vector<uint8_t> guid;
+                uint8_t guid_bytes[16] = { 0 };
+
+                switch (field.second.type)
+                {
+                case EventProperty::TYPE_STRING:
                 {
-                    record.extUser[0].localId = iter->second.as_string;
+                    CsProtocol::Value temp;
+                    temp.stringValue = field.second.to_string();
+                    record.data[0].properties[field.first] = temp;
+                    break;
                 }
-
-                iter = m_commonContextFields.find(COMMONFIELDS_USER_LANGUAGE);
-                if (iter != m_commonContextFields.end())
+                case EventProperty::TYPE_INT64:
                 {
-                    record.extUser[0].locale = iter->second.as_string;
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueInt64;
+                    temp.longValue = field.second.as_int64;
+                    record.data[0].properties[field.first] = temp;
+                    break;
                 }
-
-                iter = m_commonContextFields.find(COMMONFIELDS_USER_TIMEZONE);
-                if (iter != m_commonContextFields.end())
+                case EventProperty::TYPE_DOUBLE:
                 {
-                    record.extLoc[0].timezone = iter->second.as_string;
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueDouble;
+                    temp.doubleValue = field.second.as_double;
+                    record.data[0].properties[field.first] = temp;
+                    break;
                 }
-
-                iter = m_commonContextFields.find(COMMONFIELDS_NETWORK_COST);
-                if (iter != m_commonContextFields.end())
+                case EventProperty::TYPE_TIME:
                 {
-                    record.extNet[0].cost = iter->second.as_string;
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueDateTime;
+                    temp.longValue = field.second.as_time_ticks.ticks;
+                    record.data[0].properties[field.first] = temp;
+                    break;
                 }
-
-                iter = m_commonContextFields.find(COMMONFIELDS_NETWORK_PROVIDER);
-                if (iter != m_commonContextFields.end())
+                case EventProperty::TYPE_BOOLEAN:
                 {
-                    record.extNet[0].provider = iter->second.as_string;
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueBool;
+                    temp.longValue = field.second.as_bool;
+                    record.data[0].properties[field.first] = temp;
+                    break;
                 }
-
-                iter = m_commonContextFields.find(COMMONFIELDS_NETWORK_TYPE);
-                if (iter != m_commonContextFields.end())
+                case EventProperty::TYPE_GUID:
                 {
-                    record.extNet[0].type = iter->second.as_string;
+                    GUID_t temp = field.second.as_guid;
+                    temp.to_bytes(guid_bytes);
+                    guid = std::vector<uint8_t>(guid_bytes, guid_bytes + sizeof(guid_bytes) / sizeof(guid_bytes[0]));
+
+                    CsProtocol::Value tempValue;
+                    tempValue.type = ::CsProtocol::ValueKind::ValueGuid;
+                    tempValue.guidValue.push_back(guid);
+                    record.data[0].properties[field.first] = tempValue;
+                    break;
                 }
-            }
-
-            if (m_ticketsMap.size() > 0)
-            {
-                std::vector<std::string> tickets;
-                for (auto const& field : m_ticketsMap)
+                default:
                 {
-                    tickets.push_back(field.second);
+                    // Convert all unknown types to string
+                    CsProtocol::Value temp;
+                    temp.stringValue = field.second.to_string();
+                    record.data[0].properties[field.first] = temp;
+                }
                 }
-                CsProtocol::Protocol temp;
-                temp.ticketKeys.push_back(tickets);
-                record.extProtocol.push_back(temp);
             }
+        }
+    }
 
-            if (!commonOnly)
-            {
-                for (auto const& field : m_customContextFields)
-                {
-                    if (field.second.piiKind != PiiKind_None)
-                    {
-                        CsProtocol::PII pii;
-                        pii.Kind = static_cast<CsProtocol::PIIKind>(field.second.piiKind);
-                        CsProtocol::Value temp;
-                        CsProtocol::Attributes attrib;
-                        attrib.pii.push_back(pii);
-
-
-                        temp.attributes.push_back(attrib);
+    void ContextFieldsProvider::applyEventExperimentIds(::CsProtocol::Record& record)
+    {
+        if (m_parent)
+        {
+            m_parent->applyEventExperimentIds(record);
+        }
 
-                        temp.stringValue = field.second.to_string();
-                        record.data[0].properties[field.first] = temp;
-                    }
-                    else
-                    {
-                        std::vector<uint8_t> guid;
-                        uint8_t guid_bytes[16] = { 0 };
-
-                        switch (field.second.type)
-                        {
-                        case EventProperty::TYPE_STRING:
-                        {
-                            CsProtocol::Value temp;
-                            temp.stringValue = field.second.to_string();
-                            record.data[0].properties[field.first] = temp;
-                            break;
-                        }
-                        case EventProperty::TYPE_INT64:
-                        {
-                            CsProtocol::Value temp;
-                            temp.type = ::CsProtocol::ValueKind::ValueInt64;
-                            temp.longValue = field.second.as_int64;
-                            record.data[0].properties[field.first] = temp;
-                            break;
-                        }
-                        case EventProperty::TYPE_DOUBLE:
-                        {
-                            CsProtocol::Value temp;
-                            temp.type = ::CsProtocol::ValueKind::ValueDouble;
-                            temp.doubleValue = field.second.as_double;
-                            record.data[0].properties[field.first] = temp;
-                            break;
-                        }
-                        case EventProperty::TYPE_TIME:
-                        {
-                            CsProtocol::Value temp;
-                            temp.type = ::CsProtocol::ValueKind::ValueDateTime;
-                            temp.longValue = field.second.as_time_ticks.ticks;
-                            record.data[0].properties[field.first] = temp;
-                            break;
-                        }
-                        case EventProperty::TYPE_BOOLEAN:
-                        {
-                            CsProtocol::Value temp;
-                            temp.type = ::CsProtocol::ValueKind::ValueBool;
-                            temp.longValue = field.second.as_bool;
-                            record.data[0].properties[field.first] = temp;
-                            break;
-                        }
-                        case EventProperty::TYPE_GUID:
-                        {
-                            GUID_t temp = field.second.as_guid;
-                            temp.to_bytes(guid_bytes);
-                            guid = std::vector<uint8_t>(guid_bytes, guid_bytes + sizeof(guid_bytes) / sizeof(guid_bytes[0]));
-
-                            CsProtocol::Value tempValue;
-                            tempValue.type = ::CsProtocol::ValueKind::ValueGuid;
-                            tempValue.guidValue.push_back(guid);
-                            record.data[0].properties[field.first] = tempValue;
-                            break;
-                        }
-                        default:
-                        {
-                            // Convert all unknown types to string
-                            CsProtocol::Value temp;
-                            temp.stringValue = field.second.to_string();
-                            record.data[0].properties[field.first] = temp;
-                        }
-                        }
-                    }
-                }
-            }
-            LOG_TRACE("Record=%p decorated with SemanticContext=%p", &record, this);
+        LOCKGUARD(m_lock);
+        auto iter = m_commonContextFields.find(COMMONFIELDS_APP_EXPERIMENTIDS);
+        if (iter == m_commonContextFields.end() || iter->second.type != EventProperty::TYPE_STRING || iter->second.as_string[0] == '\0')
+        {
+            return;
         }
+
+        // Same lookup as applyCommonFields, for the actual event name
+        const auto& eventIter = m_commonContextEventToConfigIds.find(record.name);
+        record.extApp[0].expId = (eventIter != m_commonContextEventToConfigIds.end()) ? eventIter->second : std::string(iter->second.as_string);
     }
 
     void ContextFieldsProvider::ClearExperimentIds()
@@ -409,7 +562,9 @@ namespace MAT_NS_BEGIN
         SetCommonField(COMMONFIELDS_APP_EXPERIMENTIDS, "");
 
         // Clear the map of all ExperimentsIds (that's associated with event)
+        LOCKGUARD(m_lock);
         m_commonContextEventToConfigIds.clear();
+        m_version++;
     }
 
     void ContextFieldsProvider::SetEventExperimentIds(std::string const& eventName, std::string const& experimentIds)
@@ -420,6 +575,8 @@ namespace MAT_NS_BEGIN
         }
 
         std::string eventNameNormalized = toLower(eventName);
+        LOCKGUARD(m_lock);
+        m_version++;
         if (!experimentIds.empty())
         {
             m_commonContextEventToConfigIds[eventNameNormalized] = experimentIds;
@@ -434,12 +591,14 @@ namespace MAT_NS_BEGIN
     {
         LOCKGUARD(m_lock);
         m_commonContextFields[name] = value;
+        m_version++;
     }
 
     void ContextFieldsProvider::SetCustomField(const std::string& name, const EventProperty& value)
     {
         LOCKGUARD(m_lock);
         m_customContextFields[name] = value;
+        m_version++;
     }
 
     void ContextFieldsProvider::SetTicket(TicketType type, const std::string& ticketValue)
@@ -448,21 +607,29 @@ namespace MAT_NS_BEGIN
         if (!ticketValue.empty())
         {
             m_ticketsMap[type] = ticketValue;
+            m_version++;
         }
     }
 
     void ContextFieldsProvider::SetParentContext(ContextFieldsProvider* parent)
     {
+        LOCKGUARD(m_lock);
         m_parent = parent;
+        m_version++;
     }
 
     std::map<std::string, EventProperty>& ContextFieldsProvider::GetCommonFields()
     {
+        // The caller may modify the fields through the reference
+        LOCKGUARD(m_lock);
+        m_version++;
         return m_commonContextFields;
     }
 
     std::map<std::string, EventProperty>& ContextFieldsProvider::GetCustomFields()
     {
+        LOCKGUARD(m_lock);
+        m_version++;
         return m_customContextFields;
     }
 
@@ -10,14 +10,58 @@
 
 #include "utils/Utils.hpp"
 
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <string>
+#include <vector>
 #include <cassert>
 
 namespace MAT_NS_BEGIN
 {
 
+    /// <summary>
+    /// Part A extensions and context properties that a ContextFieldsProvider
+    /// and its parents write into every event. The snapshot is rebuilt only
+    /// when one of the contexts changes, so writeToRecord does not have to
+    /// look up every common field for each event.
+    /// </summary>
+    struct ContextFieldsSnapshot
+    {
+        /// <summary>
+        /// What writeToRecord produces on an empty record, minus experiment ids
+        /// that are specific to the event name.
+        /// </summary>
+        ::CsProtocol::Record record;
+
+        /// <summary>
+        /// record.data[0] properties without the provider's own custom fields,
+        /// used by writeToRecord(record, true).
+        /// </summary>
+        std::map<std::string, ::CsProtocol::Value> commonProperties;
+
+        bool hasDeviceMake = false;
+        bool hasDeviceModel = false;
+
+        /// <summary>
+        /// Names of the events that some context level gives their own experiment ids.
+        /// </summary>
+        std::set<std::string> eventsWithExperimentIds;
+
+        /// <summary>
+        /// Bond encoding of the extUser, extDevice, extOs and extApp fields of
+        /// record, spliced into serialized events that carry them unchanged.
+        /// </summary>
+        std::vector<uint8_t> encodedExtensions;
+
+        /// <summary>
+        /// Copies the extUser, extDevice, extOs and extApp fields into other.
+        /// </summary>
+        void WriteExtensions(::CsProtocol::Record& other) const;
+    };
+
     class ContextFieldsProvider : public ISemanticContext
     {
 
@@ -28,7 +72,15 @@ namespace MAT_NS_BEGIN
         ContextFieldsProvider& operator=(ContextFieldsProvider const& copy);
 
         virtual void SetCommonField(const std::string&  name, const EventProperty&  value) override;
-        void writeToRecord(::CsProtocol::Record& record, bool commonOnly = false);
+
+        /// <summary>
+        /// Writes the context fields into the record. With deferExtensions, the
+        /// extUser, extDevice, extOs and extApp fields are left empty for the
+        /// encoder to splice in, unless the event gets its own experiment ids.
+        /// Returns the snapshot whose encodedExtensions are valid for the record,
+        /// or null if the record's extensions differ from the snapshot's.
+        /// </summary>
+        std::shared_ptr<const ContextFieldsSnapshot> writeToRecord(::CsProtocol::Record& record, bool commonOnly = false, bool deferExtensions = false);
         virtual void SetCustomField(const std::string&  name, const EventProperty&  value) override;
 
         virtual void SetParentContext(ContextFieldsProvider* parent);
@@ -40,11 +92,28 @@ namespace MAT_NS_BEGIN
         virtual std::map<std::string, EventProperty>& GetCommonFields();
         virtual std::map<std::string, EventProperty>& GetCustomFields();
 
+        /// <summary>
+        /// Returns the cached snapshot of this context, rebuilding it first if
+        /// this context or one of its parents changed since it was taken.
+        /// </summary>
+        std::shared_ptr<const ContextFieldsSnapshot> GetSnapshot();
+
     protected:
+        void writeFieldsToRecord(::CsProtocol::Record& record, bool commonOnly);
+        static void addExtensions(::CsProtocol::Record& record);
+        void applyCommonFields(::CsProtocol::Record& record);
+        void applyCustomFields(::CsProtocol::Record& record);
+        void applyEventExperimentIds(::CsProtocol::Record& record);
 
         std::mutex              m_lock;
         ContextFieldsProvider*  m_parent;
 
+        // Bumped under m_lock by every change to the fields below
+        uint64_t                m_version = 0;
+        std::shared_ptr<const ContextFieldsSnapshot> m_snapshot;
+        uint64_t                m_snapshotVersion = 0;
+        std::shared_ptr<const ContextFieldsSnapshot> m_snapshotParent;
+
         std::map<std::string, EventProperty> m_commonContextFields;
         std::map<std::string, EventProperty> m_customContextFields;
 
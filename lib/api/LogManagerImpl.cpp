@@ -13,6 +13,7 @@
 #include "offline/OfflineStorageHandler.hpp"
 
 #include "system/TelemetrySystem.hpp"
+#include "decorators/EventPropertiesDecorator.hpp"
 
 #include "EventProperty.hpp"
 #include "TransmitProfiles.hpp"
@@ -117,6 +118,31 @@ namespace MAT_NS_BEGIN
 
     MATSDK_LOG_INST_COMPONENT_CLASS(LogManagerImpl, "EventsSDK.LogManager", "Microsoft Telemetry Client - LogManager class");
 
+    /// <summary>
+    /// Event context that takes over the caller's record, and keeps a copy of
+    /// the properties left for the Bond encoder, so that it may outlive the
+    /// ILogger call while waiting in the ingestion queue.
+    /// </summary>
+    class QueuedEventContext : public IncomingEventContext
+    {
+       public:
+        QueuedEventContext(IncomingEventContext& other) :
+            IncomingEventContext(other),
+            m_source(std::move(*other.source))
+        {
+            source = &m_source;
+            if (other.properties != nullptr)
+            {
+                m_properties.reset(new EventProperties(*other.properties));
+                properties = m_properties.get();
+            }
+        }
+
+       protected:
+        ::CsProtocol::Record m_source;
+        std::unique_ptr<EventProperties> m_properties;
+    };
+
 #if 1
     // TODO: integrate Tracing API from v1
     // Meanwhile we'd set the g_logLevel using ILogConfiguration settings
@@ -226,6 +252,15 @@ namespace MAT_NS_BEGIN
             }
         }
 
+        if (m_logConfiguration.HasConfig(CFG_MAP_EVENT_RULES))
+        {
+            m_eventRules.reset(new EventRuleTable(m_logConfiguration[CFG_MAP_EVENT_RULES]));
+            if (m_eventRules->Empty())
+            {
+                m_eventRules.reset();
+            }
+        }
+
         m_context.SetCommonField(SESSION_ID_LEGACY, PAL::generateUuidString());
 
         if (m_dataViewer != nullptr)
@@ -242,6 +277,16 @@ namespace MAT_NS_BEGIN
             LOG_TRACE("TaskDispatcher: External %p", m_taskDispatcher.get());
         }
 
+        // Tasks of this instance run one at a time, in parallel with other instances
+        // when the dispatcher has several workers
+        auto serialQueue = m_taskDispatcher->CreateSerialQueue();
+        if (serialQueue != nullptr)
+        {
+            m_taskDispatcher = serialQueue;
+        }
+
+        InitializeIngestionQueue();
+
         int32_t sdkMode = configuration[CFG_INT_SDK_MODE];
         (void)sdkMode; // variable may be unused when SDK is compiled without private modules
 
@@ -329,12 +374,19 @@ namespace MAT_NS_BEGIN
             // Default mode is Common Schema - direct
             m_system.reset(new TelemetrySystem(*this, *m_config, *m_offlineStorage, *m_httpClient,
                                                *m_taskDispatcher, m_bandwidthController, *m_logSessionDataProvider));
+            // Only the Bond serializer of the default telemetry system understands deferred properties
+            m_directBondEncoding = m_logConfiguration[CFG_BOOL_DIRECT_BOND_ENCODING];
         }
         LOG_TRACE("Telemetry system created, starting up...");
+        if (m_system)
+        {
+            m_system->setEventRules(m_eventRules.get());
+        }
         if (m_system && !deferSystemStart)
         {
             m_system->start();
             m_isSystemStarted = true;
+            RestoreDerivedDeviceId();
         }
 
 #ifdef HAVE_MAT_DEFAULT_FILTER
@@ -380,6 +432,27 @@ namespace MAT_NS_BEGIN
         PauseActivity();
         WaitPause();
         LOG_INFO("Shutting down...");
+        TeardownIngestionQueue();
+        if (!m_logConfiguration[CFG_BOOL_DISABLE_ZOMBIE_LOGGERS])
+        {
+            // Wait for logger calls in progress without holding m_lock:
+            // they take it to submit their events.
+            std::vector<Logger*> loggers;
+            {
+                LOCKGUARD(m_lock);
+                if (m_alive)
+                {
+                    for (auto& kv : m_loggers)
+                    {
+                        loggers.push_back(kv.second.get());
+                    }
+                }
+            }
+            for (auto logger : loggers)
+            {
+                logger->RecordShutdown();
+            }
+        }
         LOCKGUARD(m_lock);
         if (m_alive)
         {
@@ -440,6 +513,12 @@ namespace MAT_NS_BEGIN
     status_t LogManagerImpl::Flush()
     {
         LOG_INFO("Flush()");
+        if (m_ingestionDrainGate)
+        {
+            // Waits for a drain in progress on the dispatcher, events are processed in order
+            LOCKGUARD(m_ingestionDrainGate->lock);
+            FlushIngestionQueue();
+        }
         if (m_offlineStorage)
             m_offlineStorage->Flush();
         return STATUS_SUCCESS;
@@ -721,24 +800,308 @@ namespace MAT_NS_BEGIN
     }
 
     void LogManagerImpl::sendEvent(IncomingEventContextPtr const& event)
+    {
+        if (m_ingestionQueue)
+        {
+            EnqueueEvent(event);
+            return;
+        }
+        ProcessEvent(event);
+    }
+
+    /// <summary>
+    /// Copies event properties and context extensions that the logger left
+    /// for the Bond encoder into the record, for consumers that need the
+    /// complete record and may change it.
+    /// </summary>
+    void LogManagerImpl::AddDeferredProperties(IncomingEventContextPtr const& event)
+    {
+        if (event->properties != nullptr)
+        {
+            EventPropertiesDecorator::addDeferredProperties(*(event->source), *(event->properties));
+            event->properties = nullptr;
+        }
+        if (event->context)
+        {
+            if (event->source->extApp.empty())
+            {
+                event->context->WriteExtensions(*(event->source));
+            }
+            event->context.reset();
+        }
+    }
+
+    void LogManagerImpl::sendEvents(std::vector<IncomingEventContextPtr> const& events)
+    {
+        if (m_ingestionQueue)
+        {
+            for (auto const& event : events)
+            {
+                EnqueueEvent(event);
+            }
+            return;
+        }
+
+        LOCKGUARD(m_lock);
+        if (GetSystem())
+        {
+            DecorateAndInspect(events.data(), events.size());
+            GetSystem()->sendEvents(events);
+        }
+    }
+
+    /// <summary>
+    /// Decorate, inspect and pass the event to the telemetry system.
+    /// Runs on the caller thread, or on the task dispatcher thread when
+    /// the ingestion queue is enabled.
+    /// </summary>
+    void LogManagerImpl::ProcessEvent(IncomingEventContextPtr const& event)
     {
         LOCKGUARD(m_lock);
         if (GetSystem())
         {
-            if (m_customDecorator)
+            DecorateAndInspect(&event, 1);
+            GetSystem()->sendEvent(event);
+        }
+    }
+
+    /// <summary>
+    /// Runs the custom decorator and the data inspectors on the events.
+    /// Called with m_lock held.
+    /// </summary>
+    void LogManagerImpl::DecorateAndInspect(IncomingEventContextPtr const* events, size_t count)
+    {
+        if (m_customDecorator)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                AddDeferredProperties(events[i]);
+                m_customDecorator->decorate(*(events[i]->source));
+            }
+        }
+
+        LOCKGUARD(m_dataInspectorGuard);
+        if (m_dataInspectors.empty())
+        {
+            return;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            AddDeferredProperties(events[i]);
+            for (const auto& dataInspector : m_dataInspectors)
             {
-                m_customDecorator->decorate(*(event->source));
+                dataInspector->InspectRecord(*(events[i]->source));
             }
+        }
+    }
+
+    void LogManagerImpl::InitializeIngestionQueue()
+    {
+        uint32_t queueSize = m_logConfiguration[CFG_INT_INGESTION_QUEUE_SIZE];
+        if (queueSize == 0)
+        {
+            return;
+        }
+
+        std::string policy = m_logConfiguration[CFG_STR_INGESTION_QUEUE_OVERFLOW];
+        if (equalsIgnoreCase(policy, "dropOldest"))
+        {
+            m_ingestionOverflowPolicy = IngestionOverflowPolicy::DropOldest;
+        }
+        else if (equalsIgnoreCase(policy, "block"))
+        {
+            m_ingestionOverflowPolicy = IngestionOverflowPolicy::Block;
+        }
+        else
+        {
+            m_ingestionOverflowPolicy = IngestionOverflowPolicy::DropNewest;
+        }
+        uint32_t blockTime = m_logConfiguration[CFG_INT_INGESTION_QUEUE_BLOCK_TIME];
+        m_ingestionBlockTime = std::chrono::milliseconds(blockTime);
+
+        m_ingestionQueue.reset(new MpscRingBuffer<IncomingEventContextPtr>(queueSize));
+        m_ingestionDrainGate = std::make_shared<IngestionDrainGate>();
+        m_ingestionDrainGate->owner = this;
+        // A first drain tells which thread the dispatcher runs the drains on
+        ScheduleIngestionDrain();
+        LOG_TRACE("Ingestion queue enabled: capacity=%zu, policy=%s", m_ingestionQueue->Capacity(), policy.c_str());
+    }
+
+    void LogManagerImpl::TeardownIngestionQueue()
+    {
+        if (!m_ingestionQueue)
+        {
+            return;
+        }
+        // Producers are quiesced by PauseActivity / WaitPause. Detaching the
+        // gate waits for a drain in progress on the dispatcher, if any, and
+        // turns the ones still queued into no-ops. The dispatcher may be
+        // stopped, or be the calling thread: what is left is drained here.
+        {
+            LOCKGUARD(m_ingestionDrainGate->lock);
+            m_ingestionDrainGate->owner = nullptr;
+        }
+        FlushIngestionQueue();
+    }
 
+    /// <summary>
+    /// Called on the ILogger caller thread: moves the event record into the
+    /// ingestion queue and wakes up the consumer. Decoration, inspection
+    /// and serialization happen later in DrainIngestionQueue.
+    /// </summary>
+    void LogManagerImpl::EnqueueEvent(IncomingEventContextPtr const& event)
+    {
+        IncomingEventContextPtr queued = new QueuedEventContext(*event);
+        if (!m_ingestionQueue->Push(std::move(queued)))
+        {
+            switch (m_ingestionOverflowPolicy)
+            {
+            case IngestionOverflowPolicy::DropOldest:
             {
-                LOCKGUARD(m_dataInspectorGuard);
+                IncomingEventContextPtr oldest = nullptr;
+                while (!m_ingestionQueue->Push(std::move(queued)))
+                {
+                    if (m_ingestionQueue->Pop(oldest))
+                    {
+                        DropQueuedEvent(oldest);
+                    }
+                }
+                break;
+            }
 
-                for (const auto& dataInspector : m_dataInspectors)
+            case IngestionOverflowPolicy::Block:
+            {
+                auto self = std::this_thread::get_id();
+                if ((self == m_ingestionDrainGate->dispatcherThread.load()) || (self == m_ingestionDrainGate->drainingThread.load()))
+                {
+                    // This thread would wait for a drain that only it can run: make
+                    // room inline, also when the event is logged from within a drain.
+                    {
+                        LOCKGUARD(m_ingestionDrainGate->lock);
+                        if (m_ingestionDrainGate->owner != nullptr)
+                        {
+                            FlushIngestionQueue();
+                        }
+                    }
+                    if (!m_ingestionQueue->Push(std::move(queued)))
+                    {
+                        DropQueuedEvent(queued);
+                        return;
+                    }
+                    break;
+                }
+                auto deadline = std::chrono::steady_clock::now() + m_ingestionBlockTime;
+                bool pushed = false;
+                {
+                    std::unique_lock<std::mutex> lock(m_ingestionSpaceLock);
+                    m_ingestionBlockedProducers++;
+                    // Pairs with the fence in NotifyIngestionSpace: either the
+                    // consumer sees this producer waiting, or Push sees the room.
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    while (!(pushed = m_ingestionQueue->Push(std::move(queued))))
+                    {
+                        ScheduleIngestionDrain();
+                        if (m_ingestionSpace.wait_until(lock, deadline) == std::cv_status::timeout)
+                        {
+                            pushed = m_ingestionQueue->Push(std::move(queued));
+                            break;
+                        }
+                    }
+                    m_ingestionBlockedProducers--;
+                }
+                if (!pushed)
                 {
-                    dataInspector->InspectRecord(*(event->source));
+                    DropQueuedEvent(queued);
+                    return;
                 }
+                break;
             }
-            GetSystem()->sendEvent(event);
+
+            case IngestionOverflowPolicy::DropNewest:
+            default:
+                DropQueuedEvent(queued);
+                return;
+            }
+        }
+        ScheduleIngestionDrain();
+    }
+
+    void LogManagerImpl::ScheduleIngestionDrain()
+    {
+        if (!m_ingestionDrainScheduled.exchange(true))
+        {
+            PAL::dispatchTask(m_taskDispatcher.get(), m_ingestionDrainGate.get(), &IngestionDrainGate::Drain, m_ingestionDrainGate);
+        }
+    }
+
+    void LogManagerImpl::IngestionDrainGate::Drain(std::shared_ptr<IngestionDrainGate> const& /*keepAlive*/)
+    {
+        LOCKGUARD(lock);
+        dispatcherThread = std::this_thread::get_id();
+        if (owner != nullptr)
+        {
+            owner->DrainIngestionQueue();
+        }
+    }
+
+    /// <summary>
+    /// Consumer of the ingestion queue, runs on the task dispatcher. Flush and
+    /// producers blocked on the dispatcher thread drain inline: all take the
+    /// drain gate lock, so that events are processed one at a time and in order.
+    /// </summary>
+    void LogManagerImpl::DrainIngestionQueue()
+    {
+        do
+        {
+            FlushIngestionQueue();
+            m_ingestionDrainScheduled = false;
+            // A producer may have pushed after the last Pop, but before the
+            // flag was cleared: in that case it did not schedule a new drain.
+        } while (!m_ingestionQueue->Empty() && !m_ingestionDrainScheduled.exchange(true));
+    }
+
+    /// <summary>
+    /// Processes the queued events. Called with the drain gate lock held,
+    /// or once TeardownIngestionQueue has detached the gate.
+    /// </summary>
+    void LogManagerImpl::FlushIngestionQueue()
+    {
+        if (!m_ingestionQueue)
+        {
+            return;
+        }
+        auto previous = m_ingestionDrainGate->drainingThread.exchange(std::this_thread::get_id());
+        IncomingEventContextPtr event = nullptr;
+        while (m_ingestionQueue->Pop(event))
+        {
+            NotifyIngestionSpace();
+            std::unique_ptr<IncomingEventContext> owner(event);
+            ProcessEvent(event);
+        }
+        m_ingestionDrainGate->drainingThread = previous;
+    }
+
+    /// <summary>
+    /// Wakes up producers waiting for room under the Block overflow policy.
+    /// </summary>
+    void LogManagerImpl::NotifyIngestionSpace()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_ingestionBlockedProducers.load(std::memory_order_relaxed) > 0)
+        {
+            LOCKGUARD(m_ingestionSpaceLock);
+            m_ingestionSpace.notify_all();
+        }
+    }
+
+    void LogManagerImpl::DropQueuedEvent(IncomingEventContextPtr const& event)
+    {
+        std::unique_ptr<IncomingEventContext> owner(event);
+        LOG_WARN("Event %s/%s dropped: ingestion queue is full",
+                 tenantTokenToId(TenantRegistry::instance().Token(event->record)).c_str(), event->source->baseType.c_str());
+        if (m_system)
+        {
+            m_system->dropEvent(event);
         }
     }
 
@@ -797,9 +1160,32 @@ namespace MAT_NS_BEGIN
 
         m_system->start();
         m_isSystemStarted = true;
+        RestoreDerivedDeviceId();
         return m_system;
     }
 
+    void LogManagerImpl::RestoreDerivedDeviceId()
+    {
+        static const char* derivedDeviceIdName = "sysinfoderiveddeviceid";
+        auto deviceInformation = PAL::GetDeviceInformation();
+        if (!m_offlineStorage || !deviceInformation || !deviceInformation->IsDeviceIdDerived())
+        {
+            return;
+        }
+        std::string deviceId = m_offlineStorage->GetSetting(derivedDeviceIdName);
+        if (deviceId.empty())
+        {
+            if (!m_offlineStorage->StoreSetting(derivedDeviceIdName, deviceInformation->GetDeviceId()))
+            {
+                LOG_WARN("Unable to save derived device id to DB");
+            }
+        }
+        else if (deviceId != deviceInformation->GetDeviceId())
+        {
+            m_context.SetDeviceId(deviceId);
+        }
+    }
+
     void LogManagerImpl::InitializeModules() noexcept
     {
         for (const auto& module : m_modules)
@@ -879,6 +1265,13 @@ namespace MAT_NS_BEGIN
         return it != m_dataInspectors.end() ? *it : nullptr;
     }
 
+    std::vector<StageLatency> LogManagerImpl::GetStageLatencies()
+    {
+        LOCKGUARD(m_lock);
+        RouteStatistics const* routeStats = GetSystem() ? GetSystem()->getRouteStatistics() : nullptr;
+        return routeStats ? routeStats->GetStageLatencies() : std::vector<StageLatency> {};
+    }
+
     status_t LogManagerImpl::DeleteData()
     {
 
@@ -907,69 +1300,27 @@ namespace MAT_NS_BEGIN
 
     void LogManagerImpl::PauseActivity()
     {
-        std::unique_lock<std::mutex> lock(m_pause_mutex);
-        if (m_pause_state != PauseState::Active) {
-            return;
-        }
-
-        if (m_pause_active_count == 0)
-        {
-            m_pause_state = PauseState::Paused;
-            // notify under lock because a waiting thread
-            // may destroy objects (including this object)
-            m_pause_cv.notify_all();
-        }
-        else
-        {
-            m_pause_state = PauseState::Pausing;
-        }
+        m_pauseGate.Close();
     }
 
     void LogManagerImpl::ResumeActivity()
     {
-        std::unique_lock<std::mutex> lock(m_pause_mutex);
-        if (m_pause_state == PauseState::Active) {
-            return;
-        }
-        m_pause_state = PauseState::Active;
-        m_pause_cv.notify_all();
+        m_pauseGate.Open();
     }
 
     void LogManagerImpl::WaitPause()
     {
-        std::unique_lock<std::mutex> lock(m_pause_mutex);
-        if (m_pause_state != PauseState::Pausing) {
-            return;
-        }
-        m_pause_cv.wait(lock, [this]() -> bool {
-            return m_pause_state != PauseState::Pausing;
-        });
+        m_pauseGate.WaitDrained();
     }
 
     bool LogManagerImpl::StartActivity()
     {
-        std::unique_lock<std::mutex> lock(m_pause_mutex);
-        if (m_pause_state != PauseState::Active) {
-            return false;
-        }
-        m_pause_active_count += 1;
-        return true;
+        return m_pauseGate.Enter();
     }
 
     void LogManagerImpl::EndActivity()
     {
-        std::unique_lock<std::mutex> lock(m_pause_mutex);
-        if (m_pause_active_count == 0) {
-            return;
-        }
-        m_pause_active_count -= 1;
-        if (m_pause_active_count > 0) {
-            return;
-        }
-        if (m_pause_state == PauseState::Pausing) {
-            m_pause_state = PauseState::Paused;
-            m_pause_cv.notify_all();
-        }
+        m_pauseGate.Leave();
     }
 }
 MAT_NS_END
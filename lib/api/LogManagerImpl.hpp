@@ -26,15 +26,21 @@
 #include "api/AuthTokensController.hpp"
 #include "api/DataViewerCollection.hpp"
 #include "filter/EventFilterCollection.hpp"
+#include "filter/EventRuleTable.hpp"
 
 #include "AllowedLevelsCollection.hpp"
 
 #include "IDataInspector.hpp"
 #include "offline/LogSessionDataProvider.hpp"
+#include "utils/ActivityGate.hpp"
+#include "utils/MpscRingBuffer.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <set>
+#include <thread>
 
 namespace MAT_NS_BEGIN
 {
@@ -123,8 +129,20 @@ namespace MAT_NS_BEGIN
         std::shared_ptr<IDecoratorModule> m_customDecorator;
 
         virtual void sendEvent(IncomingEventContextPtr const& event) = 0;
+        virtual void sendEvents(std::vector<IncomingEventContextPtr> const& events) = 0;
         virtual const ContextFieldsProvider& GetContext() = 0;
         virtual const DiagLevelFilter& GetLevelFilter() = 0;
+
+        /// <summary>
+        /// True if loggers may leave event properties out of the record and
+        /// let the serializer encode them directly (see CFG_BOOL_DIRECT_BOND_ENCODING).
+        /// </summary>
+        virtual bool IsDirectBondEncodingEnabled() const = 0;
+
+        /// <summary>
+        /// Early drop and sampling rules (see CFG_MAP_EVENT_RULES), nullptr if none are configured.
+        /// </summary>
+        virtual EventRuleTable* GetEventRules() = 0;
     };
 
     class Logger;
@@ -273,6 +291,13 @@ namespace MAT_NS_BEGIN
         /// <param name="event">The event.</param>
         virtual void sendEvent(IncomingEventContextPtr const& event) override;
 
+        /// <summary>
+        /// Adds a batch of incoming events, decorating and inspecting them under one
+        /// lock and passing them on to the telemetry system together.
+        /// </summary>
+        /// <param name="events">The events.</param>
+        virtual void sendEvents(std::vector<IncomingEventContextPtr> const& events) override;
+
         void SetLevelFilter(uint8_t defaultLevel, uint8_t levelMin, uint8_t levelMax) override;
 
         void SetLevelFilter(uint8_t defaultLevel, const std::set<uint8_t>& allowedLevels) override;
@@ -295,6 +320,16 @@ namespace MAT_NS_BEGIN
             return m_context;
         }
 
+        virtual bool IsDirectBondEncodingEnabled() const override
+        {
+            return m_directBondEncoding;
+        }
+
+        virtual EventRuleTable* GetEventRules() override
+        {
+            return m_eventRules.get();
+        }
+
         static size_t GetDeadLoggerCount();
 
         virtual void SetDataInspector(const std::shared_ptr<IDataInspector>& dataInspector) override;
@@ -302,6 +337,8 @@ namespace MAT_NS_BEGIN
         virtual void RemoveDataInspector(const std::string& name) override;
         virtual std::shared_ptr<IDataInspector> GetDataInspector(const std::string& name) noexcept override;
 
+        virtual std::vector<StageLatency> GetStageLatencies() override;
+
         virtual void PauseActivity() override;
         virtual void ResumeActivity() override;
         virtual void WaitPause() override;
@@ -313,6 +350,34 @@ namespace MAT_NS_BEGIN
         void InitializeModules() noexcept;
         void TeardownModules() noexcept;
 
+        /// <summary>
+        /// Keeps a derived device ID stable across runs: the first one seen is
+        /// persisted in the offline storage settings and wins on later starts.
+        /// </summary>
+        void RestoreDerivedDeviceId();
+
+        /// <summary>
+        /// Policy applied by sendEvent when the ingestion queue is full
+        /// </summary>
+        enum class IngestionOverflowPolicy : uint8_t
+        {
+            DropNewest,
+            DropOldest,
+            Block
+        };
+
+        void InitializeIngestionQueue();
+        void TeardownIngestionQueue();
+        void EnqueueEvent(IncomingEventContextPtr const& event);
+        void ScheduleIngestionDrain();
+        void DrainIngestionQueue();
+        void FlushIngestionQueue();
+        void NotifyIngestionSpace();
+        void DropQueuedEvent(IncomingEventContextPtr const& event);
+        void ProcessEvent(IncomingEventContextPtr const& event);
+        void DecorateAndInspect(IncomingEventContextPtr const* events, size_t count);
+        static void AddDeferredProperties(IncomingEventContextPtr const& event);
+
         MATSDK_LOG_DECL_COMPONENT_CLASS();
 
         static DeadLoggers s_deadLoggers;
@@ -343,21 +408,47 @@ namespace MAT_NS_BEGIN
         DiagLevelFilter m_diagLevelFilter;
 
         EventFilterCollection m_filters;
+        std::unique_ptr<EventRuleTable> m_eventRules;
         std::vector<std::unique_ptr<IModule>> m_modules;
         DataViewerCollection m_dataViewerCollection;
         std::vector<std::shared_ptr<IDataInspector>> m_dataInspectors;
         std::recursive_mutex m_dataInspectorGuard;
 
-        std::mutex m_pause_mutex;
-        std::condition_variable m_pause_cv;
-        uint64_t m_pause_active_count = 0;
-        enum class PauseState : uint8_t
+        std::unique_ptr<MpscRingBuffer<IncomingEventContextPtr>> m_ingestionQueue;
+        IngestionOverflowPolicy m_ingestionOverflowPolicy = IngestionOverflowPolicy::DropNewest;
+        std::chrono::milliseconds m_ingestionBlockTime{0};
+        std::atomic<bool> m_ingestionDrainScheduled{false};
+
+        /// <summary>
+        /// Target of the drain tasks. Each task holds a reference to it, so that
+        /// tasks still queued when TeardownIngestionQueue detaches it do nothing.
+        /// The queue is only drained with lock held, which may be taken again by
+        /// an event logged from within the drain.
+        /// </summary>
+        struct IngestionDrainGate
         {
-            Active,
-            Pausing,
-            Paused
+            std::recursive_mutex lock;
+            LogManagerImpl* owner;
+            // Thread the dispatcher ran the last drain on
+            std::atomic<std::thread::id> dispatcherThread{std::thread::id()};
+            // Thread processing the queued events, on the dispatcher or inline
+            std::atomic<std::thread::id> drainingThread{std::thread::id()};
+            void Drain(std::shared_ptr<IngestionDrainGate> const& keepAlive);
         };
-        PauseState m_pause_state = PauseState::Active;
+        std::shared_ptr<IngestionDrainGate> m_ingestionDrainGate;
+
+        // Producers blocked by the Block overflow policy wait here for room
+        std::mutex m_ingestionSpaceLock;
+        std::condition_variable m_ingestionSpace;
+        std::atomic<uint32_t> m_ingestionBlockedProducers{0};
+
+        bool m_directBondEncoding{false};
+
+        /// <summary>
+        /// Counts StartActivity/EndActivity calls. PauseActivity closes it, the pause
+        /// is complete once it has drained.
+        /// </summary>
+        ActivityGate m_pauseGate;
     };
 
 }
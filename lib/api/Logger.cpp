@@ -7,6 +7,8 @@
 #include "CommonFields.h"
 #include "LogSessionData.hpp"
 #include "NullObjects.hpp"
+#include "RecordArena.hpp"
+#include "utils/EventId.hpp"
 #include "utils/Utils.hpp"
 
 #include <algorithm>
@@ -26,30 +28,20 @@ namespace MAT_NS_BEGIN
         ActiveLoggerCall(ActiveLoggerCall const& source) : m_logger(source.m_logger)
         {
             m_unpaused = m_logger.m_logManager.StartActivity();
-            std::lock_guard<std::mutex> lock(m_logger.m_shutdown_mutex);
-            m_active = m_logger.m_active;
-            if (m_active)
-            {
-                m_logger.m_active_count += 1;
-            }
+            m_active = m_logger.m_shutdownGate.Enter();
         }
 
-        /// Record current state on construction; increment active
-        /// count if we are active.
+        /// Record current state on construction; count this call
+        /// if we are active.
         explicit ActiveLoggerCall(const Logger& parent) :
             m_logger(parent)
         {
             m_unpaused = m_logger.m_logManager.StartActivity();
-            std::lock_guard<std::mutex> lock(m_logger.m_shutdown_mutex);
-            m_active = m_logger.m_active;
-            if (m_active)
-            {
-                m_logger.m_active_count += 1;
-            }
+            m_active = m_logger.m_shutdownGate.Enter();
         }
 
-        /// If active, decrement active count, wake any listeners when
-        /// active count reaches zero (usually there are no listeners).
+        /// If active, stop counting this call; the gate wakes
+        /// RecordShutdown() when the last call leaves.
         ~ActiveLoggerCall()
         {
             if (m_unpaused)
@@ -58,16 +50,7 @@ namespace MAT_NS_BEGIN
             }
             if (m_active)
             {
-                std::lock_guard<std::mutex> lock(m_logger.m_shutdown_mutex);
-
-                if (m_logger.m_active_count > 0)
-                {
-                    m_logger.m_active_count -= 1;
-                    if (m_logger.m_active_count == 0)
-                    {
-                        const_cast<std::condition_variable*>(&m_logger.m_shutdown_condition)->notify_all();
-                    }
-                }
+                m_logger.m_shutdownGate.Leave();
             }
         }
 
@@ -88,6 +71,8 @@ namespace MAT_NS_BEGIN
         ContextFieldsProvider& parentContext,
         IRuntimeConfig& runtimeConfig) :
         m_tenantToken(tenantToken),
+        m_tenant(TenantRegistry::instance().Register(tenantToken)),
+        m_tenantId(TenantRegistry::instance().TenantId(m_tenant)),
         m_source(source),
         // TODO: scope parameter can be used to rewire the logger to alternate context.
         // Scope must uniquely identify the "shared context" instance id.
@@ -105,9 +90,8 @@ namespace MAT_NS_BEGIN
         m_allowDotsInType(false),
         m_resetSessionOnEnd(false)
     {
-        std::string tenantId = tenantTokenToId(m_tenantToken);
-        LOG_TRACE("%p: New instance (tenantId=%s)", this, tenantId.c_str());
-        m_iKey = "o:" + tenantId;
+        LOG_TRACE("%p: New instance (tenantId=%s)", this, m_tenantId.c_str());
+        m_iKey = "o:" + m_tenantId;
         if (m_config.HasConfig(CFG_MAP_COMPAT))
         {
             MAT::VariantMap& cfg = m_config[CFG_MAP_COMPAT];
@@ -258,19 +242,21 @@ namespace MAT_NS_BEGIN
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        RecordArena::Lease recordLease;
+        ::CsProtocol::Record& record = *recordLease;
+        std::shared_ptr<const ContextFieldsSnapshot> context;
 
         const bool decorated =
-            applyCommonDecorators(record, properties, latency) &&
+            applyCommonDecorators(record, properties, latency, context) &&
             m_semanticApiDecorators.decorateAppLifecycleMessage(record, state);
         if (!decorated)
         {
             LOG_ERROR("Failed to log %s event %s/%s: invalid arguments provided",
-                      "AppLifecycle", tenantTokenToId(m_tenantToken).c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
+                      "AppLifecycle", m_tenantId.c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
             return;
         }
 
-        submit(record, properties);
+        submit(record, properties, context);
         DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_LIFECYCLE, size_t(latency), size_t(0), static_cast<void*>(&record), sizeof(record)));
     }
 
@@ -319,21 +305,104 @@ namespace MAT_NS_BEGIN
             latency = properties.GetLatency();
         }
 
-        ::CsProtocol::Record record;
+        RecordArena::Lease recordLease;
+        ::CsProtocol::Record& record = *recordLease;
+        std::shared_ptr<const ContextFieldsSnapshot> context;
 
-        if (!applyCommonDecorators(record, properties, latency))
+        const bool deferProperties = m_logManager.IsDirectBondEncodingEnabled();
+        if (!applyCommonDecorators(record, properties, latency, context, deferProperties))
         {
             LOG_ERROR("Failed to log %s event %s/%s: invalid arguments provided",
                       "custom",
-                      tenantTokenToId(m_tenantToken).c_str(),
+                      m_tenantId.c_str(),
                       properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
             return;
         }
 
-        submit(record, properties);
+        submit(record, properties, context, deferProperties);
         DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_EVENT, size_t(latency), size_t(0), static_cast<void*>(&record), sizeof(record)));
     }
 
+    /// <summary>
+    /// Logs a batch of custom events: the level filter and the context snapshot
+    /// are read once, and the decorated events reach the log manager together.
+    /// </summary>
+    /// <param name="events">The properties of each event.</param>
+    void Logger::LogEvents(std::vector<EventProperties> const& events)
+    {
+        ActiveLoggerCall active(*this);
+        if (active.LoggerIsDead())
+        {
+            return;
+        }
+
+        LOG_TRACE("%p: LogEvents(%zu events)", this, events.size());
+
+        const bool deferProperties = m_logManager.IsDirectBondEncodingEnabled();
+        auto levelFilter = m_logManager.GetLevelFilter();
+
+        RecordArena::BatchLease records(events.size());
+        std::vector<IncomingEventContext> contexts;
+        std::vector<IncomingEventContextPtr> batch;
+        // As LogEvent, raise EVT_LOG_EVENT for every decorated event, including
+        // the ones dropped by the level filter. The pipeline clears
+        // IncomingEventContext::source, so keep the records for the debug events.
+        std::vector<std::pair<::CsProtocol::Record*, EventLatency>> decorated;
+        contexts.reserve(events.size());
+        batch.reserve(events.size());
+        decorated.reserve(events.size());
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            EventProperties const& properties = events[i];
+            if (!CanEventPropertiesBeSent(properties))
+            {
+                DispatchEvent(DebugEventType::EVT_FILTERED);
+                continue;
+            }
+
+            EventLatency latency = EventLatency_Normal;
+            if (properties.GetLatency() > EventLatency_Unspecified)
+            {
+                latency = properties.GetLatency();
+            }
+
+            ::CsProtocol::Record& record = records[i];
+            std::shared_ptr<const ContextFieldsSnapshot> context;
+            if (!applyCommonDecorators(record, properties, latency, context, deferProperties))
+            {
+                LOG_ERROR("Failed to log %s event %s/%s: invalid arguments provided",
+                          "custom",
+                          m_tenantId.c_str(),
+                          properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
+                continue;
+            }
+            decorated.emplace_back(&record, latency);
+            if (!checkSubmitFilters(record, properties, levelFilter))
+            {
+                continue;
+            }
+
+            contexts.emplace_back(EventId::Generate(), m_tenant, properties.GetLatency(), properties.GetPersistence(), &record);
+            IncomingEventContext& event = contexts.back();
+            event.policyBitFlags = properties.GetPolicyBitFlags();
+            if (deferProperties)
+            {
+                event.properties = &properties;
+            }
+            event.context = context;
+            batch.push_back(&event);
+        }
+
+        if (!batch.empty())
+        {
+            m_logManager.sendEvents(batch);
+        }
+        for (auto const& event : decorated)
+        {
+            DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_EVENT, size_t(event.second), size_t(0), static_cast<void*>(event.first), sizeof(*event.first)));
+        }
+    }
+
     /// <summary>
     /// Logs a failure event - such as an application exception.
     /// </summary>
@@ -366,21 +435,23 @@ namespace MAT_NS_BEGIN
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        RecordArena::Lease recordLease;
+        ::CsProtocol::Record& record = *recordLease;
+        std::shared_ptr<const ContextFieldsSnapshot> context;
 
         const bool decorated =
-            applyCommonDecorators(record, properties, latency) &&
+            applyCommonDecorators(record, properties, latency, context) &&
             m_semanticApiDecorators.decorateFailureMessage(record, signature, detail, category, id);
 
         if (!decorated)
         {
             LOG_ERROR("Failed to log %s event %s/%s: invalid arguments provided",
                       "Failure",
-                      tenantTokenToId(m_tenantToken).c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
+                      m_tenantId.c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
             return;
         }
 
-        submit(record, properties);
+        submit(record, properties, context);
         DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_FAILURE, size_t(latency), size_t(0), static_cast<void*>(&record), sizeof(record)));
     }
 
@@ -417,20 +488,22 @@ namespace MAT_NS_BEGIN
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        RecordArena::Lease recordLease;
+        ::CsProtocol::Record& record = *recordLease;
+        std::shared_ptr<const ContextFieldsSnapshot> context;
 
         const bool decorated =
-            applyCommonDecorators(record, properties, latency) &&
+            applyCommonDecorators(record, properties, latency, context) &&
             m_semanticApiDecorators.decoratePageViewMessage(record, id, pageName, category, uri, referrer);
 
         if (!decorated)
         {
             LOG_ERROR("Failed to log %s event %s/%s: invalid arguments provided",
-                      "PageView", tenantTokenToId(m_tenantToken).c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
+                      "PageView", m_tenantId.c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
             return;
         }
 
-        submit(record, properties);
+        submit(record, properties, context);
         DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_PAGEVIEW, size_t(latency), size_t(0), (void*)(&record), sizeof(record)));
     }
 
@@ -471,19 +544,21 @@ namespace MAT_NS_BEGIN
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        RecordArena::Lease recordLease;
+        ::CsProtocol::Record& record = *recordLease;
+        std::shared_ptr<const ContextFieldsSnapshot> context;
 
         const bool decorated =
-            applyCommonDecorators(record, properties, latency) &&
+            applyCommonDecorators(record, properties, latency, context) &&
             m_semanticApiDecorators.decoratePageActionMessage(record, pageActionData);
         if (!decorated)
         {
             LOG_ERROR("Failed to log %s event %s/%s: invalid arguments provided",
-                      "PageAction", tenantTokenToId(m_tenantToken).c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
+                      "PageAction", m_tenantId.c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
             return;
         }
 
-        submit(record, properties);
+        submit(record, properties, context);
         DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_PAGEACTION, size_t(latency), size_t(0), (void*)(&record), sizeof(record)));
     }
 
@@ -493,15 +568,12 @@ namespace MAT_NS_BEGIN
     /// <param name="record">The record.</param>
     /// <param name="properties">The properties.</param>
     /// <param name="latency">The latency.</param>
+    /// <param name="context">Receives the context snapshot whose extensions the record carries
+    /// unchanged, or leaves for the serializer when deferProperties is set; null if none.</param>
     /// <returns></returns>
-    bool Logger::applyCommonDecorators(::CsProtocol::Record& record, EventProperties const& properties, EventLatency& latency)
+    bool Logger::applyCommonDecorators(::CsProtocol::Record& record, EventProperties const& properties, EventLatency& latency,
+                                       std::shared_ptr<const ContextFieldsSnapshot>& context, bool deferProperties)
     {
-        ActiveLoggerCall active(*this);
-        if (active.LoggerIsDead())
-        {
-            return false;
-        }
-
         record.name = properties.GetName();
         record.baseType = m_customTypePrefix;
 
@@ -525,10 +597,19 @@ namespace MAT_NS_BEGIN
         }
         record.iKey = m_iKey;
 
-        return m_baseDecorator.decorate(record) && m_semanticContextDecorator.decorate(record) && m_eventPropertiesDecorator.decorate(record, latency, properties);
+        // Part A Pii is scrubbed from the record's own extensions, which then differ from the context
+        const bool dropPii = (properties.GetPolicyBitFlags() & MICROSOFT_EVENTTAG_DROP_PII) != 0;
+        const bool decorated = m_baseDecorator.decorate(record) &&
+                               m_semanticContextDecorator.decorate(record, context, deferProperties && !dropPii) &&
+                               m_eventPropertiesDecorator.decorate(record, latency, properties, deferProperties);
+        if (dropPii)
+        {
+            context.reset();
+        }
+        return decorated;
     }
 
-    void Logger::submit(::CsProtocol::Record& record, const EventProperties& props)
+    void Logger::submit(::CsProtocol::Record& record, const EventProperties& props, std::shared_ptr<const ContextFieldsSnapshot> const& context, bool deferProperties)
     {
         ActiveLoggerCall active(*this);
         if (active.LoggerIsDead())
@@ -540,10 +621,27 @@ namespace MAT_NS_BEGIN
         const auto persistence = props.GetPersistence();
         const auto latency = props.GetLatency();
         auto levelFilter = m_logManager.GetLevelFilter();
+        if (!checkSubmitFilters(record, props, levelFilter))
+        {
+            return;
+        }
+
+        IncomingEventContext event(EventId::Generate(), m_tenant, latency, persistence, &record);
+        event.policyBitFlags = policyBitFlags;
+        if (deferProperties)
+        {
+            event.properties = &props;
+        }
+        event.context = context;
+
+        m_logManager.sendEvent(&event);
+    }
+
+    bool Logger::checkSubmitFilters(::CsProtocol::Record const& record, const EventProperties& props, const DiagLevelFilter& levelFilter)
+    {
         if (levelFilter.IsLevelFilterEnabled())
         {
-            const auto& m_props = props.GetProperties();
-            const auto it = m_props.find(COMMONFIELDS_EVENT_LEVEL);
+            const auto eventLevel = props.TryGetLevel();
             //
             // Level policy:
             // * get level from the COMMONFIELDS_EVENT_LEVEL property if set
@@ -553,7 +651,7 @@ namespace MAT_NS_BEGIN
             // then prefer to drop. This is user error: user set the range
             // restrition, but didn't specify the defaults.
             //
-            uint8_t level = (it != m_props.cend()) ? static_cast<uint8_t>(it->second.as_int64) : m_level;
+            uint8_t level = std::get<0>(eventLevel) ? std::get<1>(eventLevel) : m_level;
             if (level == DIAG_LEVEL_DEFAULT)
             {
                 level = levelFilter.GetDefaultLevel();
@@ -561,31 +659,26 @@ namespace MAT_NS_BEGIN
                 {
                     // If no default level, but restrictions are in effect, then prefer to drop event
                     LOG_INFO("Event %s/%s dropped: no diagnostic level assigned!",
-                             tenantTokenToId(m_tenantToken).c_str(), record.baseType.c_str());
+                             m_tenantId.c_str(), record.baseType.c_str());
                     DispatchEvent(DebugEventType::EVT_FILTERED);
-                    return;
+                    return false;
                 }
             }
             if (!levelFilter.IsLevelEnabled(level))
             {
                 DispatchEvent(DebugEventType::EVT_FILTERED);
-                return;
+                return false;
             }
         }
 
-        if (latency == EventLatency_Off)
+        if (props.GetLatency() == EventLatency_Off)
         {
             DispatchEvent(DebugEventType::EVT_DROPPED);
             LOG_INFO("Event %s/%s dropped: calculated latency 0 (Off)",
-                     tenantTokenToId(m_tenantToken).c_str(), record.baseType.c_str());
-            return;
+                     m_tenantId.c_str(), record.baseType.c_str());
+            return false;
         }
-
-        // TODO: [MG] - check if optimization is possible in generateUuidString
-        IncomingEventContext event(PAL::generateUuidString(), m_tenantToken, latency, persistence, &record);
-        event.policyBitFlags = policyBitFlags;
-
-        m_logManager.sendEvent(&event);
+        return true;
     }
 
     void Logger::onSubmitted()
@@ -624,20 +717,22 @@ namespace MAT_NS_BEGIN
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        RecordArena::Lease recordLease;
+        ::CsProtocol::Record& record = *recordLease;
+        std::shared_ptr<const ContextFieldsSnapshot> context;
 
         const bool decorated =
-            applyCommonDecorators(record, properties, latency) &&
+            applyCommonDecorators(record, properties, latency, context) &&
             m_semanticApiDecorators.decorateSampledMetricMessage(record, name, value, units, instanceName, objectClass, objectId);
 
         if (!decorated)
         {
             LOG_ERROR("Failed to log %s event %s/%s: invalid arguments provided",
-                      "SampledMetric", tenantTokenToId(m_tenantToken).c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
+                      "SampledMetric", m_tenantId.c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
             return;
         }
 
-        submit(record, properties);
+        submit(record, properties, context);
         DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_SAMPLEMETR, size_t(latency), size_t(0), (void*)(&record), sizeof(record)));
     }
 
@@ -680,20 +775,22 @@ namespace MAT_NS_BEGIN
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        RecordArena::Lease recordLease;
+        ::CsProtocol::Record& record = *recordLease;
+        std::shared_ptr<const ContextFieldsSnapshot> context;
 
         const bool decorated =
-            applyCommonDecorators(record, properties, latency) &&
+            applyCommonDecorators(record, properties, latency, context) &&
             m_semanticApiDecorators.decorateAggregatedMetricMessage(record, metricData);
 
         if (!decorated)
         {
             LOG_ERROR("Failed to log %s event %s/%s: invalid arguments provided",
-                      "AggregatedMetric", tenantTokenToId(m_tenantToken).c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
+                      "AggregatedMetric", m_tenantId.c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
             return;
         }
 
-        submit(record, properties);
+        submit(record, properties, context);
         DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_AGGRMETR, size_t(latency), size_t(0), (void*)(&record), sizeof(record)));
     }
 
@@ -718,20 +815,22 @@ namespace MAT_NS_BEGIN
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        RecordArena::Lease recordLease;
+        ::CsProtocol::Record& record = *recordLease;
+        std::shared_ptr<const ContextFieldsSnapshot> context;
 
         bool decorated =
-            applyCommonDecorators(record, properties, latency) &&
+            applyCommonDecorators(record, properties, latency, context) &&
             m_semanticApiDecorators.decorateTraceMessage(record, level, message);
 
         if (!decorated)
         {
             LOG_ERROR("Failed to log %s event %s/%s: invalid arguments provided",
-                      "Trace", tenantTokenToId(m_tenantToken).c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
+                      "Trace", m_tenantId.c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
             return;
         }
 
-        submit(record, properties);
+        submit(record, properties, context);
         DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_TRACE, size_t(latency), size_t(0), (void*)(&record), sizeof(record)));
     }
 
@@ -756,20 +855,22 @@ namespace MAT_NS_BEGIN
         }
 
         EventLatency latency = EventLatency_Normal;
-        ::CsProtocol::Record record;
+        RecordArena::Lease recordLease;
+        ::CsProtocol::Record& record = *recordLease;
+        std::shared_ptr<const ContextFieldsSnapshot> context;
 
         bool decorated =
-            applyCommonDecorators(record, properties, latency) &&
+            applyCommonDecorators(record, properties, latency, context) &&
             m_semanticApiDecorators.decorateUserStateMessage(record, state, timeToLiveInMillis);
 
         if (!decorated)
         {
             LOG_ERROR("Failed to log %s event %s/%s: invalid arguments provided",
-                      "UserState", tenantTokenToId(m_tenantToken).c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
+                      "UserState", m_tenantId.c_str(), properties.GetName().empty() ? "<unnamed>" : properties.GetName().c_str());
             return;
         }
 
-        submit(record, properties);
+        submit(record, properties, context);
         DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_USERSTATE, size_t(latency), size_t(0), (void*)(&record), sizeof(record)));
     }
 
@@ -859,19 +960,21 @@ namespace MAT_NS_BEGIN
         }
 
         EventLatency latency = EventLatency_RealTime;
-        ::CsProtocol::Record record;
+        RecordArena::Lease recordLease;
+        ::CsProtocol::Record& record = *recordLease;
+        std::shared_ptr<const ContextFieldsSnapshot> context;
 
-        bool decorated = applyCommonDecorators(record, props, latency) &&
+        bool decorated = applyCommonDecorators(record, props, latency, context) &&
                          m_semanticApiDecorators.decorateSessionMessage(record, state, m_sessionId, PAL::formatUtcTimestampMsAsISO8601(sessionFirstTime), sessionSDKUid, sessionDuration);
 
         if (!decorated)
         {
             LOG_ERROR("Failed to log %s event %s/%s: invalid arguments provided",
-                      "Trace", tenantTokenToId(m_tenantToken).c_str(), props.GetName().empty() ? "<unnamed>" : props.GetName().c_str());
+                      "Trace", m_tenantId.c_str(), props.GetName().empty() ? "<unnamed>" : props.GetName().c_str());
             return;
         }
 
-        submit(record, props);
+        submit(record, props, context);
         DispatchEvent(DebugEvent(DebugEventType::EVT_LOG_SESSION, size_t(latency), size_t(0), (void*)(&record), sizeof(record)));
     }
 
@@ -947,23 +1050,32 @@ namespace MAT_NS_BEGIN
             return false;
         }
 
+        // Early drop rules first: they only look at the name, tenant and level
+        EventRuleTable* eventRules = m_logManager.GetEventRules();
+        if (eventRules != nullptr && !eventRules->Allow(properties.GetName(), m_tenant, [this, &properties]() { return GetEventLevel(properties); }))
+        {
+            return false;
+        }
+
         return m_filters.CanEventPropertiesBeSent(properties) && m_logManager.GetEventFilters().CanEventPropertiesBeSent(properties);
     }
 
-    void Logger::RecordShutdown()
+    int Logger::GetEventLevel(EventProperties const& properties) const noexcept
     {
-        std::unique_lock<std::mutex> shutdownLock(m_shutdown_mutex);
-        m_active = false;
-        if (m_active_count > 0)
+        const auto eventLevel = properties.TryGetLevel();
+        uint8_t level = std::get<0>(eventLevel) ? std::get<1>(eventLevel) : m_level;
+        if (level == DIAG_LEVEL_DEFAULT)
         {
-            // wait for idle before continuing
-            // as with all condition variables, we hold the lock,
-            // so no thread can decrement m_active_count until
-            // wait() releases (and later reacquires) the lock.
-            m_shutdown_condition.wait(shutdownLock, [this]() {
-                return m_active_count == 0; // we hold the lock for this call
-            });
+            level = m_logManager.GetLevelFilter().GetDefaultLevel();
         }
+        return level;
+    }
+
+    void Logger::RecordShutdown()
+    {
+        // wait for idle before continuing
+        m_shutdownGate.Close();
+        m_shutdownGate.WaitDrained();
     }
 }
 MAT_NS_END
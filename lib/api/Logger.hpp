@@ -23,10 +23,13 @@
 #include "decorators/SemanticContextDecorator.hpp"
 
 #include "filter/EventFilterCollection.hpp"
+#include "system/TenantRegistry.hpp"
+#include "utils/ActivityGate.hpp"
 
 namespace MAT_NS_BEGIN
 {
     class BaseDecorator;
+    class DiagLevelFilter;
     class ILogManagerInternal;
 
     class ActiveLoggerCall;
@@ -142,6 +145,8 @@ namespace MAT_NS_BEGIN
 
         virtual void LogEvent(EventProperties const& properties) override;
 
+        virtual void LogEvents(std::vector<EventProperties> const& events) override;
+
         virtual void LogFailure(std::string const& signature,
                                 std::string const& detail,
                                 std::string const& category,
@@ -227,19 +232,49 @@ namespace MAT_NS_BEGIN
         virtual void RecordShutdown();
 
        protected:
+        /// <summary>
+        /// Fills the record from the properties and the context. The caller holds
+        /// the ActiveLoggerCall, once for a whole LogEvents batch.
+        /// </summary>
         bool applyCommonDecorators(::CsProtocol::Record& record,
                                    EventProperties const& properties,
-                                   MAT::EventLatency& latency);
+                                   MAT::EventLatency& latency,
+                                   std::shared_ptr<const ContextFieldsSnapshot>& context,
+                                   bool deferProperties = false);
 
+        /// <summary>
+        /// Hands the decorated record to the log manager. deferProperties tells
+        /// that the Part B/C properties of props were not copied into the record
+        /// and have to be encoded from props by the serializer.
+        /// </summary>
         virtual void
-        submit(::CsProtocol::Record& record, const EventProperties& props);
+        submit(::CsProtocol::Record& record, const EventProperties& props, std::shared_ptr<const ContextFieldsSnapshot> const& context, bool deferProperties = false);
+
+        /// <summary>
+        /// Applies the diagnostic level filter and drops events of latency Off.
+        /// Returns false, after dispatching the debug event, if the event is dropped.
+        /// </summary>
+        bool
+        checkSubmitFilters(::CsProtocol::Record const& record, const EventProperties& props, const DiagLevelFilter& levelFilter);
 
+        /// <summary>
+        /// Applies the early drop rules of the log manager, then the event filters.
+        /// </summary>
         bool
         CanEventPropertiesBeSent(EventProperties const& properties) const noexcept;
 
+        /// <summary>
+        /// Diagnostic level of an event: its COMMONFIELDS_EVENT_LEVEL property,
+        /// else the level of the logger, else the default of the log manager.
+        /// </summary>
+        int
+        GetEventLevel(EventProperties const& properties) const noexcept;
+
         std::mutex m_lock;
 
         std::string m_tenantToken;
+        TenantHandle m_tenant;
+        std::string m_tenantId;
         std::string m_iKey;
         std::string m_source;
 
@@ -268,24 +303,14 @@ namespace MAT_NS_BEGIN
         bool m_resetSessionOnEnd;
         EventFilterCollection m_filters;
 
-        /// m_shutdown_mutex protects shut-down state
-        mutable std::mutex m_shutdown_mutex;
-
-        /// RecordShutdown() uses m_shutdown_condition to wait until
-        /// m_active goes to zero.
-        mutable std::condition_variable m_shutdown_condition;
-        /// m_active count records how many calls into this logger
-        /// are in progress. We can only complete the shutdown state
-        /// transition when active_count drains to zero.
-        mutable size_t m_active_count = 0;
-        /// m_active is set to false when we start the shut-down state
-        /// transition. No new calls will start once this is false, so
-        /// m_active_count should decrement to zero as calls complete.
-        mutable bool m_active = true;
+        /// m_shutdownGate counts the calls into this logger in progress.
+        /// RecordShutdown() closes it, so no new calls start, and waits
+        /// until the calls in progress have drained.
+        mutable ActivityGate m_shutdownGate;
 
         /// ActiveLoggerCall is a stack-allocated class to handle
-        /// shut-down state for individual Logger methods: increment
-        /// and decrement m_active_count as needed, record whether
+        /// shut-down state for individual Logger methods: enter and
+        /// leave m_shutdownGate as needed, record whether
         /// this method call is in the active or shut-down state.
         friend class ActiveLoggerCall;
     };
@@ -0,0 +1,187 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "RecordArena.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace MAT_NS_BEGIN
+{
+    namespace
+    {
+        std::atomic<uint64_t> s_allocationsAvoided(0);
+
+        /// <summary>
+        /// Idle records owned by the current thread.
+        /// </summary>
+        struct RecordPool
+        {
+            std::vector<std::unique_ptr<::CsProtocol::Record>> records;
+
+            /// <summary>
+            /// Idle records of the last batch; only the first records of a
+            /// smaller batch are used, the rest stay reset.
+            /// </summary>
+            std::vector<std::unique_ptr<::CsProtocol::Record>> batch;
+
+            RecordPool()
+            {
+                records.reserve(RecordArena::MaxPooledRecords);
+            }
+        };
+
+        RecordPool& GetThreadPool()
+        {
+            static thread_local RecordPool pool;
+            return pool;
+        }
+
+        template <typename TContainer>
+        inline size_t retained(TContainer const& container) noexcept
+        {
+            return (container.capacity() != 0) ? 1 : 0;
+        }
+    }
+
+    constexpr size_t RecordArena::MaxPooledRecords;
+    constexpr size_t RecordArena::MaxPooledBatchRecords;
+
+    RecordArena::Lease::Lease()
+    {
+        auto& pool = GetThreadPool().records;
+        if (pool.empty())
+        {
+            m_record = new ::CsProtocol::Record();
+            return;
+        }
+        m_record = pool.back().release();
+        pool.pop_back();
+        s_allocationsAvoided.fetch_add(CountRetainedBuffers(*m_record), std::memory_order_relaxed);
+    }
+
+    RecordArena::Lease::~Lease() noexcept
+    {
+        std::unique_ptr<::CsProtocol::Record> record(m_record);
+        auto& pool = GetThreadPool().records;
+        if (pool.size() < MaxPooledRecords)
+        {
+            Reset(*record);
+            pool.push_back(std::move(record));
+        }
+    }
+
+    RecordArena::BatchLease::BatchLease(size_t count) :
+        m_count(count)
+    {
+        // A nested batch on the same thread finds the pool empty and allocates
+        m_records.swap(GetThreadPool().batch);
+        size_t reused = (std::min)(count, m_records.size());
+        size_t avoided = 0;
+        for (size_t i = 0; i < reused; i++)
+        {
+            avoided += CountRetainedBuffers(*m_records[i]);
+        }
+        s_allocationsAvoided.fetch_add(avoided, std::memory_order_relaxed);
+
+        m_records.reserve(count);
+        while (m_records.size() < count)
+        {
+            m_records.emplace_back(new ::CsProtocol::Record());
+        }
+    }
+
+    RecordArena::BatchLease::~BatchLease() noexcept
+    {
+        if (m_records.size() > MaxPooledBatchRecords)
+        {
+            m_records.resize(MaxPooledBatchRecords);
+        }
+        for (size_t i = 0; i < (std::min)(m_count, m_records.size()); i++)
+        {
+            Reset(*m_records[i]);
+        }
+        auto& pool = GetThreadPool().batch;
+        if (pool.empty())
+        {
+            pool.swap(m_records);
+        }
+    }
+
+    void RecordArena::Reset(::CsProtocol::Record& record) noexcept
+    {
+        record.ver.clear();
+        record.name.clear();
+        record.time = 0;
+        record.popSample = 100;
+        record.iKey.clear();
+        record.flags = 0;
+        record.cV.clear();
+#ifdef HAVE_CS4_FULL
+        record.extIngest.clear();
+#endif
+        record.extProtocol.clear();
+        record.extUser.clear();
+        record.extDevice.clear();
+        record.extOs.clear();
+        record.extApp.clear();
+        record.extUtc.clear();
+#ifdef HAVE_CS4_FULL
+        record.extXbl.clear();
+        record.extJavascript.clear();
+        record.extReceipts.clear();
+#endif
+        record.extNet.clear();
+        record.extSdk.clear();
+        record.extLoc.clear();
+#ifdef HAVE_CS4_FULL
+        record.extCloud.clear();
+        record.extService.clear();
+        record.extCs.clear();
+#endif
+        record.extM365a.clear();
+        record.ext.clear();
+#ifdef HAVE_CS4_FULL
+        record.extMscv.clear();
+        record.extIntWeb.clear();
+        record.extIntService.clear();
+        record.extWeb.clear();
+#endif
+        record.tags.clear();
+        record.baseType.clear();
+        record.baseData.clear();
+        record.data.clear();
+    }
+
+    size_t RecordArena::CountRetainedBuffers(::CsProtocol::Record const& record) noexcept
+    {
+        // Strings that fit the small-string buffer report a non-zero capacity
+        // too, so only the extension vectors are counted: each of them is a
+        // guaranteed heap allocation when the decorators populate it.
+        size_t result = 0;
+        result += retained(record.extProtocol);
+        result += retained(record.extUser);
+        result += retained(record.extDevice);
+        result += retained(record.extOs);
+        result += retained(record.extApp);
+        result += retained(record.extUtc);
+        result += retained(record.extNet);
+        result += retained(record.extSdk);
+        result += retained(record.extLoc);
+        result += retained(record.extM365a);
+        result += retained(record.ext);
+        result += retained(record.baseData);
+        result += retained(record.data);
+        return result;
+    }
+
+    uint64_t RecordArena::GetAllocationsAvoided() noexcept
+    {
+        return s_allocationsAvoided.load(std::memory_order_relaxed);
+    }
+
+}
+MAT_NS_END
@@ -0,0 +1,111 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef RECORDARENA_HPP
+#define RECORDARENA_HPP
+
+#include "pal/PAL.hpp"
+
+#include "CsProtocol_types.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Per-thread pool of CsProtocol::Record instances used on the ILogger
+    /// submit path. A released record is reset in place: its strings and
+    /// extension vectors keep their heap buffers, so the next event logged
+    /// on the same thread does not have to allocate them again.
+    /// </summary>
+    class RecordArena
+    {
+       public:
+        /// <summary>
+        /// Maximum number of idle records kept per thread. Nested leases
+        /// (e.g. a debug event listener that logs from within a Log* call)
+        /// beyond this depth are simply freed on release.
+        /// </summary>
+        static constexpr size_t MaxPooledRecords = 4;
+
+        /// <summary>
+        /// Maximum number of idle batch records kept per thread. Records of
+        /// larger batches are freed on release.
+        /// </summary>
+        static constexpr size_t MaxPooledBatchRecords = 256;
+
+        /// <summary>
+        /// Scoped ownership of a record taken from the calling thread's pool.
+        /// The record is handed back to the pool when the lease goes out of scope.
+        /// </summary>
+        class Lease
+        {
+           public:
+            Lease();
+            ~Lease() noexcept;
+
+            Lease(Lease const&) = delete;
+            Lease& operator=(Lease const&) = delete;
+
+            ::CsProtocol::Record& operator*() const noexcept
+            {
+                return *m_record;
+            }
+
+            ::CsProtocol::Record* operator->() const noexcept
+            {
+                return m_record;
+            }
+
+           protected:
+            ::CsProtocol::Record* m_record;
+        };
+
+        /// <summary>
+        /// Scoped ownership of the records of an ILogger::LogEvents batch,
+        /// taken from the calling thread's batch pool. The records keep their
+        /// addresses for the lifetime of the lease.
+        /// </summary>
+        class BatchLease
+        {
+           public:
+            explicit BatchLease(size_t count);
+            ~BatchLease() noexcept;
+
+            BatchLease(BatchLease const&) = delete;
+            BatchLease& operator=(BatchLease const&) = delete;
+
+            ::CsProtocol::Record& operator[](size_t index) const noexcept
+            {
+                return *m_records[index];
+            }
+
+           protected:
+            std::vector<std::unique_ptr<::CsProtocol::Record>> m_records;
+            size_t m_count;
+        };
+
+        /// <summary>
+        /// Clears all fields of the record to their default values while
+        /// keeping the capacity of its strings and containers.
+        /// </summary>
+        static void Reset(::CsProtocol::Record& record) noexcept;
+
+        /// <summary>
+        /// Number of heap buffers that reused records already owned when they
+        /// were handed out, i.e. allocations the submit path did not have to make.
+        /// The counter is process-wide and only grows.
+        /// </summary>
+        static uint64_t GetAllocationsAvoided() noexcept;
+
+       protected:
+        static size_t CountRetainedBuffers(::CsProtocol::Record const& record) noexcept;
+    };
+
+}
+MAT_NS_END
+
+#endif
@@ -17,9 +17,12 @@
 
 #include "CommonFields.h"
 
+#include <atomic>
 #include <mutex>
 #include <map>
 #include <cstdint>
+#include <cstring>
+#include <thread>
 
 static const char * libSemver = TELEMETRY_EVENTS_VERSION;
 
@@ -28,6 +31,28 @@ using namespace MAT;
 static std::mutex mtx;
 static std::map<evt_handle_t, capi_client> clients;
 
+/// <summary>
+/// Logger resolved with EVT_OP_GET_LOGGER, owned by the client's ILogManager.
+/// Slots are assigned under mtx but looked up without it: the logger handle
+/// is the slot index in its low bits and a serial number above them. A call
+/// pins the slot while it uses the logger, and mat_close unassigns the slots
+/// of the client and waits for them to be unpinned before it releases the
+/// ILogManager.
+/// </summary>
+typedef struct capi_logger_struct
+{
+    // 0 while the slot is free
+    std::atomic<evt_handle_t> handle;
+    std::atomic<uint32_t>     pins;
+    evt_handle_t              client;
+    ILogger*                  logger;
+} capi_logger;
+
+static const unsigned loggerIndexBits = 10;
+static const size_t maxLoggers = size_t(1) << loggerIndexBits;
+static capi_logger loggers[maxLoggers];
+static evt_handle_t lastLoggerSerial = 0;
+
 /// <summary>
 /// Convert from C API handle to internal C API client struct.
 ///
@@ -55,6 +80,114 @@ void remove_client(evt_handle_t handle)
     clients.erase(handle);
 }
 
+/// <summary>
+/// Invalidate the logger handles of a client and wait until no call is
+/// still using their loggers.
+/// </summary>
+static void remove_loggers(evt_handle_t client)
+{
+    LOCKGUARD(mtx);
+    for (auto& slot : loggers)
+    {
+        if ((slot.handle.load() == 0) || (slot.client != client))
+        {
+            continue;
+        }
+        slot.handle.store(0);
+        while (slot.pins.load() != 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/// <summary>
+/// Pins the slot of a logger handle for the lifetime of this object.
+/// logger is nullptr if the handle is not assigned.
+/// </summary>
+class capi_logger_pin
+{
+public:
+    explicit capi_logger_pin(evt_handle_t handle) :
+        slot((handle > 0) ? &loggers[static_cast<size_t>(handle) & (maxLoggers - 1)] : nullptr),
+        logger(nullptr)
+    {
+        if (slot == nullptr)
+        {
+            return;
+        }
+        slot->pins.fetch_add(1);
+        // Either remove_loggers sees the pin, or this sees the slot unassigned
+        if (slot->handle.load() != handle)
+        {
+            slot->pins.fetch_sub(1);
+            slot = nullptr;
+            return;
+        }
+        logger = slot->logger;
+    }
+
+    ~capi_logger_pin()
+    {
+        if (slot != nullptr)
+        {
+            slot->pins.fetch_sub(1);
+        }
+    }
+
+    capi_logger_pin(capi_logger_pin const&) = delete;
+    capi_logger_pin& operator=(capi_logger_pin const&) = delete;
+
+private:
+    capi_logger *slot;
+
+public:
+    ILogger *logger;
+};
+
+/// <summary>
+/// Find a property passed via C API by name without unpacking the event.
+/// </summary>
+static const evt_prop * find_prop(const evt_prop *evt, size_t size, const char *name)
+{
+    if (evt == nullptr)
+    {
+        return nullptr;
+    }
+    if (size == 0)
+    {
+        size = SIZE_MAX;
+    }
+    for (size_t i = 0; (i < size) && (evt->type != TYPE_NULL); i++, evt++)
+    {
+        if ((evt->name != nullptr) && (strcmp(evt->name, name) == 0))
+        {
+            return evt;
+        }
+    }
+    return nullptr;
+}
+
+static const char * find_string_prop(const evt_prop *evt, size_t size, const char *name)
+{
+    const evt_prop *prop = find_prop(evt, size, name);
+    return ((prop != nullptr) && (prop->type == TYPE_STRING) && (prop->value.as_string != nullptr)) ? prop->value.as_string : "";
+}
+
+/// <summary>
+/// Unpack the event properties passed via C API. Properties are kept in the
+/// flat EventProperties storage, from where the Bond serializer encodes them
+/// directly when CFG_BOOL_DIRECT_BOND_ENCODING is enabled.
+/// </summary>
+static void unpack_event(EventProperties& props, const evt_prop *evt, size_t size)
+{
+    props.unpack(evt, size);
+    if (find_prop(evt, size, COMMONFIELDS_IKEY) != nullptr)
+    {
+        props.erase(COMMONFIELDS_IKEY);
+    }
+}
+
 #define VERIFY_CLIENT_HANDLE(client, ctx)                       \
     if (ctx==nullptr)                                           \
     {                                                           \
@@ -131,6 +264,27 @@ evt_status_t mat_open_core(
     // Remember the original config string. Needed to avoid hash code collisions
     clients[code].ctx_data = config;
 
+    // Privacy feature for OTEL C API client:
+    //
+    // C API customer that does not explicitly pass down JSON
+    //   config["config]["scope"] = COMMONFIELDS_SCOPE_ALL;
+    //
+    // should not be able to capture the host's context vars.
+    clients[code].scope = CONTEXT_SCOPE_NONE;
+    {
+        MAT::VariantMap &config_map = clients[code].config[CFG_MAP_FACTORY_CONFIG];
+        const auto & it = config_map.find(CFG_STR_CONTEXT_SCOPE);
+        if (it != config_map.cend())
+        {
+            clients[code].scope = static_cast<const char *>(it->second);
+            // Specifying "*" in JSON config allows Guest C API logger to capture Host context variables
+            if (clients[code].scope == CONTEXT_SCOPE_ALL)
+            {
+                clients[code].scope = CONTEXT_SCOPE_EMPTY;
+            }
+        }
+    }
+
 #if !defined (ANDROID) || defined(ENABLE_CAPI_HTTP_CLIENT)
     // Create custom HttpClient
     if (httpSendFn != nullptr && httpCancelFn != nullptr)
@@ -237,47 +391,19 @@ evt_status_t mat_log(evt_context_t *ctx)
 {
     VERIFY_CLIENT_HANDLE(client, ctx);
 
-    ILogConfiguration & config = client->config;
     const evt_prop *evt = static_cast<evt_prop*>(ctx->data);
-    EventProperties props;
-    props.unpack(evt, ctx->size);
-
-    auto m = props.GetProperties();
-    EventProperty &prop = m[COMMONFIELDS_IKEY];
-    std::string token = prop.as_string;
-    props.erase(COMMONFIELDS_IKEY);
-
-    // Privacy feature for OTEL C API client:
-    //
-    // C API customer that does not explicitly pass down JSON
-    //   config["config]["scope"] = COMMONFIELDS_SCOPE_ALL;
-    //
-    // should not be able to capture the host's context vars.
-    std::string scope = CONTEXT_SCOPE_NONE;
-    {
-        MAT::VariantMap &config_map = config[CFG_MAP_FACTORY_CONFIG];
-        const auto & it = config_map.find(CFG_STR_CONTEXT_SCOPE);
-        if (it != config_map.cend())
-        {
-            scope = static_cast<const char *>(it->second);
-            // Specifying "*" in JSON config allows Guest C API logger to capture Host context variables
-            if (scope == CONTEXT_SCOPE_ALL)
-            {
-                scope = CONTEXT_SCOPE_EMPTY;
-            }
-        }
-    }
+    std::string token = find_string_prop(evt, ctx->size, COMMONFIELDS_IKEY);
+    std::string source = find_string_prop(evt, ctx->size, COMMONFIELDS_EVENT_SOURCE);
 
-    const auto & it = m.find(COMMONFIELDS_EVENT_SOURCE);
-    std::string source = ((it != m.cend()) && (it->second.type == EventProperty::TYPE_STRING)) ? it->second.as_string : "";
-
-    ILogger *logger = client->logmanager->GetLogger(token, source, scope);
+    ILogger *logger = client->logmanager->GetLogger(token, source, client->scope);
     if (logger == nullptr)
     {
         ctx->result = EFAULT; /* invalid address */
     }
     else
     {
+        EventProperties props;
+        unpack_event(props, evt, ctx->size);
         logger->SetParentContext(nullptr);
         logger->LogEvent(props);
         ctx->result = EOK;
@@ -285,9 +411,88 @@ evt_status_t mat_log(evt_context_t *ctx)
     return ctx->result;
 }
 
+/**
+ * Resolve a logger once, so that guests logging at high rates skip the
+ * ILogManager::GetLogger lookup of mat_log on every event.
+ */
+evt_status_t mat_get_logger(evt_context_t *ctx)
+{
+    VERIFY_CLIENT_HANDLE(client, ctx);
+
+    const evt_logger_params_t *params = static_cast<evt_logger_params_t*>(ctx->data);
+    if (params == nullptr)
+    {
+        ctx->result = EFAULT; /* bad address */
+        return ctx->result;
+    }
+
+    std::string token = (params->token != nullptr) ? params->token : "";
+    std::string source = (params->source != nullptr) ? params->source : "";
+    ILogger *logger = client->logmanager->GetLogger(token, source, client->scope);
+    if (logger == nullptr)
+    {
+        ctx->result = EFAULT; /* invalid address */
+        return ctx->result;
+    }
+    logger->SetParentContext(nullptr);
+
+    LOCKGUARD(mtx);
+    // The same logger gets the same handle
+    capi_logger *unused = nullptr;
+    for (auto& slot : loggers)
+    {
+        evt_handle_t handle = slot.handle.load();
+        if (handle == 0)
+        {
+            unused = (unused != nullptr) ? unused : &slot;
+        }
+        else if ((slot.client == ctx->handle) && (slot.logger == logger))
+        {
+            ctx->handle = handle;
+            ctx->result = EOK;
+            return ctx->result;
+        }
+    }
+    if (unused == nullptr)
+    {
+        ctx->result = ENOMEM; /* all logger slots taken */
+        return ctx->result;
+    }
+    unused->client = ctx->handle;
+    unused->logger = logger;
+    evt_handle_t handle = (++lastLoggerSerial << loggerIndexBits) | static_cast<evt_handle_t>(unused - loggers);
+    unused->handle.store(handle);
+    ctx->handle = handle;
+    ctx->result = EOK;
+    return ctx->result;
+}
+
+evt_status_t mat_log_with_logger(evt_context_t *ctx)
+{
+    if (ctx == nullptr)
+    {
+        return EFAULT; /* bad address */
+    }
+
+    capi_logger_pin pin(ctx->handle);
+    if (pin.logger == nullptr)
+    {
+        ctx->result = ENOENT;
+        return ctx->result;
+    }
+
+    EventProperties props;
+    unpack_event(props, static_cast<evt_prop*>(ctx->data), ctx->size);
+    pin.logger->LogEvent(props);
+    ctx->result = EOK;
+    return ctx->result;
+}
+
 evt_status_t mat_close(evt_context_t *ctx)
 {
     VERIFY_CLIENT_HANDLE(client, ctx);
+    // Logger handles stop working before their loggers are destroyed
+    remove_loggers(ctx->handle);
     const auto result = static_cast<evt_status_t>(LogManagerProvider::Release(client->logmanager->GetLogConfiguration()));
     
     if (client->http != nullptr)
@@ -378,6 +583,14 @@ extern "C" {
                 result = mat_log(ctx);
                 break;
 
+            case EVT_OP_GET_LOGGER:
+                result = mat_get_logger(ctx);
+                break;
+
+            case EVT_OP_LOG_WITH_LOGGER:
+                result = mat_log_with_logger(ctx);
+                break;
+
             case EVT_OP_PAUSE:
                 result = mat_pause(ctx);
                 break;
@@ -4,6 +4,9 @@
 //
 
 #include "BondSerializer.hpp"
+#include "EventPropertiesBondEncoder.hpp"
+#include "api/ContextFieldsProvider.hpp"
+#include "utils/EventId.hpp"
 #include "utils/StringUtils.hpp"
 #include "utils/Utils.hpp"
 #include "bond/All.hpp"
@@ -17,14 +20,29 @@ namespace MAT_NS_BEGIN {
     {
         OACR_USE_PTR(this);
         {
-            bond_lite::CompactBinaryProtocolWriter writer(ctx->record.blob);
-            bond_lite::Serialize(writer, *ctx->source);
+            // Reuse the cached encoding of the context extensions: the context is
+            // dropped by whatever may change them after it was applied
+            std::vector<uint8_t> const* contextExtensions = nullptr;
+            if (ctx->context)
+            {
+                contextExtensions = &ctx->context->encodedExtensions;
+            }
+
+            if (ctx->properties != nullptr)
+            {
+                EventPropertiesBondEncoder::Encode(ctx->record.blob, *ctx->source, *ctx->properties, contextExtensions);
+            }
+            else
+            {
+                bond_lite::CompactBinaryProtocolWriter writer(ctx->record.blob);
+                bond_lite::Serialize(writer, *ctx->source, false, contextExtensions);
+            }
         }
 
         LOG_TRACE("Event %s/%s submitted, priority %u (%s), serialized size %u bytes, ID %s",
-            tenantTokenToId(ctx->record.tenantToken).c_str(), ctx->source->baseType.c_str(),
+            tenantTokenToId(TenantRegistry::instance().Token(ctx->record)).c_str(), ctx->source->baseType.c_str(),
             ctx->record.latency, latencyToStr(ctx->record.latency),
-            static_cast<unsigned>(ctx->record.blob.size()), ctx->record.id.c_str());
+            static_cast<unsigned>(ctx->record.blob.size()), EventId::ToText(ctx->record.id).c_str());
 
         return true;
     }
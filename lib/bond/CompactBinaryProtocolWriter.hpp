@@ -110,12 +110,17 @@ class CompactBinaryProtocolWriter {
 
     void WriteString(std::string const& value)
     {
-        if (value.empty()) {
+        WriteString(value.data(), value.size());
+    }
+
+    void WriteString(char const* value, size_t size)
+    {
+        if (size == 0) {
             WriteUInt32(0);
         } else {
-            assert(value.size() <= UINT32_MAX);
-            WriteUInt32(static_cast<uint32_t>(value.size()));
-            WriteBlob(value.data(), value.size());
+            assert(size <= UINT32_MAX);
+            WriteUInt32(static_cast<uint32_t>(size));
+            WriteBlob(value, size);
         }
     }
 
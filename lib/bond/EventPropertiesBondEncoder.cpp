@@ -0,0 +1,343 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "EventPropertiesBondEncoder.hpp"
+#include "CorrelationVector.hpp"
+#include "system/EventPropertiesStorage.hpp"
+#include "bond/All.hpp"
+#include "bond/generated/CsProtocol_writers.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+
+namespace MAT_NS_BEGIN {
+
+    using namespace bond_lite;
+
+    namespace {
+
+        typedef FlatStringMap<EventProperty>::value_type PropertyEntry;
+        typedef std::vector<PropertyEntry const*> PropertyEntries;
+        typedef std::map<std::string, ::CsProtocol::Value> ValueMap;
+
+        bool lessByName(PropertyEntry const* lhs, PropertyEntry const* rhs)
+        {
+            return lhs->first < rhs->first;
+        }
+
+        void writeType(CompactBinaryProtocolWriter& writer, ::CsProtocol::ValueKind type)
+        {
+            writer.WriteFieldBegin(BT_INT32, 1, nullptr);
+            writer.WriteInt32(static_cast<int32_t>(type));
+            writer.WriteFieldEnd();
+        }
+
+        void writeStringValue(CompactBinaryProtocolWriter& writer, char const* value, size_t size)
+        {
+            if (size != 0)
+            {
+                writer.WriteFieldBegin(BT_STRING, 3, nullptr);
+                writer.WriteString(value, size);
+                writer.WriteFieldEnd();
+            }
+        }
+
+        void writeLongValue(CompactBinaryProtocolWriter& writer, int64_t value)
+        {
+            if (value != 0)
+            {
+                writer.WriteFieldBegin(BT_INT64, 4, nullptr);
+                writer.WriteInt64(value);
+                writer.WriteFieldEnd();
+            }
+        }
+
+        void writeGuid(CompactBinaryProtocolWriter& writer, GUID_t const& guid)
+        {
+            uint8_t bytes[16] = { 0 };
+            guid.to_bytes(bytes);
+            writer.WriteContainerBegin(sizeof(bytes), BT_UINT8);
+            writer.WriteBlob(bytes, sizeof(bytes));
+            writer.WriteContainerEnd();
+        }
+
+        /// <summary>
+        /// Opens a single-element list field. EventPropertiesDecorator wraps
+        /// GUID and array values into a list of one element.
+        /// </summary>
+        void writeSingletonListBegin(CompactBinaryProtocolWriter& writer, uint16_t id, uint8_t elementType)
+        {
+            writer.WriteFieldBegin(BT_LIST, id, nullptr);
+            writer.WriteContainerBegin(1, elementType);
+        }
+
+        void writeSingletonListEnd(CompactBinaryProtocolWriter& writer)
+        {
+            writer.WriteContainerEnd();
+            writer.WriteFieldEnd();
+        }
+
+        /// <summary>
+        /// Writes attributes=[{pii=[{Kind}]}] or attributes=[{customerContent=[{Kind}]}].
+        /// </summary>
+        void writePiiAttributes(CompactBinaryProtocolWriter& writer, PiiKind piiKind)
+        {
+            bool customerContent = (piiKind == PiiKind::CustomerContentKind_GenericData);
+            int32_t kind = customerContent ?
+                static_cast<int32_t>(::CsProtocol::CustomerContentKind::GenericContent) :
+                static_cast<int32_t>(piiKind);
+
+            writeSingletonListBegin(writer, 2, BT_STRUCT);
+            writer.WriteStructBegin(nullptr, false);
+            writeSingletonListBegin(writer, customerContent ? 2 : 1, BT_STRUCT);
+            writer.WriteStructBegin(nullptr, false);
+            if (kind != 0)
+            {
+                writer.WriteFieldBegin(BT_INT32, 1, nullptr);
+                writer.WriteInt32(kind);
+                writer.WriteFieldEnd();
+            }
+            writer.WriteStructEnd(false);
+            writeSingletonListEnd(writer);
+            writer.WriteStructEnd(false);
+            writeSingletonListEnd(writer);
+        }
+
+        /// <summary>
+        /// Writes the CsProtocol::Value that EventPropertiesDecorator builds for the property.
+        /// </summary>
+        void writeValue(CompactBinaryProtocolWriter& writer, EventProperty const& v)
+        {
+            writer.WriteStructBegin(nullptr, false);
+
+            if (v.piiKind != PiiKind_None)
+            {
+                writePiiAttributes(writer, v.piiKind);
+                std::string value = v.to_string();
+                writeStringValue(writer, value.data(), value.size());
+                writer.WriteStructEnd(false);
+                return;
+            }
+
+            switch (v.type)
+            {
+            case EventProperty::TYPE_STRING:
+                writeStringValue(writer, v.as_string, strlen(v.as_string));
+                break;
+
+            case EventProperty::TYPE_INT64:
+                writeType(writer, ::CsProtocol::ValueKind::ValueInt64);
+                writeLongValue(writer, v.as_int64);
+                break;
+
+            case EventProperty::TYPE_DOUBLE:
+                writeType(writer, ::CsProtocol::ValueKind::ValueDouble);
+                if (v.as_double != 0.0)
+                {
+                    writer.WriteFieldBegin(BT_DOUBLE, 5, nullptr);
+                    writer.WriteDouble(v.as_double);
+                    writer.WriteFieldEnd();
+                }
+                break;
+
+            case EventProperty::TYPE_TIME:
+                writeType(writer, ::CsProtocol::ValueKind::ValueDateTime);
+                writeLongValue(writer, static_cast<int64_t>(v.as_time_ticks.ticks));
+                break;
+
+            case EventProperty::TYPE_BOOLEAN:
+                writeType(writer, ::CsProtocol::ValueKind::ValueBool);
+                writeLongValue(writer, v.as_bool);
+                break;
+
+            case EventProperty::TYPE_GUID:
+                writeType(writer, ::CsProtocol::ValueKind::ValueGuid);
+                writeSingletonListBegin(writer, 6, BT_LIST);
+                writeGuid(writer, v.as_guid);
+                writeSingletonListEnd(writer);
+                break;
+
+            case EventProperty::TYPE_STRING_ARRAY:
+                writeType(writer, ::CsProtocol::ValueKind::ValueArrayString);
+                writeSingletonListBegin(writer, 10, BT_LIST);
+                writer.WriteContainerBegin(v.as_stringArray->size(), BT_STRING);
+                for (auto const& item : *v.as_stringArray)
+                {
+                    writer.WriteString(item);
+                }
+                writer.WriteContainerEnd();
+                writeSingletonListEnd(writer);
+                break;
+
+            case EventProperty::TYPE_INT64_ARRAY:
+                writeType(writer, ::CsProtocol::ValueKind::ValueArrayInt64);
+                writeSingletonListBegin(writer, 11, BT_LIST);
+                writer.WriteContainerBegin(v.as_longArray->size(), BT_INT64);
+                for (auto item : *v.as_longArray)
+                {
+                    writer.WriteInt64(item);
+                }
+                writer.WriteContainerEnd();
+                writeSingletonListEnd(writer);
+                break;
+
+            case EventProperty::TYPE_DOUBLE_ARRAY:
+                writeType(writer, ::CsProtocol::ValueKind::ValueArrayDouble);
+                writeSingletonListBegin(writer, 12, BT_LIST);
+                writer.WriteContainerBegin(v.as_doubleArray->size(), BT_DOUBLE);
+                for (auto item : *v.as_doubleArray)
+                {
+                    writer.WriteDouble(item);
+                }
+                writer.WriteContainerEnd();
+                writeSingletonListEnd(writer);
+                break;
+
+            case EventProperty::TYPE_GUID_ARRAY:
+                writeType(writer, ::CsProtocol::ValueKind::ValueArrayGuid);
+                writeSingletonListBegin(writer, 13, BT_LIST);
+                writer.WriteContainerBegin(v.as_guidArray->size(), BT_LIST);
+                for (auto const& item : *v.as_guidArray)
+                {
+                    writeGuid(writer, item);
+                }
+                writer.WriteContainerEnd();
+                writeSingletonListEnd(writer);
+                break;
+
+            default:
+            {
+                // Unknown types are sent as string
+                std::string value = v.to_string();
+                writeStringValue(writer, value.data(), value.size());
+                break;
+            }
+            }
+
+            writer.WriteStructEnd(false);
+        }
+
+        /// <summary>
+        /// Writes a CsProtocol::Data struct holding the union of the context
+        /// values and the event properties, in key order. On a key collision
+        /// the event property wins, as in EventPropertiesDecorator.
+        /// </summary>
+        void writeData(CompactBinaryProtocolWriter& writer, ValueMap const* context, PropertyEntries const& entries)
+        {
+            static const ValueMap empty;
+            ValueMap const& values = (context != nullptr) ? *context : empty;
+
+            size_t count = values.size() + entries.size();
+            {
+                auto it = values.cbegin();
+                for (auto entry : entries)
+                {
+                    while (it != values.cend() && it->first < entry->first)
+                    {
+                        ++it;
+                    }
+                    if (it != values.cend() && it->first == entry->first)
+                    {
+                        count--;
+                    }
+                }
+            }
+
+            writer.WriteStructBegin(nullptr, false);
+            if (count != 0)
+            {
+                writer.WriteFieldBegin(BT_MAP, 1, nullptr);
+                writer.WriteMapContainerBegin(count, BT_STRING, BT_STRUCT);
+                auto it = values.cbegin();
+                for (auto entry : entries)
+                {
+                    for (; it != values.cend() && it->first < entry->first; ++it)
+                    {
+                        writer.WriteString(it->first);
+                        bond_lite::Serialize(writer, it->second, false);
+                    }
+                    if (it != values.cend() && it->first == entry->first)
+                    {
+                        ++it;
+                    }
+                    writer.WriteString(entry->first);
+                    writeValue(writer, entry->second);
+                }
+                for (; it != values.cend(); ++it)
+                {
+                    writer.WriteString(it->first);
+                    bond_lite::Serialize(writer, it->second, false);
+                }
+                writer.WriteContainerEnd();
+                writer.WriteFieldEnd();
+            }
+            writer.WriteStructEnd(false);
+        }
+
+    }
+
+    void EventPropertiesBondEncoder::Encode(std::vector<uint8_t>& output, ::CsProtocol::Record const& record, EventProperties const& properties,
+                                            std::vector<uint8_t> const* contextExtensions)
+    {
+        auto const& storage = static_cast<EventPropertiesStorage const*>(properties.m_storage)->properties;
+
+        PropertyEntries partB;
+        PropertyEntries partC;
+        partC.reserve(storage.size());
+        for (auto const& kv : storage)
+        {
+            if (kv.second.dataCategory == DataCategory_PartB)
+            {
+                partB.push_back(&kv);
+            }
+            else if (kv.first != CorrelationVector::PropertyName)
+            {
+                // The correlation vector is carried in record.cV instead
+                partC.push_back(&kv);
+            }
+        }
+        std::sort(partB.begin(), partB.end(), lessByName);
+        std::sort(partC.begin(), partC.end(), lessByName);
+
+        CompactBinaryProtocolWriter writer(output);
+        writer.WriteStructBegin(nullptr, false);
+
+        bond_lite::SerializeRecordEnvelope(writer, record, contextExtensions);
+
+        size_t baseDataCount = record.baseData.size() + (partB.empty() ? 0 : 1);
+        if (baseDataCount != 0)
+        {
+            writer.WriteFieldBegin(BT_LIST, 61, nullptr);
+            writer.WriteContainerBegin(baseDataCount, BT_STRUCT);
+            for (auto const& item : record.baseData)
+            {
+                bond_lite::Serialize(writer, item, false);
+            }
+            if (!partB.empty())
+            {
+                writeData(writer, nullptr, partB);
+            }
+            writer.WriteContainerEnd();
+            writer.WriteFieldEnd();
+        }
+
+        // The decorator always provides data[0] for the context and Part C properties
+        size_t dataCount = std::max<size_t>(record.data.size(), 1);
+        writer.WriteFieldBegin(BT_LIST, 70, nullptr);
+        writer.WriteContainerBegin(dataCount, BT_STRUCT);
+        writeData(writer, record.data.empty() ? nullptr : &record.data[0].properties, partC);
+        for (size_t i = 1; i < record.data.size(); i++)
+        {
+            bond_lite::Serialize(writer, record.data[i], false);
+        }
+        writer.WriteContainerEnd();
+        writer.WriteFieldEnd();
+
+        writer.WriteStructEnd(false);
+    }
+
+} MAT_NS_END
@@ -0,0 +1,36 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include "EventProperties.hpp"
+#include "CsProtocol_types.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace MAT_NS_BEGIN {
+
+/// <summary>
+/// Serializes an event whose Part B and Part C properties were left in the
+/// caller's EventProperties instead of being copied into the record (see
+/// EventPropertiesDecorator::decorate with deferProperties set).
+///
+/// The record supplies the Part A envelope, any baseData entries and the
+/// context properties in data[0]; the event properties are streamed straight
+/// from EventProperties into the Bond blob. The output is byte-identical to
+/// bond_lite::Serialize of the same record after the properties have been
+/// added to it by EventPropertiesDecorator.
+///
+/// contextExtensions optionally supplies the pre-encoded extUser, extDevice,
+/// extOs and extApp fields (see ContextFieldsSnapshot::encodedExtensions).
+/// </summary>
+class EventPropertiesBondEncoder {
+  public:
+    static void Encode(std::vector<uint8_t>& output, ::CsProtocol::Record const& record, EventProperties const& properties,
+                       std::vector<uint8_t> const* contextExtensions = nullptr);
+};
+
+
+} MAT_NS_END
@@ -1627,11 +1627,67 @@ void Serialize(TWriter& writer, ::CsProtocol::Data const& value, bool isBase)
     writer.WriteStructEnd(isBase);
 }
 
+// Writes Record fields extUser (22), extDevice (23), extOs (24) and extApp (25),
+// which are filled from the semantic context. ContextFieldsProvider keeps this
+// fragment pre-encoded.
 template<typename TWriter>
-void Serialize(TWriter& writer, ::CsProtocol::Record const& value, bool isBase)
+void SerializeRecordContextExtensions(TWriter& writer, ::CsProtocol::Record const& value)
 {
-    writer.WriteStructBegin(nullptr, isBase);
+    if (!value.extUser.empty()) {
+        writer.WriteFieldBegin(BT_LIST, 22, nullptr);
+        writer.WriteContainerBegin(value.extUser.size(), BT_STRUCT);
+        for (auto const& item2 : value.extUser) {
+            Serialize(writer, item2, false);
+        }
+        writer.WriteContainerEnd();
+        writer.WriteFieldEnd();
+    } else {
+        writer.WriteFieldOmitted(BT_LIST, 22, nullptr);
+    }
+
+    if (!value.extDevice.empty()) {
+        writer.WriteFieldBegin(BT_LIST, 23, nullptr);
+        writer.WriteContainerBegin(value.extDevice.size(), BT_STRUCT);
+        for (auto const& item2 : value.extDevice) {
+            Serialize(writer, item2, false);
+        }
+        writer.WriteContainerEnd();
+        writer.WriteFieldEnd();
+    } else {
+        writer.WriteFieldOmitted(BT_LIST, 23, nullptr);
+    }
+
+    if (!value.extOs.empty()) {
+        writer.WriteFieldBegin(BT_LIST, 24, nullptr);
+        writer.WriteContainerBegin(value.extOs.size(), BT_STRUCT);
+        for (auto const& item2 : value.extOs) {
+            Serialize(writer, item2, false);
+        }
+        writer.WriteContainerEnd();
+        writer.WriteFieldEnd();
+    } else {
+        writer.WriteFieldOmitted(BT_LIST, 24, nullptr);
+    }
 
+    if (!value.extApp.empty()) {
+        writer.WriteFieldBegin(BT_LIST, 25, nullptr);
+        writer.WriteContainerBegin(value.extApp.size(), BT_STRUCT);
+        for (auto const& item2 : value.extApp) {
+            Serialize(writer, item2, false);
+        }
+        writer.WriteContainerEnd();
+        writer.WriteFieldEnd();
+    } else {
+        writer.WriteFieldOmitted(BT_LIST, 25, nullptr);
+    }
+}
+
+// Writes Record fields up to and including baseType (60), without the struct
+// framing. EventPropertiesBondEncoder appends baseData and data on its own.
+// If contextExtensions is set, it is copied as-is in place of fields 22-25.
+template<typename TWriter>
+void SerializeRecordEnvelope(TWriter& writer, ::CsProtocol::Record const& value, std::vector<uint8_t> const* contextExtensions = nullptr)
+{
     if (!value.ver.empty()) {
         writer.WriteFieldBegin(BT_STRING, 1, nullptr);
         writer.WriteString(value.ver);
@@ -1714,52 +1770,10 @@ void Serialize(TWriter& writer, ::CsProtocol::Record const& value, bool isBase)
         writer.WriteFieldOmitted(BT_LIST, 21, nullptr);
     }
 
-    if (!value.extUser.empty()) {
-        writer.WriteFieldBegin(BT_LIST, 22, nullptr);
-        writer.WriteContainerBegin(value.extUser.size(), BT_STRUCT);
-        for (auto const& item2 : value.extUser) {
-            Serialize(writer, item2, false);
-        }
-        writer.WriteContainerEnd();
-        writer.WriteFieldEnd();
-    } else {
-        writer.WriteFieldOmitted(BT_LIST, 22, nullptr);
-    }
-
-    if (!value.extDevice.empty()) {
-        writer.WriteFieldBegin(BT_LIST, 23, nullptr);
-        writer.WriteContainerBegin(value.extDevice.size(), BT_STRUCT);
-        for (auto const& item2 : value.extDevice) {
-            Serialize(writer, item2, false);
-        }
-        writer.WriteContainerEnd();
-        writer.WriteFieldEnd();
-    } else {
-        writer.WriteFieldOmitted(BT_LIST, 23, nullptr);
-    }
-
-    if (!value.extOs.empty()) {
-        writer.WriteFieldBegin(BT_LIST, 24, nullptr);
-        writer.WriteContainerBegin(value.extOs.size(), BT_STRUCT);
-        for (auto const& item2 : value.extOs) {
-            Serialize(writer, item2, false);
-        }
-        writer.WriteContainerEnd();
-        writer.WriteFieldEnd();
-    } else {
-        writer.WriteFieldOmitted(BT_LIST, 24, nullptr);
-    }
-
-    if (!value.extApp.empty()) {
-        writer.WriteFieldBegin(BT_LIST, 25, nullptr);
-        writer.WriteContainerBegin(value.extApp.size(), BT_STRUCT);
-        for (auto const& item2 : value.extApp) {
-            Serialize(writer, item2, false);
-        }
-        writer.WriteContainerEnd();
-        writer.WriteFieldEnd();
+    if (contextExtensions != nullptr) {
+        writer.WriteBlob(contextExtensions->data(), contextExtensions->size());
     } else {
-        writer.WriteFieldOmitted(BT_LIST, 25, nullptr);
+        SerializeRecordContextExtensions(writer, value);
     }
 
     if (!value.extUtc.empty()) {
@@ -1980,6 +1994,14 @@ void Serialize(TWriter& writer, ::CsProtocol::Record const& value, bool isBase)
     } else {
         writer.WriteFieldOmitted(BT_STRING, 60, nullptr);
     }
+}
+
+template<typename TWriter>
+void Serialize(TWriter& writer, ::CsProtocol::Record const& value, bool isBase, std::vector<uint8_t> const* contextExtensions)
+{
+    writer.WriteStructBegin(nullptr, isBase);
+
+    SerializeRecordEnvelope(writer, value, contextExtensions);
 
     if (!value.baseData.empty()) {
         writer.WriteFieldBegin(BT_LIST, 61, nullptr);
@@ -2008,5 +2030,11 @@ void Serialize(TWriter& writer, ::CsProtocol::Record const& value, bool isBase)
     writer.WriteStructEnd(isBase);
 }
 
+template<typename TWriter>
+void Serialize(TWriter& writer, ::CsProtocol::Record const& value, bool isBase)
+{
+    Serialize(writer, value, isBase, nullptr);
+}
+
 } // namespace bond_lite
 
@@ -8,61 +8,271 @@
 #include "pal/PAL.hpp"
 
 #include <atomic>
+#include <mutex>
+#include <thread>
 
 namespace MAT_NS_BEGIN {
 
+    namespace {
+
+        /// <summary>
+        /// Immutable copy of a source's listeners and cascaded sources. Writers replace it
+        /// as a whole, so DispatchEvent can walk it without holding stateLock().
+        /// </summary>
+        struct ListenerSnapshot
+        {
+            std::map<unsigned, std::vector<DebugEventListener*> > listeners;
+            std::vector<DebugEventSource*> cascaded;
+        };
+
+        /// <summary>
+        /// Bit of the event type in the "has listeners" mask. Types sharing a bit
+        /// only cost a snapshot lookup that finds no listener.
+        /// </summary>
+        uint64_t typeBit(unsigned type)
+        {
+            return uint64_t { 1 } << ((type * 0x9E3779B97F4A7C15ull) >> 58);
+        }
+
+        /// <summary>Number of DispatchEvent calls on the stack of the calling thread.</summary>
+        unsigned& dispatchDepth()
+        {
+            static thread_local unsigned depth = 0;
+            return depth;
+        }
+
+    }
+
+    struct DebugEventSource::DispatchState
+    {
+        /// <summary>
+        /// Types with a listener on this source or on any source cascaded from it.
+        /// DispatchEvent returns straight away for types that are not in the mask.
+        /// </summary>
+        std::atomic<uint64_t> typeMask { 0 };
+
+        std::atomic<ListenerSnapshot const*> current { nullptr };
+
+        std::atomic<uint64_t> seq { 0 };
+
+        /// <summary>
+        /// DispatchEvent calls reading a snapshot, counted under the parity of the epoch
+        /// they started in. synchronize() flips the epoch and waits for the old parity to
+        /// drain, so a steady stream of new dispatches cannot hold it up.
+        /// </summary>
+        std::atomic<unsigned> epoch { 0 };
+        std::atomic<unsigned> readers[2];
+
+        /// <summary>Serializes synchronize() calls.</summary>
+        std::mutex graceLock;
+
+        /// <summary>Sources this one is attached to, whose masks include ours. Guarded by stateLock().</summary>
+        std::vector<DebugEventSource*> parents;
+
+        /// <summary>Replaced snapshots that a reader may still be walking. Guarded by stateLock().</summary>
+        std::vector<std::unique_ptr<ListenerSnapshot const>> retired;
+
+        DispatchState()
+        {
+            readers[0].store(0);
+            readers[1].store(0);
+        }
+
+        ~DispatchState()
+        {
+            delete current.load();
+        }
+
+        /// <summary>
+        /// Waits until the dispatches that may have read a replaced snapshot are done:
+        /// afterwards no dispatch can still call a removed listener. Must not be called
+        /// under stateLock(), listeners may take it. A listener cannot wait for the dispatch
+        /// that is calling it, so within a dispatch this returns straight away.
+        /// </summary>
+        void synchronize()
+        {
+            if (dispatchDepth() != 0)
+            {
+                return;
+            }
+            std::lock_guard<std::mutex> guard(graceLock);
+            unsigned parity = epoch.fetch_add(1) & 1;
+            while (readers[parity].load() != 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        /// <summary>Frees the retired snapshots if no dispatch is reading any. Called under stateLock().</summary>
+        void reclaim()
+        {
+            if (readers[0].load() == 0 && readers[1].load() == 0)
+            {
+                retired.clear();
+            }
+        }
+    };
+
+    namespace {
+
+        /// <summary>
+        /// Counts a dispatch as a reader for its duration, also when a listener throws.
+        /// </summary>
+        class DispatchReader
+        {
+        public:
+            explicit DispatchReader(std::atomic<unsigned> (&readers)[2], std::atomic<unsigned>& epoch) :
+                m_readers(readers[epoch.load() & 1])
+            {
+                m_readers.fetch_add(1);
+                ++dispatchDepth();
+            }
+
+            ~DispatchReader()
+            {
+                --dispatchDepth();
+                m_readers.fetch_sub(1);
+            }
+
+            DispatchReader(DispatchReader const&) = delete;
+            DispatchReader& operator=(DispatchReader const&) = delete;
+
+        private:
+            std::atomic<unsigned>& m_readers;
+        };
+
+    }
+
+    DebugEventSource::DebugEventSource() :
+        dispatchState(new DispatchState())
+    {
+        // Constructs the lock before any static source, so that it outlives them
+        DE_LOCKGUARD(stateLock());
+    }
+
+    DebugEventSource::~DebugEventSource() noexcept
+    {
+        std::vector<DebugEventSource*> parents;
+        {
+            DE_LOCKGUARD(stateLock());
+            for (auto child : cascaded)
+            {
+                auto& childParents = child->dispatchState->parents;
+                childParents.erase(std::remove(childParents.begin(), childParents.end(), this), childParents.end());
+            }
+            parents = dispatchState->parents;
+        }
+        // Parents must stop forwarding to this source before it goes away
+        for (auto parent : parents)
+        {
+            parent->DetachEventSource(*this);
+        }
+    }
+
+    uint64_t DebugEventSource::lastSeq() const
+    {
+        return dispatchState->seq.load();
+    }
+
+    void DebugEventSource::publish()
+    {
+        DispatchState& state = *dispatchState;
+        std::unique_ptr<ListenerSnapshot> snapshot(new ListenerSnapshot());
+        uint64_t ownMask = 0;
+        for (auto const& entry : listeners)
+        {
+            if (!entry.second.empty())
+            {
+                snapshot->listeners.insert(entry);
+                ownMask |= typeBit(entry.first);
+            }
+        }
+        uint64_t mask = ownMask;
+        for (auto child : cascaded)
+        {
+            snapshot->cascaded.push_back(child);
+            mask |= child->dispatchState->typeMask.load();
+        }
+
+        // Snapshot first: a reader that sees a new bit must find its listener
+        state.retired.emplace_back(state.current.exchange(snapshot.release()));
+        uint64_t previous = state.typeMask.exchange(mask);
+        if (previous != mask)
+        {
+            for (auto parent : state.parents)
+            {
+                parent->publish();
+            }
+        }
+    }
+
     /// <summary>Add event listener for specific debug event type.</summary>
     void DebugEventSource::AddEventListener(DebugEventType type, DebugEventListener &listener)
     {
         DE_LOCKGUARD(stateLock());
         auto &v = listeners[type];
         v.push_back(&listener);
+        publish();
+        dispatchState->reclaim();
     }
 
     /// <summary>Remove previously added debug event listener for specific type.</summary>
     void DebugEventSource::RemoveEventListener(DebugEventType type, DebugEventListener &listener)
     {
-        DE_LOCKGUARD(stateLock());
-        auto registeredTypes = listeners.find(type);
-        if (registeredTypes == listeners.end())
-            return;
+        {
+            DE_LOCKGUARD(stateLock());
+            auto registeredTypes = listeners.find(type);
+            if (registeredTypes == listeners.end())
+                return;
 
-        auto &registeredListeners = (*registeredTypes).second;
-        auto it = std::remove(registeredListeners.begin(), registeredListeners.end(), &listener);
-        registeredListeners.erase(it, registeredListeners.end());
+            auto &registeredListeners = (*registeredTypes).second;
+            auto it = std::remove(registeredListeners.begin(), registeredListeners.end(), &listener);
+            registeredListeners.erase(it, registeredListeners.end());
+            publish();
+        }
+        // The caller may destroy the listener once this returns
+        dispatchState->synchronize();
+        DE_LOCKGUARD(stateLock());
+        dispatchState->reclaim();
     }
 
     /// <summary>Microsoft Telemetry SDK invokes this method to dispatch event to client callback</summary>
     bool DebugEventSource::DispatchEvent(DebugEvent evt)
     {
+        DispatchState& state = *dispatchState;
+        if ((state.typeMask.load(std::memory_order_acquire) & typeBit(evt.type)) == 0)
+        {
+            // Nobody listens to this type here or downstream
+            return false;
+        }
+
         evt.ts = PAL::getUtcSystemTime();
+        evt.seq = ++state.seq;
         bool dispatched = false;
-                
+
+        DispatchReader reader(state.readers, state.epoch);
+        ListenerSnapshot const* snapshot = state.current.load();
+        if (snapshot == nullptr)
         {
-            DE_LOCKGUARD(stateLock());
-            seq++;
-            evt.seq = seq;
-
-            if (listeners.size()) {
-                // Events filter handlers list
-                auto &v = listeners[evt.type];
-                for (auto listener : v) {
-                    listener->OnDebugEvent(evt);
-                    dispatched = true;
-                }
-            }
+            return false;
+        }
 
-            if (cascaded.size())
-            {
-                // Cascade event to all other attached sources
-                for (auto item : cascaded)
-                {
-                    if (item)
-                        item->DispatchEvent(evt);
-                }
+        // Events filter handlers list
+        auto registered = snapshot->listeners.find(evt.type);
+        if (registered != snapshot->listeners.end())
+        {
+            for (auto listener : registered->second) {
+                listener->OnDebugEvent(evt);
+                dispatched = true;
             }
         }
 
+        // Cascade event to all other attached sources
+        for (auto item : snapshot->cascaded)
+        {
+            item->DispatchEvent(evt);
+        }
+
         return dispatched;
     }
 
@@ -73,16 +283,31 @@ namespace MAT_NS_BEGIN {
            return false;
 
         DE_LOCKGUARD(stateLock());
-        cascaded.insert(&other);
+        if (cascaded.insert(&other).second)
+        {
+            other.dispatchState->parents.push_back(this);
+            publish();
+            dispatchState->reclaim();
+        }
         return true;
     }
 
     /// <summary>Detach cascaded DebugEventSource to forward all events to</summary>
     bool DebugEventSource::DetachEventSource(DebugEventSource & other)
     {
+        {
+            DE_LOCKGUARD(stateLock());
+            if (cascaded.erase(&other) == 0)
+                return false;
+
+            auto& parents = other.dispatchState->parents;
+            parents.erase(std::remove(parents.begin(), parents.end(), this), parents.end());
+            publish();
+        }
+        dispatchState->synchronize();
         DE_LOCKGUARD(stateLock());
-        return (cascaded.erase(&other)!=0);
+        dispatchState->reclaim();
+        return true;
     }
 
 } MAT_NS_END
-
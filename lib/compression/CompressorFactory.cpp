@@ -0,0 +1,27 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+
+#include "CompressorFactory.hpp"
+#include "DeflateCompressor.hpp"
+#include "ZstdCompressor.hpp"
+#include "pal/PAL.hpp"
+
+namespace MAT_NS_BEGIN
+{
+    std::unique_ptr<ICompressor> CompressorFactory::Create(IRuntimeConfig& runtimeConfig)
+    {
+        if (runtimeConfig.GetHttpRequestContentEncoding() == "zstd")
+        {
+#ifdef HAVE_MAT_ZSTD
+            return std::unique_ptr<ICompressor>(new ZstdCompressor(runtimeConfig));
+#else
+            LOG_WARN("zstd compression is not available in this build, using deflate");
+#endif
+        }
+        return std::unique_ptr<ICompressor>(new DeflateCompressor(runtimeConfig));
+    }
+}
+MAT_NS_END
@@ -0,0 +1,27 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef COMPRESSORFACTORY_HPP
+#define COMPRESSORFACTORY_HPP
+
+#include "ICompressor.hpp"
+#include "api/IRuntimeConfig.hpp"
+
+#include <memory>
+
+namespace MAT_NS_BEGIN
+{
+    class CompressorFactory
+    {
+       public:
+        /// <summary>
+        /// Creates the compressor for CFG_STR_HTTP_CONTENT_ENCODING. "zstd"
+        /// falls back to "deflate" in builds without zstd support.
+        /// </summary>
+        static std::unique_ptr<ICompressor> Create(IRuntimeConfig& runtimeConfig);
+    };
+}
+MAT_NS_END
+
+#endif  // COMPRESSORFACTORY_HPP
@@ -0,0 +1,42 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "DeflateCompressor.hpp"
+
+namespace MAT_NS_BEGIN {
+
+    DeflateCompressor::DeflateCompressor(IRuntimeConfig& config) :
+        m_settings(DeflateSettings::FromConfig(config))
+    {
+    }
+
+    char const* DeflateCompressor::getContentEncoding() const noexcept
+    {
+        if (m_settings.dictionary != nullptr)
+        {
+            return "deflate-dict";
+        }
+        return (m_settings.windowBits > 15) ? "gzip" : "deflate";
+    }
+
+    bool DeflateCompressor::compress(std::vector<BlobView>&& input, size_t size, std::vector<uint8_t>& output)
+    {
+        std::unique_ptr<DeflateStream> stream = DeflateStream::Acquire();
+        bool result = stream->begin(m_settings, output, size) && stream->write(std::move(input)) && stream->finish();
+        if (!result)
+        {
+            char const* message = stream->lastMessage();
+            m_lastError = "zlib error " + std::to_string(stream->lastError()) + " (" + (message ? message : "") + ")";
+        }
+        DeflateStream::Release(std::move(stream));
+        return result;
+    }
+
+    std::string DeflateCompressor::getLastError() const
+    {
+        return m_lastError;
+    }
+
+} MAT_NS_END
@@ -0,0 +1,29 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include "ICompressor.hpp"
+#include "DeflateStream.hpp"
+
+namespace MAT_NS_BEGIN {
+
+    /// <summary>
+    /// "deflate", "gzip" and "deflate-dict" request compression with zlib.
+    /// </summary>
+    class DeflateCompressor : public ICompressor
+    {
+    public:
+        DeflateCompressor(IRuntimeConfig& config);
+
+        char const* getContentEncoding() const noexcept override;
+        bool compress(std::vector<BlobView>&& input, size_t size, std::vector<uint8_t>& output) override;
+        std::string getLastError() const override;
+
+    protected:
+        DeflateSettings m_settings;
+        std::string     m_lastError;
+    };
+
+} MAT_NS_END
@@ -0,0 +1,289 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+
+#include "DeflateStream.hpp"
+#include "PresetDictionary.hpp"
+#include "ILogConfiguration.hpp"
+#ifdef HAVE_MAT_ZLIB
+#define ZLIB_CONST
+#include <zlib.h>
+#else
+struct z_stream_s {};
+#endif
+
+#include <cstring>
+
+namespace MAT_NS_BEGIN {
+
+    namespace {
+
+        // One idle stream per thread: uploads are packaged and compressed
+        // synchronously on the thread that retrieved the records.
+        constexpr size_t MaxCachedStreams = 1;
+
+        std::vector<std::unique_ptr<DeflateStream>>& GetThreadCache()
+        {
+            static thread_local std::vector<std::unique_ptr<DeflateStream>> cache;
+            return cache;
+        }
+
+#ifdef HAVE_MAT_ZLIB
+        int parseStrategy(std::string const& name)
+        {
+            if (name == "filtered")
+                return Z_FILTERED;
+            if (name == "huffman")
+                return Z_HUFFMAN_ONLY;
+            if (name == "rle")
+                return Z_RLE;
+            if (name == "fixed")
+                return Z_FIXED;
+            return Z_DEFAULT_STRATEGY;
+        }
+#endif
+
+    }
+
+    DeflateSettings DeflateSettings::FromConfig(IRuntimeConfig& config)
+    {
+        DeflateSettings settings { 0, 0, 0, nullptr };
+#ifdef HAVE_MAT_ZLIB
+        settings.level = Z_DEFAULT_COMPRESSION;
+        settings.strategy = Z_DEFAULT_STRATEGY;
+        // Plain "deflate": negative -MAX_WBITS argument which makes zlib use "raw deflate"
+        // without zlib header, as required by IIS.
+        // "gzip": Add 16 to windowBits to write a simple gzip header
+        // "deflate-dict": zlib header, which carries the Adler-32 of the preset dictionary
+        std::string const& encoding = config.GetHttpRequestContentEncoding();
+        if (encoding == "gzip")
+        {
+            settings.windowBits = MAX_WBITS | 16;
+        }
+        else if (encoding == "deflate-dict")
+        {
+            settings.windowBits = MAX_WBITS;
+            settings.dictionary = &PresetDictionary::CsProtocol();
+        }
+        else
+        {
+            settings.windowBits = -MAX_WBITS;
+        }
+
+        VariantMap& http = config[CFG_MAP_HTTP];
+        auto it = http.find(CFG_INT_HTTP_COMPRESSION_LEVEL);
+        if (it != http.end() && it->second.type == Variant::TYPE_INT)
+        {
+            int64_t level = it->second;
+            if (level >= Z_NO_COMPRESSION && level <= Z_BEST_COMPRESSION)
+            {
+                settings.level = static_cast<int>(level);
+            }
+        }
+        it = http.find(CFG_STR_HTTP_COMPRESSION_STRATEGY);
+        if (it != http.end())
+        {
+            const char* strategy = it->second;
+            if (strategy != nullptr)
+            {
+                settings.strategy = parseStrategy(strategy);
+            }
+        }
+#else
+        UNREFERENCED_PARAMETER(config);
+#endif
+        return settings;
+    }
+
+    DeflateStream::DeflateStream() :
+        m_stream(new z_stream_s()),
+        m_initialized(false),
+        m_settings { 0, 0, 0, nullptr },
+        m_output(nullptr),
+        m_lastError(0),
+        m_lastMessage(nullptr)
+    {
+    }
+
+    DeflateStream::~DeflateStream()
+    {
+#ifdef HAVE_MAT_ZLIB
+        if (m_initialized)
+        {
+            deflateEnd(m_stream.get());
+        }
+#endif
+    }
+
+    std::unique_ptr<DeflateStream> DeflateStream::Acquire()
+    {
+        auto& cache = GetThreadCache();
+        if (cache.empty())
+        {
+            return std::unique_ptr<DeflateStream>(new DeflateStream());
+        }
+        std::unique_ptr<DeflateStream> stream = std::move(cache.back());
+        cache.pop_back();
+        return stream;
+    }
+
+    void DeflateStream::Release(std::unique_ptr<DeflateStream>&& stream)
+    {
+        std::unique_ptr<DeflateStream> released = std::move(stream);
+        auto& cache = GetThreadCache();
+        if (released && !released->active() && released->m_initialized && cache.size() < MaxCachedStreams)
+        {
+            cache.push_back(std::move(released));
+        }
+    }
+
+    bool DeflateStream::begin(DeflateSettings const& settings, std::vector<uint8_t>& output, size_t sizeHint)
+    {
+#ifdef HAVE_MAT_ZLIB
+        int result;
+        if (m_initialized && m_settings == settings)
+        {
+            result = deflateReset(m_stream.get());
+        }
+        else
+        {
+            if (m_initialized)
+            {
+                deflateEnd(m_stream.get());
+                m_initialized = false;
+            }
+            memset(m_stream.get(), 0, sizeof(z_stream));
+            result = deflateInit2(m_stream.get(), settings.level, Z_DEFLATED, settings.windowBits, 8 /*DEF_MEM_LEVEL*/, settings.strategy);
+            m_initialized = (result == Z_OK);
+            m_settings = settings;
+        }
+        if (result == Z_OK && settings.dictionary != nullptr)
+        {
+            // Has to be set again after every deflateReset
+            result = deflateSetDictionary(m_stream.get(), settings.dictionary->data(), static_cast<uInt>(settings.dictionary->size()));
+        }
+        if (result != Z_OK)
+        {
+            fail(result);
+            return false;
+        }
+
+        // Telemetry compresses well: start from a quarter of the input
+        m_output = &output;
+        output.resize(sizeHint / 4 + 1024);
+        m_stream->next_out = output.data();
+        m_stream->avail_out = static_cast<uInt>(output.size());
+        return true;
+#else
+        UNREFERENCED_PARAMETER(settings);
+        UNREFERENCED_PARAMETER(output);
+        UNREFERENCED_PARAMETER(sizeHint);
+        return false;
+#endif
+    }
+
+    bool DeflateStream::write(uint8_t const* data, size_t size)
+    {
+        if (!active())
+        {
+            return false;
+        }
+        if (size == 0)
+        {
+            return true;
+        }
+#ifdef HAVE_MAT_ZLIB
+        m_stream->next_in = data;
+        m_stream->avail_in = static_cast<uInt>(size);
+        return deflateInto(Z_NO_FLUSH);
+#else
+        UNREFERENCED_PARAMETER(data);
+        return false;
+#endif
+    }
+
+    bool DeflateStream::write(std::vector<BlobView>&& views)
+    {
+        std::vector<BlobView> consumed = std::move(views);
+        for (BlobView& view : consumed)
+        {
+            if (!write(view.data(), view.length))
+            {
+                return false;
+            }
+            view.blob.reset();
+        }
+        return true;
+    }
+
+    bool DeflateStream::finish()
+    {
+        if (!active())
+        {
+            return false;
+        }
+#ifdef HAVE_MAT_ZLIB
+        if (!deflateInto(Z_FINISH))
+        {
+            return false;
+        }
+        m_output->resize(static_cast<size_t>(m_stream->total_out));
+        m_output = nullptr;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool DeflateStream::deflateInto(int flush)
+    {
+#ifdef HAVE_MAT_ZLIB
+        z_stream& stream = *m_stream;
+        for (;;)
+        {
+            if (stream.avail_out == 0)
+            {
+                size_t used = m_output->size();
+                m_output->resize(used * 2);
+                stream.next_out = m_output->data() + used;
+                stream.avail_out = static_cast<uInt>(m_output->size() - used);
+            }
+            int result = deflate(&stream, flush);
+            if (result == Z_STREAM_END)
+            {
+                return true;
+            }
+            if (result != Z_OK)
+            {
+                fail(result);
+                return false;
+            }
+            if (flush == Z_NO_FLUSH && stream.avail_in == 0)
+            {
+                return true;
+            }
+        }
+#else
+        UNREFERENCED_PARAMETER(flush);
+        return false;
+#endif
+    }
+
+    void DeflateStream::fail(int result)
+    {
+        m_lastError = result;
+        m_output = nullptr;
+#ifdef HAVE_MAT_ZLIB
+        m_lastMessage = m_stream->msg;
+        // Start over with a fresh deflateInit2 next time
+        if (m_initialized)
+        {
+            deflateEnd(m_stream.get());
+            m_initialized = false;
+        }
+#endif
+    }
+
+} MAT_NS_END
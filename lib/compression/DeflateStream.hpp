@@ -0,0 +1,122 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include "ctmacros.hpp"
+#include "api/IRuntimeConfig.hpp"
+#include "utils/ScatterGatherBuffer.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct z_stream_s;
+
+namespace MAT_NS_BEGIN {
+
+    /// <summary>
+    /// zlib parameters of the HTTP request compression.
+    /// </summary>
+    struct DeflateSettings
+    {
+        int level;
+        int windowBits;
+        int strategy;
+        // Preset dictionary, set for the "deflate-dict" content encoding
+        std::vector<uint8_t> const* dictionary;
+
+        bool operator==(DeflateSettings const& other) const
+        {
+            return level == other.level && windowBits == other.windowBits && strategy == other.strategy &&
+                   dictionary == other.dictionary;
+        }
+
+        /// <summary>
+        /// Reads CFG_STR_HTTP_CONTENT_ENCODING, CFG_INT_HTTP_COMPRESSION_LEVEL and
+        /// CFG_STR_HTTP_COMPRESSION_STRATEGY from the HTTP configuration map.
+        /// Missing or invalid values fall back to the zlib defaults.
+        /// </summary>
+        static DeflateSettings FromConfig(IRuntimeConfig& config);
+    };
+
+    /// <summary>
+    /// Deflate stream writing into a growing output vector. Streams are
+    /// recycled per thread through Acquire/Release: a released stream keeps
+    /// its zlib state and the next begin() with the same settings only does
+    /// a deflateReset instead of a full deflateInit2/deflateEnd cycle.
+    /// </summary>
+    class DeflateStream
+    {
+    public:
+        DeflateStream();
+        ~DeflateStream();
+        DeflateStream(DeflateStream const&) = delete;
+        DeflateStream& operator=(DeflateStream const&) = delete;
+
+        /// <summary>
+        /// Returns a stream from the calling thread's cache, or a new one.
+        /// </summary>
+        static std::unique_ptr<DeflateStream> Acquire();
+
+        /// <summary>
+        /// Returns the stream to the calling thread's cache for reuse.
+        /// </summary>
+        static void Release(std::unique_ptr<DeflateStream>&& stream);
+
+        /// <summary>
+        /// Starts a new compressed stream into output, which is cleared.
+        /// sizeHint is the expected input size, used to presize the output.
+        /// </summary>
+        bool begin(DeflateSettings const& settings, std::vector<uint8_t>& output, size_t sizeHint);
+
+        /// <summary>
+        /// Compresses the next input bytes without flushing.
+        /// </summary>
+        bool write(uint8_t const* data, size_t size);
+
+        /// <summary>
+        /// Compresses the views, releasing each blob once it is consumed.
+        /// </summary>
+        bool write(std::vector<BlobView>&& views);
+
+        /// <summary>
+        /// Flushes the stream and trims the output to the compressed size.
+        /// </summary>
+        bool finish();
+
+        /// <summary>
+        /// True between a successful begin() and finish() or a failure.
+        /// </summary>
+        bool active() const noexcept
+        {
+            return m_output != nullptr;
+        }
+
+        /// <summary>
+        /// zlib result and message of the last failure, for logging.
+        /// </summary>
+        int lastError() const noexcept
+        {
+            return m_lastError;
+        }
+
+        char const* lastMessage() const noexcept
+        {
+            return m_lastMessage;
+        }
+
+    protected:
+        bool deflateInto(int flush);
+        void fail(int result);
+
+        std::unique_ptr<z_stream_s> m_stream;
+        bool                        m_initialized;
+        DeflateSettings             m_settings;
+        std::vector<uint8_t>*       m_output;
+        int                         m_lastError;
+        char const*                 m_lastMessage;
+    };
+
+} MAT_NS_END
@@ -5,23 +5,15 @@
 #include "mat/config.h"
 
 #include "HttpDeflateCompression.hpp"
+#include "CompressorFactory.hpp"
 #include "utils/Utils.hpp"
-#ifdef HAVE_MAT_ZLIB
-#define ZLIB_CONST
-#include <zlib.h>
-#endif
 
 namespace MAT_NS_BEGIN {
 
     HttpDeflateCompression::HttpDeflateCompression(IRuntimeConfig& runtimeConfig)
-        : m_config(runtimeConfig)
+        : m_config(runtimeConfig),
+          m_compressor(CompressorFactory::Create(runtimeConfig))
     {
-        // Plain "deflate": negative -MAX_WBITS argument which makes zlib use "raw deflate"
-        // without zlib header, as required by IIS.
-        // "gzip": Add 16 to windowBits to write a simple gzip header
-#ifdef HAVE_MAT_ZLIB
-        m_windowBits = m_config.GetHttpRequestContentEncoding() == "gzip" ? (MAX_WBITS | 16) : -MAX_WBITS;
-#endif
     }
 
     HttpDeflateCompression::~HttpDeflateCompression()
@@ -32,65 +24,66 @@ namespace MAT_NS_BEGIN {
     {
         UNREFERENCED_PARAMETER(ctx);
 #ifdef HAVE_MAT_ZLIB
+        if (ctx->deflate) {
+            return finishStreamingBody(ctx);
+        }
+
         if (!m_config.IsHttpRequestCompressionEnabled()) {
             return true;
         }
 
-        // Using a slightly adapted in-place compression technique as suggested
-        // by Mark Adler himself: http://stackoverflow.com/a/12412863/3543211
-
-        z_stream stream;
-        memset(&stream, 0, sizeof(stream));
+        if (ctx->splicedBody.empty() && !ctx->body.empty()) {
+            // A body built in one piece is compressed as a single view
+            auto body = std::make_shared<const std::vector<uint8_t>>(std::move(ctx->body));
+            ctx->body.clear();
+            ctx->splicedBody.append(BlobView { body, 0, body->size() });
+        }
+        return compressSplicedBody(ctx);
+#else
+        return true;
+#endif
+    }
 
-        int result = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, m_windowBits, 8 /*DEF_MEM_LEVEL*/, Z_DEFAULT_STRATEGY);
-        if (result != Z_OK) {
-            LOG_WARN("HTTP request compressing failed, error=%u/%u (%s)", 1, result, stream.msg);
+    /// <summary>
+    /// Compresses the spliced record views straight into ctx->body, so the
+    /// uncompressed payload never exists as one contiguous buffer. Input
+    /// chunks are released as soon as they are consumed and the output grows
+    /// on demand, which keeps the peak close to a single copy of the payload.
+    /// </summary>
+    bool HttpDeflateCompression::compressSplicedBody(EventsUploadContextPtr const& ctx)
+    {
+        size_t size = ctx->splicedBody.size();
+        if (!m_compressor->compress(ctx->splicedBody.take(), size, ctx->body)) {
+            LOG_WARN("HTTP request compressing failed, %s", m_compressor->getLastError().c_str());
             compressionFailed(ctx);
             return false;
         }
 
-        stream.avail_in = static_cast<uInt>(ctx->body.size());
-        ctx->body.resize(deflateBound(&stream, stream.avail_in));
-        stream.next_in = ctx->body.data();
-
-        std::vector<uint8_t> temp(32);
-        stream.next_out = temp.data();
-        stream.avail_out = static_cast<uInt>(temp.size());
-
-        result = deflate(&stream, Z_FINISH);
-        if (result == Z_OK || result == Z_STREAM_END) {
-            std::copy(temp.cbegin(), temp.cbegin() + stream.total_out, ctx->body.begin());
-            stream.next_out = ctx->body.data() + stream.total_out;
-            stream.avail_out = static_cast<uInt>(ctx->body.size()) - static_cast<uInt>(stream.total_out);
-        }
-        if (result == Z_OK) {
-            result = deflate(&stream, Z_FINISH);
-            if (result == Z_OK) {
-                // The output shall never catch up with the input. Mark says in the
-                // Stack Overflow reference above that this should happen only for
-                // incompressible data longer than 20 MB, i.e. virtually never for
-                // telemetry events in Bond. But better make it 100% safe here.
-                temp.assign(ctx->body.cbegin() + stream.total_in, ctx->body.cbegin() + stream.total_in + stream.avail_in);
-                stream.next_in = temp.data();
-                stream.avail_in = static_cast<uInt>(temp.size());
-                result = deflate(&stream, Z_FINISH);
-            }
-        }
-
-        deflateEnd(&stream);
+        ctx->compressed = true;
+        ctx->contentEncoding = m_compressor->getContentEncoding();
+        return true;
+    }
 
-        if (result != Z_STREAM_END) {
-            LOG_WARN("HTTP request compressing failed, error=%u/%u (%s)", 2, result, stream.msg);
+    /// <summary>
+    /// Completes a body that Packager compressed record by record while the
+    /// records were being read from storage (CFG_BOOL_HTTP_STREAMING_COMPRESSION).
+    /// </summary>
+    bool HttpDeflateCompression::finishStreamingBody(EventsUploadContextPtr const& ctx)
+    {
+        std::unique_ptr<DeflateStream> stream = std::move(ctx->deflate);
+        bool result = stream->finish();
+        if (!result) {
+            LOG_WARN("HTTP request compressing failed, error=%u/%u (%s)", 2, stream->lastError(), stream->lastMessage());
+            DeflateStream::Release(std::move(stream));
             compressionFailed(ctx);
             return false;
         }
 
-        ctx->body.resize(stream.total_out);
+        DeflateStream::Release(std::move(stream));
         ctx->compressed = true;
-#endif
+        ctx->contentEncoding = m_compressor->getContentEncoding();
         return true;
     }
 
 
 } MAT_NS_END
-
@@ -6,12 +6,19 @@
 #pragma once
 #include "ctmacros.hpp"
 #include "api/IRuntimeConfig.hpp"
+#include "compression/DeflateStream.hpp"
+#include "compression/ICompressor.hpp"
 #include "system/Route.hpp"
 #include "system/Contexts.hpp"
 
 namespace MAT_NS_BEGIN {
 
 
+    /// <summary>
+    /// Compresses upload bodies with the ICompressor selected by
+    /// CFG_STR_HTTP_CONTENT_ENCODING, or finishes the deflate stream of a
+    /// package compressed by Packager in streaming mode.
+    /// </summary>
     class HttpDeflateCompression {
     public:
         HttpDeflateCompression(IRuntimeConfig& runtimeConfig);
@@ -19,10 +26,12 @@ namespace MAT_NS_BEGIN {
 
     protected:
         bool handleCompress(EventsUploadContextPtr const& ctx);
+        bool compressSplicedBody(EventsUploadContextPtr const& ctx);
+        bool finishStreamingBody(EventsUploadContextPtr const& ctx);
 
     protected:
         IRuntimeConfig& m_config;
-        int m_windowBits;
+        std::unique_ptr<ICompressor> m_compressor;
 
     public:
         RouteSource<EventsUploadContextPtr const&>                              compressionFailed;
@@ -0,0 +1,41 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include "ctmacros.hpp"
+#include "utils/ScatterGatherBuffer.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MAT_NS_BEGIN {
+
+    /// <summary>
+    /// Upload body compression format, see CompressorFactory.
+    /// </summary>
+    class ICompressor
+    {
+    public:
+        virtual ~ICompressor() noexcept = default;
+
+        /// <summary>
+        /// Value of the Content-Encoding header for the compressed body.
+        /// </summary>
+        virtual char const* getContentEncoding() const noexcept = 0;
+
+        /// <summary>
+        /// Compresses the views, size bytes in total, into output. Each blob
+        /// is released as soon as it has been consumed.
+        /// </summary>
+        virtual bool compress(std::vector<BlobView>&& input, size_t size, std::vector<uint8_t>& output) = 0;
+
+        /// <summary>
+        /// Description of the last failure, for logging.
+        /// </summary>
+        virtual std::string getLastError() const = 0;
+    };
+
+} MAT_NS_END
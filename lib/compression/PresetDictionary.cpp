@@ -0,0 +1,142 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "PresetDictionary.hpp"
+#include "CommonFields.h"
+#include "bond/All.hpp"
+#include "bond/generated/CsProtocol_writers.hpp"
+
+#include <cstring>
+#include <string>
+
+namespace MAT_NS_BEGIN {
+
+    namespace {
+
+        // Least frequent first: deflate encodes matches near the end of the
+        // dictionary with shorter distances.
+        char const* const WellKnownStrings[] = {
+            COMMONFIELDS_METADATA_VIEWINGPRODUCERID,
+            COMMONFIELDS_METADATA_VIEWINGCATEGORY,
+            COMMONFIELDS_METADATA_VIEWINGPAYLOADDECODERPATH,
+            COMMONFIELDS_METADATA_VIEWINGPAYLOADENCODEDFIELDNAME,
+            COMMONFIELDS_PIPELINEINFO_ACCOUNT,
+            COMMONFIELDS_COMMERCIAL_ID,
+            COMMONFIELDS_USER_MSAID,
+            COMMONFIELDS_USER_ANID,
+            COMMONFIELDS_USER_ADVERTISINGID,
+            COMMONFIELDS_USER_TIMEZONE,
+            COMMONFIELDS_USER_LANGUAGE,
+            COMMONFIELDS_USER_ID,
+            COMMONFIELDS_DEVICE_ORGID,
+            COMMONFIELDS_DEVICE_CLASS,
+            COMMONFIELDS_DEVICE_MAKE,
+            COMMONFIELDS_DEVICE_MODEL,
+            COMMONFIELDS_DEVICE_ID,
+            COMMONFIELDS_NETWORK_PROVIDER,
+            COMMONFIELDS_NETWORK_TYPE,
+            COMMONFIELDS_NETWORK_COST,
+            COMMONFIELDS_OS_NAME,
+            COMMONFIELDS_OS_VERSION,
+            COMMONFIELDS_OS_BUILD,
+            COMMONFIELDS_APP_ENV,
+            COMMONFIELDS_APP_NAME,
+            COMMONFIELDS_APP_VERSION,
+            COMMONFIELDS_APP_LANGUAGE,
+            COMMONFIELDS_APP_EXPERIMENTIDS,
+            COMMONFIELDS_APP_EXPERIMENTETAG,
+            COMMONFIELDS_APP_ID,
+            COMMONFIELDS_EVENT_PRIVTAGS,
+            COMMONFIELDS_EVENT_PRIVDATACATEGORY,
+            COMMONFIELDS_EVENT_PRIVPRODUCT,
+            COMMONFIELDS_EVENT_CRC32,
+            COMMONFIELDS_EVENT_INITID,
+            COMMONFIELDS_EVENT_SEQ,
+            COMMONFIELDS_EVENT_TIME,
+            COMMONFIELDS_EVENT_SDKVERSION,
+            COMMONFIELDS_EVENT_SOURCE,
+            COMMONFIELDS_EVENT_NAME,
+            COMMONFIELDS_EVENT_PRIORITY,
+            COMMONFIELDS_EVENT_LATENCY,
+            COMMONFIELDS_EVENT_PERSISTENCE,
+            COMMONFIELDS_EVENT_POLICYFLAGS,
+            SESSION_FIRST_TIME,
+            SESSION_IMPRESSION_ID,
+            SESSION_DURATION_BUCKET,
+            SESSION_DURATION,
+            SESSION_STATE,
+            SESSION_ID,
+            COMMONFIELDS_EVENT_LEVEL,
+            "Unknown", "Metered", "Unmetered", "Roaming", "Wifi", "Wired", "WWAN",
+            "true", "false", "Success", "Failure",
+        };
+
+        /// <summary>
+        /// Record with the Part A fields the SDK fills for every event. The
+        /// values are placeholders of typical length and shape.
+        /// </summary>
+        ::CsProtocol::Record MakeTemplateRecord(char const* name, char const* iKey)
+        {
+            ::CsProtocol::Record record;
+            record.ver = "3.0";
+            record.name = name;
+            record.time = 637000000000000000LL;
+            record.popSample = 100.0;
+            record.iKey = iKey;
+            record.flags = 257;
+            record.baseType = "custom";
+            record.extSdk.push_back(::CsProtocol::Sdk());
+            record.extSdk[0].libVer = "EVT-Linux-C++-No-3.7.0.0";
+            record.extSdk[0].epoch = "00000000-0000-0000-0000-000000000000";
+            record.extSdk[0].installId = "00000000-0000-0000-0000-000000000000";
+            record.extSdk[0].seq = 1;
+            record.extApp.push_back(::CsProtocol::App());
+            record.extApp[0].id = "App.Name";
+            record.extApp[0].ver = "1.0.0.0";
+            record.extApp[0].locale = "en-US";
+            record.extDevice.push_back(::CsProtocol::Device());
+            record.extDevice[0].localId = "c:00000000000000000000000000000000";
+            record.extDevice[0].deviceClass = "Windows.Desktop";
+            record.extOs.push_back(::CsProtocol::Os());
+            record.extOs[0].name = "Windows Desktop";
+            record.extOs[0].ver = "10.0.19041.1.amd64fre.vb_release.191206-1406";
+            record.extUser.push_back(::CsProtocol::User());
+            record.extUser[0].localId = "u:00000000000000000000000000000000";
+            record.extUser[0].locale = "en-US";
+            record.extNet.push_back(::CsProtocol::Net());
+            record.extNet[0].cost = "Unmetered";
+            record.extNet[0].type = "Wired";
+            record.extProtocol.push_back(::CsProtocol::Protocol());
+            record.data.push_back(::CsProtocol::Data());
+            auto& properties = record.data[0].properties;
+            properties[COMMONFIELDS_EVENT_LEVEL].type = ::CsProtocol::ValueKind::ValueInt64;
+            properties[COMMONFIELDS_EVENT_LEVEL].longValue = 2;
+            properties[SESSION_ID].stringValue = "00000000-0000-0000-0000-000000000000";
+            return record;
+        }
+
+        std::vector<uint8_t> BuildCsProtocolDictionary()
+        {
+            std::vector<uint8_t> dictionary;
+            for (char const* value : WellKnownStrings)
+            {
+                dictionary.insert(dictionary.end(), value, value + strlen(value));
+            }
+
+            bond_lite::CompactBinaryProtocolWriter writer(dictionary);
+            bond_lite::Serialize(writer, MakeTemplateRecord("evt_stats", "o:00000000000000000000000000000000"));
+            bond_lite::Serialize(writer, MakeTemplateRecord("App.Event", "o:00000000000000000000000000000000"));
+            return dictionary;
+        }
+
+    }
+
+    std::vector<uint8_t> const& PresetDictionary::CsProtocol()
+    {
+        static std::vector<uint8_t> const dictionary = BuildCsProtocolDictionary();
+        return dictionary;
+    }
+
+} MAT_NS_END
@@ -0,0 +1,30 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include "ctmacros.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace MAT_NS_BEGIN {
+
+    /// <summary>
+    /// Preset dictionaries for the "deflate-dict" content encoding.
+    /// </summary>
+    class PresetDictionary
+    {
+    public:
+        /// <summary>
+        /// Dictionary primed with what every Common Schema record repeats:
+        /// the well-known property names and values, followed by template
+        /// records serialized with bond_lite so the Bond field headers and the
+        /// Part A layout match too. The content is fixed; decoders identify it
+        /// by the Adler-32 in the zlib header.
+        /// </summary>
+        static std::vector<uint8_t> const& CsProtocol();
+    };
+
+} MAT_NS_END
@@ -0,0 +1,139 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ZstdCompressor.hpp"
+
+#ifdef HAVE_MAT_ZSTD
+#include "ILogConfiguration.hpp"
+
+#include <zstd.h>
+
+namespace MAT_NS_BEGIN {
+
+    namespace {
+
+        struct ThreadContexts
+        {
+            ZSTD_CCtx* compression;
+
+            ThreadContexts() :
+                compression(nullptr)
+            {
+            }
+
+            ~ThreadContexts()
+            {
+                ZSTD_freeCCtx(compression);
+            }
+        };
+
+        ThreadContexts& GetThreadContexts()
+        {
+            static thread_local ThreadContexts contexts;
+            return contexts;
+        }
+
+        /// <summary>
+        /// Doubles the output once it is full, as DeflateStream does.
+        /// </summary>
+        void reserveOutput(std::vector<uint8_t>& output, ZSTD_outBuffer& buffer)
+        {
+            if (buffer.pos == buffer.size)
+            {
+                output.resize(output.size() * 2);
+                buffer.dst = output.data();
+                buffer.size = output.size();
+            }
+        }
+
+    }
+
+    ZstdCompressor::ZstdCompressor(IRuntimeConfig& config) :
+        m_level(ZSTD_CLEVEL_DEFAULT)
+    {
+        VariantMap& http = config[CFG_MAP_HTTP];
+        auto it = http.find(CFG_INT_HTTP_COMPRESSION_LEVEL);
+        if (it != http.end() && it->second.type == Variant::TYPE_INT)
+        {
+            int64_t level = it->second;
+            if (level >= 1 && level <= ZSTD_maxCLevel())
+            {
+                m_level = static_cast<int>(level);
+            }
+        }
+    }
+
+    char const* ZstdCompressor::getContentEncoding() const noexcept
+    {
+        return "zstd";
+    }
+
+    bool ZstdCompressor::compress(std::vector<BlobView>&& input, size_t size, std::vector<uint8_t>& output)
+    {
+        std::vector<BlobView> views = std::move(input);
+        ThreadContexts& contexts = GetThreadContexts();
+        if (contexts.compression == nullptr)
+        {
+            contexts.compression = ZSTD_createCCtx();
+            if (contexts.compression == nullptr)
+            {
+                m_lastError = "ZSTD_createCCtx failed";
+                return false;
+            }
+        }
+        ZSTD_CCtx* cctx = contexts.compression;
+
+        size_t result = ZSTD_CCtx_reset(cctx, ZSTD_reset_session_only);
+        if (!ZSTD_isError(result))
+        {
+            result = ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, m_level);
+        }
+        if (!ZSTD_isError(result))
+        {
+            // Lets zstd size its window to the upload and record the size in the frame
+            result = ZSTD_CCtx_setPledgedSrcSize(cctx, size);
+        }
+
+        // Telemetry compresses well: start from a quarter of the input
+        output.resize(size / 4 + 1024);
+        ZSTD_outBuffer buffer { output.data(), output.size(), 0 };
+        for (size_t i = 0; i < views.size() && !ZSTD_isError(result); i++)
+        {
+            ZSTD_inBuffer chunk { views[i].data(), views[i].length, 0 };
+            while (chunk.pos < chunk.size && !ZSTD_isError(result))
+            {
+                reserveOutput(output, buffer);
+                result = ZSTD_compressStream2(cctx, &buffer, &chunk, ZSTD_e_continue);
+            }
+            views[i].blob.reset();
+        }
+        ZSTD_inBuffer none { nullptr, 0, 0 };
+        while (!ZSTD_isError(result))
+        {
+            reserveOutput(output, buffer);
+            result = ZSTD_compressStream2(cctx, &buffer, &none, ZSTD_e_end);
+            if (result == 0)
+            {
+                break;
+            }
+        }
+
+        if (ZSTD_isError(result))
+        {
+            m_lastError = ZSTD_getErrorName(result);
+            return false;
+        }
+        output.resize(buffer.pos);
+        return true;
+    }
+
+    std::string ZstdCompressor::getLastError() const
+    {
+        return m_lastError;
+    }
+
+} MAT_NS_END
+
+#endif
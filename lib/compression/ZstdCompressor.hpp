@@ -0,0 +1,35 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include "mat/config.h"
+#include "ICompressor.hpp"
+#include "api/IRuntimeConfig.hpp"
+
+#ifdef HAVE_MAT_ZSTD
+
+namespace MAT_NS_BEGIN {
+
+    /// <summary>
+    /// "zstd" request compression. Compression contexts are kept per thread
+    /// and only reset between uploads.
+    /// </summary>
+    class ZstdCompressor : public ICompressor
+    {
+    public:
+        ZstdCompressor(IRuntimeConfig& config);
+
+        char const* getContentEncoding() const noexcept override;
+        bool compress(std::vector<BlobView>&& input, size_t size, std::vector<uint8_t>& output) override;
+        std::string getLastError() const override;
+
+    protected:
+        int         m_level;
+        std::string m_lastError;
+    };
+
+} MAT_NS_END
+
+#endif
@@ -15,12 +15,19 @@ namespace MAT_NS_BEGIN
         {CFG_INT_SDK_MODE, SdkModeTypes::SdkModeTypes_CS},
         {CFG_BOOL_ENABLE_ANALYTICS, false},
         {CFG_INT_CACHE_FILE_SIZE, 3145728},
+        {CFG_STR_CACHE_STORAGE_TYPE, "sqlite"},
         {CFG_INT_RAM_QUEUE_SIZE, 524288},
         {CFG_BOOL_ENABLE_MULTITENANT, true},
         {CFG_BOOL_ENABLE_DB_DROP_IF_FULL, false},
         {CFG_INT_MAX_TEARDOWN_TIME, 1},
         {CFG_INT_MAX_PENDING_REQ, 4},
         {CFG_INT_RAM_QUEUE_BUFFERS, 3},
+        {CFG_INT_RAM_QUEUE_JOURNAL_SIZE, 0},
+        {CFG_INT_INGESTION_QUEUE_SIZE, 0},
+        {CFG_STR_INGESTION_QUEUE_OVERFLOW, "dropNewest"},
+        {CFG_INT_INGESTION_QUEUE_BLOCK_TIME, 50},
+        {CFG_BOOL_DIRECT_BOND_ENCODING, false},
+        {CFG_INT_TASK_DISPATCHER_WORKERS, 1},
         {CFG_INT_TRACE_LEVEL_MASK, 0},
         {CFG_BOOL_ENABLE_TRACE, true},
         {CFG_STR_COLLECTOR_URL, COLLECTOR_URL_PROD},
@@ -33,6 +40,7 @@ namespace MAT_NS_BEGIN
          {/* Parameter that allows to split stats events by tenant */
           {"split", false},
           {"interval", 1800},
+          {CFG_BOOL_METASTATS_STAGE_TIMING, false},
           {"tokenProd", STATS_TOKEN_PROD},
           {"tokenInt", STATS_TOKEN_INT}}},
         {"utc",
@@ -55,7 +63,10 @@ namespace MAT_NS_BEGIN
              {CFG_BOOL_HTTP_COMPRESSION, false}
 #endif
              ,
-             {"contentEncoding", "deflate"},
+             {CFG_STR_HTTP_CONTENT_ENCODING, "deflate"},
+             {CFG_INT_HTTP_COMPRESSION_LEVEL, -1},
+             {CFG_STR_HTTP_COMPRESSION_STRATEGY, "default"},
+             {CFG_BOOL_HTTP_STREAMING_COMPRESSION, false},
              /* Optional parameter to require Microsoft Root CA */
              {CFG_BOOL_HTTP_MS_ROOT_CHECK, false}}},
         {CFG_MAP_TPM,
@@ -64,6 +75,8 @@ namespace MAT_NS_BEGIN
              {CFG_INT_TPM_MAX_RETRY, 5},
              {CFG_BOOL_TPM_CLOCK_SKEW_ENABLED, true},
              {CFG_STR_TPM_BACKOFF, "E,3000,300000,2,1"},
+             {CFG_INT_TPM_IMMEDIATE_WINDOW_MS, 0},
+             {CFG_INT_TPM_IMMEDIATE_WINDOW_EVENTS, 0},
          }},
         {CFG_MAP_COMPAT,
          {
@@ -168,7 +181,7 @@ namespace MAT_NS_BEGIN
 
         virtual const std::string& GetHttpRequestContentEncoding() const override
         {
-            return config[CFG_MAP_HTTP]["contentEncoding"];
+            return config[CFG_MAP_HTTP][CFG_STR_HTTP_CONTENT_ENCODING];
         }
 
         virtual unsigned GetMinimumUploadBandwidthBps() override
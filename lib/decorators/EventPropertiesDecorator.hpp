@@ -8,6 +8,7 @@
 #include "IDecorator.hpp"
 #include "EventProperties.hpp"
 #include "CorrelationVector.hpp"
+#include "system/EventPropertiesStorage.hpp"
 #include "utils/Utils.hpp"
 
 #include <algorithm>
@@ -87,7 +88,331 @@ namespace MAT_NS_BEGIN {
             record.cV = "";
         }
 
-        bool decorate(::CsProtocol::Record& record, EventLatency& latency, EventProperties const& eventProperties)
+        /// <summary>
+        /// Converts an event property to its Common Schema value and stores it
+        /// in the Part B or Part C map, according to its data category.
+        /// </summary>
+        static void addProperty(std::map<std::string, ::CsProtocol::Value>& ext, std::map<std::string, ::CsProtocol::Value>& extPartB, std::string const& k, EventProperty const& v)
+        {
+            if (v.piiKind != PiiKind_None)
+            {
+                if (v.piiKind == PiiKind::CustomerContentKind_GenericData)
+                {  //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
+                    CsProtocol::CustomerContent cc;
+                    cc.Kind = CsProtocol::CustomerContentKind::GenericContent;
+                    CsProtocol::Value temp;
+
+                    CsProtocol::Attributes attrib;
+                    attrib.customerContent.push_back(cc);
+
+                    temp.attributes.push_back(attrib);
+                    temp.stringValue = v.to_string();
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = temp;
+                    }
+                    else
+                    {
+                        ext[k] = temp;
+                    }
+
+                }
+                else
+                { //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
+                    CsProtocol::PII pii;
+                    pii.Kind = static_cast<CsProtocol::PIIKind>(v.piiKind);
+                    CsProtocol::Value temp;
+
+                    CsProtocol::Attributes attrib;
+                    attrib.pii.push_back(pii);
+
+
+                    temp.attributes.push_back(attrib);
+                    temp.stringValue = v.to_string();
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = temp;
+                    }
+                    else
+                    {
+                        ext[k] = temp;
+                    }
+#if 0 /* v2 code */
+                    if (v.piiKind != PiiKind_None)
+                    {
+                        //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
+                        CsProtocol::PII pii;
+                        pii.Kind = static_cast<CsProtocol::PIIKind>(v.piiKind);
+                        pii.RawContent = v.to_string();
+                        // ScrubType = 1 is the O365 scrubber which is the default behavior.
+                        // pii.ScrubType = static_cast<PIIScrubber>(O365);
+                        pii.ScrubType = CsProtocol::O365;
+                        PIIExtensions[k] = pii;
+                        // 4. Send event's Pii context fields as record.PIIExtensions
+                    }
+                    else
+                    {
+                        //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
+                        CsProtocol::CustomerContent cc;
+                        cc.Kind = static_cast<CsProtocol::CustomerContentKind>(v.ccKind);
+                        cc.RawContent = v.to_string();
+                        ccExtensions[k] = cc;
+                        // 4. Send event's Pii context fields as record.PIIExtensions
+#endif
+                }
+            }
+            else {
+                std::vector<uint8_t> guid;
+                uint8_t guid_bytes[16] = { 0 };
+
+                switch (v.type)
+                {
+                case EventProperty::TYPE_STRING:
+                {
+                    CsProtocol::Value temp;
+                    temp.stringValue = v.to_string();
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = temp;
+                    }
+                    else
+                    {
+                        ext[k] = temp;
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_INT64:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueInt64;
+                    temp.longValue = v.as_int64;
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = temp;
+                    }
+                    else
+                    {
+                        ext[k] = temp;
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_DOUBLE:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueDouble;
+                    temp.doubleValue = v.as_double;
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = temp;
+                    }
+                    else
+                    {
+                        ext[k] = temp;
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_TIME:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueDateTime;
+                    temp.longValue = v.as_time_ticks.ticks;
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = temp;
+                    }
+                    else
+                    {
+                        ext[k] = temp;
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_BOOLEAN:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueBool;
+                    temp.longValue = v.as_bool;
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = temp;
+                    }
+                    else
+                    {
+                        ext[k] = temp;
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_GUID:
+                {
+                    GUID_t temp = v.as_guid;
+                    temp.to_bytes(guid_bytes);
+                    guid = std::vector<uint8_t>(guid_bytes, guid_bytes + sizeof(guid_bytes) / sizeof(guid_bytes[0]));
+
+                    CsProtocol::Value tempValue;
+                    tempValue.type = ::CsProtocol::ValueKind::ValueGuid;
+                    tempValue.guidValue.push_back(guid);
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = tempValue;
+                    }
+                    else
+                    {
+                        ext[k] = tempValue;
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_INT64_ARRAY:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueArrayInt64;
+                    temp.longArray.push_back(*v.as_longArray);
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = temp;
+                    }
+                    else
+                    {
+                        ext[k] = temp;
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_DOUBLE_ARRAY:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueArrayDouble;
+                    temp.doubleArray.push_back(*v.as_doubleArray);
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = temp;
+                    }
+                    else
+                    {
+                        ext[k] = temp;
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_STRING_ARRAY:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueArrayString;
+                    temp.stringArray.push_back(*v.as_stringArray);
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = temp;
+                    }
+                    else
+                    {
+                        ext[k] = temp;
+                    }
+                    break;
+                }
+                case EventProperty::TYPE_GUID_ARRAY:
+                {
+                    CsProtocol::Value temp;
+                    temp.type = ::CsProtocol::ValueKind::ValueArrayGuid;
+
+                    std::vector<std::vector<uint8_t>> values;
+                    for (const auto& tempValue : *v.as_guidArray)
+                    {
+                        tempValue.to_bytes(guid_bytes);
+                        guid = std::vector<uint8_t>(guid_bytes, guid_bytes + sizeof(guid_bytes) / sizeof(guid_bytes[0]));
+                        values.push_back(guid);
+                    }
+                    temp.guidArray.push_back(values);
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = temp;
+                    }
+                    else
+                    {
+                        ext[k] = temp;
+                    }
+                    break;
+                }
+                default:
+                {
+                    // Convert all unknown types to string
+                    CsProtocol::Value temp;
+                    temp.stringValue = v.to_string();
+                    if (v.dataCategory == DataCategory_PartB)
+                    {
+                        extPartB[k] = temp;
+                    }
+                    else
+                    {
+                        ext[k] = temp;
+                    }
+                }
+                }
+            }
+        }
+
+        /// <summary>
+        /// Returns true if addProperty stores the property as a ValueString.
+        /// </summary>
+        static bool isStringValue(EventProperty const& v)
+        {
+            if (v.piiKind != PiiKind_None)
+            {
+                return true;
+            }
+            switch (v.type)
+            {
+            case EventProperty::TYPE_INT64:
+            case EventProperty::TYPE_DOUBLE:
+            case EventProperty::TYPE_TIME:
+            case EventProperty::TYPE_BOOLEAN:
+            case EventProperty::TYPE_GUID:
+            case EventProperty::TYPE_INT64_ARRAY:
+            case EventProperty::TYPE_DOUBLE_ARRAY:
+            case EventProperty::TYPE_STRING_ARRAY:
+            case EventProperty::TYPE_GUID_ARRAY:
+                return false;
+            default:
+                return true;
+            }
+        }
+
+        /// <summary>
+        /// Copies the Part B and Part C properties left out by decorate() with
+        /// deferProperties set into the record, e.g. before the record is handed
+        /// to a custom decorator or a data inspector.
+        /// </summary>
+        static void addDeferredProperties(::CsProtocol::Record& record, EventProperties const& eventProperties)
+        {
+            if (record.data.size() == 0)
+            {
+                ::CsProtocol::Data data;
+                record.data.push_back(data);
+            }
+
+            std::map<std::string, ::CsProtocol::Value>& ext = record.data[0].properties;
+            std::map<std::string, ::CsProtocol::Value> extPartB;
+
+            const auto& properties = static_cast<const EventPropertiesStorage*>(eventProperties.m_storage)->properties;
+            for (auto &kv : properties) {
+                // Already moved to record.cV by decorate()
+                if (kv.second.dataCategory != DataCategory_PartB && kv.first == CorrelationVector::PropertyName)
+                {
+                    continue;
+                }
+                addProperty(ext, extPartB, kv.first, kv.second);
+            }
+
+            if (extPartB.size() > 0)
+            {
+                ::CsProtocol::Data partBdata;
+                partBdata.properties = extPartB;
+                record.baseData.push_back(partBdata);
+            }
+        }
+
+        /// <summary>
+        /// Decorates the record with the event properties. With deferProperties
+        /// set, the properties are validated and the correlation vector is
+        /// applied, but Part B and Part C values are not copied into the record:
+        /// the caller serializes them with EventPropertiesBondEncoder instead.
+        /// </summary>
+        bool decorate(::CsProtocol::Record& record, EventLatency& latency, EventProperties const& eventProperties, bool deferProperties = false)
         {
             if (latency == EventLatency_Unspecified)
                 latency = EventLatency_Normal;
@@ -159,7 +484,10 @@ namespace MAT_NS_BEGIN {
             std::map<std::string, ::CsProtocol::Value>& ext = record.data[0].properties;
             std::map<std::string, ::CsProtocol::Value> extPartB;
 
-            for (auto &kv : eventProperties.GetProperties()) {
+            // Walk the flat storage directly rather than the std::map view
+            // returned by EventProperties::GetProperties().
+            const auto& properties = static_cast<const EventPropertiesStorage*>(eventProperties.m_storage)->properties;
+            for (auto &kv : properties) {
 
                 EventRejectedReason isValidPropertyName = validatePropertyName(kv.first);
                 if (isValidPropertyName != REJECTED_REASON_OK)
@@ -170,257 +498,9 @@ namespace MAT_NS_BEGIN {
                     m_owner.DispatchEvent(evt);
                     return false;
                 }
-                const auto &k = kv.first;
-                const auto &v = kv.second;
-                if (v.piiKind != PiiKind_None)
+                if (!deferProperties)
                 {
-                    if (v.piiKind == PiiKind::CustomerContentKind_GenericData)
-                    {  //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
-                        CsProtocol::CustomerContent cc;
-                        cc.Kind = CsProtocol::CustomerContentKind::GenericContent;
-                        CsProtocol::Value temp;
-
-                        CsProtocol::Attributes attrib;
-                        attrib.customerContent.push_back(cc);
-
-                        temp.attributes.push_back(attrib);
-                        temp.stringValue = v.to_string();
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-
-                    }
-                    else
-                    { //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
-                        CsProtocol::PII pii;
-                        pii.Kind = static_cast<CsProtocol::PIIKind>(v.piiKind);
-                        CsProtocol::Value temp;
-
-                        CsProtocol::Attributes attrib;
-                        attrib.pii.push_back(pii);
-
-
-                        temp.attributes.push_back(attrib);
-                        temp.stringValue = v.to_string();
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-#if 0 /* v2 code */
-                        if (v.piiKind != PiiKind_None)
-                        {
-                            //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
-                            CsProtocol::PII pii;
-                            pii.Kind = static_cast<CsProtocol::PIIKind>(v.piiKind);
-                            pii.RawContent = v.to_string();
-                            // ScrubType = 1 is the O365 scrubber which is the default behavior.
-                            // pii.ScrubType = static_cast<PIIScrubber>(O365);
-                            pii.ScrubType = CsProtocol::O365;
-                            PIIExtensions[k] = pii;
-                            // 4. Send event's Pii context fields as record.PIIExtensions
-                        }
-                        else
-                        {
-                            //LOG_TRACE("PIIExtensions: %s=%s (PiiKind=%u)", k.c_str(), v.to_string().c_str(), v.piiKind);
-                            CsProtocol::CustomerContent cc;
-                            cc.Kind = static_cast<CsProtocol::CustomerContentKind>(v.ccKind);
-                            cc.RawContent = v.to_string();
-                            ccExtensions[k] = cc;
-                            // 4. Send event's Pii context fields as record.PIIExtensions
-#endif
-                    }
-                }
-                else {
-                    std::vector<uint8_t> guid;
-                    uint8_t guid_bytes[16] = { 0 };
-
-                    switch (v.type)
-                    {
-                    case EventProperty::TYPE_STRING:
-                    {
-                        CsProtocol::Value temp;
-                        temp.stringValue = v.to_string();
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
-                    }
-                    case EventProperty::TYPE_INT64:
-                    {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueInt64;
-                        temp.longValue = v.as_int64;
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
-                    }
-                    case EventProperty::TYPE_DOUBLE:
-                    {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueDouble;
-                        temp.doubleValue = v.as_double;
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
-                    }
-                    case EventProperty::TYPE_TIME:
-                    {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueDateTime;
-                        temp.longValue = v.as_time_ticks.ticks;
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
-                    }
-                    case EventProperty::TYPE_BOOLEAN:
-                    {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueBool;
-                        temp.longValue = v.as_bool;
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
-                    }
-                    case EventProperty::TYPE_GUID:
-                    {
-                        GUID_t temp = v.as_guid;
-                        temp.to_bytes(guid_bytes);
-                        guid = std::vector<uint8_t>(guid_bytes, guid_bytes + sizeof(guid_bytes) / sizeof(guid_bytes[0]));
-
-                        CsProtocol::Value tempValue;
-                        tempValue.type = ::CsProtocol::ValueKind::ValueGuid;
-                        tempValue.guidValue.push_back(guid);
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = tempValue;
-                        }
-                        else
-                        {
-                            ext[k] = tempValue;
-                        }
-                        break;
-                    }
-                    case EventProperty::TYPE_INT64_ARRAY:
-                    {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueArrayInt64;
-                        temp.longArray.push_back(*v.as_longArray);
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
-                    }
-                    case EventProperty::TYPE_DOUBLE_ARRAY:
-                    {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueArrayDouble;
-                        temp.doubleArray.push_back(*v.as_doubleArray);
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
-                    }
-                    case EventProperty::TYPE_STRING_ARRAY:
-                    {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueArrayString;
-                        temp.stringArray.push_back(*v.as_stringArray);
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
-                    }
-                    case EventProperty::TYPE_GUID_ARRAY:
-                    {
-                        CsProtocol::Value temp;
-                        temp.type = ::CsProtocol::ValueKind::ValueArrayGuid;
-
-                        std::vector<std::vector<uint8_t>> values;
-                        for (const auto& tempValue : *v.as_guidArray)
-                        {
-                            tempValue.to_bytes(guid_bytes);
-                            guid = std::vector<uint8_t>(guid_bytes, guid_bytes + sizeof(guid_bytes) / sizeof(guid_bytes[0]));
-                            values.push_back(guid);
-                        }
-                        temp.guidArray.push_back(values);
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                        break;
-                    }
-                    default:
-                    {
-                        // Convert all unknown types to string
-                        CsProtocol::Value temp;
-                        temp.stringValue = v.to_string();
-                        if (v.dataCategory == DataCategory_PartB)
-                        {
-                            extPartB[k] = temp;
-                        }
-                        else
-                        {
-                            ext[k] = temp;
-                        }
-                    }
-                    }
+                    addProperty(ext, extPartB, kv.first, kv.second);
                 }
             }
 
@@ -432,7 +512,20 @@ namespace MAT_NS_BEGIN {
             }
 
             // special case of CorrelationVector value
-            if (ext.count(CorrelationVector::PropertyName) > 0)
+            auto cv = properties.find(CorrelationVector::PropertyName);
+            if (deferProperties && cv != properties.end() && cv->second.dataCategory != DataCategory_PartB)
+            {
+                if (isStringValue(cv->second))
+                {
+                    record.cV = cv->second.to_string();
+                }
+                else
+                {
+                    LOG_TRACE("CorrelationVector value type is invalid %u", cv->second.type);
+                }
+                ext.erase(CorrelationVector::PropertyName);
+            }
+            else if (ext.count(CorrelationVector::PropertyName) > 0)
             {
                 CsProtocol::Value cvValue = ext[CorrelationVector::PropertyName];
 
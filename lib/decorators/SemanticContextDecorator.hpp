@@ -42,6 +42,16 @@ namespace MAT_NS_BEGIN
             return true;
         }
 
+        /// <summary>
+        /// Decorates the record, and tells through context which snapshot the
+        /// record's extensions are still taken from, see ContextFieldsProvider::writeToRecord.
+        /// </summary>
+        bool decorate(::CsProtocol::Record& record, std::shared_ptr<const ContextFieldsSnapshot>& context, bool deferExtensions)
+        {
+            context = provider.writeToRecord(record, false, deferExtensions);
+            return true;
+        }
+
     };
 
 
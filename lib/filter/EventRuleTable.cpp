@@ -0,0 +1,296 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+#include "EventRuleTable.hpp"
+#include "pal/PAL.hpp"
+#include "utils/StringUtils.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+
+namespace MAT_NS_BEGIN
+{
+    namespace
+    {
+        // Event level not asked for yet
+        constexpr int UnresolvedLevel = INT_MIN;
+
+        char toLower(char c) noexcept
+        {
+            return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+
+        /// <summary>
+        /// Prefix rule nodes met while walking an event name. Only the deepest
+        /// ones are kept if a name crosses more of them than fit.
+        /// </summary>
+        class PrefixPath
+        {
+           public:
+            void push(uint32_t node) noexcept
+            {
+                if (m_count == MaxDepth)
+                {
+                    std::copy(m_nodes + 1, m_nodes + MaxDepth, m_nodes);
+                    m_count--;
+                }
+                m_nodes[m_count++] = node;
+            }
+
+            size_t size() const noexcept
+            {
+                return m_count;
+            }
+
+            uint32_t operator[](size_t i) const noexcept
+            {
+                return m_nodes[i];
+            }
+
+           protected:
+            static constexpr size_t MaxDepth = 16;
+            uint32_t m_nodes[MaxDepth];
+            size_t m_count = 0;
+        };
+    }
+
+    EventRuleTable::EventRuleTable(VariantMap& rules)
+    {
+        m_nodes.emplace_back();
+        for (auto& kv : rules)
+        {
+            if (kv.second.type != Variant::TYPE_OBJ)
+            {
+                LOG_WARN("Event rule %s ignored: not a map", kv.first.c_str());
+                continue;
+            }
+            VariantMap& settings = kv.second;
+            std::unique_ptr<Rule> rule(new Rule());
+            rule->name = kv.first;
+
+            std::string name = "*";
+            auto it = settings.find(CFG_STR_EVENT_RULE_NAME);
+            if (it != settings.end() && static_cast<const char*>(it->second) != nullptr && *static_cast<const char*>(it->second) != '\0')
+            {
+                name = static_cast<const char*>(it->second);
+            }
+
+            it = settings.find(CFG_STR_EVENT_RULE_TENANT);
+            if (it != settings.end() && static_cast<const char*>(it->second) != nullptr && *static_cast<const char*>(it->second) != '\0')
+            {
+                rule->tenant = TenantRegistry::instance().Register(static_cast<const char*>(it->second));
+            }
+
+            it = settings.find(CFG_INT_EVENT_RULE_LEVEL);
+            if (it != settings.end() && it->second.type == Variant::TYPE_INT)
+            {
+                rule->level = static_cast<int>(static_cast<int64_t>(it->second));
+                m_usesLevel = true;
+            }
+
+            std::string action = "drop";
+            it = settings.find(CFG_STR_EVENT_RULE_ACTION);
+            if (it != settings.end() && static_cast<const char*>(it->second) != nullptr)
+            {
+                action = static_cast<const char*>(it->second);
+            }
+            it = settings.find(CFG_INT_EVENT_RULE_RATE);
+            if (it != settings.end() && it->second.type == Variant::TYPE_INT)
+            {
+                int64_t rate = it->second;
+                rule->rate = static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(rate, 0), UINT32_MAX));
+            }
+            if (equalsIgnoreCase(action, "drop"))
+            {
+                rule->action = Action::Drop;
+            }
+            else if (equalsIgnoreCase(action, "sample") && rule->rate != 0)
+            {
+                rule->action = Action::Sample;
+            }
+            else if (equalsIgnoreCase(action, "rateLimit"))
+            {
+                rule->action = Action::RateLimit;
+            }
+            else
+            {
+                LOG_WARN("Event rule %s ignored: invalid action %s or rate", kv.first.c_str(), action.c_str());
+                continue;
+            }
+
+            uint32_t index = static_cast<uint32_t>(m_rules.size());
+            m_rules.push_back(std::move(rule));
+            if (!name.empty() && name.back() == '*')
+            {
+                name.pop_back();
+                m_nodes[addNode(name)].prefixRules.push_back(index);
+            }
+            else
+            {
+                m_nodes[addNode(name)].exactRules.push_back(index);
+            }
+        }
+
+        // Rules of a node are in rule name order: put those with more conditions first
+        auto conditions = [this](uint32_t index) {
+            Rule const& rule = *m_rules[index];
+            return (rule.tenant != InvalidTenantHandle ? 1 : 0) + (rule.level != AnyLevel ? 1 : 0);
+        };
+        for (auto& node : m_nodes)
+        {
+            for (auto* list : { &node.exactRules, &node.prefixRules })
+            {
+                std::stable_sort(list->begin(), list->end(), [&conditions](uint32_t a, uint32_t b) {
+                    return conditions(a) > conditions(b);
+                });
+            }
+        }
+    }
+
+    uint32_t EventRuleTable::addNode(std::string const& path)
+    {
+        uint32_t node = 0;
+        for (char c : path)
+        {
+            c = toLower(c);
+            auto& children = m_nodes[node].children;
+            auto it = std::lower_bound(children.begin(), children.end(), c,
+                [](std::pair<char, uint32_t> const& child, char value) { return child.first < value; });
+            if (it != children.end() && it->first == c)
+            {
+                node = it->second;
+                continue;
+            }
+            uint32_t child = static_cast<uint32_t>(m_nodes.size());
+            children.insert(it, std::make_pair(c, child));
+            // May reallocate m_nodes: children is not used past this point
+            m_nodes.emplace_back();
+            node = child;
+        }
+        return node;
+    }
+
+    EventRuleTable::Rule* EventRuleTable::match(std::vector<uint32_t> const& rules, TenantHandle tenant, int& level, std::function<int()> const& getLevel) const noexcept
+    {
+        for (uint32_t index : rules)
+        {
+            Rule& rule = *m_rules[index];
+            if (rule.tenant != InvalidTenantHandle && rule.tenant != tenant)
+            {
+                continue;
+            }
+            if (rule.level != AnyLevel)
+            {
+                if (level == UnresolvedLevel)
+                {
+                    level = getLevel();
+                }
+                if (rule.level != level)
+                {
+                    continue;
+                }
+            }
+            return &rule;
+        }
+        return nullptr;
+    }
+
+    bool EventRuleTable::Allow(std::string const& name, TenantHandle tenant, int level) noexcept
+    {
+        return Allow(name, tenant, [level]() { return level; });
+    }
+
+    bool EventRuleTable::Allow(std::string const& name, TenantHandle tenant, std::function<int()> const& getLevel) noexcept
+    {
+        if (m_rules.empty())
+        {
+            return true;
+        }
+
+        PrefixPath prefixes;
+        uint32_t node = 0;
+        bool whole = true;
+        for (char c : name)
+        {
+            Node const& current = m_nodes[node];
+            if (!current.prefixRules.empty())
+            {
+                prefixes.push(node);
+            }
+            c = toLower(c);
+            auto it = std::lower_bound(current.children.begin(), current.children.end(), c,
+                [](std::pair<char, uint32_t> const& child, char value) { return child.first < value; });
+            if (it == current.children.end() || it->first != c)
+            {
+                whole = false;
+                break;
+            }
+            node = it->second;
+        }
+
+        Rule* rule = nullptr;
+        int level = UnresolvedLevel;
+        if (whole)
+        {
+            rule = match(m_nodes[node].exactRules, tenant, level, getLevel);
+            if (rule == nullptr && !m_nodes[node].prefixRules.empty())
+            {
+                prefixes.push(node);
+            }
+        }
+        for (size_t i = prefixes.size(); rule == nullptr && i > 0; i--)
+        {
+            rule = match(m_nodes[prefixes[i - 1]].prefixRules, tenant, level, getLevel);
+        }
+        return (rule == nullptr) || apply(*rule);
+    }
+
+    bool EventRuleTable::apply(Rule& rule) noexcept
+    {
+        bool keep = false;
+        switch (rule.action)
+        {
+        case Action::Drop:
+            break;
+
+        case Action::Sample:
+            keep = (rule.seen.fetch_add(1, std::memory_order_relaxed) % rule.rate) == 0;
+            break;
+
+        case Action::RateLimit:
+        {
+            // One-second windows, numbered from 1 so that 0 means none yet
+            uint64_t window = PAL::getMonotonicTimeMs() / 1000 + 1;
+            uint64_t current = rule.window.load(std::memory_order_relaxed);
+            if (current != window && rule.window.compare_exchange_strong(current, window, std::memory_order_relaxed))
+            {
+                rule.windowCount.store(0, std::memory_order_relaxed);
+            }
+            keep = rule.windowCount.fetch_add(1, std::memory_order_relaxed) < rule.rate;
+            break;
+        }
+        }
+
+        if (!keep)
+        {
+            rule.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        return keep;
+    }
+
+    std::vector<EventRuleTable::RuleDrops> EventRuleTable::GetDropCounts() const
+    {
+        std::vector<RuleDrops> result;
+        result.reserve(m_rules.size());
+        for (auto const& rule : m_rules)
+        {
+            result.push_back({ rule->name, rule->dropped.load(std::memory_order_relaxed) });
+        }
+        return result;
+    }
+
+}
+MAT_NS_END
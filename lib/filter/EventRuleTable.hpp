@@ -0,0 +1,117 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef EVENTRULETABLE_HPP
+#define EVENTRULETABLE_HPP
+
+#include "ctmacros.hpp"
+#include "Variant.hpp"
+#include "system/TenantRegistry.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Drop, sampling and rate limiting rules of CFG_MAP_EVENT_RULES, compiled
+    /// into a trie over the event names. A lookup walks the event name once
+    /// and compares tenant handles and levels of the few rules found on the
+    /// way, so that an event dropped here costs next to nothing.
+    /// </summary>
+    class EventRuleTable
+    {
+       public:
+        enum class Action : uint8_t
+        {
+            Drop,
+            Sample,
+            RateLimit
+        };
+
+        struct RuleDrops
+        {
+            std::string name;
+            uint64_t dropped;
+        };
+
+        static constexpr int AnyLevel = -1;
+
+        /// <summary>
+        /// Compiles the rules of a CFG_MAP_EVENT_RULES map. Invalid rules are
+        /// skipped with a warning.
+        /// </summary>
+        explicit EventRuleTable(VariantMap& rules);
+
+        bool Empty() const noexcept
+        {
+            return m_rules.empty();
+        }
+
+        /// <summary>
+        /// True if some rule depends on the event level.
+        /// </summary>
+        bool UsesLevel() const noexcept
+        {
+            return m_usesLevel;
+        }
+
+        /// <summary>
+        /// Applies the rule matching the event, if any, and counts the drop.
+        /// </summary>
+        /// <returns>false if the event is to be dropped</returns>
+        bool Allow(std::string const& name, TenantHandle tenant, int level) noexcept;
+
+        /// <summary>
+        /// Same as above, with the event level resolved only once a rule with
+        /// a level condition is reached, which most events never do.
+        /// </summary>
+        bool Allow(std::string const& name, TenantHandle tenant, std::function<int()> const& getLevel) noexcept;
+
+        /// <summary>
+        /// Events dropped by each rule since the table was created.
+        /// </summary>
+        std::vector<RuleDrops> GetDropCounts() const;
+
+       protected:
+        struct Rule
+        {
+            std::string name;
+            TenantHandle tenant = InvalidTenantHandle;
+            int level = AnyLevel;
+            Action action = Action::Drop;
+            uint32_t rate = 0;
+            std::atomic<uint64_t> seen { 0 };
+            std::atomic<uint64_t> dropped { 0 };
+            std::atomic<uint64_t> window { 0 };
+            std::atomic<uint32_t> windowCount { 0 };
+        };
+
+        struct Node
+        {
+            // Sorted by character
+            std::vector<std::pair<char, uint32_t>> children;
+            // Rule indices, most specific first
+            std::vector<uint32_t> prefixRules;
+            std::vector<uint32_t> exactRules;
+        };
+
+        uint32_t addNode(std::string const& path);
+        Rule* match(std::vector<uint32_t> const& rules, TenantHandle tenant, int& level, std::function<int()> const& getLevel) const noexcept;
+        bool apply(Rule& rule) noexcept;
+
+        std::vector<std::unique_ptr<Rule>> m_rules;
+        // Root first: the empty prefix, where rules for any name go
+        std::vector<Node> m_nodes;
+        bool m_usesLevel = false;
+    };
+
+}
+MAT_NS_END
+
+#endif
@@ -43,16 +43,56 @@ namespace MAT_NS_BEGIN {
         std::shared_ptr<CurlHttpOperation> m_curlOperation;
     };
 
+    // Upper bound for a single wait of the I/O thread. libcurl without
+    // curl_multi_wakeup cannot be interrupted, so it polls more often.
+#if LIBCURL_VERSION_NUM >= 0x074400
+    static const int IDLE_WAIT_MS = 10000;
+#else
+    static const int IDLE_WAIT_MS = 100;
+#endif
+
     HttpClient_Curl::HttpClient_Curl()
     {
         /* In windows, this will init the winsock stuff */
         TRACE("Initializing HttpClient_Curl...\n");
         curl_global_init(CURL_GLOBAL_ALL);
         TRACE("libcurl version = %s\n", curl_version_info(CURLVERSION_NOW)->version);
+
+        // DNS lookups and TLS sessions are reused across transfers; the
+        // connection cache is owned by the multi handle itself. Both handles
+        // are only used on the I/O thread, so the share needs no lock callbacks.
+        m_share = curl_share_init();
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+        m_multi = curl_multi_init();
+        curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+        m_thread = std::thread(&HttpClient_Curl::Run, this);
     }
 
     HttpClient_Curl::~HttpClient_Curl()
     {
+        m_stopping = true;
+        Wakeup();
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+
+        // HttpClientManager waits for outstanding requests before the client
+        // goes away, so nobody is listening for these any more.
+        for (auto& item : m_active)
+        {
+            LOG_WARN("HTTP request id=%s dropped on shutdown", item.second.requestId.c_str());
+            curl_multi_remove_handle(m_multi, item.first);
+            curl_easy_setopt(item.first, CURLOPT_SHARE, nullptr);
+        }
+        m_active.clear();
+        m_pending.clear();
+
+        curl_multi_cleanup(m_multi);
+        curl_share_cleanup(m_share);
         curl_global_cleanup();
         TRACE("Destroyed HttpClient_Curl.\n");
     };
@@ -76,35 +116,12 @@ namespace MAT_NS_BEGIN {
 
         auto curlOperation = std::make_shared<CurlHttpOperation>(curlRequest->m_method, curlRequest->m_url, callback, requestHeaders, curlRequest->m_body);
         curlRequest->SetOperation(curlOperation);
-        
-        // The lifetime of curlOperation is guarnteed by the call to result.wait() in the d'tor.  
-        curlOperation->SendAsync([this, callback, requestId](CurlHttpOperation& operation) {
-            this->EraseRequest(requestId);
-
-            auto response = std::unique_ptr<SimpleHttpResponse>(new SimpleHttpResponse(requestId));
-            response->m_result = HttpResult_OK;
-
-            response->m_statusCode = operation.GetResponseCode();
-            if (response->m_statusCode == CURLE_FAILED_INIT) {
-                // There was an error in CURL stack while trying to create request
-                response->m_result = HttpResult_LocalFailure;
-            } else if ((CURLE_OK < response->m_statusCode) && (response->m_statusCode <= CURL_LAST)) {
-                if (operation.WasAborted()) {
-                    // Operation was manually aborted
-                    response->m_result = HttpResult_Aborted;
-                } else {
-                    // There was an error in CURL stack while trying to connect
-                    response->m_result = HttpResult_NetworkFailure;
-                }
-            }
 
-            auto responseHeaders = operation.GetResponseHeaders();
-            response->m_headers.insert(responseHeaders.begin(), responseHeaders.end());
-            response->m_body = operation.GetResponseBody();
-            
-            // 'response' is no longer owned by IHttpClient and gets deleted in EventsUploadContext.clear()
-            callback->OnHttpResponse(response.release());
-        });
+        {
+            std::lock_guard<std::mutex> lock(m_pendingMtx);
+            m_pending.push_back(Transfer { curlOperation, callback, requestId });
+        }
+        Wakeup();
     }
 
     void HttpClient_Curl::CancelRequestAsync(std::string const& id)
@@ -122,7 +139,169 @@ namespace MAT_NS_BEGIN {
 
         if (request != nullptr) {
             request->Cancel();
+            Wakeup();
+        }
+    }
+
+    void HttpClient_Curl::CancelAllRequests()
+    {
+        std::vector<std::string> ids;
+        {
+            std::lock_guard<std::mutex> lock(m_requestsMtx);
+            for (auto const& item : m_requests) {
+                ids.push_back(item.first);
+            }
+        }
+        for (auto const& id : ids) {
+            CancelRequestAsync(id);
+        }
+    }
+
+    void HttpClient_Curl::Wakeup()
+    {
+#if LIBCURL_VERSION_NUM >= 0x074400
+        curl_multi_wakeup(m_multi);
+#endif
+    }
+
+    /// <summary>
+    /// I/O thread: adds submitted transfers to the multi handle, drives
+    /// them and reports finished ones to their callbacks.
+    /// </summary>
+    void HttpClient_Curl::Run()
+    {
+        while (!m_stopping)
+        {
+            StartPendingTransfers();
+            AbortCancelledTransfers();
+
+            int running = 0;
+            curl_multi_perform(m_multi, &running);
+
+            int remaining = 0;
+            CURLMsg* msg = nullptr;
+            while ((msg = curl_multi_info_read(m_multi, &remaining)) != nullptr)
+            {
+                if (msg->msg == CURLMSG_DONE)
+                {
+                    CompleteTransfer(msg->easy_handle, msg->data.result);
+                }
+            }
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+            curl_multi_poll(m_multi, nullptr, 0, IDLE_WAIT_MS, nullptr);
+#else
+            curl_multi_wait(m_multi, nullptr, 0, IDLE_WAIT_MS, nullptr);
+#endif
+        }
+    }
+
+    void HttpClient_Curl::StartPendingTransfers()
+    {
+        std::vector<Transfer> pending;
+        {
+            std::lock_guard<std::mutex> lock(m_pendingMtx);
+            pending.swap(m_pending);
         }
+
+        for (auto& transfer : pending)
+        {
+            auto& operation = *transfer.operation;
+            if (operation.WasAborted())
+            {
+                operation.Complete(CURLE_ABORTED_BY_CALLBACK);
+                OnTransferDone(std::move(transfer));
+                continue;
+            }
+            if (!operation.Prepare())
+            {
+                OnTransferDone(std::move(transfer));
+                continue;
+            }
+            CURL* handle = operation.GetHandle();
+            curl_easy_setopt(handle, CURLOPT_SHARE, m_share);
+            operation.DispatchEvent(OnSending);
+            if (curl_multi_add_handle(m_multi, handle) != CURLM_OK)
+            {
+                curl_easy_setopt(handle, CURLOPT_SHARE, nullptr);
+                operation.Complete(CURLE_FAILED_INIT);
+                OnTransferDone(std::move(transfer));
+                continue;
+            }
+            m_active[handle] = std::move(transfer);
+        }
+    }
+
+    void HttpClient_Curl::AbortCancelledTransfers()
+    {
+        std::vector<CURL*> aborted;
+        for (auto const& item : m_active)
+        {
+            if (item.second.operation->WasAborted())
+            {
+                aborted.push_back(item.first);
+            }
+        }
+        for (CURL* handle : aborted)
+        {
+            CompleteTransfer(handle, CURLE_ABORTED_BY_CALLBACK);
+        }
+    }
+
+    void HttpClient_Curl::CompleteTransfer(CURL* handle, CURLcode code)
+    {
+        auto it = m_active.find(handle);
+        if (it == m_active.end())
+        {
+            return;
+        }
+        Transfer transfer = std::move(it->second);
+        m_active.erase(it);
+
+        // Detach the handle here: the operation may be destroyed on another thread
+        curl_multi_remove_handle(m_multi, handle);
+        curl_easy_setopt(handle, CURLOPT_SHARE, nullptr);
+
+        transfer.operation->Complete(code);
+        OnTransferDone(std::move(transfer));
+    }
+
+    void HttpClient_Curl::OnTransferDone(Transfer transfer)
+    {
+        EraseRequest(transfer.requestId);
+        CurlHttpOperation& operation = *transfer.operation;
+
+        auto response = std::unique_ptr<SimpleHttpResponse>(new SimpleHttpResponse(transfer.requestId));
+        response->m_result = HttpResult_OK;
+
+        response->m_statusCode = operation.GetResponseCode();
+        if (response->m_statusCode == CURLE_FAILED_INIT ||
+            response->m_statusCode == CURLE_UNSUPPORTED_PROTOCOL ||
+            response->m_statusCode == CURLE_URL_MALFORMAT) {
+            // There was an error in CURL stack while trying to create request,
+            // or the request cannot be sent anywhere
+            response->m_result = HttpResult_LocalFailure;
+        } else if ((CURLE_OK < response->m_statusCode) && (response->m_statusCode <= CURL_LAST)) {
+            if (operation.WasAborted()) {
+                // Operation was manually aborted
+                response->m_result = HttpResult_Aborted;
+            } else {
+                // There was an error in CURL stack while trying to connect
+                response->m_result = HttpResult_NetworkFailure;
+            }
+        }
+
+        auto responseHeaders = operation.GetResponseHeaders();
+        response->m_headers.insert(responseHeaders.begin(), responseHeaders.end());
+        response->m_body = operation.GetResponseBody();
+
+        // The callback does not outlive OnHttpResponse, so OnDestroy has to be
+        // reported now; the request owns the operation from here on.
+        operation.DetachCallback();
+        transfer.operation.reset();
+
+        // 'response' is no longer owned by IHttpClient and gets deleted in EventsUploadContext.clear()
+        transfer.callback->OnHttpResponse(response.release());
     }
 
     void HttpClient_Curl::EraseRequest(std::string const& id)
@@ -20,8 +20,11 @@
 
 #include <algorithm>
 #include <numeric>
-#include <future>
 #include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include <curl/curl.h>
 
@@ -43,8 +46,16 @@
 
 namespace MAT_NS_BEGIN {
 
+class CurlHttpOperation;
+
 /**
  * Curl-based HTTP client
+ *
+ * All transfers are driven by a single curl multi handle on a dedicated I/O
+ * thread. The multi handle keeps a cache of open connections, multiplexes
+ * requests to the same host over HTTP/2 and shares DNS and TLS sessions
+ * between transfers, so steady uploads do not pay for a new connection and
+ * TLS handshake on every request.
  */
 class HttpClient_Curl : public IHttpClient {
 public:
@@ -54,13 +65,40 @@ public:
     virtual IHttpRequest* CreateRequest() override;
     virtual void SendRequestAsync(IHttpRequest* request, IHttpResponseCallback* callback) override;
     virtual void CancelRequestAsync(std::string const& id) override;
+    virtual void CancelAllRequests() override;
 
 private:
+    struct Transfer {
+        std::shared_ptr<CurlHttpOperation> operation;
+        IHttpResponseCallback*             callback;
+        std::string                        requestId;
+    };
+
     void EraseRequest(std::string const& id);
     void AddRequest(IHttpRequest* request);
 
+    void Run();
+    void Wakeup();
+    void StartPendingTransfers();
+    void AbortCancelledTransfers();
+    void CompleteTransfer(CURL* handle, CURLcode code);
+    void OnTransferDone(Transfer transfer);
+
     std::mutex m_requestsMtx;
     std::map<std::string, IHttpRequest*> m_requests;
+
+    CURLM*  m_multi = nullptr;
+    CURLSH* m_share = nullptr;
+
+    // Transfers submitted by SendRequestAsync, picked up by the I/O thread
+    std::mutex            m_pendingMtx;
+    std::vector<Transfer> m_pending;
+
+    // Transfers added to m_multi, only accessed on the I/O thread
+    std::map<CURL*, Transfer> m_active;
+
+    std::atomic<bool> m_stopping { false };
+    std::thread       m_thread;
 };
 
 class CurlHttpOperation {
@@ -72,6 +110,18 @@ public:
             m_callback->OnHttpStateEvent(type, static_cast<void*>(curl), 0);
     }
 
+    /**
+     * Report OnDestroy and stop dispatching events. Called on the I/O thread
+     * before the response is handed over: the callback is deleted once it
+     * has processed the response, while the request may keep the operation
+     * alive for longer.
+     */
+    void DetachCallback()
+    {
+        DispatchEvent(OnDestroy);
+        m_callback = nullptr;
+    }
+
     std::atomic<bool> isAborted { false };      // Set to 'true' when async callback is aborted
 
     /**
@@ -134,6 +184,9 @@ public:
         curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0);      // 2L
         // HTTP/2 please, fallback to HTTP/1.1 if not supported
         curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_0);
+        // Prefer waiting for a multiplexed HTTP/2 stream over opening another connection
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
 
         // Specify our custom headers
         for(auto &kv : this->requestHeaders)
@@ -158,13 +211,6 @@ public:
      */
     virtual ~CurlHttpOperation()
     {
-        // Given the request has not been aborted we should wait for completion here
-        // This guarantees the lifetime of this request.
-        if (result.valid())
-        {
-            result.wait();
-        }
-        DispatchEvent(OnDestroy);
         res = CURLE_OK;
         curl_easy_cleanup(curl);
         curl_slist_free_all(m_headersChunk);
@@ -172,9 +218,12 @@ public:
     }
 
     /**
-     * Send request synchronously
+     * Configure the easy handle for the transfer. The transfer itself is
+     * performed by the multi handle of HttpClient_Curl.
+     *
+     * @return false if the request cannot be sent
      */
-    long Send()
+    bool Prepare()
     {
         TRACE("method=%s\n", this->m_method.c_str());
 
@@ -187,48 +236,9 @@ public:
         {
             res = CURLE_FAILED_INIT;
             DispatchEvent(OnSendFailed);
-            goto cleanup;
+            return false;
         }
 
-        // TODO: should we control what local source port we use?
-        // curl_easy_setopt(curl, CURLOPT_LOCALPORT, dcf_port);
-
-        // Perform initial connect, handling the timeout if needed
-        curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 1L);
-        DispatchEvent(OnConnecting);
-        res = curl_easy_perform(curl);
-        if(CURLE_OK != res)
-        {
-            DispatchEvent(OnConnectFailed);     // couldn't connect - stage 1
-            TRACE("Error #1: %s\n", curl_easy_strerror(res));
-            goto cleanup;
-        }
-
-        /* Extract the socket from the curl handle - we'll need it for waiting.
-         * Note that this API takes a pointer to a 'long' while we use
-         * curl_socket_t for sockets otherwise.
-         */
-        res = curl_easy_getinfo(curl, CURLINFO_LASTSOCKET, &sockextr);
-        if(CURLE_OK != res)
-        {
-            DispatchEvent(OnConnectFailed);     // couldn't connect - stage 2
-            TRACE("Error #2: %s\n", curl_easy_strerror(res));
-            goto cleanup;
-        }
-
-        /* wait for the socket to become ready for sending */
-        sockfd = sockextr;
-        if( !WaitOnSocket(sockfd, 0, HTTP_CONN_TIMEOUT * 1000L) || isAborted)
-        {
-            TRACE("Error #3: timeout, aborted=%u\n", isAborted.load() );
-            res = CURLE_OPERATION_TIMEDOUT;
-            DispatchEvent(OnConnectFailed);     // couldn't connect - stage 3
-            goto cleanup;
-        }
-
-        // once connection is there - switch back to easy perform for HTTP post
-        curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 0);
-
         // send all data to our callback function
         if (rawResponse)
         {
@@ -254,56 +264,52 @@ public:
             // GET
         } else
         {
-            TRACE("Error #4: unsupported method %s\n", m_method.c_str());
+            TRACE("Error: unsupported method %s\n", m_method.c_str());
             res = CURLE_UNSUPPORTED_PROTOCOL;
-            goto cleanup;
+            DispatchEvent(OnSendFailed);
+            return false;
         }
 
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, static_cast<long>(httpConnTimeout));
         curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 30L);
         curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 4096);
-        DispatchEvent(OnSending);
-        res = curl_easy_perform(curl);
-        if(CURLE_OK != res)
+        DispatchEvent(OnConnecting);
+        return true;
+    }
+
+    /**
+     * Record the outcome of the transfer once the multi handle is done with it.
+     *
+     * @param code  Transfer result reported by curl_multi_info_read
+     */
+    void Complete(CURLcode code)
+    {
+        if (CURLE_OK != code)
         {
-            DispatchEvent(OnSendFailed);
-            TRACE("Error: %s\n", curl_easy_strerror(res));
-            goto cleanup;
+            res = code;
+            switch (code)
+            {
+            case CURLE_COULDNT_RESOLVE_PROXY:
+            case CURLE_COULDNT_RESOLVE_HOST:
+            case CURLE_COULDNT_CONNECT:
+            case CURLE_SSL_CONNECT_ERROR:
+                DispatchEvent(OnConnectFailed);
+                break;
+            default:
+                DispatchEvent(OnSendFailed);
+                break;
+            }
+            TRACE("Error: %s\n", curl_easy_strerror(code));
+            return;
         }
 
-        /* Code snippet to parse raw HTTP response. This might come in handy
-         * if we ever consider to handle the raw upload instead of curl_easy_perform
-       ...
-       std::string resp((const char *)response);
-       std::regex http_status_regex(HTTP_STATUS_REGEXP);
-       std::smatch match;
-       if(std::regex_search(resp, match, http_status_regex))
-         http_code = std::stol(match[1]);
-       ...
-         */
-
-        /* libcurl is nice enough to parse the response code itself: */
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &res);
-        // We got some response from server. Dump the contents.
-        TRACE("HTTP response code %d\n", res);
-        DispatchEvent(OnResponse);
-
-cleanup:
-
         // This function returns:
         // - on success: HTTP status code.
         // - on failure: CURL error code.
         // The two sets of enums (CURLE, HTTP codes) - do not intersect, so we collapse them in one set.
-        return res;
-    }
-
-    std::future<long> & SendAsync(std::function<void(CurlHttpOperation &)> callback = nullptr) {
-        result = std::async(std::launch::async, [this, callback] {
-            long result = Send();
-            if (callback!=nullptr)
-                callback(*this);
-            return result;
-        });
-        return result;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &res);
+        TRACE("HTTP response code %ld\n", res);
+        DispatchEvent(OnResponse);
     }
 
     /**
@@ -385,19 +391,12 @@ cleanup:
     }
 
     /**
-     * Abort request in connecting or reading state.
+     * Abort request in connecting or reading state. The I/O thread of
+     * HttpClient_Curl removes the transfer from the multi handle.
      */
     void Abort()
     {
         isAborted = true;
-        if (curl!=nullptr)
-        {
-            // Simply close the socket - connection reset by peer.. Ha-ha-ha-ha-ha!
-            if (sockfd) {
-                ::close(sockfd);
-                sockfd = 0;
-            }
-        }
     }
 
     CURL *GetHandle()
@@ -410,7 +409,7 @@ protected:
     const size_t httpConnTimeout;   // Timeout for connect.  Default: 5s
 
     CURL *curl;                     // Local curl instance
-    CURLcode res = CURLE_OK;        // Curl result OR HTTP status code if successful
+    long res = CURLE_OK;            // Curl result OR HTTP status code if successful
     
     IHttpResponseCallback* m_callback = nullptr;
 
@@ -425,51 +424,6 @@ protected:
     std::vector<uint8_t>        respHeaders;
     std::vector<uint8_t>        respBody;
 
-    // Socket parameters
-    curl_socket_t sockfd = 0;
-
-    long sockextr   = 0;
-
-    curl_off_t nread = 0;
-    size_t sendlen   = 0;        // # bytes sent by client
-    size_t acklen    = 0;        // # bytes ack by server
-
-    std::future<long>       result;
-
-    /**
-     * Helper routine to wait for data on socket
-     *
-     * @param sockfd
-     * @param for_recv
-     * @param timeout_ms
-     * @return
-     */
-    static int WaitOnSocket(curl_socket_t sockfd, int for_recv, long timeout_ms)
-    {
-        struct timeval tv;
-        fd_set infd, outfd, errfd;
-        int res;
-
-        tv.tv_sec = timeout_ms / 1000;
-        tv.tv_usec = (timeout_ms % 1000) * 1000;
-
-        FD_ZERO(&infd);
-        FD_ZERO(&outfd);
-        FD_ZERO(&errfd);
-
-        FD_SET(sockfd, &errfd); /* always check for error */
-
-        if(for_recv) {
-            FD_SET(sockfd, &infd);
-        } else {
-            FD_SET(sockfd, &outfd);
-        }
-
-        /* select() returns the number of signalled sockets or -1 */
-        res = select((int)sockfd + 1, &infd, &outfd, &errfd, &tv);
-        return res;
-    }
-
     // Raw response buffer
     struct MemoryStruct {
       char *memory;
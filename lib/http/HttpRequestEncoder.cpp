@@ -151,10 +151,16 @@ namespace MAT_NS_BEGIN {
         ctx->httpRequest->GetHeaders().set("APIKey", tenantTokens);
 
         if (ctx->compressed) {
-            ctx->httpRequest->GetHeaders().add("Content-Encoding", "deflate");
+            ctx->httpRequest->GetHeaders().add("Content-Encoding", ctx->contentEncoding.empty() ? "deflate" : ctx->contentEncoding);
         }
 
 
+        if (!ctx->splicedBody.empty()) {
+            // Uncompressed upload: IHttpRequest needs the body in one piece
+            ctx->splicedBody.gather(ctx->body);
+            ctx->splicedBody.clear();
+        }
+
 #if 0
         // Debug only: uncomment to set a breakpoint - decode-verify the payload before sending it.
         CsProtocol::Record result;
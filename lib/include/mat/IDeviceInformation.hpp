@@ -61,6 +61,14 @@ namespace PAL_NS_BEGIN {
         /// </summary>
         /// <returns>Device ticket</returns>
         virtual std::string GetDeviceTicket() const = 0;
+
+        /// <summary>
+        /// Tells whether the device ID had to be derived from host details
+        /// (disks, hostname) because the platform has no stable one. Such IDs
+        /// are persisted in offline storage so that they survive host changes.
+        /// </summary>
+        /// <returns>true if the device ID is derived</returns>
+        virtual bool IsDeviceIdDerived() const { return false; }
     };
 
 } PAL_NS_END
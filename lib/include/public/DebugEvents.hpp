@@ -9,6 +9,7 @@
 
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
 #include <string>
@@ -201,7 +202,13 @@ namespace MAT_NS_BEGIN
     {
     public:
         /// <summary>The DebugEventSource constructor.</summary>
-        DebugEventSource() : seq(0) {}
+        DebugEventSource();
+
+        /// <summary>The DebugEventSource destructor.</summary>
+        virtual ~DebugEventSource() noexcept;
+
+        DebugEventSource(DebugEventSource const&) = delete;
+        DebugEventSource& operator=(DebugEventSource const&) = delete;
 
         /// <summary>Adds an event listener for the specified debug event type.</summary>
         virtual void AddEventListener(DebugEventType type, DebugEventListener &listener);
@@ -232,13 +239,27 @@ namespace MAT_NS_BEGIN
         }
 #endif
 
+        /// <summary>Sequence number of the last dispatched event.</summary>
+        uint64_t lastSeq() const;
+
+        /// <summary>
+        /// Publishes listeners and cascaded to DispatchEvent. Called under stateLock()
+        /// after every change to them.
+        /// </summary>
+        void publish();
+
         /// <summary>A collection of debug event listeners.</summary>
         std::map<unsigned, std::vector<DebugEventListener*> > listeners;
 
         /// <summary>A collection of cascaded debug event sources.</summary>
         std::set<DebugEventSource*> cascaded;
 
-        uint64_t seq;
+        /// <summary>
+        /// Lock-free view of listeners and cascaded read by DispatchEvent.
+        /// Opaque so that the layout does not depend on std::atomic, which managed code cannot use.
+        /// </summary>
+        struct DispatchState;
+        std::unique_ptr<DispatchState> dispatchState;
     };
 #ifdef _MSC_VER
 #pragma warning( pop )
@@ -564,6 +564,7 @@ namespace MAT_NS_BEGIN
         DROPPED_REASON_SERVER_DECLINED_5XX,
         DROPPED_REASON_SERVER_DECLINED_OTHER,
         DROPPED_REASON_RETRY_EXCEEDED,
+        DROPPED_REASON_INGESTION_QUEUE_OVERFLOW,
         DROPPED_REASON_COUNT
     };
 
@@ -23,6 +23,8 @@
 namespace MAT_NS_BEGIN
 {
     struct EventPropertiesStorage;
+    class EventPropertiesDecorator;
+    class EventPropertiesBondEncoder;
 
     /// <summary>
     /// The EventProperties class encapsulates event properties.
@@ -367,6 +369,8 @@ namespace MAT_NS_BEGIN
 #endif
 
        private:
+        friend class EventPropertiesDecorator;
+        friend class EventPropertiesBondEncoder;
         EventPropertiesStorage* m_storage;
     };
 } MAT_NS_END
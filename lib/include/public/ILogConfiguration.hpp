@@ -134,6 +134,12 @@ namespace MAT_NS_BEGIN
     /// </summary>
     static constexpr const char* const CFG_INT_CACHE_FILE_SIZE = "cacheFileSizeLimitInBytes";
 
+    /// <summary>
+    /// The offline storage backend: "sqlite" (default) or "segments" for
+    /// memory-mapped append-only segment files next to the cache file-path.
+    /// </summary>
+    static constexpr const char* const CFG_STR_CACHE_STORAGE_TYPE = "cacheStorageType";
+
     /// <summary>
     /// The RAM queue size limit in bytes.
     /// </summary>
@@ -144,11 +150,44 @@ namespace MAT_NS_BEGIN
     /// </summary>
     static constexpr const char* const CFG_INT_RAM_QUEUE_BUFFERS = "maxDBFlushQueues";
 
+    /// <summary>
+    /// Size in bytes of each of the two memory-mapped files next to the cache
+    /// file-path that journal the RAM queue, so that its events survive a crash.
+    /// Should be at least twice the RAM queue size limit. 0 (default) disables the journal.
+    /// </summary>
+    static constexpr const char* const CFG_INT_RAM_QUEUE_JOURNAL_SIZE = "cacheMemoryJournalSizeInBytes";
+
     /// <summary>
     /// SQLite DB will be checkpointed when flushing.
     /// </summary>
     static constexpr const char* const CFG_BOOL_CHECKPOINT_DB_ON_FLUSH = "checkpointDBOnFlush";
 
+    /// <summary>
+    /// Capacity (in events) of the lock-free queue between ILogger callers and the worker thread.
+    /// When set to 0 (default), events are decorated and serialized synchronously on the caller thread.
+    /// Otherwise the event record is moved into the queue, and EVT_LOG_EVENT debug events carry an empty record.
+    /// </summary>
+    static constexpr const char* const CFG_INT_INGESTION_QUEUE_SIZE = "ingestionQueueSize";
+
+    /// <summary>
+    /// Ingestion queue overflow policy: "dropNewest" (default), "dropOldest" or "block".
+    /// </summary>
+    static constexpr const char* const CFG_STR_INGESTION_QUEUE_OVERFLOW = "ingestionQueueOverflowPolicy";
+
+    /// <summary>
+    /// Maximum time in milliseconds a caller waits for queue space with the "block" overflow policy.
+    /// </summary>
+    static constexpr const char* const CFG_INT_INGESTION_QUEUE_BLOCK_TIME = "ingestionQueueBlockTimeMs";
+
+    /// <summary>
+    /// Serialize event properties passed to ILogger::LogEvent straight into the Bond
+    /// blob, without copying them into the intermediate record first. The same goes for
+    /// the app, device, os and user Part A extensions of the semantic context. EVT_LOG_EVENT
+    /// debug events then carry a record without them and without Part B and Part C properties.
+    /// Custom decorators and data inspectors still receive the complete record.
+    /// </summary>
+    static constexpr const char* const CFG_BOOL_DIRECT_BOND_ENCODING = "directBondEncoding";
+
     /// <summary>
     /// The trace level mask.
     /// </summary>
@@ -261,6 +300,14 @@ namespace MAT_NS_BEGIN
     /// </summary>
     static constexpr const char* const CFG_MODULE_TASK_DISPATCHER = "taskDispatcher";
 
+    /// <summary>
+    /// Number of worker threads of the default task dispatcher, read when the
+    /// first LogManager starts the PAL. Each LogManager gets its own serial
+    /// queue on these workers, so different instances run in parallel while
+    /// the tasks of one instance still run one at a time. Default value: 1
+    /// </summary>
+    static constexpr const char* const CFG_INT_TASK_DISPATCHER_WORKERS = "taskDispatcherWorkers";
+
     /// <summary>
     /// IDataViewer override module
     /// </summary>
@@ -326,6 +373,52 @@ namespace MAT_NS_BEGIN
     /// </summary>
     static constexpr const char* const CFG_BOOL_METASTATS_SPLIT = "split";
 
+    /// <summary>
+    /// MetaStats configuration: time each stage of the event pipeline and
+    /// report per-stage call counts and latency percentiles, in stats events
+    /// and through ILogManager::GetStageLatencies. Default value: false
+    /// </summary>
+    static constexpr const char* const CFG_BOOL_METASTATS_STAGE_TIMING = "stageTiming";
+
+    /// <summary>
+    /// Early drop and sampling rules, checked by the logger before an event
+    /// is decorated. Each entry maps a rule name, used for the per-rule drop
+    /// counts in stats events (rule_NAME_drp), to a map of the
+    /// CFG_*_EVENT_RULE_* settings below. When several rules match an event,
+    /// the one with the most specific name wins, then the one with the most
+    /// conditions, then the first by rule name.
+    /// </summary>
+    static constexpr const char* const CFG_MAP_EVENT_RULES = "eventRules";
+
+    /// <summary>
+    /// Event rule: event name, matched case-insensitively. A trailing '*'
+    /// matches every name with that prefix. Default value: "*" (all events)
+    /// </summary>
+    static constexpr const char* const CFG_STR_EVENT_RULE_NAME = "name";
+
+    /// <summary>
+    /// Event rule: only events logged with this tenant token. Default: any tenant
+    /// </summary>
+    static constexpr const char* const CFG_STR_EVENT_RULE_TENANT = "tenant";
+
+    /// <summary>
+    /// Event rule: only events of this diagnostic level, set with
+    /// COMMONFIELDS_EVENT_LEVEL or inherited from the logger. Default: any level
+    /// </summary>
+    static constexpr const char* const CFG_INT_EVENT_RULE_LEVEL = "level";
+
+    /// <summary>
+    /// Event rule: "drop" every matching event, "sample" to keep one in
+    /// CFG_INT_EVENT_RULE_RATE, or "rateLimit" to keep at most
+    /// CFG_INT_EVENT_RULE_RATE per second. Default value: "drop"
+    /// </summary>
+    static constexpr const char* const CFG_STR_EVENT_RULE_ACTION = "action";
+
+    /// <summary>
+    /// Event rule: sampling ratio or events per second, see CFG_STR_EVENT_RULE_ACTION
+    /// </summary>
+    static constexpr const char* const CFG_INT_EVENT_RULE_RATE = "rate";
+
     /// <summary>
     /// Compatibility configuration
     /// </summary>
@@ -361,6 +454,35 @@ namespace MAT_NS_BEGIN
     /// </summary>
     static constexpr const char* const CFG_BOOL_HTTP_COMPRESSION = "compress";
 
+    /// <summary>
+    /// HTTP configuration: request compression format, also sent as the
+    /// Content-Encoding header. One of "deflate" (raw deflate), "gzip",
+    /// "deflate-dict" (zlib stream with the Common Schema preset dictionary)
+    /// or "zstd" (when built with zstd support). Default value: "deflate"
+    /// </summary>
+    static constexpr const char* const CFG_STR_HTTP_CONTENT_ENCODING = "contentEncoding";
+
+    /// <summary>
+    /// HTTP configuration: compression level, from 0 (none) to 9 (best) for
+    /// the deflate formats and from 1 to 19 for zstd.
+    /// Default value: -1 (library default, 6 for zlib and 3 for zstd)
+    /// </summary>
+    static constexpr const char* const CFG_INT_HTTP_COMPRESSION_LEVEL = "compressionLevel";
+
+    /// <summary>
+    /// HTTP configuration: zlib compression strategy, one of "default",
+    /// "filtered", "huffman", "rle" or "fixed". Default value: "default"
+    /// </summary>
+    static constexpr const char* const CFG_STR_HTTP_COMPRESSION_STRATEGY = "compressionStrategy";
+
+    /// <summary>
+    /// HTTP configuration: compress records as they are added to an upload
+    /// package, overlapping compression with the storage read. Records are
+    /// then sent in retrieval order rather than grouped by tenant.
+    /// Default value: false
+    /// </summary>
+    static constexpr const char* const CFG_BOOL_HTTP_STREAMING_COMPRESSION = "streamingCompression";
+
     /// <summary>
     /// TPM configuration map
     /// </summary>
@@ -386,6 +508,21 @@ namespace MAT_NS_BEGIN
     /// </summary>
     static constexpr const char* const CFG_BOOL_TPM_CLOCK_SKEW_ENABLED = "clockSkewEnabled";
 
+    /// <summary>
+    /// TPM configuration: time in milliseconds to hold back the upload for an
+    /// event above EventLatency_RealTime, so that events arriving in a burst
+    /// share one HTTP request. 0 uploads each such event on its own.
+    /// Default value: 0
+    /// </summary>
+    static constexpr const char* const CFG_INT_TPM_IMMEDIATE_WINDOW_MS = "immediateWindowMs";
+
+    /// <summary>
+    /// TPM configuration: number of events above EventLatency_RealTime that
+    /// closes the coalescing window early. 0 waits for the full window.
+    /// Default value: 0
+    /// </summary>
+    static constexpr const char* const CFG_INT_TPM_IMMEDIATE_WINDOW_EVENTS = "immediateWindowEvents";
+
     /// <summary>
     /// When enabled, the session timer is reset after session is completed, allowing for several session events in the duration of the SDK lifecycle
     /// </summary>
@@ -21,6 +21,7 @@
 #include "ISemanticContext.hpp"
 #include "LogConfiguration.hpp"
 #include "LogSessionData.hpp"
+#include "StageLatency.hpp"
 
 #include "DebugEvents.hpp"
 #include "TransmitProfiles.hpp"
@@ -403,6 +404,14 @@ namespace MAT_NS_BEGIN
         /// <returns>Selected instance of IDataInspector if available, nullptr otherwise.</returns>
         virtual std::shared_ptr<IDataInspector> GetDataInspector() noexcept { return GetDataInspector(std::string{}); }
 
+        /// <summary>
+        /// Get call counts and latency percentiles of the event pipeline stages.
+        /// Stages are only timed when enabled with the stageTiming entry of
+        /// CFG_MAP_METASTATS_CONFIG.
+        /// </summary>
+        /// <returns>One entry per timed stage, empty when timing is disabled.</returns>
+        virtual std::vector<StageLatency> GetStageLatencies() { return {}; }
+
         /// <summary>
         /// Ask the log manager to pause activity
         /// </summary>
@@ -434,6 +434,20 @@ Refer to https://osgwiki.com/wiki/Common_Schema_Event_Overrides for details on t
         /// <param name="properties">Properties of this custom event, specified using an EventProperties object.</param>
         virtual void LogEvent(EventProperties const& properties) = 0;
 
+        /// <summary>
+        /// Logs a batch of custom events. Each event is filtered and decorated as by
+        /// LogEvent, but the batch is handed to the telemetry pipeline as a whole, so
+        /// locks are taken and the offline storage is written once per batch.
+        /// </summary>
+        /// <param name="events">Properties of the custom events, in the order they are logged.</param>
+        virtual void LogEvents(std::vector<EventProperties> const& events)
+        {
+            for (auto const& properties : events)
+            {
+                LogEvent(properties);
+            }
+        }
+
         /// <summary>
         /// Logs a failure event - such as an application exception.
         /// </summary>
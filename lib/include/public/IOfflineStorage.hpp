@@ -33,6 +33,11 @@ namespace MAT_NS_BEGIN {
         StorageBlob     blob;
         int             retryCount = 0;
         int64_t         reservedUntil = 0;
+        // Handle of tenantToken in the SDK's tenant registry, 0 if not known.
+        // Records of logged events carry the handle only, with tenantToken
+        // empty, until they are handed to the disk storage, which always gets
+        // the token. Not persisted: records read back from it leave it at 0.
+        uint32_t        tenantHandle = 0;
 #ifdef HAVE_MAT_EVT_TRACEID 
         std::string     traceId;
 #endif // HAVE_MAT_EVT_TRACEID
@@ -190,9 +195,11 @@ namespace MAT_NS_BEGIN {
         /// The offline storage might need to trim the oldest events before
         /// inserting the new one in order to maintain its configured size limit.
         /// Called from the internal worker thread.
+        /// The records stored are moved to the front of the vector, in their
+        /// original order, so that a caller can tell which of them to retry.
         /// </remarks>
         /// <param name="record">Record data to store</param>
-        /// <returns>Number of records stored</returns>
+        /// <returns>Number of records stored, at the front of records</returns>
         virtual size_t StoreRecords(StorageRecordVector & records) = 0;
 
         /// <summary>
@@ -211,7 +218,9 @@ namespace MAT_NS_BEGIN {
         /// accepted by the consumer are reserved for the specified amount of time
         /// <paramref name="leaseTimeMs"/> and will not be returned again by this
         /// method until explicitly released or deleted or until their reservation
-        /// period expires. Called from the internal worker thread.
+        /// period expires. The consumer is lent each record for the duration of
+        /// its call only, and copies what it needs to keep. Called from the
+        /// internal worker thread.
         /// <param name="consumer">Callback functor processing the individual
         /// retrieved records</param>
         /// <param name="leaseTimeMs">Amount of time all acccepted records should
@@ -223,7 +232,7 @@ namespace MAT_NS_BEGIN {
         /// really accepted by the consumer), <c>false</c> if an error occurred and
         /// the retrieval ended prematurely, records could not be reserved
         /// etc.</returns>
-        virtual bool GetAndReserveRecords(std::function<bool(StorageRecord&&)> const& consumer, unsigned leaseTimeMs,
+        virtual bool GetAndReserveRecords(std::function<bool(StorageRecord const&)> const& consumer, unsigned leaseTimeMs,
             EventLatency minLatency = EventLatency_Unspecified, unsigned maxCount = 0) = 0;
 
         /// <summary>
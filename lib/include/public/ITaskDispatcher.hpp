@@ -9,6 +9,7 @@
 #include "ctmacros.hpp"
 
 #include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -121,6 +122,18 @@ namespace MAT_NS_BEGIN
         /// <param name="waitTime">Amount of time to wait for if the task is currently executing</param>
         /// <returns>True if successfully cancelled, else false</returns>
         virtual bool Cancel(Task* task, uint64_t waitTime = 0) = 0;
+
+        /// <summary>
+        /// Create a serial queue sharing the worker threads of this dispatcher. Tasks
+        /// queued to it run one at a time, in the same order as on a single worker
+        /// thread, while tasks of other queues may run in parallel. Each LogManager
+        /// queues its tasks to a serial queue of its dispatcher when one is available.
+        /// </summary>
+        /// <returns>New serial queue, or nullptr if the dispatcher runs all of its tasks one at a time</returns>
+        virtual std::shared_ptr<ITaskDispatcher> CreateSerialQueue()
+        {
+            return nullptr;
+        }
     };
 
     /// @endcond
@@ -162,6 +162,7 @@ namespace MAT_NS_BEGIN
     /// logmanager     - ILogManager pointer to SDK instance
     /// config         - ILogConfiguration
     /// ctx_data       - original JSON configuration or token passed to mat_open
+    /// scope          - context scope of the loggers, resolved from config by mat_open
     /// http           - optional IHttpClient override instance
     /// taskDispatcher - optional ITaskDispatcher override instance
     /// </summary>
@@ -170,6 +171,7 @@ namespace MAT_NS_BEGIN
         ILogManager*                     logmanager = nullptr;
         ILogConfiguration                config;
         std::string                      ctx_data;
+        std::string                      scope;
         std::shared_ptr<IHttpClient>     http;
         std::shared_ptr<ITaskDispatcher> taskDispatcher;
     } capi_client;
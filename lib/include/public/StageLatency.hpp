@@ -0,0 +1,35 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef STAGELATENCY_HPP
+#define STAGELATENCY_HPP
+
+#include "ctmacros.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Call count and latency distribution of one stage of the event
+    /// pipeline, see ILogManager::GetStageLatencies. Times are in nanoseconds
+    /// and exclude nested stages that ran on the same thread. Percentiles
+    /// are upper bounds, within 12.5% of the exact value.
+    /// </summary>
+    struct StageLatency
+    {
+        std::string name;
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+        uint64_t p50Ns = 0;
+        uint64_t p90Ns = 0;
+        uint64_t p99Ns = 0;
+        uint64_t maxNs = 0;
+    };
+
+}
+MAT_NS_END
+
+#endif
@@ -75,7 +75,14 @@ extern "C" {
          */
         EVT_OP_SET_LOGGER_CONTEXT = 0x0000000D,
         EVT_OP_SET_LOGMANAGER_CONTEXT = 0x0000000E,
-        EVT_OP_MAX = EVT_OP_SET_LOGMANAGER_CONTEXT + 1,
+        /**
+         * Logger handle operations allow a guest to resolve the logger for a tenant token
+         * and event source once, then log through the logger handle without the per-event
+         * logger lookup that EVT_OP_LOG performs.
+         */
+        EVT_OP_GET_LOGGER = 0x0000000F,
+        EVT_OP_LOG_WITH_LOGGER = 0x00000010,
+        EVT_OP_MAX = EVT_OP_LOG_WITH_LOGGER + 1,
         EVT_OP_MAXINT = 0xFFFFFFFF
     } evt_call_t;
 
@@ -186,6 +193,17 @@ MATSDK_PACK_POP
         int32_t                 paramsCount;
     } evt_open_with_params_data_t;
 
+    /**
+     * <summary>
+     * Identifies the logger requested with 'evt_get_logger'
+     * </summary>
+     */
+    typedef struct evt_logger_params_t
+    {
+        const char*             token;
+        const char*             source;
+    } evt_logger_params_t;
+
     typedef union evt_prop_v
     {
         /* Basic types */
@@ -638,6 +656,61 @@ MATSDK_PACK_POP
         return evt_sendprops(handle, EVT_OP_SET_LOGMANAGER_CONTEXT, evt);
     }
 
+    /**
+     * <summary>
+     * Resolves the logger for a tenant token and event source. The returned logger handle
+     * stays valid until the SDK instance is closed. Closing the instance waits for calls
+     * still logging through the handle, and later calls with it fail with ENOENT.
+     * Up to 1024 logger handles can be in use at once.
+     * </summary>
+     * <param name="handle">SDK handle.</param>
+     * <param name="token">Tenant token, or NULL for the primary token.</param>
+     * <param name="source">Event source, or NULL.</param>
+     * <returns>Logger handle, or 0 on failure.</returns>
+     */
+    static inline evt_handle_t evt_get_logger(evt_handle_t handle, const char* token, const char* source)
+    {
+        evt_logger_params_t params;
+        evt_context_t ctx;
+
+        params.token = token;
+        params.source = source;
+
+        ctx.call = EVT_OP_GET_LOGGER;
+        ctx.handle = handle;
+        ctx.data = (void *)(&params);
+        return (evt_api_call(&ctx) == 0) ? ctx.handle : 0;
+    }
+
+    /**
+     * <summary>
+     * Logs a telemetry event through a logger handle obtained with evt_get_logger (security-enhanced _s function).
+     * The iKey property, if any, is ignored: the logger handle identifies the tenant.
+     * </summary>
+     * <param name="logger">Logger handle.</param>
+     * <param name="size">Number of event properties in array.</param>
+     * <param name="evt">Event properties array.</param>
+     * <returns>Status code.</returns>
+     */
+    static inline evt_status_t evt_log_with_logger_s(evt_handle_t logger, uint32_t size, evt_prop* evt)
+    {
+        return evt_sendprops_s(logger, EVT_OP_LOG_WITH_LOGGER, size, evt);
+    }
+
+    /**
+     * <summary>
+     * Logs a telemetry event through a logger handle obtained with evt_get_logger.
+     * Last item in evt_prop array must be { .name = NULL, .type = TYPE_NULL }
+     * </summary>
+     * <param name="logger">Logger handle.</param>
+     * <param name="evt">Event properties array.</param>
+     * <returns>Status code.</returns>
+     */
+    static inline evt_status_t evt_log_with_logger(evt_handle_t logger, evt_prop* evt)
+    {
+        return evt_sendprops(logger, EVT_OP_LOG_WITH_LOGGER, evt);
+    }
+
     /* This macro automagically calculates the array size and passes it down to evt_log_s.
      * Developers don't have to calculate the number of event properties passed down to
      *'Log Event' API call utilizing the concept of Secure Template Overloads:
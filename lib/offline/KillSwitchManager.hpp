@@ -6,6 +6,7 @@
 #define KILLSWITCHMANAGER_HPP
 
 #include "pal/PAL.hpp"
+#include "system/TenantRegistry.hpp"
 
 #include <map>
 #include <string>
@@ -91,7 +92,9 @@ namespace MAT_NS_BEGIN {
             std::lock_guard<std::mutex> guard(m_lock);
             if (timeInSeconds > 0)
             {
-                m_tokenTime[tokenId] = PAL::getUtcSystemTime() + timeInSeconds; //convert milisec to sec
+                int64_t expiryTime = PAL::getUtcSystemTime() + timeInSeconds; //convert milisec to sec
+                m_tokenTime[tokenId] = expiryTime;
+                m_handleTime[TenantRegistry::instance().Register(tokenId)] = expiryTime;
             }
         }
 
@@ -99,22 +102,14 @@ namespace MAT_NS_BEGIN {
         {
             std::lock_guard<std::mutex> guard(m_lock);
 
-            if (m_isRetryAfterActive)
+            if (isRetryAfterBlocking())
             {
-                if (m_retryAfterExpiryTime > PAL::getUtcSystemTime())
-                {
-                    return true;//always return true for all tokens
-                }
-                else
-                {
-                    m_retryAfterExpiryTime = 0;
-                    m_isRetryAfterActive = false;
-                }
+                return true;//always return true for all tokens
             }
             std::map<std::string, int64_t>::iterator iter = m_tokenTime.find(tokenId);
             if (iter != m_tokenTime.end())
             {//found, check the time stamp
-                int64_t timeStamp = m_tokenTime[tokenId];
+                int64_t timeStamp = iter->second;
 
                 if (timeStamp > PAL::getUtcSystemTime())  //convert milisec to sec
                 {
@@ -122,8 +117,35 @@ namespace MAT_NS_BEGIN {
                 }
                 else
                 { //remove the entry for this token as this has expired
-                    m_tokenTime.erase(tokenId);
+                    m_tokenTime.erase(iter);
+                    m_handleTime.erase(TenantRegistry::instance().Find(tokenId));
+                }
+            }
+
+            return false;
+        }
+
+        /// <summary>
+        /// Same as isTokenBlocked, for a token registered in the TenantRegistry.
+        /// Compares handles instead of token strings.
+        /// </summary>
+        bool isTokenBlocked(TenantHandle tenant)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+
+            if (isRetryAfterBlocking())
+            {
+                return true;
+            }
+            auto iter = m_handleTime.find(tenant);
+            if (iter != m_handleTime.end())
+            {
+                if (iter->second > PAL::getUtcSystemTime())
+                {
+                    return true;
                 }
+                m_handleTime.erase(iter);
+                m_tokenTime.erase(TenantRegistry::instance().Token(tenant));
             }
 
             return false;
@@ -135,7 +157,8 @@ namespace MAT_NS_BEGIN {
             std::map<std::string, int64_t>::iterator iter = m_tokenTime.find(tokenId);
             if (iter != m_tokenTime.end())
             {//found, check the time stamp
-                m_tokenTime.erase(tokenId);
+                m_tokenTime.erase(iter);
+                m_handleTime.erase(TenantRegistry::instance().Find(tokenId));
             }
         }
 
@@ -156,7 +179,24 @@ namespace MAT_NS_BEGIN {
         }
 
     private:
+        // Called under m_lock
+        bool isRetryAfterBlocking()
+        {
+            if (m_isRetryAfterActive)
+            {
+                if (m_retryAfterExpiryTime > PAL::getUtcSystemTime())
+                {
+                    return true;
+                }
+                m_retryAfterExpiryTime = 0;
+                m_isRetryAfterActive = false;
+            }
+            return false;
+        }
+
         std::map<std::string, int64_t> m_tokenTime;
+        // Same expiry times as m_tokenTime, keyed by TenantRegistry handle
+        std::map<TenantHandle, int64_t> m_handleTime;
         std::mutex      m_lock;
         bool            m_isRetryAfterActive;
         int64_t         m_retryAfterExpiryTime;
@@ -0,0 +1,302 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "MemoryJournal.hpp"
+#include "system/TenantRegistry.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+
+namespace MAT_NS_BEGIN {
+
+    namespace {
+
+        constexpr uint32_t kJournalMagic = 0x514D5254;   // "TRMQ"
+        constexpr uint32_t kJournalVersion = 1;
+
+        constexpr uint8_t kKindRecord = 1;
+        constexpr uint8_t kKindDelete = 2;
+
+        // The file with the higher generation is the journal, the other one
+        // is where the next Rewrite goes.
+        struct JournalHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t generation;
+        };
+
+        // Entries start at multiples of 8 bytes; size includes the padding.
+        // The header is followed by the ID, the tenant token and the blob.
+        // An entry is valid when generation matches the file's: it is
+        // written after the rest of the entry, which makes it the commit
+        // point, and tells entries of earlier generations apart.
+        struct EntryHeader
+        {
+            uint32_t size;
+            uint32_t generation;
+            uint32_t blobSize;
+            uint16_t idSize;
+            uint16_t tokenSize;
+            uint8_t kind;
+            uint8_t latency;
+            uint8_t persistence;
+            uint8_t reserved;
+            int32_t retryCount;
+            int64_t timestamp;
+        };
+
+        static_assert(sizeof(JournalHeader) == 16, "JournalHeader must not be padded");
+        static_assert(sizeof(EntryHeader) == 32, "EntryHeader must not be padded");
+
+        size_t align8(size_t size)
+        {
+            return (size + 7) & ~static_cast<size_t>(7);
+        }
+
+        JournalHeader journalHeader(MappedFile const& file)
+        {
+            JournalHeader header;
+            memcpy(&header, file.Data(), sizeof(header));
+            return header;
+        }
+
+        bool isValid(JournalHeader const& header)
+        {
+            return header.magic == kJournalMagic && header.version == kJournalVersion && header.generation != 0;
+        }
+
+        uint32_t entryGeneration(uint64_t generation)
+        {
+            return static_cast<uint32_t>(generation);
+        }
+    }
+
+    MATSDK_LOG_INST_COMPONENT_CLASS(MemoryJournal, "EventsSDK.MemoryJournal", "Events telemetry client - MemoryJournal class");
+
+    MemoryJournal::MemoryJournal(std::string const& path, size_t size) :
+        m_path(path),
+        m_size(align8(std::max(size, sizeof(JournalHeader) + sizeof(EntryHeader))))
+    {
+    }
+
+    MemoryJournal::~MemoryJournal()
+    {
+        Close();
+    }
+
+    bool MemoryJournal::Open(std::vector<StorageRecord>& recovered)
+    {
+        LOCKGUARD(m_lock);
+        for (size_t i = 0; i < 2; i++)
+        {
+            if (!m_files[i].Open(m_path + ".ramq" + std::to_string(i), m_size))
+            {
+                LOG_ERROR("Failed to map RAM queue journal %s.ramq%zu", m_path.c_str(), i);
+                m_files[0].Close();
+                m_files[1].Close();
+                return false;
+            }
+        }
+
+        JournalHeader headers[2] = { journalHeader(m_files[0]), journalHeader(m_files[1]) };
+        size_t newest = (isValid(headers[1]) && (!isValid(headers[0]) || headers[1].generation > headers[0].generation)) ? 1 : 0;
+        m_active = &m_files[newest];
+        if (isValid(headers[newest]))
+        {
+            m_generation = headers[newest].generation;
+            m_offset = replay(*m_active, m_generation, recovered);
+            LOG_INFO("Recovered %zu records from RAM queue journal %s.ramq%zu", recovered.size(), m_path.c_str(), newest);
+        }
+        else
+        {
+            m_generation = 1;
+            JournalHeader header { kJournalMagic, kJournalVersion, m_generation };
+            memcpy(m_active->Data(), &header, sizeof(header));
+            m_offset = sizeof(JournalHeader);
+        }
+        m_rewriteEnd = m_offset;
+        m_full = false;
+        m_truncated = false;
+        return true;
+    }
+
+    void MemoryJournal::Close() noexcept
+    {
+        LOCKGUARD(m_lock);
+        m_active = nullptr;
+        m_files[0].Close();
+        m_files[1].Close();
+    }
+
+    size_t MemoryJournal::replay(MappedFile const& file, uint64_t generation, std::vector<StorageRecord>& recovered) const
+    {
+        std::unordered_map<std::string, size_t> positions;
+        std::vector<bool> deleted;
+        std::vector<StorageRecord> records;
+
+        uint8_t const* data = file.Data();
+        size_t offset = sizeof(JournalHeader);
+        while (offset + sizeof(EntryHeader) <= file.Size())
+        {
+            EntryHeader header;
+            memcpy(&header, data + offset, sizeof(header));
+            if (header.generation != entryGeneration(generation) || header.size < sizeof(EntryHeader) || header.size % 8 != 0 ||
+                offset + header.size > file.Size() || sizeof(EntryHeader) + header.idSize + header.tokenSize + header.blobSize > header.size ||
+                header.latency > EventLatency_Max)
+            {
+                break;
+            }
+
+            char const* text = reinterpret_cast<char const*>(data + offset + sizeof(EntryHeader));
+            std::string id(text, header.idSize);
+            auto it = positions.find(id);
+            if (it != positions.end())
+            {
+                deleted[it->second] = true;
+                positions.erase(it);
+            }
+            if (header.kind == kKindRecord)
+            {
+                uint8_t const* blob = data + offset + sizeof(EntryHeader) + header.idSize + header.tokenSize;
+                StorageRecord record(id, std::string(text + header.idSize, header.tokenSize),
+                    static_cast<EventLatency>(header.latency), static_cast<EventPersistence>(header.persistence),
+                    header.timestamp, StorageBlob(blob, blob + header.blobSize), header.retryCount);
+                positions[id] = records.size();
+                records.push_back(std::move(record));
+                deleted.push_back(false);
+            }
+            offset += header.size;
+        }
+
+        for (size_t i = 0; i < records.size(); i++)
+        {
+            if (!deleted[i])
+            {
+                recovered.push_back(std::move(records[i]));
+            }
+        }
+        return offset;
+    }
+
+    bool MemoryJournal::append(uint8_t kind, StorageRecordId const& id, StorageRecord const* record) noexcept
+    {
+        std::string const* token = (record != nullptr) ? &TenantRegistry::instance().Token(*record) : nullptr;
+        size_t tokenSize = (token != nullptr) ? token->size() : 0;
+        size_t blobSize = (record != nullptr) ? record->blob.size() : 0;
+        size_t size = align8(sizeof(EntryHeader) + id.size() + tokenSize + blobSize);
+        if (id.size() > UINT16_MAX || tokenSize > UINT16_MAX || size > UINT32_MAX || m_offset + size > m_size)
+        {
+            m_full = true;
+            return false;
+        }
+
+        uint8_t* data = m_active->Data() + m_offset;
+        EntryHeader header {};
+        header.size = static_cast<uint32_t>(size);
+        header.blobSize = static_cast<uint32_t>(blobSize);
+        header.idSize = static_cast<uint16_t>(id.size());
+        header.tokenSize = static_cast<uint16_t>(tokenSize);
+        header.kind = kind;
+        if (record != nullptr)
+        {
+            header.latency = static_cast<uint8_t>(record->latency);
+            header.persistence = static_cast<uint8_t>(record->persistence);
+            header.retryCount = record->retryCount;
+            header.timestamp = record->timestamp;
+        }
+        uint8_t* payload = data + sizeof(EntryHeader);
+        memcpy(payload, id.data(), id.size());
+        if (record != nullptr)
+        {
+            memcpy(payload + id.size(), token->data(), tokenSize);
+            if (blobSize != 0)
+            {
+                memcpy(payload + id.size() + tokenSize, record->blob.data(), blobSize);
+            }
+        }
+        memcpy(data, &header, sizeof(header));
+        std::atomic_thread_fence(std::memory_order_release);
+        uint32_t generation = entryGeneration(m_generation);
+        memcpy(data + offsetof(EntryHeader, generation), &generation, sizeof(generation));
+        m_offset += size;
+        return true;
+    }
+
+    bool MemoryJournal::Append(StorageRecord const& record) noexcept
+    {
+        LOCKGUARD(m_lock);
+        return IsOpen() && append(kKindRecord, record.id, &record);
+    }
+
+    void MemoryJournal::Delete(StorageRecordId const& id) noexcept
+    {
+        LOCKGUARD(m_lock);
+        if (IsOpen())
+        {
+            append(kKindDelete, id, nullptr);
+        }
+    }
+
+    size_t MemoryJournal::Rewrite(std::vector<StorageRecord const*> const& records) noexcept
+    {
+        LOCKGUARD(m_lock);
+        if (!IsOpen())
+        {
+            return 0;
+        }
+
+        // Entries go to the other file, which the journal switches to when
+        // its header is written with the next generation
+        MappedFile* target = (m_active == &m_files[0]) ? &m_files[1] : &m_files[0];
+        uint64_t generation = m_generation + 1;
+        if (entryGeneration(generation) == 0)
+        {
+            generation++;
+        }
+        m_active = target;
+        m_generation = generation;
+        m_offset = sizeof(JournalHeader);
+        m_full = false;
+
+        size_t written = 0;
+        for (StorageRecord const* record : records)
+        {
+            if (!append(kKindRecord, record->id, record))
+            {
+                break;
+            }
+            written++;
+        }
+        m_truncated = (written < records.size());
+        if (m_truncated)
+        {
+            LOG_WARN("RAM queue journal is too small, %zu of %zu records are not journaled", records.size() - written, records.size());
+        }
+
+        std::atomic_thread_fence(std::memory_order_release);
+        JournalHeader header { kJournalMagic, kJournalVersion, generation };
+        memcpy(target->Data(), &header, sizeof(header));
+        m_rewriteEnd = m_offset;
+        m_full = false;
+        return written;
+    }
+
+    bool MemoryJournal::NeedsRewrite() const
+    {
+        LOCKGUARD(m_lock);
+        // After a Rewrite that did not fit, only deletions make room again
+        return IsOpen() && ((m_full && !m_truncated) || (m_offset - m_rewriteEnd) * 2 > (m_size - m_rewriteEnd));
+    }
+
+    size_t MemoryJournal::GetUsedSize() const
+    {
+        LOCKGUARD(m_lock);
+        return IsOpen() ? m_offset : 0;
+    }
+
+} MAT_NS_END
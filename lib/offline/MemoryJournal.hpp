@@ -0,0 +1,98 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef MEMORYJOURNAL_HPP
+#define MEMORYJOURNAL_HPP
+
+#include "pal/PAL.hpp"
+
+#include "IOfflineStorage.hpp"
+
+#include "utils/MappedFile.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MAT_NS_BEGIN {
+
+    /// <summary>
+    /// Append-only, memory-mapped journal of the records held by MemoryStorage,
+    /// so that they survive a crash of the process. Stored records and deleted
+    /// record IDs are copied into one of two files of fixed size
+    /// (&lt;cacheFilePath&gt;.ramq0 and .ramq1). Rewrite copies the records still
+    /// held into the other file and switches to it once they are all written,
+    /// which drops deleted records without ever leaving the journal half-written.
+    /// </summary>
+    class MemoryJournal
+    {
+    public:
+        MemoryJournal(std::string const& path, size_t size);
+
+        ~MemoryJournal();
+
+        MemoryJournal(MemoryJournal const&) = delete;
+        MemoryJournal& operator=(MemoryJournal const&) = delete;
+
+        /// <summary>
+        /// Maps both files and returns the records journaled and not deleted
+        /// since, in the order they were stored.
+        /// </summary>
+        bool Open(std::vector<StorageRecord>& recovered);
+
+        void Close() noexcept;
+
+        bool IsOpen() const
+        {
+            return m_active != nullptr;
+        }
+
+        /// <summary>
+        /// Journals a stored record.
+        /// </summary>
+        /// <returns>false if the journal is full</returns>
+        bool Append(StorageRecord const& record) noexcept;
+
+        /// <summary>
+        /// Journals the deletion of a stored record.
+        /// </summary>
+        void Delete(StorageRecordId const& id) noexcept;
+
+        /// <summary>
+        /// Starts over with only the given records, as far as they fit.
+        /// </summary>
+        /// <returns>Number of records journaled</returns>
+        size_t Rewrite(std::vector<StorageRecord const*> const& records) noexcept;
+
+        /// <summary>
+        /// True once a record did not fit, or half of the room left by the
+        /// last Rewrite has been used up.
+        /// </summary>
+        bool NeedsRewrite() const;
+
+        size_t GetUsedSize() const;
+
+    protected:
+        bool append(uint8_t kind, StorageRecordId const& id, StorageRecord const* record) noexcept;
+        size_t replay(MappedFile const& file, uint64_t generation, std::vector<StorageRecord>& recovered) const;
+
+        mutable std::mutex m_lock;
+        std::string        m_path;
+        size_t             m_size;
+        MappedFile         m_files[2];
+        MappedFile*        m_active = nullptr;
+        uint64_t           m_generation = 0;
+        size_t             m_offset = 0;
+        size_t             m_rewriteEnd = 0;
+        bool               m_full = false;
+        bool               m_truncated = false;
+
+        MATSDK_LOG_DECL_COMPONENT_CLASS();
+    };
+
+} MAT_NS_END
+
+#endif
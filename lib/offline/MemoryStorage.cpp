@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 #include "MemoryStorage.hpp"
+#include "system/TenantRegistry.hpp"
 
 #include "utils/StringUtils.hpp"
 #include <climits>
@@ -16,18 +17,46 @@ namespace MAT_NS_BEGIN {
         m_config(runtimeConfig),
         m_logManager(logManager),
         m_size(0),
+        m_flushing(false),
         m_lastReadCount(0)
     {
+        uint32_t journalSize = m_config[CFG_INT_RAM_QUEUE_JOURNAL_SIZE];
+        const char* path = m_config[CFG_STR_CACHE_FILE_PATH];
+        if ((journalSize > 0) && (path != nullptr) && (path[0] != 0))
+        {
+            m_journal.reset(new MemoryJournal(path, journalSize));
+        }
     }
     
     /// <summary>
     /// Initializes the storage and sets the observer for callback notifications.
+    /// Records left in the journal by the last run are queued again.
     /// NOT IMPLEMENTED: does not support IOfflineStorageObserver notifications.
     /// </summary>
     /// <param name="observer">The observer.</param>
     void MemoryStorage::Initialize(IOfflineStorageObserver & observer)
     {
         m_observer = &observer;
+        if (!m_journal)
+        {
+            return;
+        }
+
+        std::vector<StorageRecord> recovered;
+        if (!m_journal->Open(recovered))
+        {
+            m_journal.reset();
+            return;
+        }
+        {
+            LOCKGUARD(m_records_lock);
+            for (auto& record : recovered)
+            {
+                Enqueue(RecordPtr(new StorageRecord(std::move(record))));
+            }
+        }
+        // Drops the deleted records the journal still carries
+        RewriteJournal();
     }
     
     /// <summary>
@@ -45,7 +74,7 @@ namespace MAT_NS_BEGIN {
 
         for (unsigned latency = EventLatency_Off; (latency <= EventLatency_Max); latency++)
         {
-            size_t numRecords = m_records[latency].size();
+            size_t numRecords = m_records[latency].Size();
             if (numRecords)
             {
                 // OfflineStorageHandler high-level wrapper must flush these on graceful shutdown
@@ -57,25 +86,76 @@ namespace MAT_NS_BEGIN {
         {
             LOG_WARN("Discarding %u reserved records", m_reserved_records.size());
         }
+
+        // Unflushed records stay journaled for the next run
+        if (m_journal)
+        {
+            m_journal->Close();
+        }
     }
     
     /// <summary>
     /// Save pending records to persistent storage.
     ///
-    /// This method is NOT IMPLEMENTED because the Flush is done by OfflineStorageHandler.
+    /// The records are moved to persistent storage by OfflineStorageHandler,
+    /// between BeginFlush and EndFlush. This only rewrites the journal with
+    /// the records still held.
     ///
     /// </summary>
     void MemoryStorage::Flush()
     {
+        RewriteJournal();
+    }
+
+    void MemoryStorage::RewriteJournal()
+    {
+        if (!m_journal)
+        {
+            return;
+        }
+
+        LOCKGUARD(m_reserved_lock);
+        LOCKGUARD(m_records_lock);
+        if (m_flushing)
+        {
+            return;
+        }
+        std::vector<StorageRecord const*> records;
+        records.reserve(m_reserved_records.size());
+        for (auto const& kv : m_reserved_records)
+        {
+            records.push_back(kv.second.get());
+        }
+        for (unsigned latency = EventLatency_Off; (latency <= EventLatency_Max); latency++)
+        {
+            auto const& queue = m_records[latency];
+            for (size_t i = 0; i < queue.Size(); i++)
+            {
+                records.push_back(queue[i].get());
+            }
+        }
+        m_journal->Rewrite(records);
     }
     
-    template<typename T, typename V>
-    bool contains(T vec, V value)
+    void MemoryStorage::Enqueue(RecordPtr&& record, bool front)
     {
-        auto it = std::find(vec.begin(), vec.end(), value);
-        if (it != vec.end())
-            return true;
-        return false;
+        auto& records = m_records[record->latency];
+#ifdef DEBUG_DUPLICATE_ROUTES
+        for (size_t i = 0; i < records.Size(); i++)
+        {
+            if (records[i]->id == record->id)
+                LOG_WARN("Queue already contains this element!");
+        }
+#endif
+        m_size += RecordSize(*record);
+        if (front)
+        {
+            records.PushFront(std::move(record));
+        }
+        else
+        {
+            records.PushBack(std::move(record));
+        }
     }
 
     /// <summary>
@@ -96,43 +176,61 @@ namespace MAT_NS_BEGIN {
         if (record.latency == EventLatency_Off)
             return false;
 
-        LOCKGUARD(m_records_lock);
-        m_size += record.blob.size() + sizeof(record); // approximate contents size
-
-#ifdef DEBUG_DUPLICATE_ROUTES
-        if (contains(m_records[record.latency], record))
-            LOG_WARN("Vector already contains this element!");
-#endif
-
-        m_records[record.latency].push_back(std::move(record));
+        RecordPtr stored(new StorageRecord(record));
+        {
+            LOCKGUARD(m_records_lock);
+            if (m_journal)
+            {
+                m_journal->Append(*stored);
+            }
+            Enqueue(std::move(stored));
+        }
+        RewriteJournalIfNeeded();
         return true;
     }
 
+    /// <summary>
+    /// Store a batch of records, taking the records lock once for the batch.
+    /// </summary>
+    /// <param name="records">Records to store; the ones not stored are moved to the end</param>
+    /// <returns>
+    /// The number of records stored
+    /// </returns>
     size_t MemoryStorage::StoreRecords(std::vector<StorageRecord> & records)
     {
-        size_t stored = 0;
-        for (auto  & i : records) {
-            if (StoreRecord(i)) {
-                ++stored;
+        // Don't store events with latency set to off. Logger API already does a similar check.
+        auto end = std::stable_partition(records.begin(), records.end(), [](StorageRecord const& record) {
+            return record.latency != EventLatency_Off;
+        });
+        {
+            LOCKGUARD(m_records_lock);
+            for (auto it = records.begin(); it != end; ++it)
+            {
+                if (m_journal)
+                {
+                    m_journal->Append(*it);
+                }
+                Enqueue(RecordPtr(new StorageRecord(*it)));
             }
         }
-        return stored;
+        RewriteJournalIfNeeded();
+        return static_cast<size_t>(end - records.begin());
     }
 
     /// <summary>
-    /// Get records from MemoryStorage.
-    /// Getting records automatically deletes them.
-    /// Reservation is not currently supported.
+    /// Get records from MemoryStorage, oldest first within each latency.
+    /// The consumer is lent each stored record itself, nothing is copied.
+    /// With a lease an accepted record then moves to the reserved set by
+    /// pointer, where it stays until deleted or released; without one it
+    /// is dropped from the queue.
     /// </summary>
     /// <param name="consumer">The consumer.</param>
     /// <param name="leaseTimeMs">The lease time ms.</param>
     /// <param name="minLatency">The minimum latency.</param>
     /// <param name="maxCount">The maximum count.</param>
     /// <returns></returns>
-    bool MemoryStorage::GetAndReserveRecords(std::function<bool(StorageRecord&&)> const & consumer, unsigned leaseTimeMs, EventLatency minLatency, unsigned maxCount)
+    bool MemoryStorage::GetAndReserveRecords(std::function<bool(StorageRecord const&)> const & consumer, unsigned leaseTimeMs, EventLatency minLatency, unsigned maxCount)
     {
-        UNREFERENCED_PARAMETER(leaseTimeMs);
-
         LOG_TRACE("Retrieving max. %u%s events of latency at least %d (%s)",
             maxCount, (maxCount > 0) ? "" : " (unlimited)",
             minLatency, latencyToStr(static_cast<EventLatency>(minLatency)));
@@ -143,32 +241,37 @@ namespace MAT_NS_BEGIN {
         if (minLatency == EventLatency_Unspecified)
             minLatency = EventLatency_Off;
 
+        int64_t reservedUntil = leaseTimeMs ? PAL::getUtcSystemTimeMs() + leaseTimeMs : 0;
+
         LOCKGUARD(m_reserved_lock);
         LOCKGUARD(m_records_lock);
         m_lastReadCount = 0;
         // Start processing events of critical latency first
         for (int latency = static_cast<int>(EventLatency_Max); (latency >= static_cast<int>(minLatency)) && (maxCount); latency--)
         {
-            while (maxCount && (m_records[latency]).size())
+            auto& records = m_records[latency];
+            while (maxCount && !records.Empty())
             {
-                StorageRecord & record = m_records[latency].back();
-
-                size_t recordSize = record.blob.size() + sizeof(record);
-                StorageRecord forConsumer(record);
+                StorageRecord& record = *records[0];
+                size_t recordSize = RecordSize(record);
+                int64_t previousLease = record.reservedUntil;
                 if (leaseTimeMs)
                 {
-                    forConsumer.reservedUntil = PAL::getUtcSystemTimeMs() + leaseTimeMs;
+                    record.reservedUntil = reservedUntil;
                 }
 
-                bool wantMore = consumer(std::move(forConsumer)); // move to consumer
-                if (!wantMore) {
+                if (!consumer(record))
+                {
+                    record.reservedUntil = previousLease;
                     return true;
                 }
 
-                if (leaseTimeMs) {
-                    m_reserved_records[record.id] = std::move(record); // move to reserved
+                RecordPtr taken = records.PopFront();
+                if (leaseTimeMs)
+                {
+                    StorageRecordId const& id = taken->id;
+                    m_reserved_records[id] = std::move(taken);
                 }
-                m_records[latency].pop_back();
                 m_size -= std::min(m_size, recordSize);
                 maxCount--;
                 m_lastReadCount++;
@@ -211,15 +314,12 @@ namespace MAT_NS_BEGIN {
             LOCKGUARD(m_records_lock);
             for (unsigned latency = EventLatency_Off; (latency <= EventLatency_Max); latency++)
             {
-                auto& records = m_records[latency];
-                if (records.size()) {
-                    records.clear();
-                }
+                m_records[latency].Clear();
             }
             m_size = 0;
             m_lastReadCount = 0;
         }
-
+        RewriteJournal();
     }
 
     void MemoryStorage::DeleteRecords(const std::map<std::string, std::string> & whereFilter)
@@ -231,7 +331,7 @@ namespace MAT_NS_BEGIN {
             {
                 matched &=
                     (kv.first == "record_id") ? (r.id == kv.second) :
-                    (kv.first == "tenant_token") ? (r.tenantToken == kv.second) :
+                    (kv.first == "tenant_token") ? (TenantRegistry::instance().Token(r) == kv.second) :
                     (kv.first == "latency") ? (std::to_string(r.latency) == kv.second) :
                     (kv.first == "persistence") ? (std::to_string(r.persistence) == kv.second) :
                     (kv.first == "retry_count") ? (std::to_string(r.retryCount) == kv.second) : false;
@@ -247,7 +347,7 @@ namespace MAT_NS_BEGIN {
             LOCKGUARD(m_reserved_lock);
             for (const auto & kv : m_reserved_records)
             {
-                if (matcher(kv.second, whereFilter))
+                if (matcher(*kv.second, whereFilter))
                 {
                     m_reserved_ids.push_back(kv.first);
                 }
@@ -264,22 +364,21 @@ namespace MAT_NS_BEGIN {
             LOCKGUARD(m_records_lock);
             for (unsigned latency = EventLatency_Off; latency <= EventLatency_Max;  latency++)
             {
-                auto& records = m_records[latency];
-                auto it = records.begin();
-                // remove from records all ids that were found in the set
-                while (it != records.end()) {
-                    auto &v = *it;
-                    if (matcher(v, whereFilter))
+                m_records[latency].RemoveIf([&](RecordPtr const& record) {
+                    if (!matcher(*record, whereFilter))
                     {
-                        size_t recordSize = v.blob.size() + sizeof(v);
-                        m_size -= std::min(m_size, recordSize);
-                        it = records.erase(it);
-                        continue;
+                        return false;
                     }
-                    ++it;
-                }
+                    if (m_journal)
+                    {
+                        m_journal->Delete(record->id);
+                    }
+                    m_size -= std::min(m_size, RecordSize(*record));
+                    return true;
+                });
             }
         }
+        RewriteJournalIfNeeded();
     }
 
     /// <summary>
@@ -293,28 +392,30 @@ namespace MAT_NS_BEGIN {
         UNREFERENCED_PARAMETER(headers);
         UNREFERENCED_PARAMETER(fromMemory);
 
+        bool done = false;
         {
             // Delete from reserved records (m_reserved_records)
             LOCKGUARD(m_reserved_lock);
             if (m_reserved_records.size())
             {
-                std::unordered_set<StorageRecordId> idSet(ids.begin(), ids.end());
-                auto it = m_reserved_records.begin();
-                while (it != m_reserved_records.end()) {
-                    auto &kv = *it;
-                    if (idSet.count(kv.first))
+                size_t found = 0;
+                for (auto const& id : ids)
+                {
+                    if (m_reserved_records.erase(id) == 0)
                     {
-                        idSet.erase(kv.first);
-                        it = m_reserved_records.erase(it);
                         continue;
                     }
-                    ++it;
+                    if (m_journal)
+                    {
+                        m_journal->Delete(id);
+                    }
+                    found++;
                 }
-                if (idSet.size() == 0) // done
-                    return;
+                done = (found == ids.size());
             }
         }
 
+        if (!done)
         {
             // Delete from ram queue (m_records[])
             LOCKGUARD(m_records_lock);
@@ -326,27 +427,25 @@ namespace MAT_NS_BEGIN {
             for (unsigned latency = EventLatency_Off; (latency <= EventLatency_Max); latency++)
             {
                 auto& records = m_records[latency];
-                if (records.size() && idSet.size())
+                if (!records.Empty() && idSet.size())
                 {
-                    auto it = records.begin();
-                    // remove from records all ids that were found in the set
-                    while (it != records.end()) {
-                        auto &v = *it;
-                        if (idSet.count(v.id))
+                    records.RemoveIf([&](RecordPtr const& record) {
+                        // record id appears once only, so remove from set
+                        if (idSet.erase(record->id) == 0)
                         {
-                            // record id appears once only, so remove from set
-                            idSet.erase(v.id);
-                            size_t recordSize = v.blob.size() + sizeof(v);
-                            m_size -= std::min(m_size, recordSize);
-                            it = records.erase(it);
-                            continue;
+                            return false;
                         }
-                        ++it;
-                    }
+                        if (m_journal)
+                        {
+                            m_journal->Delete(record->id);
+                        }
+                        m_size -= std::min(m_size, RecordSize(*record));
+                        return true;
+                    });
                 }
             }
         }
-
+        RewriteJournalIfNeeded();
     }
 
     /// <summary>
@@ -362,24 +461,25 @@ namespace MAT_NS_BEGIN {
         UNREFERENCED_PARAMETER(headers);
         UNREFERENCED_PARAMETER(fromMemory);
 
-        // Move back from reserved records to ram queue
+        // Move back from reserved records to the front of the ram queue,
+        // they are older than the records queued since
         LOCKGUARD(m_reserved_lock);
         if (m_reserved_records.size())
         {
-            std::unordered_set<StorageRecordId> idSet(ids.begin(), ids.end());
-            auto it = m_reserved_records.begin();
-            while (it != m_reserved_records.end()) {
-                auto &kv = *it;
-                if (idSet.count(kv.first))
+            LOCKGUARD(m_records_lock);
+            for (auto id = ids.rbegin(); id != ids.rend(); ++id)
+            {
+                auto it = m_reserved_records.find(*id);
+                if (it == m_reserved_records.end())
                 {
-                    if (incrementRetryCount)
-                        kv.second.retryCount++;
-                    StoreRecord(kv.second);
-                    idSet.erase(kv.first);
-                    it = m_reserved_records.erase(it);
                     continue;
                 }
-                ++it;
+                RecordPtr record = std::move(it->second);
+                m_reserved_records.erase(it);
+                if (incrementRetryCount)
+                    record->retryCount++;
+                record->reservedUntil = 0;
+                Enqueue(std::move(record), true);
             }
         }
     }
@@ -391,13 +491,13 @@ namespace MAT_NS_BEGIN {
         LOCKGUARD(m_reserved_lock);
         if (m_reserved_records.size())
         {
-            auto it = m_reserved_records.begin();
-            while (it != m_reserved_records.end())
+            LOCKGUARD(m_records_lock);
+            for (auto& kv : m_reserved_records)
             {
-                auto &kv = *it;
-                StoreRecord(kv.second);
-                it = m_reserved_records.erase(it);
+                kv.second->reservedUntil = 0;
+                Enqueue(std::move(kv.second));
             }
+            m_reserved_records.clear();
         }
     }
 
@@ -469,11 +569,11 @@ namespace MAT_NS_BEGIN {
         if (latency == EventLatency_Unspecified)
         {
             for (unsigned lat = EventLatency_Off; lat <= EventLatency_Max; lat++)
-                numRecords += m_records[lat].size();
+                numRecords += m_records[lat].Size();
         }
         else
         {
-            numRecords = m_records[latency].size();
+            numRecords = m_records[latency].Size();
         }
         return numRecords;
     }
@@ -481,15 +581,29 @@ namespace MAT_NS_BEGIN {
     std::vector<StorageRecord> MemoryStorage::GetRecords(bool shutdown, EventLatency minLatency, unsigned maxCount)
     {
         UNREFERENCED_PARAMETER(shutdown);
-        UNREFERENCED_PARAMETER(minLatency);
-        UNREFERENCED_PARAMETER(maxCount);
 
+        if (maxCount == 0)
+            maxCount = UINT_MAX;
+
+        if (minLatency == EventLatency_Unspecified)
+            minLatency = EventLatency_Off;
+
+        // The records leave the queue: they are moved out, not lent
         std::vector<StorageRecord> records;
-        auto consumer = [&records](StorageRecord&& record) -> bool {
-            records.push_back(std::move(record));
-            return true; // want more
-        };
-        GetAndReserveRecords(consumer, 0, minLatency, maxCount);
+        LOCKGUARD(m_records_lock);
+        m_lastReadCount = 0;
+        for (int latency = static_cast<int>(EventLatency_Max); (latency >= static_cast<int>(minLatency)) && (maxCount); latency--)
+        {
+            auto& queue = m_records[latency];
+            while (maxCount && !queue.Empty())
+            {
+                RecordPtr taken = queue.PopFront();
+                m_size -= std::min(m_size, RecordSize(*taken));
+                records.push_back(std::move(*taken));
+                maxCount--;
+                m_lastReadCount++;
+            }
+        }
         return records;
     }
     
@@ -504,6 +618,29 @@ namespace MAT_NS_BEGIN {
         return true;
     }
 
+    std::vector<StorageRecord> MemoryStorage::BeginFlush()
+    {
+        {
+            LOCKGUARD(m_records_lock);
+            m_flushing = true;
+        }
+        return GetRecords();
+    }
+
+    void MemoryStorage::EndFlush(std::vector<StorageRecord>& batch, size_t saved)
+    {
+        {
+            LOCKGUARD(m_records_lock);
+            // Back to the front of the queue in reverse, which keeps their order
+            for (size_t i = batch.size(); i > saved; i--)
+            {
+                Enqueue(RecordPtr(new StorageRecord(std::move(batch[i - 1]))), true);
+            }
+            m_flushing = false;
+        }
+        RewriteJournal();
+    }
+
     MemoryStorage::~MemoryStorage()
     {
         // Shutdown();
@@ -15,15 +15,28 @@
 
 #include "ILogManager.hpp"
 
+#include "utils/FifoRing.hpp"
+
+#include "MemoryJournal.hpp"
+
 #include <algorithm>
 #include <memory>
 #include <mutex>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace MAT_NS_BEGIN {
 
+    /// <summary>
+    /// RAM queue in front of the persistent storage. Records are kept once,
+    /// refcounted, in a FIFO ring per latency; reserving a record moves the
+    /// reference to the reserved set instead of copying the record.
+    /// With CFG_INT_RAM_QUEUE_JOURNAL_SIZE set, stored and deleted records are
+    /// also journaled to memory-mapped files, and Initialize queues the records
+    /// that a crashed run left in the journal.
+    /// </summary>
     class MemoryStorage : public IOfflineStorage
     {
 
@@ -40,7 +53,7 @@ namespace MAT_NS_BEGIN {
 
         virtual size_t StoreRecords(std::vector<StorageRecord> & records) override;
 
-        virtual bool GetAndReserveRecords(std::function<bool(StorageRecord&&)> const& consumer, unsigned leaseTimeMs,
+        virtual bool GetAndReserveRecords(std::function<bool(StorageRecord const&)> const& consumer, unsigned leaseTimeMs,
             EventLatency minLatency = EventLatency_Unspecified, unsigned maxCount = 0) override;
 
         virtual bool IsLastReadFromMemory() override;
@@ -69,6 +82,20 @@ namespace MAT_NS_BEGIN {
 
         virtual size_t GetReservedCount();
 
+        /// <summary>
+        /// Takes all the queued records out for a flush to the persistent storage.
+        /// They are moved, not copied, and stay journaled until EndFlush: the
+        /// journal is not rewritten meanwhile.
+        /// </summary>
+        std::vector<StorageRecord> BeginFlush();
+
+        /// <summary>
+        /// Ends the flush started by BeginFlush. The first saved records of the
+        /// batch are on disk and dropped; the others go back to the front of the
+        /// queue. The journal is then rewritten with the records still held.
+        /// </summary>
+        void EndFlush(std::vector<StorageRecord>& batch, size_t saved);
+
         virtual std::vector<StorageRecord> GetRecords(bool shutdown = false, EventLatency minLatency = EventLatency_Unspecified, unsigned maxCount = 0) override;
 
         virtual bool ResizeDb() override;
@@ -81,18 +108,55 @@ namespace MAT_NS_BEGIN {
         IRuntimeConfig&             m_config;
         ILogManager&                m_logManager;
 
+        using RecordPtr = std::unique_ptr<StorageRecord>;
+
+        static size_t RecordSize(StorageRecord const& record)
+        {
+            return record.blob.size() + sizeof(record); // approximate contents size
+        }
+
+        /// <summary>
+        /// Appends the record to the queue of its latency, or puts it back at the front.
+        /// Called with m_records_lock held.
+        /// </summary>
+        void Enqueue(RecordPtr&& record, bool front = false);
+
+        /// <summary>
+        /// Rewrites the journal with the records still held, queued or reserved.
+        /// Does nothing during a flush, which would drop the batch from it.
+        /// Called without m_reserved_lock and m_records_lock held.
+        /// </summary>
+        void RewriteJournal();
+
+        void RewriteJournalIfNeeded()
+        {
+            if (m_journal && m_journal->NeedsRewrite())
+            {
+                RewriteJournal();
+            }
+        }
+
         mutable std::mutex          m_records_lock;
-        std::vector<StorageRecord>  m_records[EventLatency_Max+1];
+        FifoRing<RecordPtr>         m_records[EventLatency_Max+1];
         
         /// <summary>
         /// Contains reserved (aka in-flight) records.
         /// Current storage interface API requires deletion and release by StorageRecordId.
         /// </summary>
         std::mutex                  m_reserved_lock;
-        std::map<StorageRecordId, StorageRecord> m_reserved_records;
+        std::unordered_map<StorageRecordId, RecordPtr> m_reserved_records;
 
         size_t                      m_size;
 
+        /// <summary>
+        /// Set between BeginFlush and EndFlush, guarded by m_records_lock.
+        /// Records stored meanwhile into a full journal are only journaled
+        /// by the rewrite that ends the flush.
+        /// </summary>
+        bool                        m_flushing;
+
+        std::unique_ptr<MemoryJournal> m_journal;
+
         MATSDK_LOG_DECL_COMPONENT_CLASS();
 
     private:
@@ -13,6 +13,7 @@
 #else
 #include "offline/OfflineStorage_SQLite.hpp"
 #endif
+#include "offline/OfflineStorage_Segments.hpp"
 
 #include <memory>
 
@@ -26,6 +27,11 @@ namespace MAT_NS_BEGIN
             LOG_TRACE("Creating OfflineStorage from module");
             return std::static_pointer_cast<IOfflineStorage>(std::static_pointer_cast<IOfflineStorageModule>(module));
         }
+        const char* storageType = runtimeConfig[CFG_STR_CACHE_STORAGE_TYPE];
+        if (storageType != nullptr && std::string(storageType) == "segments") {
+            LOG_TRACE("Creating OfflineStorage_Segments");
+            return std::make_shared<OfflineStorage_Segments>(logManager, runtimeConfig);
+        }
 #ifdef USE_ROOM
         LOG_TRACE("Creating OfflineStorage_Room");
         return std::make_shared<OfflineStorage_Room>(logManager, runtimeConfig);
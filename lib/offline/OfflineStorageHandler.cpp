@@ -9,12 +9,23 @@
 #include "offline/MemoryStorage.hpp"
 
 #include "ILogManager.hpp"
+#include "utils/EventId.hpp"
 #include <algorithm>
+#include <iterator>
 #include <numeric>
 #include <set>
 
 namespace MAT_NS_BEGIN {
 
+    // Records of logged events carry their tenant handle only, the disk storage
+    // gets the token as well: it persists it, and may be a custom implementation.
+    static void resolveTenantToken(StorageRecord& record)
+    {
+        if (record.tenantToken.empty())
+        {
+            record.tenantToken = TenantRegistry::instance().Token(record.tenantHandle);
+        }
+    }
 
     MATSDK_LOG_INST_COMPONENT_CLASS(OfflineStorageHandler, "EventsSDK.StorageHandler", "Events telemetry client - OfflineStorageHandler class");
 
@@ -53,7 +64,9 @@ namespace MAT_NS_BEGIN {
     {
         return (
             /* fast   */ m_killSwitchManager.isActive() &&
-            /* slower */ m_killSwitchManager.isTokenBlocked(record.tenantToken));
+            /* slower */ ((record.tenantHandle != InvalidTenantHandle) ?
+                             m_killSwitchManager.isTokenBlocked(record.tenantHandle) :
+                             m_killSwitchManager.isTokenBlocked(record.tenantToken)));
     }
 
     void OfflineStorageHandler::WaitForFlush()
@@ -98,6 +111,12 @@ namespace MAT_NS_BEGIN {
         {
             m_offlineStorageMemory.reset(new MemoryStorage(m_logManager, m_config));
             m_offlineStorageMemory->Initialize(*this);
+
+            // Records replayed from the RAM queue journal of a crashed run go on to disk
+            if ((m_offlineStorageDisk != nullptr) && (m_offlineStorageMemory->GetRecordCount() > 0))
+            {
+                Flush();
+            }
         }
 
         m_shutdownStarted = false;
@@ -153,6 +172,11 @@ namespace MAT_NS_BEGIN {
     void OfflineStorageHandler::Flush()
     {
         if (!m_logManager.StartActivity()) {
+            // Paused: a scheduled flush is skipped, do not leave WaitForFlush() waiting for it
+            LOCKGUARD(m_flushLock);
+            m_flushHandle.Cancel();
+            m_flushComplete.post();
+            m_flushPending = false;
             return;
         }
         // Flush could be executed from context of worker thread, as well as from TPM and
@@ -167,25 +191,20 @@ namespace MAT_NS_BEGIN {
         size_t dbSizeBeforeFlush = m_offlineStorageMemory->GetSize();
         if ((m_offlineStorageMemory) && (dbSizeBeforeFlush > 0) && (m_offlineStorageDisk))
         {
-            // This will block on and then take a lock for the duration of this move, and
-            // StoreRecord() will then block until the move completes.
-            auto records = m_offlineStorageMemory->GetRecords(false, EventLatency_Unspecified);
-            std::vector<StorageRecordId> ids;
-
-            // TODO: [MG] - consider running the batch in transaction
-            //            if (sqlite)
-            //                sqlite->Execute("BEGIN");
-
+            // The batch is moved out of the RAM queue, and stays journaled until
+            // it is on disk: the disk storage writes it in a single transaction.
+            std::vector<StorageRecord> records = m_offlineStorageMemory->BeginFlush();
+            std::for_each(records.begin(), records.end(), resolveTenantToken);
             size_t totalSaved = m_offlineStorageDisk->StoreRecords(records);
+            if (totalSaved < records.size())
+            {
+                // The disk storage moved the records it saved to the front, the
+                // others go back to the RAM queue for the next flush
+                LOG_WARN("Saved %zu of %zu records to disk, keeping the others in memory", totalSaved, records.size());
+            }
 
-            // TODO: [MG] - consider running the batch in transaction
-            //            if (sqlite)
-            //                sqlite->Execute("END");
-
-            // Delete records from reserved on flush
-            HttpHeaders dummy;
-            bool fromMemory = true;
-            m_offlineStorageMemory->DeleteRecords(ids, dummy, fromMemory);
+            // Stops journaling the saved records and compacts the journal
+            m_offlineStorageMemory->EndFlush(records, totalSaved);
 
             // Notify event listener about the records cached
             OnStorageRecordsSaved(totalSaved);
@@ -223,9 +242,6 @@ namespace MAT_NS_BEGIN {
             return false;
         }
 
-        // Check cache size only once at start
-        static uint32_t cacheMemorySizeLimitInBytes = m_config[CFG_INT_RAM_QUEUE_SIZE];
-
         if (nullptr != m_offlineStorageMemory && !m_shutdownStarted)
         {
             auto memDbSize = m_offlineStorageMemory->GetSize();
@@ -236,22 +252,7 @@ namespace MAT_NS_BEGIN {
                 // storage)
                 m_offlineStorageMemory->StoreRecord(record);
             }
-
-            // Perform periodic flush to disk
-            if (memDbSize > cacheMemorySizeLimitInBytes)
-            {
-                if (m_flushLock.try_lock())
-                {
-                    if (!m_flushPending)
-                    {
-                        m_flushPending = true;
-                        m_flushComplete.Reset();
-                        m_flushHandle = PAL::scheduleTask(&m_taskDispatcher, 0, this, &OfflineStorageHandler::Flush);
-                        LOG_INFO("Requested Flush (%p)", m_flushHandle.m_task);
-                    }
-                    m_flushLock.unlock();
-                }
-            }
+            requestFlushIfFull(memDbSize);
         }
         else
         {
@@ -259,7 +260,16 @@ namespace MAT_NS_BEGIN {
             {
                 if (record.persistence != EventPersistence::EventPersistence_DoNotStoreOnDisk)
                 {
-                    m_offlineStorageDisk->StoreRecord(record);
+                    if (record.tenantToken.empty())
+                    {
+                        StorageRecord resolved(record);
+                        resolveTenantToken(resolved);
+                        m_offlineStorageDisk->StoreRecord(resolved);
+                    }
+                    else
+                    {
+                        m_offlineStorageDisk->StoreRecord(record);
+                    }
                 }
             }
         }
@@ -267,17 +277,88 @@ namespace MAT_NS_BEGIN {
         return true;
     }
 
+    /// <summary>
+    /// Stores the batch with one call into the RAM queue or the disk storage,
+    /// so their locks and the disk transaction are taken once per batch.
+    /// Records of killed tenants are not stored: they are moved to the end of
+    /// records, the stored ones to the front, both keeping their order.
+    /// </summary>
+    /// <returns>Number of records stored, the records[0, result) range</returns>
     size_t OfflineStorageHandler::StoreRecords(std::vector<StorageRecord>& records)
     {
-        size_t stored = 0;
-        for (auto& i : records)
+        auto killed = records.end();
+        // Don't discard on shutdown because the kill-switch may be temporary.
+        if ((!m_shutdownStarted) && m_killSwitchManager.isActive())
+        {
+            killed = std::stable_partition(records.begin(), records.end(), [this](StorageRecord const& record) {
+                return !isKilled(record);
+            });
+        }
+
+        if (killed == records.end())
+        {
+            storeAccepted(records);
+        }
+        else if (killed != records.begin())
+        {
+            std::vector<StorageRecord> accepted(std::make_move_iterator(records.begin()), std::make_move_iterator(killed));
+            storeAccepted(accepted);
+            std::move(accepted.begin(), accepted.end(), records.begin());
+        }
+        return static_cast<size_t>(killed - records.begin());
+    }
+
+    void OfflineStorageHandler::storeAccepted(std::vector<StorageRecord>& records)
+    {
+        if (nullptr != m_offlineStorageMemory && !m_shutdownStarted)
+        {
+            auto memDbSize = m_offlineStorageMemory->GetSize();
+            m_offlineStorageMemory->StoreRecords(records);
+            requestFlushIfFull(memDbSize);
+        }
+        else if (m_offlineStorageDisk != nullptr)
+        {
+            std::for_each(records.begin(), records.end(), resolveTenantToken);
+            auto notOnDisk = [](StorageRecord const& record) {
+                return record.persistence == EventPersistence::EventPersistence_DoNotStoreOnDisk;
+            };
+            if (std::none_of(records.begin(), records.end(), notOnDisk))
+            {
+                m_offlineStorageDisk->StoreRecords(records);
+            }
+            else
+            {
+                std::vector<StorageRecord> persistent;
+                std::remove_copy_if(records.begin(), records.end(), std::back_inserter(persistent), notOnDisk);
+                m_offlineStorageDisk->StoreRecords(persistent);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Schedules a flush of the RAM queue to disk once it has grown past
+    /// CFG_INT_RAM_QUEUE_SIZE. memDbSize is the queue size before the store.
+    /// </summary>
+    void OfflineStorageHandler::requestFlushIfFull(size_t memDbSize)
+    {
+        // Check cache size only once at start
+        static uint32_t cacheMemorySizeLimitInBytes = m_config[CFG_INT_RAM_QUEUE_SIZE];
+
+        // Perform periodic flush to disk
+        if (memDbSize > cacheMemorySizeLimitInBytes)
         {
-            if (StoreRecord(i))
+            if (m_flushLock.try_lock())
             {
-                ++stored;
+                if (!m_flushPending)
+                {
+                    m_flushPending = true;
+                    m_flushComplete.Reset();
+                    m_flushHandle = PAL::scheduleTask(&m_taskDispatcher, 0, this, &OfflineStorageHandler::Flush);
+                    LOG_INFO("Requested Flush (%p)", m_flushHandle.m_task);
+                }
+                m_flushLock.unlock();
             }
         }
-        return stored;
     }
 
     bool OfflineStorageHandler::ResizeDb()
@@ -305,7 +386,7 @@ namespace MAT_NS_BEGIN {
         return m_lastReadCount;
     }
 
-    bool OfflineStorageHandler::GetAndReserveRecords(std::function<bool(StorageRecord&&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency, unsigned maxCount)
+    bool OfflineStorageHandler::GetAndReserveRecords(std::function<bool(StorageRecord const&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency, unsigned maxCount)
     {
         bool returnValue = false;
 
@@ -379,7 +460,7 @@ namespace MAT_NS_BEGIN {
 
     void OfflineStorageHandler::DeleteAllRecords()
     {
-        for (const auto storagePtr : { m_offlineStorageMemory.get() , m_offlineStorageDisk.get() })
+        for (IOfflineStorage* const storagePtr : { static_cast<IOfflineStorage*>(m_offlineStorageMemory.get()), m_offlineStorageDisk.get() })
         {
             if (storagePtr != nullptr)
             {
@@ -402,7 +483,7 @@ namespace MAT_NS_BEGIN {
     /// </remarks>
     void OfflineStorageHandler::DeleteRecords(const std::map<std::string, std::string>& whereFilter)
     {
-        for (const auto storagePtr : {m_offlineStorageMemory.get(), m_offlineStorageDisk.get()})
+        for (IOfflineStorage* const storagePtr : {static_cast<IOfflineStorage*>(m_offlineStorageMemory.get()), m_offlineStorageDisk.get()})
         {
             if (storagePtr != nullptr)
             {
@@ -438,7 +519,7 @@ namespace MAT_NS_BEGIN {
         }
 
         LOG_TRACE(" OfflineStorageHandler Deleting %u sent event(s) {%s%s}...",
-                  static_cast<unsigned>(ids.size()), ids.front().c_str(), (ids.size() > 1) ? ", ..." : "");
+                  static_cast<unsigned>(ids.size()), EventId::ToText(ids.front()).c_str(), (ids.size() > 1) ? ", ..." : "");
         if (fromMemory && nullptr != m_offlineStorageMemory)
         {
             m_offlineStorageMemory->DeleteRecords(ids, headers, fromMemory);
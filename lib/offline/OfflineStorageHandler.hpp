@@ -8,6 +8,7 @@
 
 #include "pal/PAL.hpp"
 #include "IOfflineStorage.hpp"
+#include "MemoryStorage.hpp"
 
 #include "api/IRuntimeConfig.hpp"
 #include "ILogManager.hpp"
@@ -33,7 +34,7 @@ namespace MAT_NS_BEGIN {
         virtual void Flush() override;
         virtual bool StoreRecord(StorageRecord const& record) override;
         virtual size_t StoreRecords(std::vector<StorageRecord> & records) override;
-        virtual bool GetAndReserveRecords(std::function<bool(StorageRecord&&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency = EventLatency_Unspecified, unsigned maxCount = 0) override;
+        virtual bool GetAndReserveRecords(std::function<bool(StorageRecord const&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency = EventLatency_Unspecified, unsigned maxCount = 0) override;
 
         virtual bool IsLastReadFromMemory() override;
         virtual unsigned LastReadRecordCount() override;
@@ -80,7 +81,7 @@ namespace MAT_NS_BEGIN {
         PAL::DeferredCallbackHandle            m_flushHandle;
         PAL::Event                             m_flushComplete;
 
-        std::unique_ptr<IOfflineStorage>       m_offlineStorageMemory;
+        std::unique_ptr<MemoryStorage>         m_offlineStorageMemory;
         std::shared_ptr<IOfflineStorage>       m_offlineStorageDisk;
 
         bool                                   m_readFromMemory;
@@ -97,6 +98,8 @@ namespace MAT_NS_BEGIN {
 
     private:
         void WaitForFlush();
+        void requestFlushIfFull(size_t memDbSize);
+        void storeAccepted(std::vector<StorageRecord>& records);
 
     };
 
@@ -350,7 +350,7 @@ namespace MAT_NS_BEGIN
              * this implementation does not.
              */
     bool OfflineStorage_Room::GetAndReserveRecords(
-        std::function<bool(StorageRecord&&)> const& consumer,
+        std::function<bool(StorageRecord const&)> const& consumer,
         unsigned leaseTimeMs,
         EventLatency minLatency,
         unsigned maxCount)
@@ -483,7 +483,7 @@ namespace MAT_NS_BEGIN
                     env->ReleaseByteArrayElements(blob_java,
                                                   reinterpret_cast<jbyte*>(start), 0);
                     env.popLocalFrame();
-                    if (!consumer(std::move(dest)))
+                    if (!consumer(dest))
                     {
                         break;
                     }
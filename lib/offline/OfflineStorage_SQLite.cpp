@@ -8,7 +8,9 @@
 #include "OfflineStorage_SQLite.hpp"
 #include "ILogManager.hpp"
 #include "SQLiteWrapper.hpp"
+#include "utils/EventId.hpp"
 #include "utils/StringUtils.hpp"
+#include "utils/Utils.hpp"
 #include <algorithm>
 #include <numeric>
 #include <set>
@@ -17,6 +19,10 @@ namespace MAT_NS_BEGIN {
 
     constexpr static size_t kBlockSize = 8192;
 
+    // Rows per multi-row insert. 6 parameters per row stay below the default
+    // SQLITE_MAX_VARIABLE_NUMBER (999) of SQLite versions before 3.32.
+    constexpr static size_t kInsertBatchRows = 64;
+
     std::mutex OfflineStorage_SQLite::m_initAndShutdownLock;
     int OfflineStorage_SQLite::m_instanceCount = 0;
 
@@ -146,21 +152,23 @@ namespace MAT_NS_BEGIN {
             m_db->execute(command.c_str());
     }
 
-    bool OfflineStorage_SQLite::StoreRecord(StorageRecord const& record)
+    static bool isStorable(StorageRecord const& record)
     {
-        // TODO: [MG] - this works, but may not play nicely with several LogManager instances
-        // static SqliteStatement sql_insert(*m_db, m_stmtInsertEvent_id_tenant_prio_ts_data);
+        return !record.id.empty() && !record.tenantToken.empty() && static_cast<int>(record.latency) >= 0 && record.timestamp > 0;
+    }
 
-        if (record.id.empty() || record.tenantToken.empty() || static_cast<int>(record.latency) < 0 || record.timestamp <= 0) {
+    bool OfflineStorage_SQLite::StoreRecord(StorageRecord const& record)
+    {
+        if (!isStorable(record)) {
             LOG_ERROR("Failed to store event %s:%s: Invalid parameters",
-                tenantTokenToId(record.tenantToken).c_str(), record.id.c_str());
+                tenantTokenToId(record.tenantToken).c_str(), EventId::ToText(record.id).c_str());
             m_observer->OnStorageFailed("Invalid parameters");
             return false;
         }
 
         if (!m_db) {
             LOG_ERROR("Failed to store event %s:%s: Database is not open",
-                tenantTokenToId(record.tenantToken).c_str(), record.id.c_str());
+                tenantTokenToId(record.tenantToken).c_str(), EventId::ToText(record.id).c_str());
             m_observer->OnStorageOpenFailed("Database is not open");
             return false;
         }
@@ -171,15 +179,124 @@ namespace MAT_NS_BEGIN {
             DbTransaction transaction(m_db.get());
             if (!transaction.locked)
             {
-                LOG_ERROR("Failed to store event %s:%s: Database error", tenantTokenToId(record.tenantToken).c_str(), record.id.c_str());
+                LOG_ERROR("Failed to store event %s:%s: Database error", tenantTokenToId(record.tenantToken).c_str(), EventId::ToText(record.id).c_str());
                 m_observer->OnStorageFailed("Database error");
                 return false;
             }
 #endif
-            SqliteStatement(*m_db, m_stmtInsertEvent_id_tenant_prio_ts_data).execute(record.id, record.tenantToken, static_cast<int>(record.latency), static_cast<int>(record.persistence), record.timestamp, record.blob);
-            m_DbSizeEstimate += record.id.size() + record.tenantToken.size() + record.blob.size();
+            SqliteStatement insertStmt(*m_db, m_stmtInsertEvent_id_tenant_prio_ts_data);
+            insertRecord(insertStmt, record);
+        }
+
+        checkDbSizeLimits();
+        return true;
+
+    }
+
+    /// <summary>
+    /// Stores the batch in a single transaction, so moving the RAM queue to
+    /// disk costs one commit instead of one per record. Records are written
+    /// kInsertBatchRows at a time with a multi-row REPLACE; the remainder, or
+    /// a chunk whose multi-row insert failed, goes through the single-row
+    /// statement. Both prepared statements are reused for the whole batch.
+    /// The records stored are moved to the front of the batch.
+    /// </summary>
+    size_t OfflineStorage_SQLite::StoreRecords(std::vector<StorageRecord> & records)
+    {
+        if (records.empty()) {
+            return 0;
+        }
+
+        if (!m_db) {
+            LOG_ERROR("Failed to store %zu events: Database is not open", records.size());
+            m_observer->OnStorageOpenFailed("Database is not open");
+            return 0;
         }
 
+        std::vector<StorageRecord const*> storable;
+        std::vector<size_t> storableIndex;
+        storable.reserve(records.size());
+        storableIndex.reserve(records.size());
+        for (size_t index = 0; index < records.size(); index++) {
+            StorageRecord const& record = records[index];
+            if (!isStorable(record)) {
+                LOG_ERROR("Failed to store event %s:%s: Invalid parameters",
+                    tenantTokenToId(record.tenantToken).c_str(), EventId::ToText(record.id).c_str());
+                m_observer->OnStorageFailed("Invalid parameters");
+                continue;
+            }
+            storable.push_back(&record);
+            storableIndex.push_back(index);
+        }
+
+        std::vector<bool> saved(records.size(), false);
+        {
+            LOCKGUARD(m_lock);
+#ifdef ENABLE_LOCKING
+            DbTransaction transaction(m_db.get());
+            if (!transaction.locked)
+            {
+                LOG_ERROR("Failed to store %zu events: Database error", storable.size());
+                m_observer->OnStorageFailed("Database error");
+                return 0;
+            }
+#endif
+            SqliteStatement batchStmt(*m_db, m_stmtInsertEvents_batch);
+            SqliteStatement insertStmt(*m_db, m_stmtInsertEvent_id_tenant_prio_ts_data);
+            size_t i = 0;
+            while (i < storable.size()) {
+                size_t count = std::min(kInsertBatchRows, storable.size() - i);
+                if (count == kInsertBatchRows && insertRecords(batchStmt, &storable[i], count)) {
+                    for (size_t end = i + count; i < end; i++) {
+                        saved[storableIndex[i]] = true;
+                    }
+                    continue;
+                }
+                for (size_t end = i + count; i < end; i++) {
+                    saved[storableIndex[i]] = insertRecord(insertStmt, *storable[i]);
+                }
+            }
+        }
+
+        // The storable pointers are not used past this point
+        size_t stored = moveFlaggedToFront(records, saved);
+        checkDbSizeLimits();
+        return stored;
+    }
+
+    bool OfflineStorage_SQLite::insertRecord(SqliteStatement& stmt, StorageRecord const& record)
+    {
+        std::string const id = EventId::ToText(record.id);
+        if (!stmt.execute(id, record.tenantToken, static_cast<int>(record.latency), static_cast<int>(record.persistence), record.timestamp, record.blob)) {
+            return false;
+        }
+        m_DbSizeEstimate += id.size() + record.tenantToken.size() + record.blob.size();
+        return true;
+    }
+
+    bool OfflineStorage_SQLite::insertRecords(SqliteStatement& stmt, StorageRecord const* const* records, size_t count)
+    {
+        // Parameters are bound without copying and must outlive the statement execution
+        std::vector<std::string> ids;
+        ids.reserve(count);
+        int failedIdx = 0;
+        size_t size = 0;
+        for (size_t row = 0; row < count && failedIdx == 0; row++) {
+            StorageRecord const& record = *records[row];
+            ids.push_back(EventId::ToText(record.id));
+            failedIdx = stmt.bindAt(static_cast<int>(row * 6), ids.back(), record.tenantToken, static_cast<int>(record.latency), static_cast<int>(record.persistence), record.timestamp, record.blob);
+            size += ids.back().size() + record.tenantToken.size() + record.blob.size();
+        }
+        if (!stmt.executeBound(failedIdx)) {
+            stmt.reset();
+            return false;
+        }
+        m_DbSizeEstimate += size;
+        return true;
+    }
+
+    void OfflineStorage_SQLite::checkDbSizeLimits()
+    {
         if ((m_DbSizeNotificationLimit != 0) && (m_DbSizeEstimate>m_DbSizeNotificationLimit))
         {
             auto now = PAL::getMonotonicTimeMs();
@@ -209,20 +326,6 @@ namespace MAT_NS_BEGIN {
                 m_resizing = false;
             }
         }
-
-        return true;
-
-    }
-
-    size_t OfflineStorage_SQLite::StoreRecords(std::vector<StorageRecord> & records)
-    {
-        size_t stored = 0;
-        for (auto & i : records) {
-            if (StoreRecord(i)) {
-                ++stored;
-            }
-        }
-        return stored;
     }
 
     // Debug routine to print record count in the DB
@@ -246,7 +349,7 @@ namespace MAT_NS_BEGIN {
     /// <param name="minLatency">The minimum latency.</param>
     /// <param name="maxCount">The maximum count.</param>
     /// <returns></returns>
-    bool OfflineStorage_SQLite::GetAndReserveRecords(std::function<bool(StorageRecord&&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency, unsigned maxCount)
+    bool OfflineStorage_SQLite::GetAndReserveRecords(std::function<bool(StorageRecord const&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency, unsigned maxCount)
     {
         m_lastReadCount = 0;
 
@@ -294,6 +397,7 @@ namespace MAT_NS_BEGIN {
 
             while (selectStmt.getRow(record.id, record.tenantToken, latency, record.timestamp, record.retryCount, record.reservedUntil, record.blob))
             {
+                EventId::FromText(record.id);
                 if (latency < EventLatency_Off || latency > EventLatency_Max) {
                     record.latency = EventLatency_Normal;
                 }
@@ -301,7 +405,7 @@ namespace MAT_NS_BEGIN {
                     record.latency = static_cast<EventLatency>(latency);
                 }
                 consumedIds.push_back(record.id);
-                if (!consumer(std::move(record)))
+                if (!consumer(record))
                 {
                     consumedIds.pop_back();
                     break;
@@ -321,7 +425,7 @@ namespace MAT_NS_BEGIN {
             }
 
             LOG_TRACE("Reserving %u event(s) {%s%s} for %u milliseconds",
-                static_cast<unsigned>(consumedIds.size()), consumedIds.front().c_str(), (consumedIds.size() > 1) ? ", ..." : "", leaseTimeMs);
+                static_cast<unsigned>(consumedIds.size()), EventId::ToText(consumedIds.front()).c_str(), (consumedIds.size() > 1) ? ", ..." : "", leaseTimeMs);
 
             for (size_t i = 0; i < consumedIds.size(); i += kBlockSize)
             {
@@ -366,6 +470,7 @@ namespace MAT_NS_BEGIN {
                 int latency;
                 while (selectStmt.getRow(record.id, record.tenantToken, latency, record.timestamp, record.retryCount, record.reservedUntil, record.blob))
                 {
+                    EventId::FromText(record.id);
                     record.latency = static_cast<EventLatency>(latency);
                     records.push_back(record);
                 }
@@ -380,6 +485,7 @@ namespace MAT_NS_BEGIN {
                 int latency;
                 while (selectStmt.getRow(record.id, record.tenantToken, latency, record.timestamp, record.retryCount, record.reservedUntil, record.blob))
                 {
+                    EventId::FromText(record.id);
                     record.latency = static_cast<EventLatency>(latency);
                     records.push_back(record);
                 }
@@ -461,7 +567,7 @@ namespace MAT_NS_BEGIN {
 
         if (!m_db) {
             LOG_ERROR("Failed to delete %u sent event(s) {%s%s}: Database is not open",
-                static_cast<unsigned>(ids.size()), ids.front().c_str(), (ids.size() > 1) ? ", ..." : "");
+                static_cast<unsigned>(ids.size()), EventId::ToText(ids.front()).c_str(), (ids.size() > 1) ? ", ..." : "");
             return;
         }
 
@@ -476,7 +582,7 @@ namespace MAT_NS_BEGIN {
                 return;
             }
 #endif
-            LOG_TRACE("Deleting %u sent event(s) {%s%s}...", static_cast<unsigned>(ids.size()), ids.front().c_str(), (ids.size() > 1) ? ", ..." : "");
+            LOG_TRACE("Deleting %u sent event(s) {%s%s}...", static_cast<unsigned>(ids.size()), EventId::ToText(ids.front()).c_str(), (ids.size() > 1) ? ", ..." : "");
 
             for (size_t i = 0; i < ids.size(); i += kBlockSize) {
                 size_t count = std::min(kBlockSize, ids.size() - i);
@@ -485,7 +591,7 @@ namespace MAT_NS_BEGIN {
                 if (!SqliteStatement(*m_db, m_stmtDeleteEvents_ids).execute(idList)) {
                     LOG_ERROR(
                             "Failed to delete %u sent event(s) {%s%s}: Database error occurred, recreating database",
-                            static_cast<unsigned>(ids.size()), ids.front().c_str(),
+                            static_cast<unsigned>(ids.size()), EventId::ToText(ids.front()).c_str(),
                             (ids.size() > 1) ? ", ..." : "");
                     recreate(302);
                     return;
@@ -504,7 +610,7 @@ namespace MAT_NS_BEGIN {
         }
         if (!m_db) {
             LOG_ERROR("Failed to release %u event(s) {%s%s}, retry count %s: Database is not open",
-                static_cast<unsigned>(ids.size()), ids.front().c_str(), (ids.size() > 1) ? ", ..." : "", incrementRetryCount ? "+1" : "not changed");
+                static_cast<unsigned>(ids.size()), EventId::ToText(ids.front()).c_str(), (ids.size() > 1) ? ", ..." : "", incrementRetryCount ? "+1" : "not changed");
             return;
         }
 
@@ -519,7 +625,7 @@ namespace MAT_NS_BEGIN {
             }
 #endif
             LOG_TRACE("Releasing %u event(s) {%s%s}, retry count %s...",
-                static_cast<unsigned>(ids.size()), ids.front().c_str(), (ids.size() > 1) ? ", ..." : "", incrementRetryCount ? "+1" : "not changed");
+                static_cast<unsigned>(ids.size()), EventId::ToText(ids.front()).c_str(), (ids.size() > 1) ? ", ..." : "", incrementRetryCount ? "+1" : "not changed");
 
             SqliteStatement releaseStmt(*m_db, m_stmtReleaseEvents_ids_retryCountDelta);
             for (size_t i = 0; i < ids.size(); i += kBlockSize) {
@@ -528,7 +634,7 @@ namespace MAT_NS_BEGIN {
                 if (!releaseStmt.execute(idList, incrementRetryCount ? 1 : 0)) {
                     LOG_ERROR(
                             "Failed to release %u event(s) {%s%s}, retry count %s: Database error occurred, recreating database",
-                            static_cast<unsigned>(ids.size()), ids.front().c_str(),
+                            static_cast<unsigned>(ids.size()), EventId::ToText(ids.front()).c_str(),
                             (ids.size() > 1) ? ", ..." : "",
                             incrementRetryCount ? "+1" : "not changed");
                     recreate(403);
@@ -851,6 +957,12 @@ namespace MAT_NS_BEGIN {
             " WHERE retry_count>?");
         PREPARE_SQL(m_stmtInsertEvent_id_tenant_prio_ts_data,
             "REPLACE INTO " TABLE_NAME_EVENTS " (record_id,tenant_token,latency,persistence,timestamp,payload) VALUES (?,?,?,?,?,?)");
+        std::string insertBatch("REPLACE INTO " TABLE_NAME_EVENTS " (record_id,tenant_token,latency,persistence,timestamp,payload) VALUES (?,?,?,?,?,?)");
+        for (size_t i = 1; i < kInsertBatchRows; i++) {
+            insertBatch += ",(?,?,?,?,?,?)";
+        }
+        PREPARE_SQL(m_stmtInsertEvents_batch,
+            insertBatch.c_str());
         PREPARE_SQL(m_stmtInsertSetting_name_value,
             "REPLACE INTO " TABLE_NAME_SETTINGS " (name,value) VALUES (?,?)");
         PREPARE_SQL(m_stmtDeleteSetting_name,
@@ -982,8 +1094,9 @@ namespace MAT_NS_BEGIN {
         std::vector<std::string>::const_iterator const & begin,
         std::vector<std::string>::const_iterator const & end) const
     {
+        // Binary IDs are stored as text, see EventId::ToText
         size_t size = std::accumulate(begin, end, size_t(0), [](size_t sum, std::string const& id) -> size_t {
-            return sum + id.length() + 1;
+            return sum + ((id.length() == EventId::Size) ? 2 * EventId::Size : id.length()) + 1;
         });
 
         std::vector<uint8_t> result;
@@ -991,7 +1104,7 @@ namespace MAT_NS_BEGIN {
 
         for (auto i = begin; i != end; ++i)
         {
-            std::string const & id(*i);
+            std::string const id = EventId::ToText(*i);
             uint8_t const* ptr = reinterpret_cast<uint8_t const*>(id.c_str());
             result.insert(result.end(), ptr, ptr + id.size() + 1);
         }
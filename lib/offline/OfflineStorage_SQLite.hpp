@@ -22,6 +22,7 @@
 namespace MAT_NS_BEGIN {
 
     class SqliteDB;
+    class SqliteStatement;
 
     class OfflineStorage_SQLite : public IOfflineStorage
     {
@@ -35,7 +36,7 @@ namespace MAT_NS_BEGIN {
         virtual void Execute(std::string command);
         virtual bool StoreRecord(StorageRecord const& record) override;
         virtual size_t StoreRecords(std::vector<StorageRecord> & records) override;
-        virtual bool GetAndReserveRecords(std::function<bool(StorageRecord&&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency = EventLatency_Normal, unsigned maxCount = 0) override;
+        virtual bool GetAndReserveRecords(std::function<bool(StorageRecord const&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency = EventLatency_Normal, unsigned maxCount = 0) override;
         virtual bool IsLastReadFromMemory() override;
         virtual unsigned LastReadRecordCount() override;
 
@@ -60,6 +61,10 @@ namespace MAT_NS_BEGIN {
             std::vector<std::string>::const_iterator const & begin,
             std::vector<std::string>::const_iterator const & end) const;
 
+        bool insertRecord(SqliteStatement& stmt, StorageRecord const& record);
+        bool insertRecords(SqliteStatement& stmt, StorageRecord const* const* records, size_t count);
+        void checkDbSizeLimits();
+
         // Debug routine to print record count in the DB
         void printRecordCount();
 
@@ -105,6 +110,7 @@ namespace MAT_NS_BEGIN {
         size_t                      m_stmtDeleteEventsRetried_maxRetryCount {};
         size_t                      m_stmtSelectEventsRetried_maxRetryCount {};
         size_t                      m_stmtInsertEvent_id_tenant_prio_ts_data {};
+        size_t                      m_stmtInsertEvents_batch {};
         size_t                      m_stmtInsertSetting_name_value {};
         size_t                      m_stmtDeleteSetting_name {};
         size_t                      m_stmtSelectSetting_name {};
@@ -0,0 +1,1125 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+#ifdef HAVE_MAT_STORAGE
+
+#include "OfflineStorage_Segments.hpp"
+#include "ILogManager.hpp"
+#include "utils/EventId.hpp"
+#include "utils/FileUtils.hpp"
+#include "utils/StringUtils.hpp"
+#include "utils/Utils.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace MAT_NS_BEGIN {
+
+    constexpr size_t OfflineStorage_Segments::MaxRecordsPerSegment;
+    constexpr size_t OfflineStorage_Segments::LatencyCount;
+
+    namespace {
+
+        constexpr uint32_t kIndexMagic = 0x4753544D;   // "MTSG"
+        constexpr uint32_t kIndexVersion = 2;
+
+        constexpr size_t kMinSegmentSize = 64 * 1024;
+        constexpr size_t kMaxSegmentSize = 1024 * 1024;
+        // Slots when the cache file size is unlimited
+        constexpr size_t kDefaultSlotCount = 256;
+
+        struct IndexHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t segmentSize;
+            uint32_t slotCount;
+            uint64_t nextSeq;
+        };
+
+        // A slot is in use when seq is not 0. Only the first recordCount
+        // records of its segment are valid: the count is raised after a
+        // record has been written, which makes it the commit point. A slot
+        // gets a new seq whenever its segment is started over, and records
+        // carry the seq they were written under, so that headers left in
+        // the file from an earlier use are never taken for valid ones.
+        struct IndexSlot
+        {
+            uint64_t seq;
+            uint32_t recordCount;
+            uint32_t reserved;
+            uint8_t acked[OfflineStorage_Segments::MaxRecordsPerSegment / 8];
+            uint8_t retries[OfflineStorage_Segments::MaxRecordsPerSegment];
+        };
+
+        // Records start at multiples of 8 bytes; size includes the padding.
+        // The header is followed by the ID, the tenant token and the blob.
+        struct RecordHeader
+        {
+            uint32_t size;
+            uint32_t blobSize;
+            uint16_t idSize;
+            uint16_t tokenSize;
+            uint8_t latency;
+            uint8_t persistence;
+            uint16_t reserved;
+            int64_t timestamp;
+            // Low bits of the seq of the slot when the record was written
+            uint32_t epoch;
+            uint32_t reserved2;
+        };
+
+        static_assert(sizeof(RecordHeader) == 32, "RecordHeader must not be padded");
+
+        size_t align8(size_t size)
+        {
+            return (size + 7) & ~static_cast<size_t>(7);
+        }
+
+        IndexHeader* indexHeader(MappedFile const& index)
+        {
+            return reinterpret_cast<IndexHeader*>(index.Data());
+        }
+
+        IndexSlot* indexSlot(MappedFile const& index, size_t slot)
+        {
+            return reinterpret_cast<IndexSlot*>(index.Data() + sizeof(IndexHeader)) + slot;
+        }
+
+        RecordHeader recordHeader(uint8_t const* data)
+        {
+            RecordHeader header;
+            memcpy(&header, data, sizeof(header));
+            return header;
+        }
+
+        size_t criticality(uint8_t persistence)
+        {
+            return (persistence >= EventPersistence_Critical) ? 1 : 0;
+        }
+
+        bool isStorable(StorageRecord const& record)
+        {
+            return !record.id.empty() && !record.tenantToken.empty() && static_cast<int>(record.latency) >= 0 && record.timestamp > 0;
+        }
+
+        // Settings are stored one "name=value" per line
+        std::string escapeSetting(std::string const& text)
+        {
+            static char const hex[] = "0123456789ABCDEF";
+            std::string result;
+            result.reserve(text.size());
+            for (char c : text)
+            {
+                if (c == '%' || c == '=' || c == '\n' || c == '\r')
+                {
+                    result += '%';
+                    result += hex[(static_cast<uint8_t>(c) >> 4) & 0xF];
+                    result += hex[static_cast<uint8_t>(c) & 0xF];
+                }
+                else
+                {
+                    result += c;
+                }
+            }
+            return result;
+        }
+
+        std::string unescapeSetting(std::string const& text)
+        {
+            std::string result;
+            result.reserve(text.size());
+            for (size_t i = 0; i < text.size(); i++)
+            {
+                if (text[i] == '%' && i + 2 < text.size())
+                {
+                    result += static_cast<char>(std::strtol(text.substr(i + 1, 2).c_str(), nullptr, 16));
+                    i += 2;
+                }
+                else
+                {
+                    result += text[i];
+                }
+            }
+            return result;
+        }
+
+    }
+
+    MATSDK_LOG_INST_COMPONENT_CLASS(OfflineStorage_Segments, "EventsSDK.Storage", "Events telemetry client - OfflineStorage_Segments class");
+
+    OfflineStorage_Segments::OfflineStorage_Segments(ILogManager& logManager, IRuntimeConfig& runtimeConfig)
+        : m_config(runtimeConfig)
+        , m_logManager(logManager)
+    {
+        m_path = (const char *)m_config[CFG_STR_CACHE_FILE_PATH];
+
+        size_t limit = m_config.GetOfflineStorageMaximumSizeBytes();
+        if (limit == 0)
+        {
+            m_segmentSize = kMaxSegmentSize;
+            m_slotCount = kDefaultSlotCount;
+        }
+        else
+        {
+            // About 8 segments per cache file, so that dropping one when the
+            // storage is full loses a small part of the backlog
+            m_segmentSize = std::min(kMaxSegmentSize, std::max(kMinSegmentSize, (limit / 8) & ~(kMinSegmentSize - 1)));
+            m_slotCount = std::max<size_t>(2, limit / m_segmentSize);
+        }
+
+        m_fullNotificationPct = m_config[CFG_INT_STORAGE_FULL_PCT];
+        if ((m_fullNotificationPct == 0) || (m_fullNotificationPct > 100))
+        {
+            m_fullNotificationPct = DB_FULL_NOTIFICATION_DEFAULT_PERCENTAGE;
+        }
+        m_fullNotificationInterval = m_config[CFG_INT_STORAGE_FULL_CHECK_TIME];
+    }
+
+    OfflineStorage_Segments::~OfflineStorage_Segments()
+    {
+        close();
+    }
+
+    void OfflineStorage_Segments::Initialize(IOfflineStorageObserver& observer)
+    {
+        m_observer = &observer;
+
+        LOG_TRACE("Initializing offline storage: %s", m_path.c_str());
+        LOCKGUARD(m_lock);
+        auto startTime = GetUptimeMs();
+        if (open())
+        {
+            m_isOpen = true;
+            LOG_INFO("Storage opened in %lld ms, %zu segment(s) of %zu bytes in use", GetUptimeMs() - startTime, m_segments.size(), m_segmentSize);
+            m_observer->OnStorageOpened("Segments/Default");
+            return;
+        }
+
+        close();
+        LOG_ERROR("Failed to open offline storage %s", m_path.c_str());
+        m_observer->OnStorageOpenFailed("Failed to map segment index");
+    }
+
+    void OfflineStorage_Segments::Shutdown()
+    {
+        LOG_TRACE("Shutting down offline storage %s", m_path.c_str());
+        LOCKGUARD(m_lock);
+        close();
+    }
+
+    void OfflineStorage_Segments::Flush()
+    {
+        LOCKGUARD(m_lock);
+        for (auto const& segment : m_segments)
+        {
+            segment->file.Flush();
+        }
+        m_index.Flush();
+    }
+
+    bool OfflineStorage_Segments::open()
+    {
+        if (!m_index.Open(m_path + ".idx", sizeof(IndexHeader) + m_slotCount * sizeof(IndexSlot)))
+        {
+            return false;
+        }
+
+        IndexHeader* header = indexHeader(m_index);
+        if (header->magic != kIndexMagic || header->version != kIndexVersion ||
+            header->segmentSize != m_segmentSize || header->slotCount != m_slotCount)
+        {
+            if (header->magic != 0)
+            {
+                LOG_WARN("Discarding stored events: segment layout has changed");
+            }
+            reset();
+        }
+
+        loadSettings();
+
+        for (size_t slot = m_slotCount; slot-- > 0;)
+        {
+            IndexSlot* indexed = indexSlot(m_index, slot);
+            if (indexed->seq != 0 && !loadSegment(slot))
+            {
+                memset(indexed, 0, sizeof(IndexSlot));
+            }
+            if (indexed->seq == 0)
+            {
+                m_freeSlots.push_back(slot);
+            }
+        }
+
+        std::sort(m_segments.begin(), m_segments.end(), [](std::unique_ptr<Segment> const& a, std::unique_ptr<Segment> const& b) {
+            return a->seq < b->seq;
+        });
+
+        // A record stored again under the same ID replaces the older copy
+        std::vector<Segment*> replaced;
+        for (auto const& segment : m_segments)
+        {
+            for (size_t i = 0; i < segment->entries.size(); i++)
+            {
+                if (segment->entries[i].acked)
+                {
+                    continue;
+                }
+                Location& location = m_ids[readId(*segment, i)];
+                if (location.segment != nullptr)
+                {
+                    acknowledge(*location.segment, location.index);
+                    replaced.push_back(location.segment);
+                }
+                location = Location { segment.get(), static_cast<uint32_t>(i) };
+            }
+        }
+        std::sort(replaced.begin(), replaced.end());
+        replaced.erase(std::unique(replaced.begin(), replaced.end()), replaced.end());
+        for (Segment* segment : replaced)
+        {
+            reclaim(segment);
+        }
+        return true;
+    }
+
+    void OfflineStorage_Segments::close()
+    {
+        m_isOpen = false;
+        m_segments.clear();
+        m_freeSlots.clear();
+        m_ids.clear();
+        std::fill(std::begin(m_live), std::end(m_live), 0);
+        std::fill(std::begin(m_available), std::end(m_available), 0);
+        m_reservedCount = 0;
+        m_settings.clear();
+        m_index.Close();
+    }
+
+    /// <summary>
+    /// Starts over with an empty index. Segment files of the previous layout
+    /// are deleted, including those of slots that no longer exist.
+    /// </summary>
+    void OfflineStorage_Segments::reset()
+    {
+        IndexHeader* previous = indexHeader(m_index);
+        size_t staleSlots = (previous->magic == kIndexMagic) ? previous->slotCount : kDefaultSlotCount;
+        for (size_t slot = 0; slot < std::max(staleSlots, m_slotCount); slot++)
+        {
+            std::string path = segmentPath(slot);
+            if (FileExists(path.c_str()))
+            {
+                FileDelete(path.c_str());
+            }
+        }
+
+        memset(m_index.Data(), 0, m_index.Size());
+        IndexHeader* header = indexHeader(m_index);
+        header->magic = kIndexMagic;
+        header->version = kIndexVersion;
+        header->segmentSize = static_cast<uint32_t>(m_segmentSize);
+        header->slotCount = static_cast<uint32_t>(m_slotCount);
+        header->nextSeq = 1;
+    }
+
+    bool OfflineStorage_Segments::loadSegment(size_t slot)
+    {
+        IndexSlot* indexed = indexSlot(m_index, slot);
+        if (indexed->recordCount == 0 || indexed->recordCount > MaxRecordsPerSegment)
+        {
+            return false;
+        }
+
+        std::unique_ptr<Segment> segment(new Segment());
+        segment->slot = slot;
+        segment->seq = indexed->seq;
+        if (!segment->file.Open(segmentPath(slot), m_segmentSize))
+        {
+            LOG_ERROR("Failed to map segment %zu, its events are lost", slot);
+            return false;
+        }
+
+        uint8_t const* data = segment->file.Data();
+        size_t offset = 0;
+        while (segment->entries.size() < indexed->recordCount && offset + sizeof(RecordHeader) <= m_segmentSize)
+        {
+            RecordHeader header = recordHeader(data + offset);
+            if (header.size < sizeof(RecordHeader) || header.size % 8 != 0 || offset + header.size > m_segmentSize ||
+                sizeof(RecordHeader) + header.idSize + header.tokenSize + header.blobSize > header.size ||
+                header.latency >= LatencyCount || header.epoch != static_cast<uint32_t>(indexed->seq))
+            {
+                break;
+            }
+            size_t index = segment->entries.size();
+            bool acked = (indexed->acked[index / 8] & (1u << (index % 8))) != 0;
+            segment->entries.push_back(Entry { static_cast<uint32_t>(offset), header.latency, header.persistence, acked, 0, 0 });
+            enqueue(*segment, index);
+            offset += header.size;
+        }
+
+        if (segment->entries.size() != indexed->recordCount)
+        {
+            LOG_WARN("Segment %zu is damaged, keeping %zu of %u events", slot, segment->entries.size(), indexed->recordCount);
+            indexed->recordCount = static_cast<uint32_t>(segment->entries.size());
+        }
+        segment->writeOffset = offset;
+
+        for (Entry const& entry : segment->entries)
+        {
+            if (!entry.acked)
+            {
+                segment->live++;
+                segment->available[entry.latency]++;
+            }
+        }
+        if (segment->live == 0)
+        {
+            return false;
+        }
+        for (size_t latency = 0; latency < LatencyCount; latency++)
+        {
+            m_live[latency] += segment->available[latency];
+            m_available[latency] += segment->available[latency];
+        }
+        while (segment->entries[segment->first].acked)
+        {
+            segment->first++;
+        }
+        m_segments.push_back(std::move(segment));
+        return true;
+    }
+
+    std::string OfflineStorage_Segments::segmentPath(size_t slot) const
+    {
+        return m_path + ".seg" + toString(slot);
+    }
+
+    bool OfflineStorage_Segments::StoreRecord(StorageRecord const& record)
+    {
+        if (!isStorable(record)) {
+            LOG_ERROR("Failed to store event %s:%s: Invalid parameters",
+                tenantTokenToId(record.tenantToken).c_str(), EventId::ToText(record.id).c_str());
+            m_observer->OnStorageFailed("Invalid parameters");
+            return false;
+        }
+
+        LOCKGUARD(m_lock);
+        if (!m_isOpen) {
+            LOG_ERROR("Failed to store event %s:%s: Storage is not open",
+                tenantTokenToId(record.tenantToken).c_str(), EventId::ToText(record.id).c_str());
+            m_observer->OnStorageOpenFailed("Storage is not open");
+            return false;
+        }
+        return append(record);
+    }
+
+    size_t OfflineStorage_Segments::StoreRecords(std::vector<StorageRecord> & records)
+    {
+        if (records.empty()) {
+            return 0;
+        }
+
+        LOCKGUARD(m_lock);
+        if (!m_isOpen) {
+            LOG_ERROR("Failed to store %zu events: Storage is not open", records.size());
+            m_observer->OnStorageOpenFailed("Storage is not open");
+            return 0;
+        }
+
+        std::vector<bool> saved(records.size(), false);
+        for (size_t index = 0; index < records.size(); index++) {
+            StorageRecord const& record = records[index];
+            if (!isStorable(record)) {
+                LOG_ERROR("Failed to store event %s:%s: Invalid parameters",
+                    tenantTokenToId(record.tenantToken).c_str(), EventId::ToText(record.id).c_str());
+                m_observer->OnStorageFailed("Invalid parameters");
+                continue;
+            }
+            saved[index] = append(record);
+        }
+        return moveFlaggedToFront(records, saved);
+    }
+
+    void OfflineStorage_Segments::enqueue(Segment& segment, size_t index)
+    {
+        Entry& entry = segment.entries[index];
+        std::vector<uint32_t>& queue = segment.queued[entry.latency][criticality(entry.persistence)];
+        entry.position = static_cast<uint32_t>(queue.size());
+        queue.push_back(static_cast<uint32_t>(index));
+    }
+
+    bool OfflineStorage_Segments::append(StorageRecord const& record)
+    {
+        size_t size = align8(sizeof(RecordHeader) + record.id.size() + record.tenantToken.size() + record.blob.size());
+        if (size > m_segmentSize || record.id.size() > UINT16_MAX || record.tenantToken.size() > UINT16_MAX) {
+            LOG_ERROR("Failed to store event %s:%s: %zu bytes do not fit in a segment",
+                tenantTokenToId(record.tenantToken).c_str(), EventId::ToText(record.id).c_str(), size);
+            m_observer->OnStorageFailed("Event too large");
+            return false;
+        }
+
+        auto existing = m_ids.find(record.id);
+        if (existing != m_ids.end()) {
+            Location location = existing->second;
+            m_ids.erase(existing);
+            acknowledge(*location.segment, location.index);
+            reclaim(location.segment);
+        }
+
+        Segment* segment = appendSegment(size);
+        if (segment == nullptr) {
+            return false;
+        }
+
+        uint8_t latency = static_cast<uint8_t>(std::min(static_cast<int>(record.latency), static_cast<int>(EventLatency_Max)));
+        RecordHeader header {};
+        header.size = static_cast<uint32_t>(size);
+        header.blobSize = static_cast<uint32_t>(record.blob.size());
+        header.idSize = static_cast<uint16_t>(record.id.size());
+        header.tokenSize = static_cast<uint16_t>(record.tenantToken.size());
+        header.latency = latency;
+        header.persistence = static_cast<uint8_t>(record.persistence);
+        header.timestamp = record.timestamp;
+        header.epoch = static_cast<uint32_t>(segment->seq);
+
+        uint8_t* data = segment->file.Data() + segment->writeOffset;
+        memcpy(data, &header, sizeof(header));
+        data += sizeof(header);
+        memcpy(data, record.id.data(), record.id.size());
+        data += record.id.size();
+        memcpy(data, record.tenantToken.data(), record.tenantToken.size());
+        data += record.tenantToken.size();
+        if (!record.blob.empty()) {
+            memcpy(data, record.blob.data(), record.blob.size());
+        }
+
+        size_t index = segment->entries.size();
+        segment->entries.push_back(Entry { static_cast<uint32_t>(segment->writeOffset), latency, header.persistence, false, 0, 0 });
+        enqueue(*segment, index);
+        segment->writeOffset += size;
+        segment->live++;
+        segment->available[latency]++;
+        m_live[latency]++;
+        m_available[latency]++;
+        m_ids[record.id] = Location { segment, static_cast<uint32_t>(index) };
+
+        indexSlot(m_index, segment->slot)->recordCount = static_cast<uint32_t>(index + 1);
+        return true;
+    }
+
+    /// <summary>
+    /// Returns the segment to append size bytes to: the newest one if the
+    /// record fits, else a new segment. When all slots are taken, the oldest
+    /// segment is dropped with whatever it still holds.
+    /// </summary>
+    OfflineStorage_Segments::Segment* OfflineStorage_Segments::appendSegment(size_t size)
+    {
+        if (!m_segments.empty()) {
+            Segment* newest = m_segments.back().get();
+            if (newest->writeOffset + size <= m_segmentSize && newest->entries.size() < MaxRecordsPerSegment) {
+                return newest;
+            }
+        }
+
+        if (m_freeSlots.empty()) {
+            DroppedMap trimmed;
+            size_t count = m_segments.front()->live;
+            releaseSegment(m_segments.front().get(), &trimmed);
+            if (count > 0) {
+                LOG_WARN("Storage is full, dropped %zu oldest events", count);
+                m_observer->OnStorageTrimmed(trimmed);
+            }
+        }
+
+        size_t slot = m_freeSlots.back();
+        std::unique_ptr<Segment> segment(new Segment());
+        if (!segment->file.Open(segmentPath(slot), m_segmentSize)) {
+            LOG_ERROR("Failed to map segment %zu", slot);
+            m_observer->OnStorageFailed("Failed to map segment");
+            return nullptr;
+        }
+        m_freeSlots.pop_back();
+
+        IndexSlot* indexed = indexSlot(m_index, slot);
+        memset(indexed, 0, sizeof(IndexSlot));
+        indexed->seq = indexHeader(m_index)->nextSeq++;
+        segment->slot = slot;
+        segment->seq = indexed->seq;
+        m_segments.push_back(std::move(segment));
+
+        notifyIfFull();
+        return m_segments.back().get();
+    }
+
+    void OfflineStorage_Segments::releaseSegment(Segment* segment, DroppedMap* dropped)
+    {
+        for (size_t i = segment->first; i < segment->entries.size(); i++) {
+            Entry const& entry = segment->entries[i];
+            if (entry.acked) {
+                continue;
+            }
+            if (dropped != nullptr) {
+                (*dropped)[readTenantToken(*segment, i)]++;
+            }
+            m_ids.erase(readId(*segment, i));
+            m_live[entry.latency]--;
+            if (entry.reservedUntil != 0) {
+                m_reservedCount--;
+            }
+            else {
+                m_available[entry.latency]--;
+            }
+        }
+
+        memset(indexSlot(m_index, segment->slot), 0, sizeof(IndexSlot));
+        m_freeSlots.push_back(segment->slot);
+        m_segments.erase(std::find_if(m_segments.begin(), m_segments.end(), [segment](std::unique_ptr<Segment> const& item) {
+            return item.get() == segment;
+        }));
+    }
+
+    /// <summary>
+    /// Frees a segment once all of its records are acknowledged. The newest
+    /// segment is rewound in place instead, so that a queue that is drained
+    /// as fast as it is filled keeps writing to the same mapping. It gets a
+    /// new seq, which stays the highest, so the old records that remain in
+    /// the file cannot be read back after a crash.
+    /// </summary>
+    void OfflineStorage_Segments::reclaim(Segment* segment)
+    {
+        if (segment->live != 0) {
+            return;
+        }
+        if (segment != m_segments.back().get()) {
+            releaseSegment(segment, nullptr);
+            return;
+        }
+        IndexSlot* indexed = indexSlot(m_index, segment->slot);
+        indexed->recordCount = 0;
+        indexed->seq = indexHeader(m_index)->nextSeq++;
+        memset(indexed->acked, 0, sizeof(indexed->acked));
+        memset(indexed->retries, 0, std::min(segment->entries.size(), sizeof(indexed->retries)));
+        segment->seq = indexed->seq;
+        segment->entries.clear();
+        segment->writeOffset = 0;
+        segment->first = 0;
+        for (size_t latency = 0; latency < LatencyCount; latency++) {
+            for (size_t critical = 0; critical < 2; critical++) {
+                segment->queued[latency][critical].clear();
+                segment->cursor[latency][critical] = 0;
+            }
+        }
+    }
+
+    void OfflineStorage_Segments::readRecord(Segment const& segment, size_t index, StorageRecord& record) const
+    {
+        Entry const& entry = segment.entries[index];
+        uint8_t const* data = segment.file.Data() + entry.offset;
+        RecordHeader header = recordHeader(data);
+        char const* text = reinterpret_cast<char const*>(data + sizeof(RecordHeader));
+        record.id.assign(text, header.idSize);
+        record.tenantToken.assign(text + header.idSize, header.tokenSize);
+        uint8_t const* blob = data + sizeof(RecordHeader) + header.idSize + header.tokenSize;
+        record.blob.assign(blob, blob + header.blobSize);
+        record.latency = static_cast<EventLatency>(entry.latency);
+        record.persistence = static_cast<EventPersistence>(entry.persistence);
+        record.timestamp = header.timestamp;
+        record.retryCount = retryCount(segment, index);
+        record.reservedUntil = entry.reservedUntil;
+    }
+
+    std::string OfflineStorage_Segments::readId(Segment const& segment, size_t index) const
+    {
+        uint8_t const* data = segment.file.Data() + segment.entries[index].offset;
+        RecordHeader header = recordHeader(data);
+        return std::string(reinterpret_cast<char const*>(data + sizeof(RecordHeader)), header.idSize);
+    }
+
+    std::string OfflineStorage_Segments::readTenantToken(Segment const& segment, size_t index) const
+    {
+        uint8_t const* data = segment.file.Data() + segment.entries[index].offset;
+        RecordHeader header = recordHeader(data);
+        return std::string(reinterpret_cast<char const*>(data + sizeof(RecordHeader) + header.idSize), header.tokenSize);
+    }
+
+    uint8_t& OfflineStorage_Segments::retryCount(Segment const& segment, size_t index) const
+    {
+        return indexSlot(m_index, segment.slot)->retries[index];
+    }
+
+    void OfflineStorage_Segments::acknowledge(Segment& segment, size_t index)
+    {
+        Entry& entry = segment.entries[index];
+        if (entry.acked) {
+            return;
+        }
+        entry.acked = true;
+        indexSlot(m_index, segment.slot)->acked[index / 8] |= static_cast<uint8_t>(1u << (index % 8));
+        segment.live--;
+        m_live[entry.latency]--;
+        if (entry.reservedUntil != 0) {
+            entry.reservedUntil = 0;
+            m_reservedCount--;
+        }
+        else {
+            segment.available[entry.latency]--;
+            m_available[entry.latency]--;
+        }
+        while (segment.first < segment.entries.size() && segment.entries[segment.first].acked) {
+            segment.first++;
+        }
+    }
+
+    void OfflineStorage_Segments::reserve(Segment& segment, size_t index, int64_t until)
+    {
+        Entry& entry = segment.entries[index];
+        entry.reservedUntil = std::max<int64_t>(until, 1);
+        if (m_reservedCount == 0 || entry.reservedUntil < m_nextExpiry) {
+            m_nextExpiry = entry.reservedUntil;
+        }
+        segment.available[entry.latency]--;
+        m_available[entry.latency]--;
+        m_reservedCount++;
+    }
+
+    void OfflineStorage_Segments::release(Segment& segment, size_t index, bool incrementRetryCount)
+    {
+        Entry& entry = segment.entries[index];
+        if (entry.acked || entry.reservedUntil == 0) {
+            return;
+        }
+        entry.reservedUntil = 0;
+        size_t& cursor = segment.cursor[entry.latency][criticality(entry.persistence)];
+        cursor = std::min<size_t>(cursor, entry.position);
+        segment.available[entry.latency]++;
+        m_available[entry.latency]++;
+        m_reservedCount--;
+        uint8_t& retries = retryCount(segment, index);
+        if (incrementRetryCount && retries < UINT8_MAX) {
+            retries++;
+        }
+    }
+
+    void OfflineStorage_Segments::releaseExpired(int64_t now)
+    {
+        if (m_reservedCount == 0 || now < m_nextExpiry) {
+            return;
+        }
+        unsigned released = 0;
+        int64_t nextExpiry = INT64_MAX;
+        for (auto const& segment : m_segments) {
+            for (size_t i = segment->first; i < segment->entries.size(); i++) {
+                Entry const& entry = segment->entries[i];
+                if (entry.acked || entry.reservedUntil == 0) {
+                    continue;
+                }
+                if (entry.reservedUntil <= now) {
+                    release(*segment, i, true);
+                    released++;
+                }
+                else {
+                    nextExpiry = std::min(nextExpiry, entry.reservedUntil);
+                }
+            }
+        }
+        m_nextExpiry = nextExpiry;
+        if (released > 0) {
+            LOG_TRACE("Released %u expired reserved events", released);
+        }
+    }
+
+    void OfflineStorage_Segments::dropRetried(DroppedMap& dropped)
+    {
+        unsigned maxRetryCount = m_config.GetMaximumRetryCount();
+        std::vector<Segment*> emptied;
+        for (auto const& segment : m_segments) {
+            for (size_t i = segment->first; i < segment->entries.size(); i++) {
+                if (!segment->entries[i].acked && retryCount(*segment, i) > maxRetryCount) {
+                    dropped[readTenantToken(*segment, i)]++;
+                    m_ids.erase(readId(*segment, i));
+                    acknowledge(*segment, i);
+                }
+            }
+            if (segment->live == 0) {
+                emptied.push_back(segment.get());
+            }
+        }
+        for (Segment* segment : emptied) {
+            reclaim(segment);
+        }
+    }
+
+    bool OfflineStorage_Segments::GetAndReserveRecords(std::function<bool(StorageRecord const&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency, unsigned maxCount)
+    {
+        LOCKGUARD(m_lock);
+        m_lastReadCount = 0;
+
+        if (!m_isOpen) {
+            LOG_ERROR("Failed to retrieve events to send: Storage is not open");
+            return false;
+        }
+
+        LOG_TRACE("Retrieving max. %u%s events of latency at least %d (%s)",
+            maxCount, (maxCount > 0) ? "" : " (unlimited)", minLatency, latencyToStr(static_cast<EventLatency>(minLatency)));
+
+        int64_t now = PAL::getUtcSystemTimeMs();
+        releaseExpired(now);
+
+        // Same order as the SQLite storage: latency descending, critical
+        // events first, then oldest first, which is the order of the log.
+        // The cursors skip entries that were reserved or acknowledged before.
+        unsigned count = 0;
+        int lowest = std::max(static_cast<int>(minLatency), static_cast<int>(EventLatency_Off));
+        for (int latency = EventLatency_Max; latency >= lowest; latency--) {
+            for (int critical = 1; critical >= 0 && m_available[latency] > 0; critical--) {
+                for (auto const& segment : m_segments) {
+                    if (segment->available[latency] == 0) {
+                        continue;
+                    }
+                    std::vector<uint32_t> const& queue = segment->queued[latency][critical];
+                    size_t& cursor = segment->cursor[latency][critical];
+                    for (; cursor < queue.size(); cursor++) {
+                        size_t i = queue[cursor];
+                        Entry const& entry = segment->entries[i];
+                        if (entry.acked || entry.reservedUntil != 0) {
+                            continue;
+                        }
+                        StorageRecord record;
+                        readRecord(*segment, i, record);
+                        if (!consumer(record)) {
+                            m_lastReadCount = count;
+                            return count > 0;
+                        }
+                        reserve(*segment, i, now + leaseTimeMs);
+                        if (++count == maxCount) {
+                            cursor++;
+                            m_lastReadCount = count;
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+
+        m_lastReadCount = count;
+        return count > 0;
+    }
+
+    bool OfflineStorage_Segments::IsLastReadFromMemory()
+    {
+        return false;
+    }
+
+    unsigned OfflineStorage_Segments::LastReadRecordCount()
+    {
+        return m_lastReadCount;
+    }
+
+    std::vector<StorageRecord> OfflineStorage_Segments::GetRecords(bool shutdown, EventLatency minLatency, unsigned maxCount)
+    {
+        std::vector<StorageRecord> records;
+        LOCKGUARD(m_lock);
+        if (!m_isOpen) {
+            LOG_ERROR("Storage is not open");
+            return records;
+        }
+
+        // At shutdown: every record of the latency or higher, highest first.
+        // Otherwise: the unreserved records of the lowest such latency.
+        int lowest = std::max(static_cast<int>(minLatency), static_cast<int>(EventLatency_Off));
+        int highest = EventLatency_Max;
+        if (!shutdown) {
+            while (lowest <= EventLatency_Max && m_available[lowest] == 0) {
+                lowest++;
+            }
+            highest = lowest;
+        }
+
+        for (int latency = highest; latency >= lowest; latency--) {
+            for (int critical = 1; critical >= 0; critical--) {
+                for (auto const& segment : m_segments) {
+                    std::vector<uint32_t> const& queue = segment->queued[latency][critical];
+                    for (size_t position = shutdown ? 0 : segment->cursor[latency][critical]; position < queue.size(); position++) {
+                        size_t i = queue[position];
+                        Entry const& entry = segment->entries[i];
+                        if (entry.acked || (!shutdown && entry.reservedUntil != 0)) {
+                            continue;
+                        }
+                        records.emplace_back();
+                        readRecord(*segment, i, records.back());
+                        if (records.size() == maxCount) {
+                            return records;
+                        }
+                    }
+                }
+            }
+        }
+        return records;
+    }
+
+    void OfflineStorage_Segments::DeleteAllRecords()
+    {
+        LOCKGUARD(m_lock);
+        while (!m_segments.empty()) {
+            releaseSegment(m_segments.front().get(), nullptr);
+        }
+    }
+
+    void OfflineStorage_Segments::DeleteRecords(const std::map<std::string, std::string> & whereFilter)
+    {
+        LOCKGUARD(m_lock);
+        if (!m_isOpen) {
+            LOG_ERROR("Storage is not open");
+            return;
+        }
+
+        for (auto const& kv : whereFilter) {
+            if (kv.first != "record_id" && kv.first != "tenant_token" && kv.first != "latency" &&
+                kv.first != "persistence" && kv.first != "retry_count") {
+                LOG_ERROR("Failed to delete events: unknown column %s", kv.first.c_str());
+                return;
+            }
+        }
+
+        auto matches = [&](Segment const& segment, size_t i) {
+            Entry const& entry = segment.entries[i];
+            for (auto const& kv : whereFilter) {
+                bool match;
+                if (kv.first == "record_id") {
+                    match = EventId::ToText(readId(segment, i)) == kv.second;
+                }
+                else if (kv.first == "tenant_token") {
+                    match = readTenantToken(segment, i) == kv.second;
+                }
+                else {
+                    long value = std::strtol(kv.second.c_str(), nullptr, 10);
+                    if (kv.first == "latency") {
+                        match = entry.latency == value;
+                    }
+                    else if (kv.first == "persistence") {
+                        match = entry.persistence == value;
+                    }
+                    else {
+                        match = retryCount(segment, i) == value;
+                    }
+                }
+                if (!match) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        std::vector<Segment*> emptied;
+        for (auto const& segment : m_segments) {
+            for (size_t i = segment->first; i < segment->entries.size(); i++) {
+                if (!segment->entries[i].acked && matches(*segment, i)) {
+                    m_ids.erase(readId(*segment, i));
+                    acknowledge(*segment, i);
+                }
+            }
+            if (segment->live == 0) {
+                emptied.push_back(segment.get());
+            }
+        }
+        for (Segment* segment : emptied) {
+            reclaim(segment);
+        }
+    }
+
+    void OfflineStorage_Segments::DeleteRecords(std::vector<StorageRecordId> const& ids, HttpHeaders headers, bool& fromMemory)
+    {
+        UNREFERENCED_PARAMETER(fromMemory);
+        UNREFERENCED_PARAMETER(headers);
+
+        if (ids.empty()) {
+            return;
+        }
+
+        LOCKGUARD(m_lock);
+        LOG_TRACE("Deleting %u sent event(s) {%s%s}...", static_cast<unsigned>(ids.size()), EventId::ToText(ids.front()).c_str(), (ids.size() > 1) ? ", ..." : "");
+
+        std::vector<Segment*> touched;
+        for (auto const& id : ids) {
+            auto it = m_ids.find(id);
+            if (it == m_ids.end()) {
+                continue;
+            }
+            Location location = it->second;
+            m_ids.erase(it);
+            acknowledge(*location.segment, location.index);
+            if (touched.empty() || touched.back() != location.segment) {
+                touched.push_back(location.segment);
+            }
+        }
+
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        for (Segment* segment : touched) {
+            reclaim(segment);
+        }
+    }
+
+    void OfflineStorage_Segments::ReleaseRecords(std::vector<StorageRecordId> const& ids, bool incrementRetryCount, HttpHeaders headers, bool& fromMemory)
+    {
+        UNREFERENCED_PARAMETER(fromMemory);
+        UNREFERENCED_PARAMETER(headers);
+
+        if (ids.empty()) {
+            return;
+        }
+
+        LOCKGUARD(m_lock);
+        LOG_TRACE("Releasing %u event(s) {%s%s}, retry count %s...",
+            static_cast<unsigned>(ids.size()), EventId::ToText(ids.front()).c_str(), (ids.size() > 1) ? ", ..." : "", incrementRetryCount ? "+1" : "not changed");
+
+        for (auto const& id : ids) {
+            auto it = m_ids.find(id);
+            if (it != m_ids.end()) {
+                release(*it->second.segment, it->second.index, incrementRetryCount);
+            }
+        }
+
+        if (incrementRetryCount) {
+            DroppedMap dropped;
+            dropRetried(dropped);
+            if (!dropped.empty()) {
+                LOG_ERROR("Deleted events over maximum retry count %u", m_config.GetMaximumRetryCount());
+                m_observer->OnStorageRecordsDropped(dropped);
+            }
+        }
+    }
+
+    void OfflineStorage_Segments::loadSettings()
+    {
+        m_settings.clear();
+        std::string contents = FileGetContents((m_path + ".settings").c_str());
+        size_t start = 0;
+        while (start < contents.size()) {
+            size_t end = contents.find('\n', start);
+            if (end == std::string::npos) {
+                end = contents.size();
+            }
+            size_t separator = contents.find('=', start);
+            if (separator < end) {
+                m_settings[unescapeSetting(contents.substr(start, separator - start))] = unescapeSetting(contents.substr(separator + 1, end - separator - 1));
+            }
+            start = end + 1;
+        }
+    }
+
+    bool OfflineStorage_Segments::saveSettings()
+    {
+        std::string contents;
+        for (auto const& kv : m_settings) {
+            contents += escapeSetting(kv.first);
+            contents += '=';
+            contents += escapeSetting(kv.second);
+            contents += '\n';
+        }
+        if (!FileWrite((m_path + ".settings").c_str(), contents.c_str())) {
+            LOG_ERROR("Failed to write settings file");
+            return false;
+        }
+        return true;
+    }
+
+    bool OfflineStorage_Segments::StoreSetting(std::string const& name, std::string const& value)
+    {
+        if (name.empty()) {
+            LOG_ERROR("Failed to set setting \"%s\": Name cannot be empty", name.c_str());
+            return false;
+        }
+
+        LOCKGUARD(m_lock);
+        if (!m_isOpen) {
+            LOG_ERROR("Failed to set setting \"%s\": Storage is not open", name.c_str());
+            return false;
+        }
+
+        if (value.empty()) {
+            if (m_settings.erase(name) == 0) {
+                return true;
+            }
+        }
+        else {
+            auto it = m_settings.find(name);
+            if (it != m_settings.end() && it->second == value) {
+                return true;
+            }
+            m_settings[name] = value;
+        }
+        return saveSettings();
+    }
+
+    std::string OfflineStorage_Segments::GetSetting(std::string const& name)
+    {
+        LOCKGUARD(m_lock);
+        auto it = m_settings.find(name);
+        return (it != m_settings.end()) ? it->second : std::string();
+    }
+
+    bool OfflineStorage_Segments::DeleteSetting(std::string const& name)
+    {
+        return StoreSetting(name, std::string());
+    }
+
+    size_t OfflineStorage_Segments::GetSize()
+    {
+        LOCKGUARD(m_lock);
+        return m_segments.size() * m_segmentSize;
+    }
+
+    size_t OfflineStorage_Segments::GetSegmentCount() const
+    {
+        LOCKGUARD(m_lock);
+        return m_segments.size();
+    }
+
+    size_t OfflineStorage_Segments::GetRecordCount(EventLatency latency) const
+    {
+        LOCKGUARD(m_lock);
+        if (latency == EventLatency_Unspecified) {
+            size_t count = 0;
+            for (size_t live : m_live) {
+                count += live;
+            }
+            return count;
+        }
+        if (latency < EventLatency_Off || latency > EventLatency_Max) {
+            return 0;
+        }
+        return m_live[latency];
+    }
+
+    /// <summary>
+    /// The storage never grows past its slots: segments are dropped as soon
+    /// as they are acknowledged, and the oldest one when a new one is needed.
+    /// </summary>
+    bool OfflineStorage_Segments::ResizeDb()
+    {
+        return true;
+    }
+
+    void OfflineStorage_Segments::notifyIfFull()
+    {
+        size_t percent = (100 * m_segments.size()) / m_slotCount;
+        if (percent < m_fullNotificationPct) {
+            return;
+        }
+        auto now = PAL::getMonotonicTimeMs();
+        if (static_cast<uint64_t>(now - m_fullNotificationTime) > m_fullNotificationInterval) {
+            // Notify the client that the storage is getting full, but only once in DB_FULL_CHECK_TIME_MS
+            m_fullNotificationTime = now;
+            DebugEvent evt;
+            evt.type = DebugEventType::EVT_STORAGE_FULL;
+            evt.param1 = percent;
+            m_logManager.DispatchEvent(evt);
+        }
+    }
+
+} MAT_NS_END
+#endif
+
@@ -0,0 +1,176 @@
+#include "mat/config.h"
+#ifdef HAVE_MAT_STORAGE
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+#include "pal/PAL.hpp"
+#include "IOfflineStorage.hpp"
+
+#include "api/IRuntimeConfig.hpp"
+
+#include "ILogManager.hpp"
+
+#include "utils/MappedFile.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MAT_NS_BEGIN {
+
+    /// <summary>
+    /// Offline storage kept as a FIFO log instead of a database. Records are
+    /// appended to fixed-size, memory-mapped segment files
+    /// (&lt;cacheFilePath&gt;.seg&lt;n&gt;). A sidecar index
+    /// (&lt;cacheFilePath&gt;.idx) lists the segments in use and, per record,
+    /// whether it has been acknowledged and how often it has been retried.
+    /// Reservations are leases held in memory only. Space is reclaimed by
+    /// dropping whole segments: once all of their records are acknowledged,
+    /// or oldest first when all segment slots are taken.
+    /// </summary>
+    class OfflineStorage_Segments : public IOfflineStorage
+    {
+    public:
+        OfflineStorage_Segments(ILogManager& logManager, IRuntimeConfig& runtimeConfig);
+
+        virtual ~OfflineStorage_Segments() override;
+        virtual void Initialize(IOfflineStorageObserver& observer) override;
+        virtual void Shutdown() override;
+        virtual void Flush() override;
+        virtual bool StoreRecord(StorageRecord const& record) override;
+        virtual size_t StoreRecords(std::vector<StorageRecord> & records) override;
+        virtual bool GetAndReserveRecords(std::function<bool(StorageRecord const&)> const& consumer, unsigned leaseTimeMs, EventLatency minLatency = EventLatency_Normal, unsigned maxCount = 0) override;
+        virtual bool IsLastReadFromMemory() override;
+        virtual unsigned LastReadRecordCount() override;
+
+        virtual void DeleteRecords(const std::map<std::string, std::string> & whereFilter) override;
+        virtual void DeleteAllRecords() override;
+        virtual void DeleteRecords(std::vector<StorageRecordId> const& ids, HttpHeaders headers, bool& fromMemory) override;
+        virtual void ReleaseRecords(std::vector<StorageRecordId> const& ids, bool incrementRetryCount, HttpHeaders headers, bool& fromMemory) override;
+
+        virtual bool StoreSetting(std::string const& name, std::string const& value) override;
+        virtual std::string GetSetting(std::string const& name) override;
+        virtual bool DeleteSetting(std::string const& name) override;
+        virtual size_t GetSize() override;
+        virtual size_t GetRecordCount(EventLatency latency) const override;
+        virtual std::vector<StorageRecord> GetRecords(bool shutdown, EventLatency minLatency = EventLatency_Normal, unsigned maxCount = 0) override;
+        virtual bool ResizeDb() override;
+
+        /// <summary>
+        /// Records per segment are capped so that the per-record state in
+        /// the index has a fixed size.
+        /// </summary>
+        static constexpr size_t MaxRecordsPerSegment = 4096;
+
+        size_t GetSegmentSize() const
+        {
+            return m_segmentSize;
+        }
+
+        size_t GetSegmentCount() const;
+
+    protected:
+        static constexpr size_t LatencyCount = EventLatency_Max + 1;
+
+        struct Entry
+        {
+            uint32_t offset;
+            uint8_t latency;
+            uint8_t persistence;
+            bool acked;
+            int64_t reservedUntil;
+            // Position in the queue of its latency and criticality
+            uint32_t position;
+        };
+
+        struct Segment
+        {
+            size_t slot;
+            uint64_t seq;
+            MappedFile file;
+            size_t writeOffset;
+            // Index of the first entry that may still be unacknowledged
+            size_t first;
+            size_t live;
+            // Unacknowledged and unreserved entries per latency
+            size_t available[LatencyCount];
+            std::vector<Entry> entries;
+            // Entry indices per latency and criticality, oldest first. No
+            // entry before the cursor is available to be reserved.
+            std::vector<uint32_t> queued[LatencyCount][2];
+            size_t cursor[LatencyCount][2];
+        };
+
+        struct Location
+        {
+            Segment* segment;
+            uint32_t index;
+        };
+
+        bool open();
+        void close();
+        void reset();
+        bool loadSegment(size_t slot);
+
+        void enqueue(Segment& segment, size_t index);
+        bool append(StorageRecord const& record);
+        Segment* appendSegment(size_t size);
+        void releaseSegment(Segment* segment, DroppedMap* dropped);
+        void reclaim(Segment* segment);
+
+        void readRecord(Segment const& segment, size_t index, StorageRecord& record) const;
+        std::string readId(Segment const& segment, size_t index) const;
+        std::string readTenantToken(Segment const& segment, size_t index) const;
+
+        void acknowledge(Segment& segment, size_t index);
+        void reserve(Segment& segment, size_t index, int64_t until);
+        void release(Segment& segment, size_t index, bool incrementRetryCount);
+        void releaseExpired(int64_t now);
+        void dropRetried(DroppedMap& dropped);
+        uint8_t& retryCount(Segment const& segment, size_t index) const;
+
+        std::string segmentPath(size_t slot) const;
+        void loadSettings();
+        bool saveSettings();
+        void notifyIfFull();
+
+    protected:
+        mutable std::recursive_mutex m_lock {};
+        IOfflineStorageObserver*    m_observer {};
+        IRuntimeConfig&             m_config;
+        ILogManager&                m_logManager;
+        std::string                 m_path;
+        size_t                      m_segmentSize {};
+        size_t                      m_slotCount {};
+        bool                        m_isOpen {};
+
+        MappedFile                  m_index;
+        // Segments in use, oldest first
+        std::vector<std::unique_ptr<Segment>> m_segments;
+        std::vector<size_t>         m_freeSlots;
+        std::unordered_map<std::string, Location> m_ids;
+        size_t                      m_live[LatencyCount] {};
+        size_t                      m_available[LatencyCount] {};
+        size_t                      m_reservedCount {};
+        // No reservation expires before this time
+        int64_t                     m_nextExpiry {};
+        unsigned                    m_lastReadCount {};
+        std::map<std::string, std::string> m_settings;
+
+        unsigned                    m_fullNotificationPct {};
+        uint64_t                    m_fullNotificationInterval {};
+        uint64_t                    m_fullNotificationTime {};
+
+    protected:
+        MATSDK_LOG_DECL_COMPONENT_CLASS();
+    };
+
+} MAT_NS_END
+#endif
+
@@ -571,6 +571,30 @@ namespace MAT_NS_BEGIN {
             }
         }
 
+        /// <summary>
+        /// Binds args to the parameters following #offset, so one statement can
+        /// insert several rows. Returns 0, or the index of the failed parameter.
+        /// </summary>
+        template<typename... TArgs>
+        int bindAt(int offset, TArgs&& ... args)
+        {
+            if (m_stmt == nullptr) {
+                return offset + 1;
+            }
+            return bindAll(offset, std::forward<TArgs>(args) ...);
+        }
+
+        /// <summary>
+        /// Executes the statement with the parameters set through bindAt().
+        /// </summary>
+        bool executeBound(int bindFailedIdx)
+        {
+            if (m_stmt == nullptr) {
+                return false;
+            }
+            return execute2(bindFailedIdx);
+        }
+
         template<typename... TArgs>
         bool select(TArgs&& ... args)
         {
@@ -41,11 +41,51 @@ namespace MAT_NS_BEGIN {
         return true;
     }
 
+    /// <summary>
+    /// Stores a batch of events with one StoreRecords call, then reports each
+    /// event as stored or failed. The records are moved into the batch and back,
+    /// and the storage keeps the stored ones first and in order, so an event's
+    /// record is recognized by its ID.
+    /// </summary>
+    void StorageObserver::handleStoreRecords(std::vector<IncomingEventContextPtr> const& events)
+    {
+        std::vector<StorageRecord> records;
+        std::vector<StorageRecordId> ids;
+        records.reserve(events.size());
+        ids.reserve(events.size());
+        int64_t now = PAL::getUtcSystemTimeMs();
+        for (auto const& ctx : events)
+        {
+            ctx->record.timestamp = now;
+            ids.push_back(ctx->record.id);
+            records.push_back(std::move(ctx->record));
+        }
+
+        size_t stored = m_offlineStorage.StoreRecords(records);
+        size_t next = 0;
+        size_t rejected = stored;
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            bool isStored = (next < stored) && (records[next].id == ids[i]);
+            auto const& ctx = events[i];
+            ctx->record = std::move(records[isStored ? next++ : rejected++]);
+            if (isStored)
+            {
+                recordStored(ctx);
+            }
+            else
+            {
+                // stats implementation must trigger a failure notification
+                storeRecordFailed(ctx);
+            }
+        }
+    }
+
     void StorageObserver::handleRetrieveEvents(EventsUploadContextPtr const& ctx)
     {
-        auto consumer = [&ctx, this](StorageRecord&& record) -> bool {
+        auto consumer = [&ctx, this](StorageRecord const& record) -> bool {
             bool wantMore = true;
-            retrievedEvent(ctx, std::move(record), wantMore);
+            retrievedEvent(ctx, record, wantMore);
             return wantMore;
         };
 
@@ -31,6 +31,7 @@ namespace MAT_NS_BEGIN {
         bool handleStop();
 
         bool handleStoreRecord(IncomingEventContextPtr const& ctx);
+        void handleStoreRecords(std::vector<IncomingEventContextPtr> const& events);
         void handleRetrieveEvents(EventsUploadContextPtr const& ctx);
 
         bool handleDeleteRecords(EventsUploadContextPtr const& ctx);
@@ -68,6 +69,9 @@ namespace MAT_NS_BEGIN {
         RouteSource<IncomingEventContextPtr const&>                              storeRecordFailed;
         RoutePassThrough<StorageObserver, IncomingEventContextPtr const&>        storeRecord{ this, &StorageObserver::handleStoreRecord };
 
+        RouteSink<StorageObserver, std::vector<IncomingEventContextPtr> const&>  storeRecords{ this, &StorageObserver::handleStoreRecords };
+        RouteSource<IncomingEventContextPtr const&>                              recordStored;
+
         RouteSink<StorageObserver, EventsUploadContextPtr const&>                retrieveEvents{ this, &StorageObserver::handleRetrieveEvents };
         RouteSource<EventsUploadContextPtr const&, StorageRecord const&, bool&>  retrievedEvent;
         RouteSource<EventsUploadContextPtr const&>                               retrievalFinished;
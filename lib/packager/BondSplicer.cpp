@@ -7,16 +7,17 @@
 #include "bond/All.hpp"
 #include "bond/generated/CsProtocol_writers.hpp"
 #include <assert.h>
+#include <algorithm>
 
 namespace MAT_NS_BEGIN {
 
+constexpr size_t BondSplicer::ChunkSize;
+
 size_t BondSplicer::addTenantToken(std::string const& tenantToken)
 {
-    size_t begin = m_buffer.size();
-
     m_overheadEstimate += 8 + tenantToken.size();
 
-    m_packages.push_back(PackageInfo { tenantToken, Span{begin, size_t{0}}, {} });
+    m_packages.push_back(PackageInfo { tenantToken, Span{m_chunks.size(), size_t{0}, size_t{0}}, {} });
     return m_packages.size() - 1;
 }
 
@@ -25,38 +26,47 @@ void BondSplicer::addRecord(size_t dataPackageIndex, std::vector<uint8_t> const&
     assert(dataPackageIndex < m_packages.size());
     assert(!recordBlob.empty() && recordBlob.back() == bond_lite::BT_STOP);
 
-    m_packages[dataPackageIndex].records.push_back(Span{m_buffer.size(), recordBlob.size()});
-    m_buffer.insert(m_buffer.end(), recordBlob.begin(), recordBlob.end());
+    if (m_chunks.empty() || m_chunks.back()->capacity() - m_chunks.back()->size() < recordBlob.size()) {
+        m_chunks.push_back(std::make_shared<std::vector<uint8_t>>());
+        m_chunks.back()->reserve(std::max(ChunkSize, recordBlob.size()));
+    }
+    std::vector<uint8_t>& chunk = *m_chunks.back();
+
+    m_packages[dataPackageIndex].records.push_back(Span{m_chunks.size() - 1, chunk.size(), recordBlob.size()});
+    chunk.insert(chunk.end(), recordBlob.begin(), recordBlob.end());
+    m_size += recordBlob.size();
 }
 
 size_t BondSplicer::getSizeEstimate() const
 {
-    return m_buffer.size() + m_overheadEstimate + 8 /*DataPackages*/;
+    return m_size + m_overheadEstimate + 8 /*DataPackages*/;
 }
 
 std::vector<uint8_t> BondSplicer::splice() const
 {
-    std::vector<uint8_t> output;
-    bond_lite::CompactBinaryProtocolWriter writer(output);
-
-    if (!m_packages.empty()) {
-        for (PackageInfo const& package : m_packages) {
-            if (!package.records.empty()) {
-                for (Span const& record : package.records) {
-                    writer.WriteBlob(m_buffer.data() + record.offset, record.length);
-                }
-            } 
-        }
-    } 
+    ScatterGatherBuffer views;
+    splice(views);
 
+    std::vector<uint8_t> output;
+    views.gather(output);
     return output;
 }
 
+void BondSplicer::splice(ScatterGatherBuffer& output) const
+{
+    for (PackageInfo const& package : m_packages) {
+        for (Span const& record : package.records) {
+            output.append(BlobView { m_chunks[record.chunk], record.offset, record.length });
+        }
+    }
+}
+
 void BondSplicer::clear()
 {
-    // Swap with empty instead of clear() to release memory
-    std::vector<uint8_t>().swap(m_buffer);
+    // Chunks stay alive as long as views returned by splice() refer to them
+    std::vector<std::shared_ptr<std::vector<uint8_t>>>().swap(m_chunks);
     std::vector<PackageInfo>().swap(m_packages);
+    m_size = 0;
     m_overheadEstimate = 0;
 }
 
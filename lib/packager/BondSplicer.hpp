@@ -10,6 +10,7 @@
 #include "ISplicer.hpp"
 
 #include <list>
+#include <memory>
 #include <vector>
 
 namespace MAT_NS_BEGIN {
@@ -18,11 +19,16 @@ namespace MAT_NS_BEGIN {
 class BondSplicer : public ISplicer
 {
   protected:
-    std::vector<uint8_t>     m_buffer;
+    // Record blobs are appended to fixed-capacity chunks, which are never
+    // reallocated, so splice() can hand out views into them.
+    std::vector<std::shared_ptr<std::vector<uint8_t>>> m_chunks;
+    size_t                   m_size {};
     std::vector<PackageInfo> m_packages;
     size_t                   m_overheadEstimate {};
 
   public:
+    static constexpr size_t ChunkSize = 64 * 1024;
+
     BondSplicer() noexcept = default;
     BondSplicer(BondSplicer const&) = delete;
     BondSplicer& operator=(BondSplicer const&) = delete;
@@ -32,6 +38,7 @@ class BondSplicer : public ISplicer
 
     size_t getSizeEstimate() const override;
     std::vector<uint8_t> splice() const override;
+    void splice(ScatterGatherBuffer& output) const override;
 
     void clear() override;
 };
@@ -7,6 +7,7 @@
 
 #include "pal/PAL.hpp"
 #include "DataPackage.hpp"
+#include "utils/ScatterGatherBuffer.hpp"
 
 #include <list>
 #include <vector>
@@ -17,7 +18,7 @@ class ISplicer
 {
   protected:
     struct Span {
-        size_t offset, length;
+        size_t chunk, offset, length;
     };
 
     struct PackageInfo {
@@ -34,6 +35,7 @@ class ISplicer
 
     virtual size_t getSizeEstimate() const = 0;
     virtual std::vector<uint8_t> splice() const = 0;
+    virtual void splice(ScatterGatherBuffer& output) const = 0;
 
     virtual void clear() = 0;
 };
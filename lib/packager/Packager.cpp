@@ -5,19 +5,34 @@
 
 #include "Packager.hpp"
 #include "ILogManager.hpp"
+#include "utils/EventId.hpp"
 #include "utils/StringUtils.hpp"
 #include <algorithm>
 
 namespace MAT_NS_BEGIN {
 
     Packager::Packager(IRuntimeConfig& runtimeConfig)
-        : m_config(runtimeConfig)
+        : m_config(runtimeConfig),
+          m_forcedTenant(InvalidTenantHandle),
+          m_streamingCompression(false),
+          m_deflateSettings { 0, 0, 0, nullptr }
     {
         const char *forcedTenantToken = runtimeConfig["forcedTenantToken"];
         if (forcedTenantToken != nullptr)
         {
             m_forcedTenantToken = forcedTenantToken;
         }
+        if (!m_forcedTenantToken.empty())
+        {
+            m_forcedTenant = TenantRegistry::instance().Register(m_forcedTenantToken);
+        }
+        m_streamingCompression = runtimeConfig[CFG_MAP_HTTP][CFG_BOOL_HTTP_STREAMING_COMPRESSION];
+        if (m_streamingCompression)
+        {
+            // Only the deflate formats are streamed, zstd uploads are compressed at once
+            m_streamingCompression = (runtimeConfig.GetHttpRequestContentEncoding() != "zstd");
+            m_deflateSettings = DeflateSettings::FromConfig(runtimeConfig);
+        }
     }
 
     void Packager::handleAddEventToPackage(EventsUploadContextPtr const& ctx, StorageRecord const& record, bool& wantMore)
@@ -30,7 +45,7 @@ namespace MAT_NS_BEGIN {
                 wantMore = false;
                 if (!ctx->recordIdsAndTenantIds.empty()) {
                     LOG_TRACE("Maximum upload size %u bytes exceeded, not adding the next event (ID %s, size %u bytes)",
-                        ctx->maxUploadSize, record.id.c_str(), static_cast<unsigned>(record.blob.size()));
+                        ctx->maxUploadSize, EventId::ToText(record.id).c_str(), static_cast<unsigned>(record.blob.size()));
                     return;
                 }
                 else {
@@ -45,23 +60,31 @@ namespace MAT_NS_BEGIN {
                     ctx->latency, latencyToStr(ctx->latency));
             }
 
+            TenantHandle tenant = tenantOf(ctx, record);
+
             LOG_TRACE("Adding event %s:%s, size %u bytes",
-                tenantTokenToId(record.tenantToken).c_str(), record.id.c_str(), static_cast<unsigned>(record.blob.size()));
+                TenantRegistry::instance().TenantId(tenant).c_str(), EventId::ToText(record.id).c_str(), static_cast<unsigned>(record.blob.size()));
 
             #ifdef HAVE_MAT_EVT_TRACEID
                         ctx->traceId = record.traceId;
             #endif // HAVE_MAT_EVT_TRACEID
 
-            std::string const& tenantToken = m_forcedTenantToken.empty() ? record.tenantToken : m_forcedTenantToken;
-            auto it = ctx->packageIds.lower_bound(tenantToken);
-            if (it == ctx->packageIds.end() || it->first != tenantToken)
-            {
-                it = ctx->packageIds.insert(it, { tenantToken, ctx->splicer->addTenantToken(tenantToken) });
+            size_t dataPackageIndex = addTenantToPackage(ctx, (m_forcedTenant != InvalidTenantHandle) ? m_forcedTenant : tenant);
+
+            if (m_streamingCompression && ctx->recordIdsAndTenantIds.empty()) {
+                beginStreamingCompression(ctx);
             }
 
-            ctx->splicer->addRecord(it->second, record.blob);
+            ctx->splicer->addRecord(dataPackageIndex, record.blob);
+
+            if (ctx->deflate && !ctx->deflate->write(record.blob.data(), record.blob.size())) {
+                // The splicer still has all records, compress them at once instead
+                LOG_WARN("Streaming compression failed, error=%d (%s)", ctx->deflate->lastError(), ctx->deflate->lastMessage());
+                ctx->deflate.reset();
+                ctx->body.clear();
+            }
 
-            ctx->recordIdsAndTenantIds[record.id] = record.tenantToken;
+            ctx->recordIdsAndTenantIds[record.id] = tenant;
             ctx->recordTimestamps.push_back(record.timestamp);
             ctx->maxRetryCountSeen = std::max<int>(ctx->maxRetryCountSeen, record.retryCount);
         }
@@ -71,6 +94,44 @@ namespace MAT_NS_BEGIN {
         }
     }
 
+    TenantHandle Packager::tenantOf(EventsUploadContextPtr const& ctx, StorageRecord const& record)
+    {
+        if (record.tenantHandle != InvalidTenantHandle)
+        {
+            return record.tenantHandle;
+        }
+        // Records read back from the database have no handle: compare their token with the
+        // ones already seen in this package first, so the registry lock is taken once per tenant
+        TenantRegistry& registry = TenantRegistry::instance();
+        for (TenantHandle tenant : ctx->recordTenants)
+        {
+            if (registry.Token(tenant) == record.tenantToken)
+            {
+                return tenant;
+            }
+        }
+        TenantHandle tenant = registry.Register(record.tenantToken);
+        ctx->recordTenants.push_back(tenant);
+        return tenant;
+    }
+
+    size_t Packager::addTenantToPackage(EventsUploadContextPtr const& ctx, TenantHandle tenant)
+    {
+        // A package rarely has more than a handful of tenants, a linear scan over handles beats the token map
+        for (auto const& item : ctx->packageTenants)
+        {
+            if (item.first == tenant)
+            {
+                return item.second;
+            }
+        }
+        std::string const& tenantToken = TenantRegistry::instance().Token(tenant);
+        size_t dataPackageIndex = ctx->splicer->addTenantToken(tenantToken);
+        ctx->packageIds[tenantToken] = dataPackageIndex;
+        ctx->packageTenants.emplace_back(tenant, dataPackageIndex);
+        return dataPackageIndex;
+    }
+
     void Packager::handleFinalizePackage(EventsUploadContextPtr const& ctx)
     {
         if (ctx->packageIds.empty()) {
@@ -78,12 +139,35 @@ namespace MAT_NS_BEGIN {
             return;
         }
 
-        ctx->body = ctx->splicer->splice();
+        if (ctx->deflate) {
+            // Records are already compressed into body, HttpDeflateCompression finishes the stream
+            ctx->splicer->clear();
+            packagedEvents(ctx);
+            return;
+        }
+
+        // The views keep the splicer's chunks alive, no contiguous copy is made here
+        ctx->splicer->splice(ctx->splicedBody);
         ctx->splicer->clear();
 
         packagedEvents(ctx);
     }
 
+    void Packager::beginStreamingCompression(EventsUploadContextPtr const& ctx)
+    {
+        if (!m_config.IsHttpRequestCompressionEnabled()) {
+            return;
+        }
+
+        std::unique_ptr<DeflateStream> stream = DeflateStream::Acquire();
+        if (!stream->begin(m_deflateSettings, ctx->body, 0)) {
+            LOG_WARN("Streaming compression failed to start, error=%d (%s)", stream->lastError(), stream->lastMessage());
+            ctx->body.clear();
+            return;
+        }
+        ctx->deflate = std::move(stream);
+    }
+
 
 } MAT_NS_END
 
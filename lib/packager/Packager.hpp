@@ -5,6 +5,7 @@
 
 #pragma once
 #include "api/IRuntimeConfig.hpp"
+#include "compression/DeflateStream.hpp"
 
 #include "system/Route.hpp"
 #include "system/Contexts.hpp"
@@ -18,10 +19,16 @@ namespace MAT_NS_BEGIN {
     protected:
         void handleAddEventToPackage(EventsUploadContextPtr const& ctx, StorageRecord const& record, bool& wantMore);
         void handleFinalizePackage(EventsUploadContextPtr const& ctx);
+        void beginStreamingCompression(EventsUploadContextPtr const& ctx);
+        size_t addTenantToPackage(EventsUploadContextPtr const& ctx, TenantHandle tenant);
+        TenantHandle tenantOf(EventsUploadContextPtr const& ctx, StorageRecord const& record);
 
     protected:
         IRuntimeConfig & m_config;
         std::string      m_forcedTenantToken;
+        TenantHandle     m_forcedTenant;
+        bool             m_streamingCompression;
+        DeflateSettings  m_deflateSettings;
 
     public:
         RouteSink<Packager, EventsUploadContextPtr const&, StorageRecord const&, bool&> addEventToPackage{ this, &Packager::handleAddEventToPackage };
@@ -40,6 +40,7 @@ namespace PAL_NS_BEGIN {
         virtual OsArchitectureType GetOsArchitectureType() const override { return m_os_architecture; }
         virtual PowerSource GetPowerSource() const override { return m_powerSource; }
         virtual std::string GetDeviceTicket() const override;
+        virtual bool IsDeviceIdDerived() const override { return m_device_id_derived; }
 
         DeviceInformationImpl(MAT::IRuntimeConfig& configuration);
         virtual ~DeviceInformationImpl();
@@ -57,6 +58,7 @@ namespace PAL_NS_BEGIN {
         std::string m_device_id;
         std::string m_manufacturer;
         std::string m_model;
+        bool m_device_id_derived = false;
     private:
         size_t m_registeredCount;
     };
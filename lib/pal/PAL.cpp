@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 #include "PAL.hpp"
+#include "WorkerPool.hpp"
 
 #include "ILogManager.hpp"
 #include "ISemanticContext.hpp"
@@ -297,9 +298,10 @@ namespace PAL_NS_BEGIN {
     {
         if (!m_taskDispatcher)
         {
-            // Default implementation of task dispatcher is a single-threaded worker thread task queue
-            LOG_TRACE("Initializing PAL worker thread");
-            m_taskDispatcher = PAL::WorkerThreadFactory::Create();
+            // Default implementation of task dispatcher is a pool of worker threads
+            // with a serial task queue per LogManager instance
+            LOG_TRACE("Initializing PAL worker pool");
+            m_taskDispatcher = PAL::WorkerPoolFactory::Create(m_taskDispatcherWorkers);
         }
         return m_taskDispatcher;
     }
@@ -595,6 +597,8 @@ namespace PAL_NS_BEGIN {
             m_SystemInformation = SystemInformationImpl::Create(configuration);
             m_DeviceInformation = DeviceInformationImpl::Create(configuration);
             m_NetworkInformation = NetworkInformationImpl::Create(configuration);
+            uint32_t workers = configuration[CFG_INT_TASK_DISPATCHER_WORKERS];
+            m_taskDispatcherWorkers = (workers > 0) ? workers : 1;
             LOG_INFO("Initialized");
         }
         else
@@ -113,6 +113,7 @@ namespace PAL_NS_BEGIN
     private:
         volatile std::atomic<long> m_palStarted { 0 };
         std::shared_ptr<ITaskDispatcher> m_taskDispatcher;
+        size_t m_taskDispatcherWorkers { 1 };
         std::shared_ptr<ISystemInformation> m_SystemInformation;
         std::shared_ptr<INetworkInformation> m_NetworkInformation;
         std::shared_ptr<IDeviceInformation> m_DeviceInformation;
@@ -0,0 +1,495 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+// clang-format off
+#include "pal/WorkerPool.hpp"
+#include "pal/PAL.hpp"
+
+#if defined(MATSDK_PAL_CPP11) || defined(MATSDK_PAL_WIN32)
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/* Maximum scheduler interval for SDK is 1 hour required for clamping in case of monotonic clock drift */
+#define MAX_FUTURE_DELTA_MS (60 * 60 * 1000)
+
+namespace PAL_NS_BEGIN {
+
+    /// <summary>
+    /// Tasks of one serial queue, guarded by the pool lock. Timed tasks that
+    /// became due go ahead of queued calls, as on the former single worker
+    /// thread, and at most one task of the queue runs at any time.
+    /// </summary>
+    struct SerialQueueState
+    {
+        struct DueTimer
+        {
+            MAT::Task* task;
+            uint64_t seq;
+        };
+
+        std::deque<DueTimer>    dueTimers;
+        std::deque<MAT::Task*>  calls;
+        // Queued in the runnable list or running on a worker
+        bool                    scheduled = false;
+
+        bool HasWork() const
+        {
+            return !dueTimers.empty() || !calls.empty();
+        }
+    };
+
+    class WorkerPool : public ITaskDispatcher, public std::enable_shared_from_this<WorkerPool>
+    {
+    public:
+        explicit WorkerPool(size_t workerCount) :
+            m_slots(std::max<size_t>(workerCount, 1)),
+            m_activeWorkers(m_slots.size()),
+            m_defaultQueue(std::make_shared<SerialQueueState>())
+        {
+            for (size_t i = 0; i < m_slots.size(); i++)
+            {
+                m_slots[i].thread = std::thread(&WorkerPool::threadFunc, this, i);
+            }
+            LOG_INFO("Started %u worker threads", static_cast<unsigned>(m_slots.size()));
+        }
+
+        ~WorkerPool()
+        {
+            Join();
+        }
+
+        void Join() final
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_stopping = true;
+            }
+            m_wakeup.notify_all();
+
+            std::thread::id this_id = std::this_thread::get_id();
+            for (auto& slot : m_slots)
+            {
+                try {
+                    if (slot.thread.joinable() && (slot.thread.get_id() != this_id))
+                        slot.thread.join();
+                    else if (slot.thread.joinable())
+                        slot.thread.detach();
+                }
+                catch (...) {};
+            }
+
+            // Timed tasks that did not come due before shutdown are dropped
+            std::vector<MAT::Task*> dropped;
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                for (auto const& kv : m_pendingTimers)
+                {
+                    dropped.push_back(kv.first);
+                }
+                m_pendingTimers.clear();
+                m_timers.clear();
+                m_cancelledTimers = 0;
+            }
+            if (!dropped.empty())
+            {
+                LOG_WARN("Dropping %u timed tasks on shutdown", static_cast<unsigned>(dropped.size()));
+            }
+            for (MAT::Task* task : dropped)
+            {
+                delete task;
+            }
+        }
+
+        void Queue(MAT::Task* task) final
+        {
+            Enqueue(m_defaultQueue, task);
+        }
+
+        // Cancel a task or wait for task completion for up to waitTime ms:
+        //
+        // - if the task is running on another thread, wait up to waitTime
+        //   for it to complete. A task cancelling itself is assumed to finish
+        //   and therefore be cancelled.
+        //
+        // - if the task is a timed call that did not start yet, drop it.
+        //   This is a hash lookup: the timer heap entry is left behind and
+        //   skipped when it comes up.
+        //
+        // - calls queued for immediate execution are not cancelled.
+        //
+        bool Cancel(MAT::Task* task, uint64_t waitTime) override
+        {
+            if (task == nullptr)
+            {
+                return false;
+            }
+
+            std::unique_lock<std::mutex> lock(m_lock);
+            if (WorkerSlot* slot = findRunning(task))
+            {
+                if (slot->id == std::this_thread::get_id())
+                {
+                    return true;
+                }
+                if (waitTime > 0)
+                {
+                    m_taskDone.wait_for(lock, std::chrono::milliseconds(waitTime), [&]() { return findRunning(task) == nullptr; });
+                }
+                return findRunning(task) == nullptr;
+            }
+
+            auto it = m_pendingTimers.find(task);
+            if (it != m_pendingTimers.end())
+            {
+                forgetTimer(it);
+                lock.unlock();
+                delete task;
+            }
+            return true;
+        }
+
+        std::shared_ptr<ITaskDispatcher> CreateSerialQueue() override;
+
+        void Enqueue(std::shared_ptr<SerialQueueState> const& queue, MAT::Task* task)
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            if (m_stopping)
+            {
+                lock.unlock();
+                LOG_WARN("Task dispatcher stopped, dropping task %s", task->TypeName.c_str());
+                delete task;
+                return;
+            }
+
+            if (task->Type == MAT::Task::TimedCall)
+            {
+                uint64_t latest = getMonotonicTimeMs() + MAX_FUTURE_DELTA_MS;
+                if (task->TargetTime > latest)
+                {
+                    task->TargetTime = latest;
+                }
+                uint64_t seq = ++m_timerSeq;
+                m_pendingTimers[task] = PendingTimer { seq, queue.get(), false };
+                m_timers.push_back(TimerEntry { task->TargetTime, seq, task, queue });
+                std::push_heap(m_timers.begin(), m_timers.end(), LaterTimer());
+                if (m_timers.front().seq == seq)
+                {
+                    // Earlier than what the workers sleep for
+                    m_wakeup.notify_one();
+                }
+            }
+            else
+            {
+                queue->calls.push_back(task);
+                schedule(queue);
+            }
+        }
+
+        // Waits until the tasks queued so far have run and drops pending timed tasks
+        void Drain(std::shared_ptr<SerialQueueState> const& queue)
+        {
+            std::vector<MAT::Task*> dropped;
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                for (auto it = m_pendingTimers.begin(); it != m_pendingTimers.end();)
+                {
+                    if (it->second.queue == queue.get())
+                    {
+                        dropped.push_back(it->first);
+                        it = forgetTimer(it);
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+                // Can't wait on our own workers
+                if (currentPool() != this)
+                {
+                    m_taskDone.wait(lock, [&]() { return !queue->scheduled || m_activeWorkers == 0; });
+                }
+            }
+            for (MAT::Task* task : dropped)
+            {
+                delete task;
+            }
+        }
+
+    protected:
+        struct WorkerSlot
+        {
+            std::thread     thread;
+            std::thread::id id;
+            MAT::Task*      task = nullptr;
+        };
+
+        struct TimerEntry
+        {
+            uint64_t                          targetTime;
+            uint64_t                          seq;
+            MAT::Task*                        task;
+            std::shared_ptr<SerialQueueState> queue;
+        };
+
+        // Orders the heap by target time, then by queueing order
+        struct LaterTimer
+        {
+            bool operator()(TimerEntry const& a, TimerEntry const& b) const
+            {
+                return (a.targetTime != b.targetTime) ? (a.targetTime > b.targetTime) : (a.seq > b.seq);
+            }
+        };
+
+        struct PendingTimer
+        {
+            uint64_t          seq;
+            SerialQueueState* queue;
+            bool              due;
+        };
+
+        typedef std::unordered_map<MAT::Task*, PendingTimer> PendingTimers;
+
+        static WorkerPool*& currentPool() noexcept;
+
+        WorkerSlot* findRunning(MAT::Task* task)
+        {
+            for (auto& slot : m_slots)
+            {
+                if (slot.task == task)
+                {
+                    return &slot;
+                }
+            }
+            return nullptr;
+        }
+
+        bool isPending(MAT::Task* task, uint64_t seq) const
+        {
+            auto it = m_pendingTimers.find(task);
+            return (it != m_pendingTimers.end()) && (it->second.seq == seq);
+        }
+
+        PendingTimers::iterator forgetTimer(PendingTimers::iterator it)
+        {
+            if (!it->second.due)
+            {
+                m_cancelledTimers++;
+            }
+            it = m_pendingTimers.erase(it);
+            // Rebuild the heap once cancelled entries make up most of it
+            if (m_cancelledTimers > 64 && m_cancelledTimers > m_timers.size() / 2)
+            {
+                m_timers.erase(std::remove_if(m_timers.begin(), m_timers.end(),
+                    [this](TimerEntry const& entry) { return !isPending(entry.task, entry.seq); }), m_timers.end());
+                std::make_heap(m_timers.begin(), m_timers.end(), LaterTimer());
+                m_cancelledTimers = 0;
+            }
+            return it;
+        }
+
+        void schedule(std::shared_ptr<SerialQueueState> const& queue)
+        {
+            if (!queue->scheduled)
+            {
+                queue->scheduled = true;
+                m_runnable.push_back(queue);
+                m_wakeup.notify_one();
+            }
+        }
+
+        // Moves timed tasks that came due to their queues, returns the time until the next one
+        uint64_t promoteDueTimers(uint64_t now)
+        {
+            while (!m_timers.empty())
+            {
+                TimerEntry const& top = m_timers.front();
+                bool pending = isPending(top.task, top.seq);
+                if (pending && top.targetTime > now)
+                {
+                    return std::min<uint64_t>(top.targetTime - now, MAX_FUTURE_DELTA_MS);
+                }
+                std::pop_heap(m_timers.begin(), m_timers.end(), LaterTimer());
+                TimerEntry entry = std::move(m_timers.back());
+                m_timers.pop_back();
+                if (!pending)
+                {
+                    if (m_cancelledTimers > 0)
+                    {
+                        m_cancelledTimers--;
+                    }
+                    continue;
+                }
+                m_pendingTimers[entry.task].due = true;
+                entry.queue->dueTimers.push_back({ entry.task, entry.seq });
+                schedule(entry.queue);
+            }
+            return MAX_FUTURE_DELTA_MS;
+        }
+
+        MAT::Task* takeNext(SerialQueueState& queue)
+        {
+            while (!queue.dueTimers.empty())
+            {
+                SerialQueueState::DueTimer timer = queue.dueTimers.front();
+                queue.dueTimers.pop_front();
+                auto it = m_pendingTimers.find(timer.task);
+                if (it != m_pendingTimers.end() && it->second.seq == timer.seq)
+                {
+                    m_pendingTimers.erase(it);
+                    return timer.task;
+                }
+            }
+            if (!queue.calls.empty())
+            {
+                MAT::Task* task = queue.calls.front();
+                queue.calls.pop_front();
+                return task;
+            }
+            return nullptr;
+        }
+
+        void threadFunc(size_t index)
+        {
+            currentPool() = this;
+
+            std::unique_lock<std::mutex> lock(m_lock);
+            WorkerSlot& slot = m_slots[index];
+            slot.id = std::this_thread::get_id();
+            for (;;)
+            {
+                uint64_t nextTimerInMs = MAX_FUTURE_DELTA_MS;
+                if (!m_stopping)
+                {
+                    nextTimerInMs = promoteDueTimers(getMonotonicTimeMs());
+                }
+
+                if (m_runnable.empty())
+                {
+                    if (m_stopping)
+                    {
+                        break;
+                    }
+                    m_wakeup.wait_for(lock, std::chrono::milliseconds(nextTimerInMs));
+                    continue;
+                }
+
+                std::shared_ptr<SerialQueueState> queue = std::move(m_runnable.front());
+                m_runnable.pop_front();
+                MAT::Task* task = takeNext(*queue);
+                if (task == nullptr)
+                {
+                    queue->scheduled = false;
+                    m_taskDone.notify_all();
+                    continue;
+                }
+
+                slot.task = task;
+                lock.unlock();
+                LOG_TRACE("Execute item=%p type=%s\n", task, task->TypeName.c_str());
+                (*task)();
+                task->Type = MAT::Task::Done;
+                delete task;
+                lock.lock();
+                slot.task = nullptr;
+
+                if (queue->HasWork())
+                {
+                    // Behind the other queues that are waiting for a worker
+                    m_runnable.push_back(std::move(queue));
+                }
+                else
+                {
+                    queue->scheduled = false;
+                }
+                m_taskDone.notify_all();
+            }
+
+            m_activeWorkers--;
+            m_taskDone.notify_all();
+        }
+
+        std::mutex                                    m_lock;
+        std::condition_variable                       m_wakeup;
+        std::condition_variable                       m_taskDone;
+        std::vector<WorkerSlot>                       m_slots;
+        size_t                                        m_activeWorkers;
+        bool                                          m_stopping = false;
+
+        std::shared_ptr<SerialQueueState>             m_defaultQueue;
+        std::deque<std::shared_ptr<SerialQueueState>> m_runnable;
+
+        // Min-heap of timed tasks. Cancelled entries stay until they reach
+        // the top or the heap is rebuilt; m_pendingTimers tells them apart.
+        std::vector<TimerEntry>                       m_timers;
+        PendingTimers                                 m_pendingTimers;
+        size_t                                        m_cancelledTimers = 0;
+        uint64_t                                      m_timerSeq = 0;
+    };
+
+    /// <summary>
+    /// Serial queue handle of a WorkerPool. The queue state outlives the
+    /// handle until its remaining tasks have run, like tasks on a shared
+    /// worker thread outlive the instance that queued them.
+    /// </summary>
+    class SerialQueue : public ITaskDispatcher
+    {
+    public:
+        explicit SerialQueue(std::shared_ptr<WorkerPool> const& pool) :
+            m_pool(pool),
+            m_state(std::make_shared<SerialQueueState>())
+        {
+        }
+
+        void Join() final
+        {
+            m_pool->Drain(m_state);
+        }
+
+        void Queue(MAT::Task* task) final
+        {
+            m_pool->Enqueue(m_state, task);
+        }
+
+        bool Cancel(MAT::Task* task, uint64_t waitTime) override
+        {
+            return m_pool->Cancel(task, waitTime);
+        }
+
+        std::shared_ptr<ITaskDispatcher> CreateSerialQueue() override
+        {
+            return m_pool->CreateSerialQueue();
+        }
+
+    protected:
+        std::shared_ptr<WorkerPool>       m_pool;
+        std::shared_ptr<SerialQueueState> m_state;
+    };
+
+    WorkerPool*& WorkerPool::currentPool() noexcept
+    {
+        static thread_local WorkerPool* pool = nullptr;
+        return pool;
+    }
+
+    std::shared_ptr<ITaskDispatcher> WorkerPool::CreateSerialQueue()
+    {
+        return std::make_shared<SerialQueue>(shared_from_this());
+    }
+
+    namespace WorkerPoolFactory {
+        std::shared_ptr<ITaskDispatcher> Create(size_t workerCount)
+        {
+            return std::make_shared<WorkerPool>(workerCount);
+        }
+    }
+
+} PAL_NS_END
+
+#endif
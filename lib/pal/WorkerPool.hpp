@@ -0,0 +1,28 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <cstddef>
+#include <memory>
+
+#include "ITaskDispatcher.hpp"
+#include "ctmacros.hpp"
+
+namespace PAL_NS_BEGIN {
+
+    namespace WorkerPoolFactory {
+        /// <summary>
+        /// Creates a task dispatcher running on workerCount threads (at least one).
+        /// Tasks queued to the dispatcher itself run one at a time like on a single
+        /// worker thread; ITaskDispatcher::CreateSerialQueue adds more such queues
+        /// that share the same threads and timer heap.
+        /// </summary>
+        std::shared_ptr<MAT::ITaskDispatcher> Create(size_t workerCount);
+    }
+
+} PAL_NS_END
+
+#endif
@@ -78,10 +78,6 @@ namespace PAL_NS_BEGIN {
         inline bool IsSet() const { return m_bFlag; }
     };
 
-    namespace WorkerThreadFactory {
-        std::shared_ptr<MAT::ITaskDispatcher> Create();
-    }
-
 } PAL_NS_END
 
 #endif
@@ -39,9 +39,10 @@ namespace PAL_NS_BEGIN {
         m_os_architecture = OsArchitectureType_Unknown;
 #endif
 
-        auto sysInfo = sysinfo_sources_impl::GetSysInfo();
+        auto& sysInfo = sysinfo_sources_impl::GetSysInfo();
         std::string devId = sysInfo.get("devId");
         m_device_id = (devId.empty()) ? DEFAULT_DEVICE_ID : devId;
+        m_device_id_derived = !sysInfo.get("devIdDerived").empty();
 
         m_manufacturer = sysInfo.get("devMake");
 
@@ -22,11 +22,10 @@
 #include <streambuf>
 #include <list>
 
+#include <dirent.h>
 #include <unistd.h>
 #include <sys/utsname.h>
 
-#include <regex>
-
 #include <iostream>
 #include <iomanip>
 
@@ -98,81 +97,159 @@ inline std::string ReadFile(const char *filename)
     return str;
 }
 
+#if defined(__linux__)
 /**
- * Execute command and get output
- * @param cmd Command to execute
- * @return output
+ * Format local timezone as +hh:mm or -hh:mm offset from UTC
+ *
+ * @return
  */
+static std::string GetTimeZone()
+{
+    time_t t = time(NULL);
+
 #if defined(__clang__)
 #pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wunused-function"  // Used on non-Apple platforms. See sysinfo_sources_impl()
+#pragma clang diagnostic ignored "-Wmissing-field-initializers"  // error: missing initializer for member 'tm::tm_min' [-Werror=missing-field-initializers]
 #elif defined(__GNUC__)
 #pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-function"  // Used on non-Apple platforms. See sysinfo_sources_impl()
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"  // error: missing initializer for member 'tm::tm_min' [-Werror=missing-field-initializers]
+#endif
+
+    struct tm lt { 0 };
+    localtime_r(&t, &lt);
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
 #endif
-static std::string Exec(const char* cmd)
+
+    int hh = lt.tm_gmtoff / 3600;
+    int mm = (lt.tm_gmtoff / 60) % 60;
+    std::ostringstream oss;
+    oss << ((hh<0)?"-":"+"); // +hh:mm or -hh:mm
+    oss << std::setw(2) << std::setfill('0') << std::abs(hh);
+    oss << std::setw(1) << ":";
+    oss << std::setw(2) << std::setfill('0') << std::abs(mm);
+    return oss.str();
+}
+
+/**
+ * Derive Device Id from disk UUIDs and hostname. Both would rarely change,
+ * as well as guarantee at least some protection from cloned VM images.
+ * Both are read directly rather than by running blkid and hostname, so the
+ * id differs from the one derived by earlier versions from blkid output.
+ * LogManagerImpl persists the first id derived, which keeps it stable after.
+ *
+ * @return
+ */
+static std::string GetDerivedDeviceId()
 {
-    std::array<char, 128> buffer;
-    std::string result;
-    std::shared_ptr<FILE> pipe(popen(cmd, "r"), pclose);
-    if (!pipe)
+    std::vector<std::string> uuids;
+    DIR* dir = opendir("/dev/disk/by-uuid");
+    if (dir != nullptr)
     {
-        // throw std::runtime_error("popen() failed!");
-        return result;
+        while (struct dirent* entry = readdir(dir))
+        {
+            if (entry->d_name[0] != '.')
+            {
+                uuids.push_back(entry->d_name);
+            }
+        }
+        closedir(dir);
     }
+    std::sort(uuids.begin(), uuids.end());
 
-    while (!feof(pipe.get()))
+    std::string contents;
+    for (const auto& uuid : uuids)
     {
-        if (fgets(buffer.data(), buffer.size(), pipe.get())!=NULL)
-            result += buffer.data();
+        contents += uuid;
+        contents += ' ';
     }
-
-    // Remove EOL. In all use-cases below we don't need it.
-    if (!result.empty() && result[result.length()-1]=='\n')
+    char hostname[256] = { 0 };
+    if (gethostname(hostname, sizeof(hostname) - 1) == 0)
     {
-        result.erase(result.length()-1);
+        contents += hostname;
+    }
+    if (contents.empty())
+    {
+        return contents;
     }
 
-    return result;
+    uint8_t guid_bytes[16] = { 0 };
+    for(size_t i=0; i<contents.length(); i++)
+    {   // Simple XOR of contents to generate a UUID
+        guid_bytes[i % 16] ^= contents.at(i);
+    }
+    return MAT::GUID_t(guid_bytes).to_string();
 }
-#if defined(__clang__)
-#pragma clang diagnostic pop
-#elif defined(__GNUC__)
-#pragma GCC diagnostic pop
 #endif
 
 /**
- * Read node value, preprocess it using regexp and store result in cache
+ * Apply selector to file contents.
+ *
+ * @param contents  File contents
+ * @param selector  Source selector
+ * @param value     Selected value
+ * @return          true if selector matched
+ */
+bool sysinfo_sources::select(const std::string& contents, const std::string& selector, std::string& value)
+{
+    if (selector.empty() || (selector == "*"))
+    {
+        value = contents;
+        return !value.empty();
+    }
+
+    if (selector == "\n")
+    {
+        // First line of text files, first field of NUL-separated ones like cmdline
+        value = contents.substr(0, contents.find_first_of(std::string("\n\0", 2)));
+        return !value.empty();
+    }
+
+    size_t pos = 0;
+    while (pos < contents.length())
+    {
+        size_t end = contents.find('\n', pos);
+        if (end == std::string::npos)
+        {
+            end = contents.length();
+        }
+        if ((end - pos >= selector.length()) && (contents.compare(pos, selector.length(), selector) == 0))
+        {
+            value = contents.substr(pos + selector.length(), end - pos - selector.length());
+            // Values may be quoted, e.g. ID="opensuse-leap"
+            if ((value.length() >= 2) && ((value[0] == '"') || (value[0] == '\'')) && (value[value.length() - 1] == value[0]))
+            {
+                value = value.substr(1, value.length() - 2);
+            }
+            return !value.empty();
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+/**
+ * Read node value, preprocess it using selector and store result in cache
  *
  * @param key       Field name
  * @return          true if field value is found and saved in cache
  */
-bool sysinfo_sources::fetch(std::string key)
+bool sysinfo_sources::fetch(const std::string& key)
 {
-	for(auto &kv : (*this))
-	{
-		if(kv.first == key)
-		{
-			const std::string star("*");
-			const std::string empty("");
-
-			std::string contents = ReadFile(kv.second.path);
-			if((kv.second.selector == star) || (kv.second.selector == empty))
-			{
-				cache[key] = contents;
-				return true;
-			}
-			// Run regexp
-			std::regex selector_regex(kv.second.selector);
-			std::smatch match;
-			if(std::regex_search(contents, match, selector_regex))
-			{
-				cache[key] = match[1];
-				return true;
-			}
-		}
-	}
-	return false;
+    auto range = equal_range(key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        std::string value;
+        if (select(ReadFile(it->second.path), it->second.selector, value))
+        {
+            cache[key] = value;
+            return true;
+        }
+    }
+    return false;
 }
 
 /**
@@ -197,72 +274,37 @@ sysinfo_sources::sysinfo_sources() :
 /**
  * Retrieve value by key from sysinfo_sources. Try to fetch from cache,
  * if not found, then fetch from filesystem and save to in-ram cache.
+ * Keys that could not be resolved are cached as empty.
  *
  * @param key
  * @return
  */
-const std::string& sysinfo_sources::get(std::string key)
+const std::string& sysinfo_sources::get(const std::string& key)
 {
-    if(cache.find(key) == cache.end())
-        fetch(key);
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    auto it = cache.find(key);
+    if (it != cache.end())
+        return it->second;
+    fetch(key);
     return cache[key];
 }
 
 /**
- * Obtain system hardware and application information
+ * Describe where system hardware and application information is found.
+ * Nothing is read here: each key is resolved on its first lookup.
  */
 sysinfo_sources_impl::sysinfo_sources_impl() : sysinfo_sources()
 {
-    struct utsname buf;
-    uname(&buf);
 #if defined(__linux__)
     // Obtain Linux system information from filesystem
     add("devId", { "/etc/machine-id", "*"});
-    add("osName", {"/etc/os-release", ".*ID=(.*)[\n]+"});
-    add("osVer", {"/etc/os-release", ".*VERSION_ID=\"(.*)\".*"});
-    add("osRel", {"/etc/os-release", ".*VERSION=\"(.*)\".*"});
-    add("osBuild", {"/proc/version", "(.*)[\n]+"});
-    // add("proc_loadavg", {"/proc/loadavg", "(.*)[\n]*"});
-    // add("proc_uptime", {"/proc/uptime", "(.*)[\n]*"});
-
-    // osName may contain quotes on openSUSE
-    if (get("osName").find('"') == 0)
-    {
-        std::string contents = get("osName");
-        size_t pos_end_quote = contents.rfind('"');
-        if (pos_end_quote != std::string::npos && pos_end_quote > 0)
-        {
-            cache["osName"] = contents.substr(1, pos_end_quote - 1);
-        }
-    }
-
-    time_t t = time(NULL);
-
-#if defined(__clang__)
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wmissing-field-initializers"  // error: missing initializer for member �tm::tm_min� [-Werror=missing-field-initializers]
-#elif defined(__GNUC__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmissing-field-initializers"  // error: missing initializer for member �tm::tm_min� [-Werror=missing-field-initializers]
-#endif
-
-    struct tm lt { 0 };
-    localtime_r(&t, &lt);
-
-#if defined(__clang__)
-#pragma clang diagnostic pop
-#elif defined(__GNUC__)
-#pragma GCC diagnostic pop
-#endif
-
-    int hh = lt.tm_gmtoff / 3600;
-    int mm = (lt.tm_gmtoff / 60) % 60;
-    std::ostringstream oss;
-    oss << ((hh<0)?"-":"+"); // +hh:mm or -hh:mm
-    oss << std::setw(2) << std::setfill('0') << std::abs(hh);
-    oss << std::setw(1) << ":";
-    oss << std::setw(2) << std::setfill('0') << std::abs(mm);
-    cache["tz"] = oss.str();
+    add("devId", { "/var/lib/dbus/machine-id", "*"});
+    add("osName", {"/etc/os-release", "ID="});
+    add("osVer", {"/etc/os-release", "VERSION_ID="});
+    add("osRel", {"/etc/os-release", "VERSION="});
+    add("osBuild", {"/proc/version", "\n"});
+    // add("proc_loadavg", {"/proc/loadavg", "\n"});
+    // add("proc_uptime", {"/proc/uptime", "\n"});
 #endif
 
 #if defined(__MINGW32__) || defined(__MSYS__)
@@ -296,57 +338,70 @@ sysinfo_sources_impl::sysinfo_sources_impl() : sysinfo_sources()
     oss << std::setw(1) << ":";
     oss << std::setw(2) << std::setfill('0') << mm;
     cache["tz"] = oss.str();
+
+    cache["appId"] = get_app_name();
+#else
+    add("appId", {"/proc/self/cmdline", "\n"});
 #endif
+}
 
-    // Fallback to uname if above methods failed
-    if (!get("osVer").compare(""))
+/**
+ * Fetch from the registered sources, then fall back to uname,
+ * platform APIs and derived values for the keys that have them.
+ */
+bool sysinfo_sources_impl::fetch(const std::string& key)
+{
+    if (sysinfo_sources::fetch(key))
     {
-        cache["osVer"]  = (const char *)(buf.version);
+        return true;
     }
 
-    if (!get("osName").compare(""))
+    std::string value;
+    if ((key == "osVer") || (key == "osName") || (key == "osRel"))
     {
-        cache["osName"] = (const char *)(buf.sysname);
+        // Fallback to uname if above methods failed
+        struct utsname buf;
+        if (uname(&buf) == 0)
+        {
+            value = (key == "osVer") ? buf.version : (key == "osName") ? buf.sysname : buf.release;
+        }
     }
-
-    if (!get("osRel").compare(""))
+#if defined(__linux__)
+    else if (key == "tz")
     {
-        cache["osRel"]  = (const char *)(buf.release);
+        value = GetTimeZone();
     }
-
-#ifndef __APPLE__
-    add("appId", {"/proc/self/cmdline", "(.*)[ ]*.*[\n]*"});
-#else
-    cache["appId"] = get_app_name();
 #endif
-
-    if (!get("devId").compare(""))
+    else if (key == "devIdDerived")
+    {
+        // Set along with devId when it had to be derived
+        get("devId");
+        return cache.find(key) != cache.end();
+    }
+    else if (key == "devId")
     {
 #ifdef __APPLE__
         std::string contents = GetDeviceId();
 #if TARGET_OS_IPHONE
-        cache["devId"] = "i:";
+        value = "i:";
 #else
-        cache["devId"] = "u:";
+        value = "u:";
 #endif // TARGET_OS_IPHONE
-        cache["devId"] += MAT::GUID_t(contents.c_str()).to_string();
-#else
+        value += MAT::GUID_t(contents.c_str()).to_string();
+#elif defined(__linux__)
         // We were unable to obtain Device Id using standard means.
-        // Try to use hash of blkid + hostname instead. Both blkid
-        // and hostname would rarely change, as well as guarantee
-        // at least some protection from cloned VM images.
-        std::string contents = Exec("echo `blkid; hostname`");
-        if (!contents.empty())
+        value = GetDerivedDeviceId();
+        if (!value.empty())
         {
-            uint8_t guid_bytes[16] = { 0 };
-            for(size_t i=0; i<contents.length(); i++)
-            {   // Simple XOR of contents to generate a UUID
-                guid_bytes[i % 16] ^= contents.at(i);
-            }
-            cache["devId"] = MAT::GUID_t(guid_bytes).to_string();
+            cache["devIdDerived"] = "1";
         }
 #endif
     }
 
+    if (value.empty())
+    {
+        return false;
+    }
+    cache[key] = value;
+    return true;
 }
-
@@ -6,10 +6,16 @@
 //
 
 #include <map>
+#include <mutex>
 #include <string>
 
 /**
- * System information source path and selector
+ * System information source path and selector.
+ *
+ * Selector is one of:
+ * - "*" or "" : whole file contents
+ * - "NAME="   : value of the first line starting with NAME=, unquoted
+ * - "\n"      : first line or first NUL-terminated field of the file
  */
 typedef struct {
     const char * path;
@@ -20,7 +26,8 @@ typedef struct {
  * Helper class to retrieve various key-value pairs from system info sources.
  *
  * Everything is a file in POSIX / UNIX, so this file helps to retrieve and
- * cache info obtained from various files.
+ * cache info obtained from various files. Values are only read on first
+ * request of their key, and lookups may come from any thread.
  *
  */
 class sysinfo_sources : public std::multimap<std::string, sysinfo_source_t> {
@@ -28,13 +35,25 @@ class sysinfo_sources : public std::multimap<std::string, sysinfo_source_t> {
 protected:
     std::map<std::string, std::string> cache;
 
+    std::recursive_mutex lock;
+
     /**
-     * Read node value, preprocess it using regexp and store result in cache
+     * Read node value, preprocess it using selector and store result in cache
      *
      * @param key       Field name
      * @return          true if field value is found and saved in cache
      */
-    bool fetch(std::string key);
+    virtual bool fetch(const std::string& key);
+
+    /**
+     * Apply selector to file contents.
+     *
+     * @param contents  File contents
+     * @param selector  Source selector
+     * @param value     Selected value
+     * @return          true if selector matched
+     */
+    static bool select(const std::string& contents, const std::string& selector, std::string& value);
 
 public:
 
@@ -48,6 +67,8 @@ public:
 
     sysinfo_sources();
 
+    virtual ~sysinfo_sources() {}
+
     /**
      * Retrieve value by key from sysinfo_sources. Try to fetch from cache,
      * if not found, then fetch from filesystem and save to in-ram cache.
@@ -55,7 +76,7 @@ public:
      * @param key
      * @return
      */
-    const std::string& get(std::string key);
+    const std::string& get(const std::string& key);
 
 };
 
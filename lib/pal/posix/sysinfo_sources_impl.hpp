@@ -9,10 +9,18 @@
 
 class sysinfo_sources_impl: public sysinfo_sources {
 
+protected:
+
+    /**
+     * Fetch from the registered sources, then fall back to uname,
+     * platform APIs and derived values for the keys that have them.
+     */
+    virtual bool fetch(const std::string& key) override;
+
 public:
 
     sysinfo_sources_impl();
-    
+
     /**
      * Get instance for serving all singleton calls
      */
@@ -180,6 +180,11 @@ namespace MAT_NS_BEGIN {
 
         // Cumulative
         resetTelemetryStats(m_telemetryStats);
+        if (!start)
+        {
+            m_lastStageSnapshots = m_stageSnapshots;
+            m_lastRuleDrops = m_ruleDrops;
+        }
 
         // Per-tenant
         if (m_enableTenantStats)
@@ -282,6 +287,7 @@ namespace MAT_NS_BEGIN {
         insertNonZero(ext, "drp_ful", recordStats.overflown);
         insertNonZero(ext, "drp_io", recordStats.droppedByReason[DROPPED_REASON_OFFLINE_STORAGE_SAVE_FAILED]);
         insertNonZero(ext, "drp_ret", recordStats.droppedByReason[DROPPED_REASON_RETRY_EXCEEDED]);
+        insertNonZero(ext, "drp_iq", recordStats.droppedByReason[DROPPED_REASON_INGESTION_QUEUE_OVERFLOW]);
         addCountsPerHttpReturnCodeToRecordFields(record, "drp_HTTP", recordStats.droppedByHTTPCode);
 
         // Event size stats
@@ -307,6 +313,36 @@ namespace MAT_NS_BEGIN {
             insertNonZero(ext, pfx + "bytes", r_stats.totalRecordsSizeInBytes);
         }
 
+        // Pipeline stage latencies, in microseconds, and early drop rule counts are not split per tenant
+        if (&telemetryStats == &m_telemetryStats)
+        {
+            for (size_t i = 0; i < m_stageSnapshots.size(); i++)
+            {
+                auto const& stage = m_stageSnapshots[i];
+                LatencyHistogram::Snapshot latency = stage.latency;
+                if (i < m_lastStageSnapshots.size() && m_lastStageSnapshots[i].name == stage.name)
+                {
+                    latency = stage.latency.Since(m_lastStageSnapshots[i].latency);
+                }
+                std::string pfx = "stg_" + stage.name + "_";
+                insertNonZero(ext, pfx + "cnt", latency.count);
+                insertNonZero(ext, pfx + "p50", latency.Percentile(0.5) / 1000);
+                insertNonZero(ext, pfx + "p99", latency.Percentile(0.99) / 1000);
+                insertNonZero(ext, pfx + "max", latency.max / 1000);
+            }
+
+            for (size_t i = 0; i < m_ruleDrops.size(); i++)
+            {
+                auto const& rule = m_ruleDrops[i];
+                uint64_t dropped = rule.dropped;
+                if (i < m_lastRuleDrops.size() && m_lastRuleDrops[i].name == rule.name)
+                {
+                    dropped -= m_lastRuleDrops[i].dropped;
+                }
+                insertNonZero(ext, "rule_" + rule.name + "_drp", dropped);
+            }
+        }
+
         records.push_back(record);
     }
 
@@ -334,6 +370,24 @@ namespace MAT_NS_BEGIN {
         }
     }
 
+    /// <summary>
+    /// Updates the pipeline stage latencies reported by the next stats event.
+    /// </summary>
+    /// <param name="stages">Current snapshot of every timed stage.</param>
+    void MetaStats::updateOnStageLatencies(std::vector<RouteStatistics::StageSnapshot> const& stages)
+    {
+        m_stageSnapshots = stages;
+    }
+
+    /// <summary>
+    /// Updates the early drop rule counts reported by the next stats event.
+    /// </summary>
+    /// <param name="drops">Events dropped by each rule so far.</param>
+    void MetaStats::updateOnEventRuleDrops(std::vector<EventRuleTable::RuleDrops> const& drops)
+    {
+        m_ruleDrops = drops;
+    }
+
     /// <summary>
     /// Clears the stats.
     /// </summary>
@@ -405,11 +459,11 @@ namespace MAT_NS_BEGIN {
     /// <summary>
     /// Updates stats on incoming event.
     /// </summary>
-    /// <param name="tenanttoken">The tenanttoken.</param>
+    /// <param name="tenant">The tenant handle.</param>
     /// <param name="size">The size.</param>
     /// <param name="latency">The latency.</param>
     /// <param name="metastats">if set to <c>true</c> [metastats].</param>
-    void MetaStats::updateOnEventIncoming(std::string const& tenanttoken, unsigned size, EventLatency latency, bool metastats)
+    void MetaStats::updateOnEventIncoming(TenantHandle tenant, unsigned size, EventLatency latency, bool metastats)
     {
         auto updateRecordStats = [&](RecordStats& recordStats)
         {
@@ -422,7 +476,7 @@ namespace MAT_NS_BEGIN {
             recordStats.minOfRecordSizeInBytes = std::min<unsigned>(recordStats.minOfRecordSizeInBytes, size);
             recordStats.totalRecordsSizeInBytes += size;
             if (latency >= 0) {
-                RecordStats& recordStatsPerPriority = m_telemetryTenantStats[tenanttoken].recordStatsPerLatency[latency];
+                RecordStats& recordStatsPerPriority = m_telemetryTenantStats[tenant].recordStatsPerLatency[latency];
                 recordStatsPerPriority.received++;
                 recordStatsPerPriority.totalRecordsSizeInBytes += size;
             }
@@ -434,11 +488,12 @@ namespace MAT_NS_BEGIN {
         // Per-tenant
         if (m_enableTenantStats)
         {
-            if (m_telemetryTenantStats[tenanttoken].tenantId.empty())
+            TelemetryStats& tenantStats = m_telemetryTenantStats[tenant];
+            if (tenantStats.tenantId.empty())
             {
-                m_telemetryTenantStats[tenanttoken].tenantId = tenanttoken.substr(0, tenanttoken.find('-'));
+                tenantStats.tenantId = TenantRegistry::instance().TenantId(tenant);
             }
-            updateRecordStats(m_telemetryTenantStats[tenanttoken].recordStats);
+            updateRecordStats(tenantStats.recordStats);
         }
     }
 
@@ -466,7 +521,7 @@ namespace MAT_NS_BEGIN {
     /// <param name="durationMs">The duration ms.</param>
     /// <param name="latencyToSendMs">The latency to send ms.</param>
     /// <param name="metastatsOnly">if set to <c>true</c> [metastats only].</param>
-    void MetaStats::updateOnPackageSentSucceeded(std::map<std::string, std::string> const& recordIdsAndTenantids, EventLatency eventLatency, unsigned retryFailedTimes, unsigned durationMs, std::vector<unsigned> const& /*latencyToSendMs*/, bool metastatsOnly)
+    void MetaStats::updateOnPackageSentSucceeded(std::map<std::string, TenantHandle> const& recordIdsAndTenantids, EventLatency eventLatency, unsigned retryFailedTimes, unsigned durationMs, std::vector<unsigned> const& /*latencyToSendMs*/, bool metastatsOnly)
     {
         // Package summary stats
         PackageStats& packageStats = m_telemetryStats.packageStats;
@@ -500,9 +555,19 @@ namespace MAT_NS_BEGIN {
         // Per-tenant
         if (m_enableTenantStats)
         {
+            // Look each tenant's stats up once, records of a package mostly share a few tenants
+            std::map<TenantHandle, size_t> countOnHandle;
             for (const auto& entry : recordIdsAndTenantids)
             {
-                updatePackageSent(m_telemetryTenantStats[entry.second]);
+                countOnHandle[entry.second]++;
+            }
+            for (const auto& entry : countOnHandle)
+            {
+                TelemetryStats& tenantStats = m_telemetryTenantStats[entry.first];
+                for (size_t i = 0; i < entry.second; i++)
+                {
+                    updatePackageSent(tenantStats);
+                }
             }
         }
 
@@ -549,7 +614,7 @@ namespace MAT_NS_BEGIN {
             // Per-tenant
             if (m_enableTenantStats)
             {
-                auto& temp = m_telemetryTenantStats[dropcouttenant.first];
+                auto& temp = m_telemetryTenantStats[TenantRegistry::instance().Register(dropcouttenant.first)];
                 temp.recordStats.droppedByReason[reason] += static_cast<unsigned int>(dropcouttenant.second);
                 temp.recordStats.dropped += static_cast<unsigned int>(dropcouttenant.second);
             }
@@ -572,7 +637,7 @@ namespace MAT_NS_BEGIN {
             // Per-tenant
             if (m_enableTenantStats)
             {
-                auto& temp = m_telemetryTenantStats[overflowntenant.first];
+                auto& temp = m_telemetryTenantStats[TenantRegistry::instance().Register(overflowntenant.first)];
                 temp.recordStats.overflown += static_cast<unsigned int>(overflowntenant.second);
             }
             overallCount += static_cast<unsigned int>(overflowntenant.second);
@@ -594,7 +659,7 @@ namespace MAT_NS_BEGIN {
             // Per-tenant
             if (m_enableTenantStats)
             {
-                TelemetryStats& temp = m_telemetryTenantStats[rejecttenant.first];
+                TelemetryStats& temp = m_telemetryTenantStats[TenantRegistry::instance().Register(rejecttenant.first)];
                 temp.recordStats.rejectedByReason[reason] += static_cast<unsigned int>(rejecttenant.second);
                 temp.recordStats.rejected += static_cast<unsigned int>(rejecttenant.second);
             }
@@ -8,6 +8,9 @@
 #include "pal/PAL.hpp"
 
 #include "api/IRuntimeConfig.hpp"
+#include "filter/EventRuleTable.hpp"
+#include "system/RouteStatistics.hpp"
+#include "system/TenantRegistry.hpp"
 
 #include "Enums.hpp"
 #include "CsProtocol_types.hpp"
@@ -524,9 +527,9 @@ namespace MAT_NS_BEGIN {
 
         std::vector< ::CsProtocol::Record> generateStatsEvent(RollUpKind rollupKind);
 
-        void updateOnEventIncoming(std::string const& tenanttoken, unsigned size, EventLatency latency, bool metastats);
+        void updateOnEventIncoming(TenantHandle tenant, unsigned size, EventLatency latency, bool metastats);
         void updateOnPostData(unsigned postDataLength, bool metastatsOnly);
-        void updateOnPackageSentSucceeded(std::map<std::string, std::string> const& recordIdsAndTenantids, EventLatency eventLatency, unsigned retryFailedTimes, unsigned durationMs, std::vector<unsigned> const& latencyToSendMs, bool metastatsOnly);
+        void updateOnPackageSentSucceeded(std::map<std::string, TenantHandle> const& recordIdsAndTenantids, EventLatency eventLatency, unsigned retryFailedTimes, unsigned durationMs, std::vector<unsigned> const& latencyToSendMs, bool metastatsOnly);
         void updateOnPackageFailed(int statusCode);
         void updateOnPackageRetry(int statusCode, unsigned retryFailedTimes);
         void updateOnRecordsDropped(EventDroppedReason reason, std::map<std::string, size_t> const& droppedCount);
@@ -534,6 +537,8 @@ namespace MAT_NS_BEGIN {
         void updateOnRecordsRejected(EventRejectedReason reason, std::map<std::string, size_t> const& rejectedCount);
         void updateOnStorageOpened(std::string const& type);
         void updateOnStorageFailed(std::string const& reason);
+        void updateOnStageLatencies(std::vector<RouteStatistics::StageSnapshot> const& stages);
+        void updateOnEventRuleDrops(std::vector<EventRuleTable::RuleDrops> const& drops);
 
     protected:
         /// <summary>
@@ -581,9 +586,23 @@ namespace MAT_NS_BEGIN {
         bool                            m_enableTenantStats;
 
         /// <summary>
-        /// Per-tenant stats
+        /// Per-tenant stats, by TenantRegistry handle
         /// </summary>
-        std::map<std::string, TelemetryStats>  m_telemetryTenantStats;
+        std::map<TenantHandle, TelemetryStats> m_telemetryTenantStats;
+
+        /// <summary>
+        /// Pipeline stage latencies: latest snapshot and the one of the last
+        /// stats event, reported as the difference between the two
+        /// </summary>
+        std::vector<RouteStatistics::StageSnapshot> m_stageSnapshots;
+        std::vector<RouteStatistics::StageSnapshot> m_lastStageSnapshots;
+
+        /// <summary>
+        /// Events dropped by each early drop rule: latest counts and the ones
+        /// of the last stats event, reported as the difference between the two
+        /// </summary>
+        std::vector<EventRuleTable::RuleDrops> m_ruleDrops;
+        std::vector<EventRuleTable::RuleDrops> m_lastRuleDrops;
 
         const std::map<EventLatency, std::string> m_latency_pfx =
         {
@@ -7,6 +7,7 @@
 
 #include "Statistics.hpp"
 #include "ILogManager.hpp"
+#include "utils/EventId.hpp"
 #include "utils/Utils.hpp"
 #include <oacr.h>
 
@@ -18,6 +19,7 @@ namespace MAT_NS_BEGIN {
         m_taskDispatcher(taskDispatcher),
         m_config(telemetrySystem.getConfig()),
         m_logManager(telemetrySystem.getLogManager()),
+        m_metaStatsTenant(TenantRegistry::instance().Register(m_config.GetMetaStatsTenantToken())),
         m_baseDecorator(m_logManager),
         m_semanticContextDecorator(m_logManager),
         m_isStarted(false)
@@ -63,10 +65,18 @@ namespace MAT_NS_BEGIN {
         std::vector< ::CsProtocol::Record> records;
         {
             LOCKGUARD(m_metaStats_mtx);
+            RouteStatistics const* routeStats = m_iTelemetrySystem.getRouteStatistics();
+            if (routeStats != nullptr)
+            {
+                m_metaStats.updateOnStageLatencies(routeStats->GetSnapshots());
+            }
+            EventRuleTable const* eventRules = m_iTelemetrySystem.getEventRules();
+            if (eventRules != nullptr)
+            {
+                m_metaStats.updateOnEventRuleDrops(eventRules->GetDropCounts());
+            }
             records = m_metaStats.generateStatsEvent(rollupKind);
         }
-        std::string tenantToken = m_config.GetMetaStatsTenantToken();
-
         for (auto& record : records)
         {
             bool result = true;
@@ -75,7 +85,7 @@ namespace MAT_NS_BEGIN {
             result &= m_semanticContextDecorator.decorate(record, true);
             if (result)
             {
-                IncomingEventContext evt(PAL::generateUuidString(), tenantToken, EventLatency_Normal, EventPersistence_Normal, &record);
+                IncomingEventContext evt(EventId::Generate(), m_metaStatsTenant, EventLatency_Normal, EventPersistence_Normal, &record);
                 m_iTelemetrySystem.sendEvent(&evt);
             }
             else
@@ -121,10 +131,13 @@ namespace MAT_NS_BEGIN {
 
     bool Statistics::handleOnIncomingEventAccepted(IncomingEventContextPtr const& ctx)
     {
-        bool metastats = (ctx->record.tenantToken == m_config.GetMetaStatsTenantToken());
+        // Events made from a token rather than a logger's handle are rare, see IncomingEventContext
+        TenantHandle tenant = (ctx->record.tenantHandle != InvalidTenantHandle) ?
+            ctx->record.tenantHandle : TenantRegistry::instance().Register(ctx->record.tenantToken);
+        bool metastats = (tenant == m_metaStatsTenant);
         {
             LOCKGUARD(m_metaStats_mtx);
-            m_metaStats.updateOnEventIncoming(ctx->record.tenantToken, static_cast<unsigned>(ctx->record.blob.size()), ctx->record.latency, metastats);
+            m_metaStats.updateOnEventIncoming(tenant, static_cast<unsigned>(ctx->record.blob.size()), ctx->record.latency, metastats);
         }
         scheduleSend();
 
@@ -140,7 +153,7 @@ namespace MAT_NS_BEGIN {
     {
         UNREFERENCED_PARAMETER(ctx);
         std::map<std::string, size_t> failedData;
-        failedData[ctx->record.tenantToken] = 1;
+        failedData[TenantRegistry::instance().Token(ctx->record)] = 1;
         {
             LOCKGUARD(m_metaStats_mtx);
             m_metaStats.updateOnRecordsDropped(DROPPED_REASON_OFFLINE_STORAGE_SAVE_FAILED, failedData);
@@ -155,6 +168,24 @@ namespace MAT_NS_BEGIN {
         return true;
     }
 
+    bool Statistics::handleOnIncomingEventDropped(IncomingEventContextPtr const& ctx)
+    {
+        std::map<std::string, size_t> droppedData;
+        droppedData[TenantRegistry::instance().Token(ctx->record)] = 1;
+        {
+            LOCKGUARD(m_metaStats_mtx);
+            m_metaStats.updateOnRecordsDropped(DROPPED_REASON_INGESTION_QUEUE_OVERFLOW, droppedData);
+        }
+        scheduleSend();
+
+        DebugEvent evt;
+        evt.type = DebugEventType::EVT_DROPPED;
+        evt.param1 = 1;
+        OnDebugEvent(evt);
+
+        return true;
+    }
+
     bool Statistics::handleOnUploadStarted(EventsUploadContextPtr const& ctx)
     {
         bool metastatsOnly = (ctx->packageIds.count(m_config.GetMetaStatsTenantToken()) == ctx->packageIds.size());
@@ -204,10 +235,15 @@ namespace MAT_NS_BEGIN {
         {
             LOCKGUARD(m_metaStats_mtx);
             m_metaStats.updateOnPackageFailed(status);
-            std::map<std::string, size_t> countOnTenant;
+            std::map<TenantHandle, size_t> countOnHandle;
             for (const auto& recordAndTenant : ctx->recordIdsAndTenantIds)
             {
-                countOnTenant[recordAndTenant.second]++;
+                countOnHandle[recordAndTenant.second]++;
+            }
+            std::map<std::string, size_t> countOnTenant;
+            for (const auto& handleAndCount : countOnHandle)
+            {
+                countOnTenant[TenantRegistry::instance().Token(handleAndCount.first)] += handleAndCount.second;
             }
             m_metaStats.updateOnRecordsRejected(REJECTED_REASON_SERVER_DECLINED, countOnTenant);
         }
@@ -43,6 +43,7 @@ namespace MAT_NS_BEGIN {
         bool handleOnIncomingEventAccepted(IncomingEventContextPtr const& ctx);
         // bool handleOnIncomingEventRejected(DebugEvent &evt); 
         bool handleOnIncomingEventFailed(IncomingEventContextPtr const& ctx);
+        bool handleOnIncomingEventDropped(IncomingEventContextPtr const& ctx);
 
         bool handleOnUploadStarted(EventsUploadContextPtr const& ctx);
         bool handleOnPackagingFailed(EventsUploadContextPtr const& ctx);
@@ -63,6 +64,8 @@ namespace MAT_NS_BEGIN {
         ITaskDispatcher&            m_taskDispatcher;
         IRuntimeConfig&             m_config;
         ILogManager&                m_logManager;
+        // Tenant of the stats events themselves
+        TenantHandle                m_metaStatsTenant;
 
         // Both decorators are associated with m_logManager
         BaseDecorator               m_baseDecorator;
@@ -84,6 +87,7 @@ namespace MAT_NS_BEGIN {
 #if 1   // TODO: [MG] - verify this codepath
         RoutePassThrough<Statistics, IncomingEventContextPtr const&>    onIncomingEventAccepted{ this, &Statistics::handleOnIncomingEventAccepted };
         RoutePassThrough<Statistics, IncomingEventContextPtr const&>    onIncomingEventFailed{ this, &Statistics::handleOnIncomingEventFailed };
+        RoutePassThrough<Statistics, IncomingEventContextPtr const&>    onIncomingEventDropped{ this, &Statistics::handleOnIncomingEventDropped };
 #else
         bool dummy_IncomingEventContextPtr(IncomingEventContextPtr const& ctx)
         {
@@ -93,6 +97,7 @@ namespace MAT_NS_BEGIN {
 
         RoutePassThrough<Statistics, IncomingEventContextPtr const&>    onIncomingEventAccepted{ this, &Statistics::dummy_IncomingEventContextPtr };
         RoutePassThrough<Statistics, IncomingEventContextPtr const&>    onIncomingEventFailed{ this, &Statistics::dummy_IncomingEventContextPtr };
+        RoutePassThrough<Statistics, IncomingEventContextPtr const&>    onIncomingEventDropped{ this, &Statistics::dummy_IncomingEventContextPtr };
 #endif
 
 #if 1   // TODO: [MG] - verify this codepath
@@ -6,10 +6,13 @@
 #pragma once
 #include "IHttpClient.hpp"
 #include "IOfflineStorage.hpp"
+#include "compression/DeflateStream.hpp"
 #include "packager/ISplicer.hpp"
 #include "packager/BondSplicer.hpp"
 #include "pal/PAL.hpp"
+#include "system/TenantRegistry.hpp"
 #include "utils/Utils.hpp"
+#include "utils/ScatterGatherBuffer.hpp"
 
 #include <map>
 #include <memory>
@@ -18,33 +21,64 @@
 
 namespace MAT_NS_BEGIN {
 
+    class EventProperties;
+    struct ContextFieldsSnapshot;
 
     class IncomingEventContext {
     public:
         ::CsProtocol::Record*  source;
         StorageRecord          record;
         std::uint64_t          policyBitFlags;
+        // Part B/C properties not yet copied into source, see EventPropertiesBondEncoder
+        EventProperties const* properties;
+        // Semantic context whose extensions the record carries unchanged, or leaves
+        // empty for the serializer, see ContextFieldsProvider::writeToRecord.
+        // Reset by whatever may change them.
+        std::shared_ptr<const ContextFieldsSnapshot> context;
 
     public:
         IncomingEventContext() :
             source(nullptr),
-            policyBitFlags(0)
+            policyBitFlags(0),
+            properties(nullptr)
         {
         }
 
+        // Events of a registered tenant are made from its handle: their record
+        // leaves tenantToken empty, see StorageRecord::tenantHandle.
 #ifdef HAVE_MAT_EVT_TRACEID   
         IncomingEventContext(std::string const& id, std::string const& tenantToken, EventLatency latency, EventPersistence persistence, ::CsProtocol::Record* source)
             : source(source),
             record{ id, tenantToken, latency, persistence, (source != nullptr) ? source->cV : "" },
-	    policyBitFlags(0)
+	    policyBitFlags(0),
+            properties(nullptr)
         {
         }
+
+        IncomingEventContext(std::string const& id, TenantHandle tenant, EventLatency latency, EventPersistence persistence, ::CsProtocol::Record* source)
+            : source(source),
+            record{ id, std::string(), latency, persistence, (source != nullptr) ? source->cV : "" },
+            policyBitFlags(0),
+            properties(nullptr)
+        {
+            record.tenantHandle = tenant;
+        }
 #else
         IncomingEventContext(std::string const& id, std::string const& tenantToken, EventLatency latency, EventPersistence persistence, ::CsProtocol::Record* source)
             : source(source),
             record{ id, tenantToken, latency, persistence },
-	    policyBitFlags(0)
+	    policyBitFlags(0),
+            properties(nullptr)
+        {
+        }
+
+        IncomingEventContext(std::string const& id, TenantHandle tenant, EventLatency latency, EventPersistence persistence, ::CsProtocol::Record* source)
+            : source(source),
+            record{ id, std::string(), latency, persistence },
+            policyBitFlags(0),
+            properties(nullptr)
         {
+            record.tenantHandle = tenant;
         }
 #endif
 
@@ -97,16 +131,26 @@ namespace MAT_NS_BEGIN {
         unsigned                             maxUploadSize = 0;
         EventLatency                         latency = EventLatency_Unspecified;
         std::map<std::string, size_t>        packageIds;
+        // Splicer tenant index by tenant handle, looked up before packageIds
+        std::vector<std::pair<TenantHandle, size_t>> packageTenants;
+        // Tenants of the records added with a token but no handle, see Packager::tenantOf
+        std::vector<TenantHandle>            recordTenants;
 #ifdef HAVE_MAT_EVT_TRACEID  
         std::string                          traceId;
 #endif
-        std::map<std::string, std::string>   recordIdsAndTenantIds;
+        std::map<std::string, TenantHandle>  recordIdsAndTenantIds;
         std::vector<int64_t>                 recordTimestamps;
         unsigned                             maxRetryCountSeen = 0;
+        // Set in streaming compression mode: records are deflated into body as they are added
+        std::unique_ptr<DeflateStream>       deflate;
 
         // Encoding
+        // Spliced records: compressed into body, or gathered into it by HttpRequestEncoder
+        ScatterGatherBuffer                  splicedBody;
         std::vector<uint8_t>                 body;
         bool                                 compressed = false;
+        // Content-Encoding of a compressed body, "deflate" when not set
+        std::string                          contentEncoding;
 
         // Sending
         IHttpRequest*                        httpRequest = nullptr;
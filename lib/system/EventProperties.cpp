@@ -35,9 +35,7 @@ namespace MAT_NS_BEGIN {
     {
         for (auto &kv : properties)
         {
-            auto key = kv.first;
-            auto val = kv.second;
-            m_storage->properties[key] = val;
+            m_storage->properties.insert_or_assign(kv.first, kv.second);
         }
         return (*this);
     }
@@ -119,10 +117,7 @@ namespace MAT_NS_BEGIN {
 
         for (auto &kv : properties)
         {
-            auto key = kv.first;
-            auto val = kv.second;
-
-            m_storage->properties[key] = val;
+            m_storage->properties.insert_or_assign(kv.first, kv.second);
         }
 
         return (*this);
@@ -310,8 +305,9 @@ namespace MAT_NS_BEGIN {
 
     std::tuple<bool, uint8_t> EventProperties::TryGetLevel() const
     {
-        const auto& findResult = GetProperties().find(COMMONFIELDS_EVENT_LEVEL);
-        if (findResult == GetProperties().cend())
+        const auto& props = static_cast<const EventPropertiesStorage*>(m_storage)->properties;
+        const auto& findResult = props.find(COMMONFIELDS_EVENT_LEVEL);
+        if (findResult == props.cend())
             return std::make_tuple<bool, uint8_t>(false, 0);
         
         const auto& property = findResult->second;
@@ -344,7 +340,7 @@ namespace MAT_NS_BEGIN {
             return;
         }
 
-        m_storage->properties[name] = prop;
+        m_storage->properties.insert_or_assign(name, prop);
     }
 
     //
@@ -363,14 +359,7 @@ namespace MAT_NS_BEGIN {
 
     const map<string, EventProperty>& EventProperties::GetProperties(DataCategory category) const
     {
-        if (category == DataCategory_PartC)
-        {
-            return m_storage->properties;
-        }
-        else
-        {
-            return m_storage->propertiesPartB;
-        }
+        return m_storage->GetMapView(category);
     }
 
     /// <summary>
@@ -391,11 +380,11 @@ namespace MAT_NS_BEGIN {
     const map<string, pair<string, PiiKind> > EventProperties::GetPiiProperties(DataCategory category) const
     {
         std::map<string, pair<string, PiiKind> > pIIExtensions;
-        auto &props = (category == DataCategory_PartC) ? m_storage->properties : m_storage->propertiesPartB;
+        const auto &props = (category == DataCategory_PartC) ? m_storage->properties : m_storage->propertiesPartB;
         for (const auto &kv : props)
         {
-            auto k = kv.first;
-            auto v = kv.second;
+            const auto& k = kv.first;
+            const auto& v = kv.second;
             if (v.piiKind != PiiKind_None)
             {
                 pIIExtensions[k] = std::pair<string, PiiKind>(v.to_string(), v.piiKind);
@@ -4,11 +4,13 @@
 //
 #pragma once
 #include <map>
+#include <mutex>
 #include <string>
 
 #include "Enums.hpp"
 #include "EventProperty.hpp"
 #include "ctmacros.hpp"
+#include "utils/FlatStringMap.hpp"
 
 namespace MAT_NS_BEGIN {
 
@@ -22,8 +24,8 @@ namespace MAT_NS_BEGIN {
        uint64_t         eventPolicyBitflags = {};
        int64_t          timestampInMillis = {};
 
-       std::map<std::string, EventProperty> properties;
-       std::map<std::string, EventProperty> propertiesPartB;
+       FlatStringMap<EventProperty> properties;
+       FlatStringMap<EventProperty> propertiesPartB;
 
        EventPropertiesStorage() noexcept {}
 
@@ -64,9 +66,52 @@ namespace MAT_NS_BEGIN {
           eventPopSample = other.eventPopSample;
           eventPolicyBitflags = other.eventPolicyBitflags;
           timestampInMillis = other.timestampInMillis;
+          // The maps now carry the versions of other's: a view cached here
+          // may have been built at the same version from different contents
+          invalidateViews();
 
           return *this;
        }
+
+       /// <summary>
+       /// std::map copy of the requested property bag, kept for the public
+       /// EventProperties::GetProperties API. The copy is rebuilt lazily
+       /// only when the flat storage has been modified since the last call.
+       /// </summary>
+       const std::map<std::string, EventProperty>& GetMapView(DataCategory category) const
+       {
+          const bool partC = (category == DataCategory_PartC);
+          const auto& source = partC ? properties : propertiesPartB;
+          auto& view = partC ? propertiesView : propertiesPartBView;
+          auto& viewVersion = partC ? propertiesViewVersion : propertiesPartBViewVersion;
+
+          std::lock_guard<std::mutex> lock(viewLock);
+          if (viewVersion != source.Version())
+          {
+             view.clear();
+             for (const auto& kv : source)
+             {
+                view.emplace(kv.first, kv.second);
+             }
+             viewVersion = source.Version();
+          }
+          return view;
+       }
+
+    private:
+       void invalidateViews()
+       {
+          // Versions start at 1, so no map matches a view version of 0
+          std::lock_guard<std::mutex> lock(viewLock);
+          propertiesViewVersion = 0;
+          propertiesPartBViewVersion = 0;
+       }
+
+       mutable std::mutex viewLock;
+       mutable std::map<std::string, EventProperty> propertiesView;
+       mutable std::map<std::string, EventProperty> propertiesPartBView;
+       mutable uint64_t propertiesViewVersion = 0;
+       mutable uint64_t propertiesPartBViewVersion = 0;
     };
 
 } MAT_NS_END
@@ -16,6 +16,8 @@
 namespace MAT_NS_BEGIN {
 
     class DebugEventDispatcher;
+    class RouteStatistics;
+    class EventRuleTable;
     
     /// <summary>
     /// Common interface of a telemetry system
@@ -41,12 +43,25 @@ namespace MAT_NS_BEGIN {
 
         virtual EventsUploadContextPtr createEventsUploadContext() = 0;
 
+        // Pipeline stage latencies, nullptr unless stage timing is enabled
+        virtual RouteStatistics const* getRouteStatistics() const { return nullptr; }
+
+        // Early drop rules of the log manager, for their drop counts in stats events
+        virtual void setEventRules(EventRuleTable const*) {}
+        virtual EventRuleTable const* getEventRules() const { return nullptr; }
+
         // Debug functionality
         virtual bool DispatchEvent(DebugEvent evt) override = 0;
 
         // Core sendEvent
         virtual void sendEvent(IncomingEventContextPtr const& event) = 0;
 
+        // Batch sendEvent: the events are stored together
+        virtual void sendEvents(std::vector<IncomingEventContextPtr> const& events) = 0;
+
+        // Event discarded before reaching the pipeline (e.g. ingestion queue overflow)
+        virtual void dropEvent(IncomingEventContextPtr const& event) = 0;
+
     protected:
         virtual void handleFlushTaskDispatcher() = 0;
         virtual void signalDone() = 0;
@@ -135,7 +135,7 @@ namespace MAT_NS_BEGIN
         ans["name"] = source->name;
         if (source->time) ans["time"] = source->time;
         std::string iKey("P-ARIA-");
-        iKey.append(event->record.tenantToken);
+        iKey.append(TenantRegistry::instance().Token(event->record));
         ans["iKey"] = iKey;
         if (!source->cV.empty())
             ans[CorrelationVector::PropertyName] = source->cV;
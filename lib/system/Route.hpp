@@ -6,6 +6,7 @@
 #define SYSTEM_ROUTE_HPP
 
 #include "pal/PAL.hpp"
+#include "system/RouteStatistics.hpp"
 
 #include <assert.h>
 #include <vector>
@@ -38,18 +39,30 @@ namespace MAT_NS_BEGIN {
     public:
         RouteHandlerT(TOwner* owner, typename TParent::ReturnType(TOwner::* handler)(TArgs...))
             : m_owner(owner),
-            m_handler(handler)
+            m_handler(handler),
+            m_latency(nullptr)
         {
         }
 
         virtual typename TParent::ReturnType operator()(TArgs... args) override
         {
+            if (m_latency == nullptr) {
+                return (m_owner->*m_handler)(std::forward<TArgs>(args) ...);
+            }
+            RouteStageTimer timer(*m_latency);
             return (m_owner->*m_handler)(std::forward<TArgs>(args) ...);
         }
 
+        //! Times every call into the histogram, see RouteStatistics::Attach
+        void setLatencyHistogram(LatencyHistogram* latency)
+        {
+            m_latency = latency;
+        }
+
     protected:
         TOwner * m_owner;
         typename TParent::ReturnType(TOwner::* m_handler)(TArgs...);
+        LatencyHistogram* m_latency;
     };
 
 
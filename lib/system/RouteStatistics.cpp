@@ -0,0 +1,189 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "RouteStatistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace MAT_NS_BEGIN
+{
+    LatencyHistogram::LatencyHistogram() noexcept :
+        m_count(0),
+        m_total(0),
+        m_max(0)
+    {
+        for (auto& bucket : m_buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    size_t LatencyHistogram::BucketIndex(uint64_t value) noexcept
+    {
+        if (value < SubBucketCount)
+        {
+            return static_cast<size_t>(value);
+        }
+        unsigned magnitude = 0;
+        for (unsigned shift = 32; shift > 0; shift /= 2)
+        {
+            if ((value >> (magnitude + shift)) != 0)
+            {
+                magnitude += shift;
+            }
+        }
+        if (magnitude >= MaxMagnitude)
+        {
+            return BucketCount - 1;
+        }
+        size_t sub = static_cast<size_t>(value >> (magnitude - SubBucketBits)) & (SubBucketCount - 1);
+        return (magnitude - SubBucketBits + 1) * SubBucketCount + sub;
+    }
+
+    uint64_t LatencyHistogram::BucketLowerBound(size_t index) noexcept
+    {
+        if (index < SubBucketCount)
+        {
+            return index;
+        }
+        size_t group = index / SubBucketCount;
+        uint64_t sub = index % SubBucketCount;
+        return (SubBucketCount + sub) << (group - 1);
+    }
+
+    uint64_t LatencyHistogram::BucketUpperBound(size_t index) noexcept
+    {
+        if (index + 1 >= BucketCount)
+        {
+            return (std::numeric_limits<uint64_t>::max)();
+        }
+        return BucketLowerBound(index + 1) - 1;
+    }
+
+    void LatencyHistogram::Record(uint64_t value) noexcept
+    {
+        m_buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_total.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    LatencyHistogram::Snapshot LatencyHistogram::GetSnapshot() const
+    {
+        // Counters are read one by one while other threads may record, so
+        // the bucket sum can be a few values off the count
+        Snapshot snapshot;
+        snapshot.buckets.resize(BucketCount);
+        uint64_t count = 0;
+        for (size_t i = 0; i < BucketCount; i++)
+        {
+            snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+            count += snapshot.buckets[i];
+        }
+        snapshot.count = count;
+        snapshot.total = m_total.load(std::memory_order_relaxed);
+        snapshot.max = m_max.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    uint64_t LatencyHistogram::Snapshot::Percentile(double q) const
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::ceil(std::min(std::max(q, 0.0), 1.0) * static_cast<double>(count)));
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); i++)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+            {
+                return std::min(BucketUpperBound(i), max);
+            }
+        }
+        return max;
+    }
+
+    LatencyHistogram::Snapshot LatencyHistogram::Snapshot::Since(Snapshot const& earlier) const
+    {
+        Snapshot result;
+        result.buckets.resize(buckets.size());
+        size_t highest = 0;
+        for (size_t i = 0; i < buckets.size(); i++)
+        {
+            uint64_t before = (i < earlier.buckets.size()) ? earlier.buckets[i] : 0;
+            result.buckets[i] = (buckets[i] > before) ? buckets[i] - before : 0;
+            result.count += result.buckets[i];
+            if (result.buckets[i] != 0)
+            {
+                highest = i;
+            }
+        }
+        result.total = (total > earlier.total) ? total - earlier.total : 0;
+        // Only the overall maximum is tracked: bound it by the highest bucket used since
+        result.max = (result.count != 0) ? std::min(max, BucketUpperBound(highest)) : 0;
+        return result;
+    }
+
+    RouteStageTimer*& RouteStageTimer::current() noexcept
+    {
+        static thread_local RouteStageTimer* timer = nullptr;
+        return timer;
+    }
+
+    LatencyHistogram* RouteStatistics::AddStage(std::string const& name)
+    {
+        if (!m_enabled)
+        {
+            return nullptr;
+        }
+        m_stages.emplace_back(new Stage());
+        m_stages.back()->name = name;
+        return &m_stages.back()->latency;
+    }
+
+    std::vector<RouteStatistics::StageSnapshot> RouteStatistics::GetSnapshots() const
+    {
+        std::vector<StageSnapshot> result;
+        result.reserve(m_stages.size());
+        for (auto const& stage : m_stages)
+        {
+            result.push_back({ stage->name, stage->latency.GetSnapshot() });
+        }
+        return result;
+    }
+
+    std::vector<StageLatency> RouteStatistics::GetStageLatencies() const
+    {
+        std::vector<StageLatency> result;
+        result.reserve(m_stages.size());
+        for (auto const& stage : m_stages)
+        {
+            result.push_back(ToStageLatency(stage->name, stage->latency.GetSnapshot()));
+        }
+        return result;
+    }
+
+    StageLatency RouteStatistics::ToStageLatency(std::string const& name, LatencyHistogram::Snapshot const& latency)
+    {
+        StageLatency result;
+        result.name = name;
+        result.count = latency.count;
+        result.totalNs = latency.total;
+        result.p50Ns = latency.Percentile(0.5);
+        result.p90Ns = latency.Percentile(0.9);
+        result.p99Ns = latency.Percentile(0.99);
+        result.maxNs = latency.max;
+        return result;
+    }
+
+}
+MAT_NS_END
@@ -0,0 +1,176 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef ROUTESTATISTICS_HPP
+#define ROUTESTATISTICS_HPP
+
+#include "ctmacros.hpp"
+#include "StageLatency.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Log-linear latency histogram in the style of HdrHistogram: every
+    /// power of two is split into 8 linear buckets, so a recorded value is
+    /// known to within 1/8 of itself. Values are nanoseconds; anything from
+    /// 2^40 ns (about 18 minutes) up shares the last bucket. Recording is a
+    /// handful of relaxed atomic operations and may happen on any thread.
+    /// </summary>
+    class LatencyHistogram
+    {
+       public:
+        static constexpr unsigned SubBucketBits = 3;
+        static constexpr size_t SubBucketCount = size_t(1) << SubBucketBits;
+        static constexpr unsigned MaxMagnitude = 40;
+        // Linear buckets below SubBucketCount, one group per power of two up
+        // to MaxMagnitude, then a single overflow bucket
+        static constexpr size_t BucketCount = (MaxMagnitude - SubBucketBits + 1) * SubBucketCount + 1;
+
+        /// <summary>
+        /// Plain copy of the counters. Subtracting an earlier snapshot of the
+        /// same histogram gives the distribution of the values recorded since.
+        /// </summary>
+        struct Snapshot
+        {
+            uint64_t count = 0;
+            uint64_t total = 0;
+            uint64_t max = 0;
+            std::vector<uint64_t> buckets;
+
+            /// <summary>
+            /// Highest value of the bucket holding the q-th quantile (0..1),
+            /// capped at the maximum.
+            /// </summary>
+            uint64_t Percentile(double q) const;
+
+            Snapshot Since(Snapshot const& earlier) const;
+        };
+
+        LatencyHistogram() noexcept;
+
+        void Record(uint64_t value) noexcept;
+
+        Snapshot GetSnapshot() const;
+
+        static size_t BucketIndex(uint64_t value) noexcept;
+        static uint64_t BucketLowerBound(size_t index) noexcept;
+        static uint64_t BucketUpperBound(size_t index) noexcept;
+
+       protected:
+        std::atomic<uint64_t> m_count;
+        std::atomic<uint64_t> m_total;
+        std::atomic<uint64_t> m_max;
+        std::atomic<uint64_t> m_buckets[BucketCount];
+    };
+
+    /// <summary>
+    /// Times one call of a route handler into a histogram. Time spent in
+    /// other timed handlers called from it on the same thread is left to
+    /// them, so that a synchronous chain such as retrieve, package, compress
+    /// is broken down instead of being counted again at every level.
+    /// </summary>
+    class RouteStageTimer
+    {
+       public:
+        explicit RouteStageTimer(LatencyHistogram& histogram) noexcept :
+            m_histogram(histogram),
+            m_parent(current()),
+            m_nested(0),
+            m_start(std::chrono::steady_clock::now())
+        {
+            current() = this;
+        }
+
+        ~RouteStageTimer() noexcept
+        {
+            uint64_t elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+            current() = m_parent;
+            if (m_parent != nullptr)
+            {
+                m_parent->m_nested += elapsed;
+            }
+            m_histogram.Record((elapsed > m_nested) ? elapsed - m_nested : 0);
+        }
+
+        RouteStageTimer(RouteStageTimer const&) = delete;
+        RouteStageTimer& operator=(RouteStageTimer const&) = delete;
+
+       protected:
+        // Innermost timer running on the calling thread
+        static RouteStageTimer*& current() noexcept;
+
+        LatencyHistogram& m_histogram;
+        RouteStageTimer* m_parent;
+        uint64_t m_nested;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    /// <summary>
+    /// The named stages of one telemetry system's pipeline, each with a
+    /// latency histogram. When disabled no histogram is created and route
+    /// handlers stay untimed. Stages are added while the pipeline is wired,
+    /// before any event flows, and are never removed.
+    /// </summary>
+    class RouteStatistics
+    {
+       public:
+        struct StageSnapshot
+        {
+            std::string name;
+            LatencyHistogram::Snapshot latency;
+        };
+
+        explicit RouteStatistics(bool enabled) noexcept :
+            m_enabled(enabled)
+        {
+        }
+
+        bool IsEnabled() const noexcept
+        {
+            return m_enabled;
+        }
+
+        /// <summary>
+        /// Adds a stage, returns its histogram or nullptr when disabled.
+        /// </summary>
+        LatencyHistogram* AddStage(std::string const& name);
+
+        /// <summary>
+        /// Times a route handler as the named stage.
+        /// </summary>
+        template<typename TRoute>
+        void Attach(TRoute& route, std::string const& name)
+        {
+            route.setLatencyHistogram(AddStage(name));
+        }
+
+        std::vector<StageSnapshot> GetSnapshots() const;
+
+        std::vector<StageLatency> GetStageLatencies() const;
+
+        static StageLatency ToStageLatency(std::string const& name, LatencyHistogram::Snapshot const& latency);
+
+       protected:
+        struct Stage
+        {
+            std::string name;
+            LatencyHistogram latency;
+        };
+
+        bool m_enabled;
+        std::vector<std::unique_ptr<Stage>> m_stages;
+    };
+
+}
+MAT_NS_END
+
+#endif
@@ -150,9 +150,11 @@ namespace MAT_NS_BEGIN {
 
         // On an arbitrary user thread
         this->sending >> bondSerializer.serialize >> this->incomingEventPrepared;
+        this->dropping >> stats.onIncomingEventDropped;
 
         // On the inner worker thread
         this->preparedIncomingEvent >> storage.storeRecord >> stats.onIncomingEventAccepted >> tpm.eventArrived;
+        storage.recordStored >> stats.onIncomingEventAccepted >> tpm.eventArrived;
 
 
         storage.storeRecordFailed >> stats.onIncomingEventFailed;
@@ -175,7 +177,7 @@ namespace MAT_NS_BEGIN {
         compression.compressionFailed >> storage.releaseRecords >> stats.onPackagingFailed >> tpm.packagingFailed;
 #endif
 
-        hcm.requestDone >> clockSkewDelta.decode >> httpDecoder.decode;
+        hcm.requestDone >> httpResponse >> clockSkewDelta.decode >> httpDecoder.decode;
 
         httpDecoder.eventsAccepted >> storage.deleteRecords >> stats.onUploadSuccessful >> tpm.eventsUploadSuccessful;
         httpDecoder.eventsRejected >> storage.deleteRecords >> stats.onUploadRejected >> tpm.eventsUploadRejected;
@@ -193,6 +195,29 @@ namespace MAT_NS_BEGIN {
         storage.trimmed >> stats.onStorageTrimmed;
         storage.recordsDropped >> stats.onStorageRecordsDropped;
         storage.recordsRejected >> stats.onStorageRecordsRejected;
+
+        //
+        // Stage timing, no-op unless enabled in the stats configuration
+        //
+
+        routeStats.Attach(bondSerializer.serialize, "serialize");
+        routeStats.Attach(storage.storeRecord, "storeRecord");
+        routeStats.Attach(storage.storeRecords, "storeRecords");
+        routeStats.Attach(tpm.eventArrived, "eventArrived");
+        routeStats.Attach(storage.retrieveEvents, "retrieveEvents");
+        routeStats.Attach(packager.addEventToPackage, "addEventToPackage");
+        routeStats.Attach(packager.finalizePackage, "finalizePackage");
+#ifdef HAVE_MAT_ZLIB
+        routeStats.Attach(compression.compress, "compress");
+#endif
+        routeStats.Attach(httpEncoder.encode, "encode");
+        routeStats.Attach(hcm.sendRequest, "sendRequest");
+        // Measured by the HTTP client manager, not timed around a handler
+        m_httpLatency = routeStats.AddStage("http");
+        routeStats.Attach(httpDecoder.decode, "decode");
+        routeStats.Attach(storage.deleteRecords, "deleteRecords");
+        routeStats.Attach(storage.releaseRecords, "releaseRecords");
+        routeStats.Attach(storage.releaseRecordsIncRetryCount, "releaseRecordsIncRetryCount");
     }
 
     TelemetrySystem::~TelemetrySystem()
@@ -212,6 +237,35 @@ namespace MAT_NS_BEGIN {
     }
 
     void TelemetrySystem::handleIncomingEventPrepared(IncomingEventContextPtr const& event)
+    {
+        if (acceptPreparedEvent(event))
+        {
+            preparedIncomingEventAsync(event);
+        }
+    }
+
+    void TelemetrySystem::sendEvents(std::vector<IncomingEventContextPtr> const& events)
+    {
+        std::vector<IncomingEventContextPtr> prepared;
+        prepared.reserve(events.size());
+        for (auto const& event : events)
+        {
+            if (bondSerializer.serialize(event) && acceptPreparedEvent(event))
+            {
+                prepared.push_back(event);
+            }
+        }
+        if (!prepared.empty())
+        {
+            storage.storeRecords(prepared);
+        }
+    }
+
+    /// <summary>
+    /// Drops serialized events over the maximum blob size; the source record
+    /// and properties of accepted events are not used past this point.
+    /// </summary>
+    bool TelemetrySystem::acceptPreparedEvent(IncomingEventContextPtr const& event)
     {
         uint32_t maxBlobSize = m_config[CFG_MAP_TPM][CFG_INT_TPM_MAX_BLOB_BYTES];
         if (event->record.blob.size() > maxBlobSize)
@@ -221,12 +275,22 @@ namespace MAT_NS_BEGIN {
             evt.param1 = REJECTED_REASON_EVENT_SIZE_LIMIT_EXCEEDED;
             m_logManager.DispatchEvent(evt);
             LOG_INFO("Event %s/%s dropped because size more than 2 MB",
-                tenantTokenToId(event->record.tenantToken).c_str(), event->source->baseType.c_str());
-            return;
+                tenantTokenToId(TenantRegistry::instance().Token(event->record)).c_str(), event->source->baseType.c_str());
+            return false;
         }
 
         event->source = nullptr;
-        preparedIncomingEventAsync(event);
+        event->properties = nullptr;
+        return true;
+    }
+
+    bool TelemetrySystem::handleHttpResponse(EventsUploadContextPtr const& ctx)
+    {
+        if (m_httpLatency != nullptr && ctx->durationMs >= 0)
+        {
+            m_httpLatency->Record(static_cast<uint64_t>(ctx->durationMs) * 1000000);
+        }
+        return true;
     }
 
     void TelemetrySystem::handleFlushTaskDispatcher()
@@ -57,10 +57,18 @@ namespace MAT_NS_BEGIN {
         virtual bool upload() override;
         virtual void handleIncomingEventPrepared(IncomingEventContextPtr const& event) override;
 
+        /// <summary>
+        /// Serializes the events and stores them with one storage call, on the calling thread.
+        /// </summary>
+        virtual void sendEvents(std::vector<IncomingEventContextPtr> const& events) override;
+
     protected:
+        bool acceptPreparedEvent(IncomingEventContextPtr const& event);
 
         virtual void handleFlushTaskDispatcher() override;
 
+        bool handleHttpResponse(EventsUploadContextPtr const& ctx);
+
 #ifdef HAVE_MAT_ZLIB
         HttpDeflateCompression    compression;
 #else
@@ -74,10 +82,12 @@ namespace MAT_NS_BEGIN {
         Packager                  packager;
         TransmissionPolicyManager tpm;
         ClockSkewDelta            clockSkewDelta;
+        LatencyHistogram*         m_httpLatency = nullptr;
 
     public:
         RouteSink<TelemetrySystem>                                 flushTaskDispatcher{ this, &TelemetrySystem::handleFlushTaskDispatcher };
         RouteSink<TelemetrySystem, IncomingEventContextPtr const&> incomingEventPrepared{ this, &TelemetrySystem::handleIncomingEventPrepared };
+        RoutePassThrough<TelemetrySystem, EventsUploadContextPtr const&> httpResponse{ this, &TelemetrySystem::handleHttpResponse };
     };
 
 } MAT_NS_END
@@ -8,6 +8,7 @@
 #include "system/ITelemetrySystem.hpp"
 #include "ITaskDispatcher.hpp"
 #include "stats/Statistics.hpp"
+#include "system/RouteStatistics.hpp"
 #include <functional>
 
 namespace MAT_NS_BEGIN {
@@ -34,6 +35,7 @@ namespace MAT_NS_BEGIN {
             m_config(runtimeConfig),
             m_isStarted(false),
             m_isPaused(false),
+            routeStats(static_cast<bool>(runtimeConfig[CFG_MAP_METASTATS_CONFIG][CFG_BOOL_METASTATS_STAGE_TIMING])),
             stats(*this, taskDispatcher)
         {
             onStart  = []() { return true; };
@@ -139,6 +141,19 @@ namespace MAT_NS_BEGIN {
             sending(event);
         }
 
+        void sendEvents(std::vector<IncomingEventContextPtr> const& events) override
+        {
+            for (auto const& event : events)
+            {
+                sending(event);
+            }
+        }
+
+        void dropEvent(IncomingEventContextPtr const& event) override
+        {
+            dropping(event);
+        }
+
         /// <summary>
         /// Gets the log manager.
         /// </summary>
@@ -167,6 +182,21 @@ namespace MAT_NS_BEGIN {
             return std::make_shared<EventsUploadContext>();
         }
 
+        RouteStatistics const* getRouteStatistics() const override
+        {
+            return routeStats.IsEnabled() ? &routeStats : nullptr;
+        }
+
+        void setEventRules(EventRuleTable const* rules) override
+        {
+            eventRules = rules;
+        }
+
+        EventRuleTable const* getEventRules() const override
+        {
+            return eventRules;
+        }
+
         virtual bool DispatchEvent(DebugEvent evt) override
         {
             return m_logManager.DispatchEvent(std::move(evt));
@@ -180,6 +210,8 @@ namespace MAT_NS_BEGIN {
         std::atomic<bool>       m_isPaused;
         PAL::Event              m_done;
         BondSerializer          bondSerializer;
+        RouteStatistics         routeStats;
+        EventRuleTable const*   eventRules = nullptr;
         Statistics              stats;
 
         std::function<bool(void)>                                  onStart;
@@ -191,6 +223,7 @@ namespace MAT_NS_BEGIN {
     // TODO: [MG] - clean this up - get rid of RouteSource
     public:
         RouteSource<IncomingEventContextPtr const&>                sending;
+        RouteSource<IncomingEventContextPtr const&>                dropping;
         RouteSource<IncomingEventContextPtr const&>                preparedIncomingEvent;
 
     };
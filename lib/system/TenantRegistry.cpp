@@ -0,0 +1,100 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+#include "TenantRegistry.hpp"
+#include "utils/Utils.hpp"
+
+namespace MAT_NS_BEGIN
+{
+    TenantRegistry& TenantRegistry::instance()
+    {
+        static TenantRegistry registry;
+        return registry;
+    }
+
+    TenantHandle TenantRegistry::Register(std::string const& tenantToken)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        auto it = m_handles.find(tenantToken);
+        if (it != m_handles.end())
+        {
+            return it->second;
+        }
+        uint32_t size = m_size.load(std::memory_order_relaxed);
+        size_t chunk;
+        size_t offset;
+        locate(size, chunk, offset);
+        if (chunk >= MaxChunks)
+        {
+            return InvalidTenantHandle;
+        }
+        if (!m_chunks[chunk])
+        {
+            m_chunks[chunk].reset(new Entry[FirstChunkSize << chunk]);
+        }
+        m_chunks[chunk][offset] = Entry { tenantToken, tenantTokenToId(tenantToken) };
+        m_size.store(size + 1, std::memory_order_release);
+        TenantHandle handle = static_cast<TenantHandle>(size + 1);
+        m_handles.emplace(tenantToken, handle);
+        return handle;
+    }
+
+    TenantHandle TenantRegistry::Find(std::string const& tenantToken) const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        auto it = m_handles.find(tenantToken);
+        return (it != m_handles.end()) ? it->second : InvalidTenantHandle;
+    }
+
+    void TenantRegistry::locate(size_t index, size_t& chunk, size_t& offset)
+    {
+        // Chunk k starts at index FirstChunkSize * (2^k - 1)
+        size_t start = index / FirstChunkSize + 1;
+        chunk = 0;
+        while ((start >>= 1) != 0)
+        {
+            chunk++;
+        }
+        offset = index - FirstChunkSize * ((size_t(1) << chunk) - 1);
+    }
+
+    TenantRegistry::Entry const* TenantRegistry::find(TenantHandle handle) const
+    {
+        if (handle == InvalidTenantHandle || handle > m_size.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        size_t chunk;
+        size_t offset;
+        locate(handle - 1, chunk, offset);
+        return &m_chunks[chunk][offset];
+    }
+
+    std::string const& TenantRegistry::Token(TenantHandle handle) const
+    {
+        static std::string const empty;
+        Entry const* entry = find(handle);
+        return (entry != nullptr) ? entry->token : empty;
+    }
+
+    std::string const& TenantRegistry::TenantId(TenantHandle handle) const
+    {
+        static std::string const empty;
+        Entry const* entry = find(handle);
+        return (entry != nullptr) ? entry->tenantId : empty;
+    }
+
+    std::string const& TenantRegistry::Token(StorageRecord const& record) const
+    {
+        return (!record.tenantToken.empty()) ? record.tenantToken : Token(record.tenantHandle);
+    }
+
+    size_t TenantRegistry::Size() const
+    {
+        return m_size.load(std::memory_order_acquire);
+    }
+
+}
+MAT_NS_END
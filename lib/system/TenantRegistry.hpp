@@ -0,0 +1,97 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef TENANTREGISTRY_HPP
+#define TENANTREGISTRY_HPP
+
+#include "ctmacros.hpp"
+
+#include "IOfflineStorage.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Small integer standing for a tenant token, see TenantRegistry.
+    /// </summary>
+    using TenantHandle = uint32_t;
+
+    constexpr TenantHandle InvalidTenantHandle = 0;
+
+    /// <summary>
+    /// Process-wide table of the tenant tokens in use. Each token is registered
+    /// once, when a logger is created for it, and is then referred to by its
+    /// handle, so that the pipeline compares and copies integers instead of
+    /// 70-odd character strings. Tokens are never removed: a handle stays
+    /// valid, and the strings it refers to stay in place, for the lifetime of
+    /// the process. Only Register and Find take the lock, looking a handle up
+    /// does not, so that the pipeline can do it once per event.
+    /// </summary>
+    class TenantRegistry
+    {
+       public:
+        static TenantRegistry& instance();
+
+        /// <summary>
+        /// Returns the handle of the token, registering it if it is new.
+        /// </summary>
+        TenantHandle Register(std::string const& tenantToken);
+
+        /// <summary>
+        /// Returns the handle of the token, or InvalidTenantHandle if it was never registered.
+        /// </summary>
+        TenantHandle Find(std::string const& tenantToken) const;
+
+        /// <summary>
+        /// Returns the token of a handle, or an empty string for an unknown handle.
+        /// </summary>
+        std::string const& Token(TenantHandle handle) const;
+
+        /// <summary>
+        /// Returns the tenant ID part of the token of a handle, as used in log lines.
+        /// </summary>
+        std::string const& TenantId(TenantHandle handle) const;
+
+        /// <summary>
+        /// Returns the tenant token of a record: its own if set, else the one
+        /// of its handle. See StorageRecord::tenantHandle.
+        /// </summary>
+        std::string const& Token(StorageRecord const& record) const;
+
+        size_t Size() const;
+
+       protected:
+        struct Entry
+        {
+            std::string token;
+            std::string tenantId;
+        };
+
+        Entry const* find(TenantHandle handle) const;
+        static void locate(size_t index, size_t& chunk, size_t& offset);
+
+        // Entries live in chunks of FirstChunkSize, 2 * FirstChunkSize, ...
+        // entries, so they never move, and the chunk of a published entry is
+        // never written again: readers need nothing but m_size.
+        static constexpr size_t FirstChunkSize = 16;
+        static constexpr size_t MaxChunks = 28;
+
+        mutable std::mutex m_lock;
+        std::unordered_map<std::string, TenantHandle> m_handles;
+        std::unique_ptr<Entry[]> m_chunks[MaxChunks];
+        // Number of entries readers may look at, stored after the entry is written
+        std::atomic<uint32_t> m_size { 0 };
+    };
+
+}
+MAT_NS_END
+
+#endif
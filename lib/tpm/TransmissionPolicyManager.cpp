@@ -7,6 +7,7 @@
 #include "TransmitProfiles.hpp"
 #include "utils/Utils.hpp"
 
+#include <algorithm>
 #include <limits>
 
 namespace MAT_NS_BEGIN {
@@ -41,6 +42,21 @@ namespace MAT_NS_BEGIN {
         return (a > b) ? (a - b) : (b - a);
     }
 
+    namespace {
+
+        int64_t getTpmSetting(IRuntimeConfig& config, const char* key)
+        {
+            VariantMap& tpm = config[CFG_MAP_TPM];
+            auto it = tpm.find(key);
+            if (it != tpm.end() && it->second.type == Variant::TYPE_INT)
+            {
+                return it->second;
+            }
+            return 0;
+        }
+
+    }
+
     MATSDK_LOG_INST_COMPONENT_CLASS(TransmissionPolicyManager, "EventsSDK.TPM", "Events telemetry client - TransmissionPolicyManager class");
 
     TransmissionPolicyManager::TransmissionPolicyManager(ITelemetrySystem& system, ITaskDispatcher& taskDispatcher, IBandwidthController* bandwidthController) :
@@ -216,8 +232,13 @@ namespace MAT_NS_BEGIN {
         }
 #endif
 
+        startUpload(m_runningLatency);
+    }
+
+    void TransmissionPolicyManager::startUpload(EventLatency latency)
+    {
         auto ctx = m_system.createEventsUploadContext();
-        ctx->requestedMinLatency = m_runningLatency;
+        ctx->requestedMinLatency = latency;
         addUpload(ctx);
         initiateUpload(ctx);
     }
@@ -287,6 +308,7 @@ namespace MAT_NS_BEGIN {
             // Make sure we wait for completion of the upload scheduling task that may be running
             cancelUploadTask();
         }
+        cancelImmediateUpload();
 
         // Make sure we wait for all active upload callbacks to finish
         while (uploadCount() > 0)
@@ -306,6 +328,7 @@ namespace MAT_NS_BEGIN {
      bool TransmissionPolicyManager::handleCleanup()
      {
         cancelUploadTask();
+        cancelImmediateUpload();
         // Make sure ongoing uploads are finished.
         while (uploadCount() > 0)
         {
@@ -331,13 +354,19 @@ namespace MAT_NS_BEGIN {
         }
         bool forceTimerRestart = false;
 
-        /* This logic needs to be revised: one event in a dedicated HTTP post is wasteful! */
-        // Initiate upload right away
         if (event->record.latency > EventLatency_RealTime) {
-            auto ctx = m_system.createEventsUploadContext();
-            ctx->requestedMinLatency = event->record.latency;
-            addUpload(ctx);
-            initiateUpload(ctx);
+            int64_t windowMs = getTpmSetting(m_config, CFG_INT_TPM_IMMEDIATE_WINDOW_MS);
+            if (windowMs > 0)
+            {
+                // Hold the upload back briefly so that a burst shares one HTTP post
+                int64_t windowEvents = getTpmSetting(m_config, CFG_INT_TPM_IMMEDIATE_WINDOW_EVENTS);
+                coalesceImmediateEvent(event->record.latency,
+                    static_cast<unsigned>(std::min<int64_t>(windowMs, std::numeric_limits<unsigned>::max())),
+                    static_cast<size_t>(std::max<int64_t>(windowEvents, 0)));
+                return;
+            }
+            // Initiate upload right away
+            startUpload(event->record.latency);
             return;
         }
 
@@ -357,6 +386,67 @@ namespace MAT_NS_BEGIN {
         }
     }
 
+    void TransmissionPolicyManager::coalesceImmediateEvent(EventLatency latency, unsigned windowMs, size_t windowEvents)
+    {
+        {
+            LOCKGUARD(m_immediateMutex);
+            m_immediatePending++;
+            m_immediateLatency = std::max(m_immediateLatency, latency);
+            if (windowEvents == 0 || m_immediatePending < windowEvents)
+            {
+                if (!m_immediateScheduled)
+                {
+                    m_immediateScheduled = true;
+                    m_immediateUpload = PAL::scheduleTask(&m_taskDispatcher, windowMs, this, &TransmissionPolicyManager::uploadImmediateEvents);
+                }
+                return;
+            }
+            // Window full: the task still scheduled for it finds nothing pending,
+            // or uploads the events that arrive before it runs
+            latency = m_immediateLatency;
+            m_immediatePending = 0;
+            m_immediateLatency = EventLatency_Unspecified;
+        }
+        LOG_TRACE("Coalescing window full, upload for lat=%d", latency);
+        startUpload(latency);
+    }
+
+    void TransmissionPolicyManager::uploadImmediateEvents()
+    {
+        EventLatency latency;
+        {
+            LOCKGUARD(m_immediateMutex);
+            m_immediateScheduled = false;
+            if (m_immediatePending == 0)
+            {
+                return;
+            }
+            latency = m_immediateLatency;
+            m_immediatePending = 0;
+            m_immediateLatency = EventLatency_Unspecified;
+        }
+
+        PauseGuard guard(m_system.getLogManager());
+        if (guard.isPaused() || m_isPaused || m_scheduledUploadAborted)
+        {
+            LOG_TRACE("Paused or upload aborted: drop coalesced upload.");
+            return;
+        }
+        LOG_TRACE("Coalescing window closed, upload for lat=%d", latency);
+        startUpload(latency);
+    }
+
+    void TransmissionPolicyManager::cancelImmediateUpload()
+    {
+        // Not under m_immediateMutex: the task takes it and Cancel may wait for it.
+        // Events that were held back stay in storage for the next scheduled upload.
+        m_immediateUpload.Cancel(getCancelWaitTime().count());
+        LOCKGUARD(m_immediateMutex);
+        m_immediateScheduled = false;
+        m_immediatePending = 0;
+        m_immediateLatency = EventLatency_Unspecified;
+    }
+
     // We do only Normal if too few values or timers[0] == timers[2]
     // We do only RealTime if timers[0] < 0 (do not transmit)
     // We alternate RealTime and Normal otherwise (timers differ)
@@ -446,6 +536,7 @@ namespace MAT_NS_BEGIN {
         PauseGuard guard(m_system.getLogManager());
         m_isPaused = true;
         cancelUploadTask();
+        cancelImmediateUpload();
     }
 
     std::chrono::milliseconds TransmissionPolicyManager::getCancelWaitTime() const noexcept
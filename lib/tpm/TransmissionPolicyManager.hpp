@@ -68,6 +68,25 @@ constexpr const char* const DefaultBackoffConfig = "E,3000,300000,2,1";
 
         void handleEventArrived(IncomingEventContextPtr const& event);
 
+        /// <summary>
+        /// Count an event above EventLatency_RealTime towards the coalescing window,
+        /// starting the window if none is open. Uploads right away when the window
+        /// reaches its event limit.
+        /// </summary>
+        void coalesceImmediateEvent(EventLatency latency, unsigned windowMs, size_t windowEvents);
+
+        /// <summary>
+        /// Close the coalescing window and start one upload for the events it held back.
+        /// </summary>
+        void uploadImmediateEvents();
+
+        /// <summary>
+        /// Cancels the pending coalescing window task.
+        /// </summary>
+        void cancelImmediateUpload();
+
+        void startUpload(EventLatency latency);
+
         void handleNothingToUpload(EventsUploadContextPtr const& ctx);
         void handlePackagingFailed(EventsUploadContextPtr const& ctx);
         void handleEventsUploadSuccessful(EventsUploadContextPtr const& ctx);
@@ -96,6 +115,12 @@ constexpr const char* const DefaultBackoffConfig = "E,3000,300000,2,1";
         PAL::DeferredCallbackHandle      m_scheduledUpload;
         bool                             m_scheduledUploadAborted { false };
 
+        std::mutex                       m_immediateMutex;
+        PAL::DeferredCallbackHandle      m_immediateUpload;
+        bool                             m_immediateScheduled { false };
+        size_t                           m_immediatePending { 0 };
+        EventLatency                     m_immediateLatency { EventLatency_Unspecified };
+
         mutable std::mutex               m_activeUploads_lock;
         std::set<EventsUploadContextPtr> m_activeUploads;
         
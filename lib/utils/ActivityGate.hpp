@@ -0,0 +1,142 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef ACTIVITYGATE_HPP
+#define ACTIVITYGATE_HPP
+
+#include "ctmacros.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Counts calls in progress and lets another thread close the gate to new calls
+    /// and wait until those in progress have left. While the gate is open, Enter and
+    /// Leave are a single atomic read-modify-write each; the mutex and condition
+    /// variable are only used once the gate is closed.
+    /// </summary>
+    class ActivityGate
+    {
+       public:
+        ActivityGate() :
+            m_state(0)
+        {
+        }
+
+        ActivityGate(ActivityGate const&) = delete;
+        ActivityGate& operator=(ActivityGate const&) = delete;
+
+        /// <summary>
+        /// Start a call. Returns false, without counting the call, if the gate is closed.
+        /// </summary>
+        bool Enter() noexcept
+        {
+            uint64_t state = m_state.load(std::memory_order_relaxed);
+            do
+            {
+                if (state & Closed)
+                {
+                    return false;
+                }
+            } while (!m_state.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed));
+            return true;
+        }
+
+        /// <summary>
+        /// End a call that Enter admitted. Extra calls are ignored.
+        /// </summary>
+        void Leave()
+        {
+            uint64_t state = m_state.load(std::memory_order_relaxed);
+            while ((state & Closed) == 0)
+            {
+                if ((state & Count) == 0)
+                {
+                    return;
+                }
+                if (m_state.compare_exchange_weak(state, state - 1, std::memory_order_release, std::memory_order_relaxed))
+                {
+                    return;
+                }
+            }
+
+            // Closed: decrement and notify under the lock, so that a waiter cannot see
+            // the count drain, return and destroy this gate before we are done with it
+            std::lock_guard<std::mutex> lock(m_mutex);
+            state = m_state.load(std::memory_order_relaxed);
+            while ((state & Count) != 0 && !m_state.compare_exchange_weak(state, state - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+            {
+            }
+            if ((state & Count) == 1)
+            {
+                m_drained.notify_all();
+            }
+        }
+
+        /// <summary>
+        /// Refuse new calls. Returns false if the gate was already closed.
+        /// </summary>
+        bool Close()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return (m_state.fetch_or(Closed) & Closed) == 0;
+        }
+
+        /// <summary>
+        /// Admit new calls again and release the threads blocked in WaitDrained.
+        /// Returns false if the gate was already open.
+        /// </summary>
+        bool Open()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            bool wasClosed = (m_state.fetch_and(~Closed) & Closed) != 0;
+            if (wasClosed)
+            {
+                m_drained.notify_all();
+            }
+            return wasClosed;
+        }
+
+        /// <summary>
+        /// Block while the gate is closed and calls are still in progress.
+        /// </summary>
+        void WaitDrained()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_drained.wait(lock, [this]() -> bool {
+                uint64_t state = m_state.load();
+                return (state & Closed) == 0 || (state & Count) == 0;
+            });
+        }
+
+        bool IsClosed() const noexcept
+        {
+            return (m_state.load() & Closed) != 0;
+        }
+
+        /// <summary>
+        /// Number of calls in progress.
+        /// </summary>
+        uint64_t ActiveCount() const noexcept
+        {
+            return m_state.load() & Count;
+        }
+
+       private:
+        static constexpr uint64_t Closed = uint64_t { 1 } << 63;
+        static constexpr uint64_t Count = Closed - 1;
+
+        std::atomic<uint64_t> m_state;
+        std::mutex m_mutex;
+        std::condition_variable m_drained;
+    };
+
+}
+MAT_NS_END
+
+#endif
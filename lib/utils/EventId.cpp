@@ -0,0 +1,132 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+#include "EventId.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <thread>
+
+namespace MAT_NS_BEGIN
+{
+    namespace
+    {
+        uint64_t splitmix64(uint64_t& state)
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        uint64_t rotl(uint64_t x, int k)
+        {
+            return (x << k) | (x >> (64 - k));
+        }
+
+        /// <summary>
+        /// xoshiro256** generator, one per thread: no shared state between
+        /// threads and no locking, unlike std::rand().
+        /// </summary>
+        class ThreadRandom
+        {
+        public:
+            ThreadRandom()
+            {
+                // Seeded from the OS entropy source, mixed with time and thread
+                // identity in case std::random_device is deterministic.
+                std::random_device device;
+                uint64_t seed = (static_cast<uint64_t>(device()) << 32) ^ device();
+                seed ^= static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+                seed ^= static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) << 1;
+                seed ^= static_cast<uint64_t>(reinterpret_cast<uintptr_t>(this));
+                for (uint64_t& word : m_state)
+                {
+                    word = splitmix64(seed);
+                }
+            }
+
+            uint64_t next()
+            {
+                uint64_t const result = rotl(m_state[1] * 5, 7) * 9;
+                uint64_t const t = m_state[1] << 17;
+                m_state[2] ^= m_state[0];
+                m_state[3] ^= m_state[1];
+                m_state[1] ^= m_state[2];
+                m_state[0] ^= m_state[3];
+                m_state[2] ^= t;
+                m_state[3] = rotl(m_state[3], 45);
+                return result;
+            }
+
+        private:
+            uint64_t m_state[4];
+        };
+
+        ThreadRandom& GetThreadRandom()
+        {
+            static thread_local ThreadRandom random;
+            return random;
+        }
+
+        int hexValue(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            return -1;
+        }
+    }
+
+    constexpr size_t EventId::Size;
+
+    std::string EventId::Generate()
+    {
+        ThreadRandom& random = GetThreadRandom();
+        uint64_t words[2] = { random.next(), random.next() };
+        return std::string(reinterpret_cast<char const*>(words), Size);
+    }
+
+    std::string EventId::ToText(std::string const& id)
+    {
+        if (id.size() != Size)
+        {
+            return id;
+        }
+        static char const digits[] = "0123456789abcdef";
+        std::string text(2 * Size, '0');
+        for (size_t i = 0; i < Size; i++)
+        {
+            uint8_t const value = static_cast<uint8_t>(id[i]);
+            text[2 * i] = digits[value >> 4];
+            text[2 * i + 1] = digits[value & 0x0F];
+        }
+        return text;
+    }
+
+    void EventId::FromText(std::string& id)
+    {
+        if (id.size() != 2 * Size)
+        {
+            return;
+        }
+        char binary[Size];
+        for (size_t i = 0; i < Size; i++)
+        {
+            int const high = hexValue(id[2 * i]);
+            int const low = hexValue(id[2 * i + 1]);
+            if (high < 0 || low < 0)
+            {
+                return;
+            }
+            binary[i] = static_cast<char>((high << 4) | low);
+        }
+        id.assign(binary, Size);
+    }
+
+} MAT_NS_END
@@ -0,0 +1,44 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef LIB_EVENT_ID_HPP
+#define LIB_EVENT_ID_HPP
+
+#include "ctmacros.hpp"
+#include <cstddef>
+#include <string>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Local identifiers of submitted events (StorageRecord::id). An ID is 128
+    /// random bits kept as 16 raw bytes; it is only formatted as text where it
+    /// leaves memory: in log messages and in the SQLite events table.
+    /// </summary>
+    class EventId
+    {
+        public:
+            static constexpr size_t Size = 16;
+
+            /// <summary>
+            /// Returns a new binary ID from the calling thread's generator.
+            /// </summary>
+            static std::string Generate();
+
+            /// <summary>
+            /// Formats a binary ID as 32 lowercase hex digits. Any other ID,
+            /// e.g. a textual UUID stored by an older version, is returned as is.
+            /// </summary>
+            static std::string ToText(std::string const& id);
+
+            /// <summary>
+            /// Reverts ToText in place: 32 lowercase hex digits become the
+            /// binary ID again, anything else is left unchanged.
+            /// </summary>
+            static void FromText(std::string& id);
+    };
+
+} MAT_NS_END
+
+#endif
@@ -0,0 +1,153 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef FIFORING_HPP
+#define FIFORING_HPP
+
+#include "ctmacros.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Unbounded FIFO queue over a single circular array, for use under an
+    /// external lock. Elements are appended at the back and taken from the
+    /// front; PushFront puts an element back ahead of the others. The array
+    /// doubles when full and is never shrunk, so a queue that turns over at a
+    /// steady rate stops allocating once it has reached its working size.
+    /// </summary>
+    template <typename T>
+    class FifoRing
+    {
+       public:
+        FifoRing() :
+            m_capacity(0),
+            m_head(0),
+            m_size(0)
+        {
+        }
+
+        FifoRing(FifoRing const&) = delete;
+        FifoRing& operator=(FifoRing const&) = delete;
+
+        void PushBack(T&& value)
+        {
+            Reserve(m_size + 1);
+            m_cells[(m_head + m_size) & (m_capacity - 1)] = std::move(value);
+            m_size++;
+        }
+
+        void PushFront(T&& value)
+        {
+            Reserve(m_size + 1);
+            m_head = (m_head + m_capacity - 1) & (m_capacity - 1);
+            m_cells[m_head] = std::move(value);
+            m_size++;
+        }
+
+        /// <summary>
+        /// Remove and return the oldest element. The queue must not be empty.
+        /// </summary>
+        T PopFront()
+        {
+            T value = std::move(m_cells[m_head]);
+            m_cells[m_head] = T();
+            m_head = (m_head + 1) & (m_capacity - 1);
+            m_size--;
+            return value;
+        }
+
+        /// <summary>
+        /// Element at position i counted from the front.
+        /// </summary>
+        T& operator[](size_t i)
+        {
+            return m_cells[(m_head + i) & (m_capacity - 1)];
+        }
+
+        T const& operator[](size_t i) const
+        {
+            return m_cells[(m_head + i) & (m_capacity - 1)];
+        }
+
+        /// <summary>
+        /// Remove the elements matching the predicate, keeping the order of
+        /// the others. Returns the number of elements removed.
+        /// </summary>
+        template <typename TPredicate>
+        size_t RemoveIf(TPredicate predicate)
+        {
+            size_t kept = 0;
+            for (size_t i = 0; i < m_size; i++)
+            {
+                T& cell = (*this)[i];
+                if (!predicate(cell))
+                {
+                    if (kept != i)
+                    {
+                        (*this)[kept] = std::move(cell);
+                    }
+                    kept++;
+                }
+            }
+            size_t removed = m_size - kept;
+            for (size_t i = kept; i < m_size; i++)
+            {
+                (*this)[i] = T();
+            }
+            m_size = kept;
+            return removed;
+        }
+
+        void Clear()
+        {
+            for (size_t i = 0; i < m_size; i++)
+            {
+                (*this)[i] = T();
+            }
+            m_head = 0;
+            m_size = 0;
+        }
+
+        size_t Size() const noexcept
+        {
+            return m_size;
+        }
+
+        bool Empty() const noexcept
+        {
+            return m_size == 0;
+        }
+
+       protected:
+        void Reserve(size_t size)
+        {
+            if (size <= m_capacity)
+            {
+                return;
+            }
+            size_t capacity = (m_capacity == 0) ? 16 : m_capacity * 2;
+            std::unique_ptr<T[]> cells(new T[capacity]);
+            for (size_t i = 0; i < m_size; i++)
+            {
+                cells[i] = std::move((*this)[i]);
+            }
+            m_cells = std::move(cells);
+            m_capacity = capacity;
+            m_head = 0;
+        }
+
+        std::unique_ptr<T[]> m_cells;
+        size_t m_capacity;
+        size_t m_head;
+        size_t m_size;
+    };
+
+}
+MAT_NS_END
+
+#endif
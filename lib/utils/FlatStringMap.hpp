@@ -0,0 +1,264 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef FLATSTRINGMAP_HPP
+#define FLATSTRINGMAP_HPP
+
+#include "ctmacros.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Insertion-ordered map from string keys to values, stored contiguously.
+    /// Small maps are searched linearly; once the map grows past
+    /// LinearScanLimit entries an open-addressing index of entry positions
+    /// is maintained next to the entries. Keys rely on std::string's
+    /// small-string buffer, so short property names are stored inline.
+    /// Any non-const access bumps Version(), which lets owners cache views
+    /// derived from the map contents.
+    /// </summary>
+    template <typename TValue>
+    class FlatStringMap
+    {
+       public:
+        using value_type = std::pair<std::string, TValue>;
+        using iterator = typename std::vector<value_type>::iterator;
+        using const_iterator = typename std::vector<value_type>::const_iterator;
+
+        static constexpr size_t LinearScanLimit = 8;
+        static constexpr size_t InitialCapacity = 16;
+
+        FlatStringMap() = default;
+
+        TValue& operator[](const std::string& key)
+        {
+            m_version++;
+            size_t pos = lookup(key);
+            if (pos != npos)
+            {
+                return m_entries[pos].second;
+            }
+            return append(key, TValue());
+        }
+
+        /// <summary>
+        /// Sets the value of an existing key, or appends a new entry
+        /// constructed directly from the value (no default-constructed
+        /// placeholder, unlike operator[]).
+        /// </summary>
+        /// <returns>true if a new entry was added</returns>
+        template <typename TArg>
+        bool insert_or_assign(const std::string& key, TArg&& value)
+        {
+            m_version++;
+            size_t pos = lookup(key);
+            if (pos != npos)
+            {
+                m_entries[pos].second = std::forward<TArg>(value);
+                return false;
+            }
+            append(key, std::forward<TArg>(value));
+            return true;
+        }
+
+        iterator find(const std::string& key)
+        {
+            m_version++;
+            size_t pos = lookup(key);
+            return (pos != npos) ? (m_entries.begin() + pos) : m_entries.end();
+        }
+
+        const_iterator find(const std::string& key) const
+        {
+            size_t pos = lookup(key);
+            return (pos != npos) ? (m_entries.cbegin() + pos) : m_entries.cend();
+        }
+
+        size_t erase(const std::string& key)
+        {
+            size_t pos = lookup(key);
+            if (pos == npos)
+            {
+                return 0;
+            }
+            m_version++;
+            m_entries.erase(m_entries.begin() + pos);
+            rebuildIndex();
+            return 1;
+        }
+
+        void clear() noexcept
+        {
+            m_version++;
+            m_entries.clear();
+            m_slots.clear();
+        }
+
+        void reserve(size_t count)
+        {
+            m_entries.reserve(count);
+        }
+
+        size_t size() const noexcept
+        {
+            return m_entries.size();
+        }
+
+        bool empty() const noexcept
+        {
+            return m_entries.empty();
+        }
+
+        iterator begin()
+        {
+            m_version++;
+            return m_entries.begin();
+        }
+
+        iterator end()
+        {
+            return m_entries.end();
+        }
+
+        const_iterator begin() const noexcept
+        {
+            return m_entries.cbegin();
+        }
+
+        const_iterator end() const noexcept
+        {
+            return m_entries.cend();
+        }
+
+        const_iterator cbegin() const noexcept
+        {
+            return m_entries.cbegin();
+        }
+
+        const_iterator cend() const noexcept
+        {
+            return m_entries.cend();
+        }
+
+        uint64_t Version() const noexcept
+        {
+            return m_version;
+        }
+
+       protected:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        template <typename TArg>
+        TValue& append(const std::string& key, TArg&& value)
+        {
+            if (m_entries.capacity() == 0)
+            {
+                // Values may not be nothrow-movable, so growing the vector
+                // copies them; start with room for a typical event.
+                m_entries.reserve(InitialCapacity);
+            }
+            m_entries.emplace_back(key, std::forward<TArg>(value));
+            indexEntry(m_entries.size() - 1);
+            return m_entries.back().second;
+        }
+
+        size_t lookup(const std::string& key) const
+        {
+            if (m_slots.empty())
+            {
+                for (size_t i = 0; i < m_entries.size(); i++)
+                {
+                    if (m_entries[i].first == key)
+                    {
+                        return i;
+                    }
+                }
+                return npos;
+            }
+            size_t mask = m_slots.size() - 1;
+            for (size_t slot = std::hash<std::string>()(key) & mask;; slot = (slot + 1) & mask)
+            {
+                uint32_t entry = m_slots[slot];
+                if (entry == 0)
+                {
+                    return npos;
+                }
+                if (m_entries[entry - 1].first == key)
+                {
+                    return entry - 1;
+                }
+            }
+        }
+
+        void indexEntry(size_t pos)
+        {
+            if (m_entries.size() <= LinearScanLimit)
+            {
+                return;
+            }
+            // Keep the load factor at or below one half
+            if (m_entries.size() * 2 > m_slots.size())
+            {
+                rebuildIndex();
+                return;
+            }
+            insertSlot(pos);
+        }
+
+        void insertSlot(size_t pos)
+        {
+            size_t mask = m_slots.size() - 1;
+            size_t slot = std::hash<std::string>()(m_entries[pos].first) & mask;
+            while (m_slots[slot] != 0)
+            {
+                slot = (slot + 1) & mask;
+            }
+            m_slots[slot] = static_cast<uint32_t>(pos + 1);
+        }
+
+        void rebuildIndex()
+        {
+            if (m_entries.size() <= LinearScanLimit)
+            {
+                m_slots.clear();
+                return;
+            }
+            size_t capacity = LinearScanLimit * 2;
+            while (capacity < m_entries.size() * 4)
+            {
+                capacity <<= 1;
+            }
+            m_slots.assign(capacity, 0);
+            for (size_t i = 0; i < m_entries.size(); i++)
+            {
+                insertSlot(i);
+            }
+        }
+
+        std::vector<value_type> m_entries;
+        // Open-addressing table of (entry position + 1); zero marks an empty slot
+        std::vector<uint32_t> m_slots;
+        uint64_t m_version = 1;
+    };
+
+    template <typename TValue>
+    constexpr size_t FlatStringMap<TValue>::LinearScanLimit;
+
+    template <typename TValue>
+    constexpr size_t FlatStringMap<TValue>::InitialCapacity;
+
+    template <typename TValue>
+    constexpr size_t FlatStringMap<TValue>::npos;
+
+}
+MAT_NS_END
+
+#endif
@@ -0,0 +1,214 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+#include "MappedFile.hpp"
+#include "pal/PAL.hpp"
+
+#ifdef _WIN32
+#include "utils/StringConversion.hpp"
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace MAT_NS_BEGIN
+{
+    MappedFile::MappedFile() noexcept :
+        m_data(nullptr),
+        m_size(0)
+#ifdef _WIN32
+        ,
+        m_file(INVALID_HANDLE_VALUE),
+        m_mapping(nullptr)
+#endif
+    {
+    }
+
+    MappedFile::~MappedFile() noexcept
+    {
+        Close();
+    }
+
+#if defined(_WIN32) && !defined(_WINRT)
+
+    bool MappedFile::Open(std::string const& path, size_t size)
+    {
+        Close();
+        if (size == 0)
+        {
+            return false;
+        }
+        std::wstring path_w = to_utf16_string(path);
+        HANDLE file = ::CreateFileW(path_w.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        LARGE_INTEGER length;
+        length.QuadPart = static_cast<LONGLONG>(size);
+        HANDLE mapping = nullptr;
+        if (::SetFilePointerEx(file, length, nullptr, FILE_BEGIN) && ::SetEndOfFile(file))
+        {
+            mapping = ::CreateFileMappingW(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size), nullptr);
+        }
+        void* data = (mapping != nullptr) ? ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size) : nullptr;
+        if (data == nullptr)
+        {
+            if (mapping != nullptr)
+            {
+                ::CloseHandle(mapping);
+            }
+            ::CloseHandle(file);
+            return false;
+        }
+        m_file = file;
+        m_mapping = mapping;
+        m_data = static_cast<uint8_t*>(data);
+        m_size = size;
+        return true;
+    }
+
+    void MappedFile::Close() noexcept
+    {
+        if (m_data != nullptr)
+        {
+            ::UnmapViewOfFile(m_data);
+            m_data = nullptr;
+        }
+        if (m_mapping != nullptr)
+        {
+            ::CloseHandle(m_mapping);
+            m_mapping = nullptr;
+        }
+        if (m_file != INVALID_HANDLE_VALUE)
+        {
+            ::CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+        m_size = 0;
+    }
+
+    bool MappedFile::Flush() noexcept
+    {
+        if (m_data == nullptr)
+        {
+            return false;
+        }
+        return ::FlushViewOfFile(m_data, m_size) && ::FlushFileBuffers(m_file);
+    }
+
+#elif defined(_WIN32)
+
+    // CreateFileMappingW is not available to UWP apps
+    bool MappedFile::Open(std::string const& path, size_t size)
+    {
+        UNREFERENCED_PARAMETER(path);
+        UNREFERENCED_PARAMETER(size);
+        return false;
+    }
+
+    void MappedFile::Close() noexcept
+    {
+    }
+
+    bool MappedFile::Flush() noexcept
+    {
+        return false;
+    }
+
+#else
+
+    /// <summary>
+    /// Allocate disk blocks for the first size bytes of the file. Stores through a
+    /// shared mapping into a hole that the file system cannot fill raise SIGBUS,
+    /// so running out of space must surface here rather than on first write.
+    /// </summary>
+    static bool ReserveBlocks(int fd, size_t from, size_t size)
+    {
+#ifndef __APPLE__
+        int rc = ::posix_fallocate(fd, 0, static_cast<off_t>(size));
+        if (rc != EOPNOTSUPP && rc != ENOSYS)
+        {
+            return rc == 0;
+        }
+#endif
+        // No preallocation support: write zeros over the part the file grows into
+        static const uint8_t zeros[4096] = {};
+        while (from < size)
+        {
+            size_t chunk = (size - from < sizeof(zeros)) ? (size - from) : sizeof(zeros);
+            ssize_t written = ::pwrite(fd, zeros, chunk, static_cast<off_t>(from));
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (written <= 0)
+            {
+                return false;
+            }
+            from += static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    bool MappedFile::Open(std::string const& path, size_t size)
+    {
+        Close();
+        if (size == 0)
+        {
+            return false;
+        }
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 ||
+            (static_cast<size_t>(st.st_size) > size && ::ftruncate(fd, static_cast<off_t>(size)) != 0) ||
+            !ReserveBlocks(fd, static_cast<size_t>(st.st_size), size))
+        {
+            ::close(fd);
+            return false;
+        }
+        void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        // The mapping keeps the file open
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            return false;
+        }
+        m_data = static_cast<uint8_t*>(data);
+        m_size = size;
+        return true;
+    }
+
+    void MappedFile::Close() noexcept
+    {
+        if (m_data != nullptr)
+        {
+            ::munmap(m_data, m_size);
+            m_data = nullptr;
+        }
+        m_size = 0;
+    }
+
+    bool MappedFile::Flush() noexcept
+    {
+        if (m_data == nullptr)
+        {
+            return false;
+        }
+        return ::msync(m_data, m_size, MS_SYNC) == 0;
+    }
+
+#endif
+
+}
+MAT_NS_END
@@ -0,0 +1,71 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include "ctmacros.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Read-write shared mapping of a whole file of fixed size. Writes to Data()
+    /// reach the file through the page cache; Flush waits until they are on disk.
+    /// </summary>
+    class MappedFile
+    {
+       public:
+        MappedFile() noexcept;
+        ~MappedFile() noexcept;
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        /// <summary>
+        /// Open or create the file (UTF-8 path), set its size to size bytes and map it.
+        /// Bytes added by growing the file read as zero. On POSIX the disk blocks are
+        /// allocated up front, so Open fails when the disk is full instead of a later
+        /// store into the mapping raising SIGBUS.
+        /// </summary>
+        bool Open(std::string const& path, size_t size);
+
+        void Close() noexcept;
+
+        /// <summary>
+        /// Write the mapped pages back to the file and wait for the disk.
+        /// </summary>
+        bool Flush() noexcept;
+
+        bool IsOpen() const noexcept
+        {
+            return m_data != nullptr;
+        }
+
+        uint8_t* Data() const noexcept
+        {
+            return m_data;
+        }
+
+        size_t Size() const noexcept
+        {
+            return m_size;
+        }
+
+       protected:
+        uint8_t* m_data;
+        size_t m_size;
+#ifdef _WIN32
+        void* m_file;
+        void* m_mapping;
+#endif
+    };
+
+}
+MAT_NS_END
+
+#endif
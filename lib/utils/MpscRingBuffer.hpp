@@ -0,0 +1,155 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef MPSCRINGBUFFER_HPP
+#define MPSCRINGBUFFER_HPP
+
+#include "ctmacros.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Bounded lock-free ring buffer (D. Vyukov's sequence-per-cell algorithm).
+    /// Any number of threads may Push concurrently. Pop is normally called
+    /// by a single consumer, but it is also safe for producers to Pop in
+    /// order to evict the oldest element when the buffer is full.
+    /// Capacity is rounded up to the next power of two.
+    /// </summary>
+    template <typename T>
+    class MpscRingBuffer
+    {
+       public:
+        explicit MpscRingBuffer(size_t capacity) :
+            m_mask(roundUpToPowerOfTwo(capacity) - 1),
+            m_cells(new Cell[m_mask + 1]),
+            m_enqueuePos(0),
+            m_dequeuePos(0)
+        {
+            for (size_t i = 0; i <= m_mask; i++)
+            {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscRingBuffer(MpscRingBuffer const&) = delete;
+        MpscRingBuffer& operator=(MpscRingBuffer const&) = delete;
+
+        /// <summary>
+        /// Append an element. Returns false without blocking if the buffer is full.
+        /// </summary>
+        bool Push(T&& value)
+        {
+            size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell& cell = m_cells[pos & m_mask];
+                size_t seq = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0)
+                {
+                    if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        cell.value = std::move(value);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = m_enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Remove the oldest element. Returns false if the buffer is empty.
+        /// </summary>
+        bool Pop(T& value)
+        {
+            size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell& cell = m_cells[pos & m_mask];
+                size_t seq = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+                if (diff == 0)
+                {
+                    if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        value = std::move(cell.value);
+                        cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = m_dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Approximate number of queued elements (exact when quiescent).
+        /// </summary>
+        size_t Size() const noexcept
+        {
+            size_t head = m_dequeuePos.load(std::memory_order_acquire);
+            size_t tail = m_enqueuePos.load(std::memory_order_acquire);
+            return (tail > head) ? (tail - head) : 0;
+        }
+
+        bool Empty() const noexcept
+        {
+            return Size() == 0;
+        }
+
+        size_t Capacity() const noexcept
+        {
+            return m_mask + 1;
+        }
+
+       protected:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        static size_t roundUpToPowerOfTwo(size_t value) noexcept
+        {
+            size_t result = 2;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        const size_t m_mask;
+        std::unique_ptr<Cell[]> m_cells;
+        // Padding keeps producer and consumer cursors on separate cache lines
+        char m_pad0[64];
+        std::atomic<size_t> m_enqueuePos;
+        char m_pad1[64];
+        std::atomic<size_t> m_dequeuePos;
+    };
+
+}
+MAT_NS_END
+
+#endif
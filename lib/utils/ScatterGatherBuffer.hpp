@@ -0,0 +1,121 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef SCATTERGATHERBUFFER_HPP
+#define SCATTERGATHERBUFFER_HPP
+
+#include "ctmacros.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace MAT_NS_BEGIN
+{
+    /// <summary>
+    /// Read-only view of a byte range inside a shared blob. The view keeps
+    /// the blob alive, so it may outlive whoever produced the bytes.
+    /// </summary>
+    struct BlobView
+    {
+        std::shared_ptr<const std::vector<uint8_t>> blob;
+        size_t offset;
+        size_t length;
+
+        uint8_t const* data() const noexcept
+        {
+            return blob->data() + offset;
+        }
+    };
+
+    /// <summary>
+    /// Payload made of a sequence of blob views, e.g. the spliced records of
+    /// an upload. Consumers walk the views instead of requiring one
+    /// contiguous copy; gather() produces that copy only when unavoidable.
+    /// </summary>
+    class ScatterGatherBuffer
+    {
+       public:
+        /// <summary>
+        /// Appends a view. A view that continues the previous one in the
+        /// same blob extends it instead of adding a new entry.
+        /// </summary>
+        void append(BlobView const& view)
+        {
+            if (view.length == 0)
+            {
+                return;
+            }
+            m_size += view.length;
+            if (!m_views.empty())
+            {
+                BlobView& last = m_views.back();
+                if (last.blob == view.blob && last.offset + last.length == view.offset)
+                {
+                    last.length += view.length;
+                    return;
+                }
+            }
+            m_views.push_back(view);
+        }
+
+        std::vector<BlobView> const& views() const noexcept
+        {
+            return m_views;
+        }
+
+        size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        bool empty() const noexcept
+        {
+            return m_size == 0;
+        }
+
+        /// <summary>
+        /// Replaces the contents of output with the concatenated views.
+        /// </summary>
+        void gather(std::vector<uint8_t>& output) const
+        {
+            output.clear();
+            output.reserve(m_size);
+            for (BlobView const& view : m_views)
+            {
+                output.insert(output.end(), view.data(), view.data() + view.length);
+            }
+        }
+
+        /// <summary>
+        /// Moves the views out and leaves the buffer empty. A consumer can
+        /// then release each blob as soon as it is done with it.
+        /// </summary>
+        std::vector<BlobView> take() noexcept
+        {
+            std::vector<BlobView> result;
+            result.swap(m_views);
+            m_size = 0;
+            return result;
+        }
+
+        /// <summary>
+        /// Drops all views, releasing blobs no longer referenced elsewhere.
+        /// </summary>
+        void clear() noexcept
+        {
+            std::vector<BlobView>().swap(m_views);
+            m_size = 0;
+        }
+
+       protected:
+        std::vector<BlobView> m_views;
+        size_t m_size = 0;
+    };
+
+}
+MAT_NS_END
+
+#endif
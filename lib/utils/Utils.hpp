@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <string>
 #include <cstdio>
+#include <vector>
 
 #include "EventProperty.hpp"
 
@@ -75,6 +76,30 @@ namespace MAT_NS_BEGIN {
 
     EventRejectedReason validatePropertyName(std::string const& name);
 
+    /// <summary>
+    /// Moves the items whose flag is set to the front, keeping the order of
+    /// both the flagged and the other items, and returns how many were flagged.
+    /// </summary>
+    template <typename T>
+    size_t moveFlaggedToFront(std::vector<T>& items, std::vector<bool> const& flags)
+    {
+        std::vector<T> rest;
+        size_t front = 0;
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            if (!flags[i])
+            {
+                rest.push_back(std::move(items[i]));
+            }
+            else if (front++ != i)
+            {
+                items[front - 1] = std::move(items[i]);
+            }
+        }
+        std::move(rest.begin(), rest.end(), items.begin() + front);
+        return front;
+    }
+
     inline std::string tenantTokenToId(std::string const& tenantToken)
     {
         return tenantToken.substr(0, tenantToken.find('-'));
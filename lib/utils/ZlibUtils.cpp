@@ -13,17 +13,14 @@
 
 namespace MAT_NS_BEGIN
 {
-    bool ZlibUtils::InflateVector(const std::vector<uint8_t>& in, std::vector<uint8_t>& out, bool isGzip)
-    {
 #ifdef HAVE_MAT_ZLIB
+    static bool InflateWith(const std::vector<uint8_t>& in, std::vector<uint8_t>& out, int windowBits, const std::vector<uint8_t>* dictionary)
+    {
         bool result = true;
 
         z_stream zs;
         memset(&zs, 0, sizeof(zs));
 
-        // "deflate": negative -MAX_WBITS argument which makes zlib use "raw deflate" format,
-        // "gzip": Add 16 to windowBits to decode a simple gzip header
-        int windowBits = isGzip ? (MAX_WBITS | 16) : -MAX_WBITS;
         if (inflateInit2(&zs, windowBits) != Z_OK)
         {
             return false;
@@ -44,6 +41,11 @@ namespace MAT_NS_BEGIN
             zs.next_out = reinterpret_cast<Bytef*>(outbuffer);
             zs.avail_out = outbufferSize;
             ret = inflate(&zs, Z_NO_FLUSH);
+            if (ret == Z_NEED_DICT && dictionary != nullptr)
+            {
+                ret = inflateSetDictionary(&zs, dictionary->data(), static_cast<uInt>(dictionary->size()));
+                dictionary = nullptr;
+            }
             out.insert(out.end(), outbuffer, outbuffer + (outbufferSize - zs.avail_out));
         } while (ret == Z_OK);
         if (ret != Z_STREAM_END)
@@ -54,6 +56,15 @@ namespace MAT_NS_BEGIN
         inflateEnd(&zs);
         delete[] outbuffer;
         return result;
+    }
+#endif
+
+    bool ZlibUtils::InflateVector(const std::vector<uint8_t>& in, std::vector<uint8_t>& out, bool isGzip)
+    {
+#ifdef HAVE_MAT_ZLIB
+        // "deflate": negative -MAX_WBITS argument which makes zlib use "raw deflate" format,
+        // "gzip": Add 16 to windowBits to decode a simple gzip header
+        return InflateWith(in, out, isGzip ? (MAX_WBITS | 16) : -MAX_WBITS, nullptr);
 #else
         UNREFERENCED_PARAMETER(in);
         UNREFERENCED_PARAMETER(out);
@@ -62,4 +73,17 @@ namespace MAT_NS_BEGIN
 #endif
     }
 
+    bool ZlibUtils::InflateVector(const std::vector<uint8_t>& in, std::vector<uint8_t>& out, const std::vector<uint8_t>& dictionary)
+    {
+#ifdef HAVE_MAT_ZLIB
+        // zlib header: inflate asks for the dictionary it carries the Adler-32 of
+        return InflateWith(in, out, MAX_WBITS, &dictionary);
+#else
+        UNREFERENCED_PARAMETER(in);
+        UNREFERENCED_PARAMETER(out);
+        UNREFERENCED_PARAMETER(dictionary);
+        return false;
+#endif
+    }
+
 } MAT_NS_END
@@ -15,6 +15,11 @@ namespace MAT_NS_BEGIN
     {
         public:
             static bool InflateVector(const std::vector<uint8_t>& in, std::vector<uint8_t>& out, bool isGzip);
+
+            /// <summary>
+            /// Inflates a zlib stream compressed with the given preset dictionary.
+            /// </summary>
+            static bool InflateVector(const std::vector<uint8_t>& in, std::vector<uint8_t>& out, const std::vector<uint8_t>& dictionary);
     };
 
 } MAT_NS_END
@@ -0,0 +1,100 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "AllocationCounter.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // Per-thread so that multi-threaded benchmarks only see their own allocations
+    thread_local uint64_t s_allocations = 0;
+    thread_local int64_t s_liveBytes = 0;
+    thread_local int64_t s_peakBytes = 0;
+
+    // Each block is prefixed with its size; the header keeps the block
+    // aligned for any fundamental type.
+    constexpr std::size_t HeaderSize = alignof(std::max_align_t) > sizeof(std::size_t) ? alignof(std::max_align_t) : sizeof(std::size_t);
+
+    void* countedAlloc(std::size_t size)
+    {
+        s_allocations++;
+        void* ptr = std::malloc(HeaderSize + (size ? size : 1));
+        if (ptr == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        *static_cast<std::size_t*>(ptr) = size;
+        s_liveBytes += static_cast<int64_t>(size);
+        if (s_liveBytes > s_peakBytes)
+        {
+            s_peakBytes = s_liveBytes;
+        }
+        return static_cast<char*>(ptr) + HeaderSize;
+    }
+
+    void countedFree(void* ptr) noexcept
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+        void* block = static_cast<char*>(ptr) - HeaderSize;
+        s_liveBytes -= static_cast<int64_t>(*static_cast<std::size_t*>(block));
+        std::free(block);
+    }
+}
+
+uint64_t benchmarks::GetAllocationCount() noexcept
+{
+    return s_allocations;
+}
+
+int64_t benchmarks::GetLiveBytes() noexcept
+{
+    return s_liveBytes;
+}
+
+int64_t benchmarks::GetPeakBytes() noexcept
+{
+    return s_peakBytes;
+}
+
+void benchmarks::ResetPeakBytes() noexcept
+{
+    s_peakBytes = s_liveBytes;
+}
+
+void* operator new(std::size_t size)
+{
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    countedFree(ptr);
+}
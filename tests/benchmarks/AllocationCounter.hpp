@@ -0,0 +1,54 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#ifndef ALLOCATIONCOUNTER_HPP
+#define ALLOCATIONCOUNTER_HPP
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+namespace benchmarks
+{
+    /// <summary>
+    /// Number of global operator new calls made by the calling thread so far.
+    /// </summary>
+    uint64_t GetAllocationCount() noexcept;
+
+    /// <summary>
+    /// Bytes currently allocated through global operator new by the calling
+    /// thread, and the highest value seen since the last ResetPeakBytes().
+    /// Memory freed by another thread is not credited back.
+    /// </summary>
+    int64_t GetLiveBytes() noexcept;
+    int64_t GetPeakBytes() noexcept;
+    void ResetPeakBytes() noexcept;
+
+    /// <summary>
+    /// Counts allocations made between construction and Report(), and
+    /// publishes them as an "allocs/event" average per benchmark iteration.
+    /// </summary>
+    class ScopedAllocationCounter
+    {
+       public:
+        explicit ScopedAllocationCounter(benchmark::State& state) :
+            m_state(state),
+            m_start(GetAllocationCount())
+        {
+        }
+
+        void Report(double eventsPerIteration = 1.0)
+        {
+            double allocs = static_cast<double>(GetAllocationCount() - m_start);
+            double events = static_cast<double>(m_state.iterations()) * eventsPerIteration;
+            m_state.counters["allocs/event"] = benchmark::Counter((events > 0) ? allocs / events : 0, benchmark::Counter::kAvgThreads);
+        }
+
+       protected:
+        benchmark::State& m_state;
+        uint64_t m_start;
+    };
+}
+
+#endif
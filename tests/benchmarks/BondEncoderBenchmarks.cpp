@@ -0,0 +1,98 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "AllocationCounter.hpp"
+
+#include "NullObjects.hpp"
+#include "bond/All.hpp"
+#include "bond/EventPropertiesBondEncoder.hpp"
+#include "bond/generated/CsProtocol_writers.hpp"
+#include "decorators/EventPropertiesDecorator.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace MAT;
+
+namespace
+{
+    EventProperties MakeEvent(size_t count)
+    {
+        EventProperties props("Contoso.Benchmark.Event");
+        for (size_t i = 0; i < count; i++)
+        {
+            std::string name = "Contoso.Prop" + std::to_string(i);
+            if (i % 2)
+            {
+                props.SetProperty(name, static_cast<int64_t>(i));
+            }
+            else
+            {
+                props.SetProperty(name, "string value of moderate length");
+            }
+        }
+        return props;
+    }
+
+    ::CsProtocol::Record MakeRecord()
+    {
+        ::CsProtocol::Record record;
+        record.ver = "3.0";
+        record.name = "Contoso.Benchmark.Event";
+        record.iKey = "o:0123456789abcdef";
+        record.extSdk.push_back(::CsProtocol::Sdk());
+        record.extSdk[0].epoch = "epoch";
+        record.extSdk[0].installId = "installId";
+        record.data.push_back(::CsProtocol::Data());
+        record.data[0].properties["AppInfo.Language"].stringValue = "en-US";
+        return record;
+    }
+}
+
+/// Reference point: copy the properties into the record, then serialize it.
+static void BM_Bond_DecorateAndSerializeRecord(benchmark::State& state)
+{
+    NullLogManager logManager;
+    EventPropertiesDecorator decorator(logManager);
+    EventProperties props = MakeEvent(static_cast<size_t>(state.range(0)));
+    const ::CsProtocol::Record source = MakeRecord();
+    std::vector<uint8_t> blob;
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        ::CsProtocol::Record record = source;
+        EventLatency latency = EventLatency_Normal;
+        decorator.decorate(record, latency, props);
+        blob.clear();
+        bond_lite::CompactBinaryProtocolWriter writer(blob);
+        bond_lite::Serialize(writer, record);
+        benchmark::DoNotOptimize(blob.data());
+    }
+    allocs.Report();
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * blob.size()));
+}
+BENCHMARK(BM_Bond_DecorateAndSerializeRecord)->Arg(10)->Arg(40);
+
+static void BM_Bond_DeferAndEncodeProperties(benchmark::State& state)
+{
+    NullLogManager logManager;
+    EventPropertiesDecorator decorator(logManager);
+    EventProperties props = MakeEvent(static_cast<size_t>(state.range(0)));
+    const ::CsProtocol::Record source = MakeRecord();
+    std::vector<uint8_t> blob;
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        ::CsProtocol::Record record = source;
+        EventLatency latency = EventLatency_Normal;
+        decorator.decorate(record, latency, props, true);
+        blob.clear();
+        EventPropertiesBondEncoder::Encode(blob, record, props);
+        benchmark::DoNotOptimize(blob.data());
+    }
+    allocs.Report();
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * blob.size()));
+}
+BENCHMARK(BM_Bond_DeferAndEncodeProperties)->Arg(10)->Arg(40);
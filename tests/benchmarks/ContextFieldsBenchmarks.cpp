@@ -0,0 +1,93 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "AllocationCounter.hpp"
+
+#include "api/ContextFieldsProvider.hpp"
+#include "bond/All.hpp"
+#include "bond/generated/CsProtocol_writers.hpp"
+
+using namespace MAT;
+
+namespace
+{
+    void PopulateContext(ContextFieldsProvider& ctx)
+    {
+        ctx.SetAppId("Contoso.Benchmarks");
+        ctx.SetAppVersion("1.2.3");
+        ctx.SetAppLanguage("en-US");
+        ctx.SetAppExperimentIds("exp1;exp2");
+        ctx.SetDeviceId("4f5e6d7c-8b9a-0f1e-2d3c-4b5a69788796");
+        ctx.SetDeviceMake("Contoso");
+        ctx.SetDeviceModel("Model 1");
+        ctx.SetOsName("Linux");
+        ctx.SetOsBuild("5.15");
+        ctx.SetUserId("user@contoso.com", PiiKind_Identity);
+        ctx.SetUserTimeZone("-08:00");
+        ctx.SetNetworkProvider("Contoso Wireless");
+        ctx.SetCustomField("Session.Flavor", "benchmark");
+    }
+
+    /// <summary>
+    /// Decorates and serializes one event. A record that already carries
+    /// an extension takes the field-by-field path in writeToRecord.
+    /// </summary>
+    void DecorateAndSerialize(ContextFieldsProvider& ctx, bool fieldByField, bool splice, std::vector<uint8_t>& blob)
+    {
+        ::CsProtocol::Record record;
+        record.ver = "3.0";
+        record.name = "Contoso.Benchmark.SampleEvent";
+        record.iKey = "o:0c21c15bdccc48c99678a748488bb87f";
+        if (fieldByField)
+        {
+            record.extM365a.push_back(::CsProtocol::M365a());
+        }
+        auto snapshot = ctx.writeToRecord(record, false, splice);
+        std::vector<uint8_t> const* extensions = nullptr;
+        if (splice && snapshot)
+        {
+            extensions = &snapshot->encodedExtensions;
+        }
+        blob.clear();
+        bond_lite::CompactBinaryProtocolWriter writer(blob);
+        bond_lite::Serialize(writer, record, false, extensions);
+    }
+
+    void RunContextBenchmark(benchmark::State& state, bool fieldByField, bool splice)
+    {
+        ContextFieldsProvider parent(nullptr);
+        ContextFieldsProvider ctx(&parent);
+        PopulateContext(parent);
+
+        std::vector<uint8_t> blob;
+        size_t bytes = 0;
+        benchmarks::ScopedAllocationCounter allocs(state);
+        for (auto _ : state)
+        {
+            DecorateAndSerialize(ctx, fieldByField, splice, blob);
+            bytes += blob.size();
+        }
+        allocs.Report();
+        state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    }
+}
+
+static void BM_Context_FieldByField(benchmark::State& state)
+{
+    RunContextBenchmark(state, true, false);
+}
+BENCHMARK(BM_Context_FieldByField);
+
+static void BM_Context_Snapshot(benchmark::State& state)
+{
+    RunContextBenchmark(state, false, false);
+}
+BENCHMARK(BM_Context_Snapshot);
+
+static void BM_Context_SnapshotSpliced(benchmark::State& state)
+{
+    RunContextBenchmark(state, false, true);
+}
+BENCHMARK(BM_Context_SnapshotSpliced);
@@ -0,0 +1,247 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "AllocationCounter.hpp"
+
+#include "bond/All.hpp"
+#include "bond/generated/CsProtocol_writers.hpp"
+#include "compression/CompressorFactory.hpp"
+#include "compression/DeflateStream.hpp"
+#include "compression/HttpDeflateCompression.hpp"
+#include "config/RuntimeConfig_Default.hpp"
+#include "packager/Packager.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace MAT;
+
+namespace
+{
+    /// <summary>
+    /// A Common Schema 4.0 record as the SDK stores it: Part A extensions
+    /// filled from the context, a mix of string, integer and GUID-like
+    /// Part C properties, and per-event values that differ between records.
+    /// </summary>
+    std::vector<uint8_t> MakeRecordBlob(int i)
+    {
+        ::CsProtocol::Record record;
+        record.ver = "3.0";
+        record.name = (i % 4) ? "Contoso.Product.FeatureUsed" : "Contoso.Product.SessionHeartbeat";
+        record.time = 637000000000000000LL + i * 12345;
+        record.iKey = (i % 3) ? "o:7c8b1796cbc44bd5a03803c01c2b9d61" : "o:4bb4d6f7cafc4e9292f972dca2dcde42";
+        record.popSample = 100.0;
+        record.flags = 257;
+        record.extSdk.push_back(::CsProtocol::Sdk());
+        record.extSdk[0].libVer = "EVT-Linux-C++-No-3.7.62.1";
+        record.extSdk[0].epoch = "28EC4DA3-A25E-5088-E463-6BB1E95E2580";
+        record.extSdk[0].installId = "3667834F-915C-1355-F82-46C31F15F12C";
+        record.extSdk[0].seq = i;
+        record.extApp.push_back(::CsProtocol::App());
+        record.extApp[0].id = "Contoso.Product";
+        record.extApp[0].ver = "16.0.14326.20404";
+        record.extApp[0].locale = "en-US";
+        record.extDevice.push_back(::CsProtocol::Device());
+        record.extDevice[0].localId = "c:67e3d13727e94486a0cd8c0d55eeb41b";
+        record.extDevice[0].deviceClass = "Linux.Desktop";
+        record.extOs.push_back(::CsProtocol::Os());
+        record.extOs[0].name = "Debian GNU/Linux";
+        record.extOs[0].ver = "12 (bookworm)";
+        record.extUser.push_back(::CsProtocol::User());
+        record.extUser[0].localId = "u:0f67c3ce89e747db90901b9998a100a0";
+        record.extNet.push_back(::CsProtocol::Net());
+        record.extNet[0].cost = "Unmetered";
+        record.extNet[0].type = "Wired";
+        record.extProtocol.push_back(::CsProtocol::Protocol());
+
+        record.data.push_back(::CsProtocol::Data());
+        auto& properties = record.data[0].properties;
+        properties["Session.Id"].stringValue = "39d9160f-396d-4427-ad76-9dedc5dea386";
+        properties["Feature.Name"].stringValue = "Feature" + std::to_string(i % 37);
+        properties["Feature.Result"].stringValue = (i % 5) ? "Success" : "Cancelled";
+        properties["Activity.CorrelationId"].stringValue = std::to_string(i * 2654435761u) + "-" + std::to_string(i);
+        properties["Activity.Duration"].type = ::CsProtocol::ValueKind::ValueInt64;
+        properties["Activity.Duration"].longValue = (i * 7919) % 100000;
+        properties["Activity.Count"].type = ::CsProtocol::ValueKind::ValueInt64;
+        properties["Activity.Count"].longValue = i % 13;
+        properties["Document.SizeBytes"].type = ::CsProtocol::ValueKind::ValueInt64;
+        properties["Document.SizeBytes"].longValue = (i * 104729) % 10000000;
+
+        std::vector<uint8_t> blob;
+        bond_lite::CompactBinaryProtocolWriter writer(blob);
+        bond_lite::Serialize(writer, record);
+        return blob;
+    }
+
+    std::vector<StorageRecord> MakeStoredRecords(size_t count)
+    {
+        std::vector<StorageRecord> result;
+        for (size_t i = 0; i < count; i++)
+        {
+            int n = static_cast<int>(i);
+            result.emplace_back("r" + std::to_string(n), (n % 3) ? "tenant1-token" : "tenant2-token",
+                                EventLatency_Normal, EventPersistence_Normal, 1234567890 + n, MakeRecordBlob(n));
+        }
+        return result;
+    }
+
+    std::vector<BlobView> MakeViews(std::vector<StorageRecord> const& records, size_t& payload)
+    {
+        auto blob = std::make_shared<std::vector<uint8_t>>();
+        for (auto const& record : records)
+        {
+            blob->insert(blob->end(), record.blob.begin(), record.blob.end());
+        }
+        payload = blob->size();
+        return std::vector<BlobView> { BlobView { blob, 0, blob->size() } };
+    }
+
+    DeflateSettings GetSettings(int level, const char* strategy)
+    {
+        ILogConfiguration logConfig;
+        RuntimeConfig_Default config(logConfig);
+        config[CFG_MAP_HTTP][CFG_INT_HTTP_COMPRESSION_LEVEL] = level;
+        config[CFG_MAP_HTTP][CFG_STR_HTTP_COMPRESSION_STRATEGY] = strategy;
+        return DeflateSettings::FromConfig(config);
+    }
+
+    /// <summary>
+    /// Compresses one upload of state.range(0) records. With reuse set the
+    /// stream comes from the thread cache and is only reset per upload.
+    /// </summary>
+    void RunDeflateBenchmark(benchmark::State& state, DeflateSettings const& settings, bool reuse)
+    {
+        auto const records = MakeStoredRecords(static_cast<size_t>(state.range(0)));
+        size_t payload = 0;
+        std::vector<BlobView> const views = MakeViews(records, payload);
+        std::vector<uint8_t> output;
+
+        benchmarks::ScopedAllocationCounter allocs(state);
+        for (auto _ : state)
+        {
+            std::unique_ptr<DeflateStream> stream = reuse ? DeflateStream::Acquire() : std::unique_ptr<DeflateStream>(new DeflateStream());
+            std::vector<BlobView> input = views;
+            stream->begin(settings, output, payload);
+            stream->write(std::move(input));
+            stream->finish();
+            if (reuse)
+            {
+                DeflateStream::Release(std::move(stream));
+            }
+            benchmark::DoNotOptimize(output.data());
+        }
+        allocs.Report(static_cast<double>(records.size()));
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload));
+        state.counters["ratio"] = static_cast<double>(output.size()) / static_cast<double>(payload);
+    }
+
+    class UploadPipeline : public Packager, public HttpDeflateCompression
+    {
+       public:
+        UploadPipeline(IRuntimeConfig& config) :
+            Packager(config),
+            HttpDeflateCompression(config)
+        {
+        }
+
+        using HttpDeflateCompression::handleCompress;
+        using Packager::handleAddEventToPackage;
+        using Packager::handleFinalizePackage;
+    };
+}
+
+static void BM_Deflate_FreshStream(benchmark::State& state)
+{
+    RunDeflateBenchmark(state, GetSettings(-1, "default"), false);
+}
+BENCHMARK(BM_Deflate_FreshStream)->Arg(1)->Arg(10)->Arg(500);
+
+static void BM_Deflate_ReusedStream(benchmark::State& state)
+{
+    RunDeflateBenchmark(state, GetSettings(-1, "default"), true);
+}
+BENCHMARK(BM_Deflate_ReusedStream)->Arg(1)->Arg(10)->Arg(500);
+
+static void BM_Deflate_Level(benchmark::State& state)
+{
+    RunDeflateBenchmark(state, GetSettings(static_cast<int>(state.range(1)), "default"), true);
+}
+BENCHMARK(BM_Deflate_Level)->Args({500, 1})->Args({500, 6})->Args({500, 9});
+
+static void BM_Deflate_Strategy(benchmark::State& state)
+{
+    static const char* const strategies[] = { "default", "filtered", "huffman", "rle" };
+    state.SetLabel(strategies[state.range(1)]);
+    RunDeflateBenchmark(state, GetSettings(-1, strategies[state.range(1)]), true);
+}
+BENCHMARK(BM_Deflate_Strategy)->Args({500, 0})->Args({500, 1})->Args({500, 2})->Args({500, 3});
+
+/// Packages and compresses 500 records, compressing either once the package
+/// is complete or record by record as Packager adds them.
+static void BM_Deflate_Upload(benchmark::State& state)
+{
+    bool streaming = state.range(0) != 0;
+    state.SetLabel(streaming ? "streaming" : "batch");
+    ILogConfiguration logConfig;
+    RuntimeConfig_Default config(logConfig);
+    config[CFG_MAP_HTTP][CFG_BOOL_HTTP_STREAMING_COMPRESSION] = streaming;
+    UploadPipeline pipeline(config);
+    auto const records = MakeStoredRecords(500);
+
+    size_t payload = 0;
+    for (auto const& record : records)
+    {
+        payload += record.blob.size();
+    }
+
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        auto ctx = std::make_shared<EventsUploadContext>();
+        for (auto const& record : records)
+        {
+            bool wantMore = true;
+            pipeline.handleAddEventToPackage(ctx, record, wantMore);
+        }
+        pipeline.handleFinalizePackage(ctx);
+        pipeline.handleCompress(ctx);
+        benchmark::DoNotOptimize(ctx->body.data());
+    }
+    allocs.Report(static_cast<double>(records.size()));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * records.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload));
+}
+BENCHMARK(BM_Deflate_Upload)->Arg(0)->Arg(1);
+
+/// Compresses uploads of 1 and 50 records with each content encoding. The
+/// preset dictionary matters most for small uploads, which have little
+/// history of their own to match against.
+static void BM_Compressor_Encoding(benchmark::State& state)
+{
+    static const char* const encodings[] = { "deflate", "deflate-dict", "zstd" };
+    const char* encoding = encodings[state.range(1)];
+    ILogConfiguration logConfig;
+    RuntimeConfig_Default config(logConfig);
+    config[CFG_MAP_HTTP][CFG_STR_HTTP_CONTENT_ENCODING] = encoding;
+    std::unique_ptr<ICompressor> compressor = CompressorFactory::Create(config);
+    state.SetLabel(compressor->getContentEncoding());
+
+    auto const records = MakeStoredRecords(static_cast<size_t>(state.range(0)));
+    size_t payload = 0;
+    std::vector<BlobView> const views = MakeViews(records, payload);
+    std::vector<uint8_t> output;
+
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        std::vector<BlobView> input = views;
+        compressor->compress(std::move(input), payload, output);
+        benchmark::DoNotOptimize(output.data());
+    }
+    allocs.Report(static_cast<double>(records.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload));
+    state.counters["ratio"] = static_cast<double>(output.size()) / static_cast<double>(payload);
+}
+BENCHMARK(BM_Compressor_Encoding)->Args({1, 0})->Args({1, 1})->Args({1, 2})->Args({50, 0})->Args({50, 1})->Args({50, 2});
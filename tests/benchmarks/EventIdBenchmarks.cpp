@@ -0,0 +1,49 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "AllocationCounter.hpp"
+
+#include "pal/PAL.hpp"
+#include "utils/EventId.hpp"
+
+using namespace MAT;
+
+/// IDs per second generated by state.threads() threads at once. The text
+/// UUID generator shares the std::rand() state between all threads.
+static void BM_EventId_Generate(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        std::string id = EventId::Generate();
+        benchmark::DoNotOptimize(id.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_EventId_Generate)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_EventId_GenerateUuidString(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        std::string id = PAL::generateUuidString();
+        benchmark::DoNotOptimize(id.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_EventId_GenerateUuidString)->ThreadRange(1, 8)->UseRealTime();
+
+/// Formatting for the SQLite events table and back
+static void BM_EventId_TextRoundTrip(benchmark::State& state)
+{
+    std::string const id = EventId::Generate();
+    for (auto _ : state)
+    {
+        std::string text = EventId::ToText(id);
+        EventId::FromText(text);
+        benchmark::DoNotOptimize(text.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_EventId_TextRoundTrip);
@@ -0,0 +1,63 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "AllocationCounter.hpp"
+
+#include "EventProperties.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace MAT;
+
+namespace
+{
+    std::vector<std::string> MakePropertyNames(size_t count)
+    {
+        std::vector<std::string> names;
+        for (size_t i = 0; i < count; i++)
+        {
+            names.push_back("Contoso.Prop" + std::to_string(i));
+        }
+        return names;
+    }
+}
+
+/// Reference point: the std::map<std::string, EventProperty> layout
+/// EventPropertiesStorage used before it switched to FlatStringMap.
+static void BM_StdMap_SetProperties(benchmark::State& state)
+{
+    auto names = MakePropertyNames(static_cast<size_t>(state.range(0)));
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        std::map<std::string, EventProperty> properties;
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            properties[names[i]] = EventProperty(static_cast<int64_t>(i));
+        }
+        benchmark::DoNotOptimize(properties.find(names[0]));
+    }
+    allocs.Report();
+}
+BENCHMARK(BM_StdMap_SetProperties)->Arg(20)->Arg(60);
+
+static void BM_EventProperties_SetProperties(benchmark::State& state)
+{
+    auto names = MakePropertyNames(static_cast<size_t>(state.range(0)));
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        EventProperties properties("Contoso.Benchmark.Event");
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            properties.SetProperty(names[i], static_cast<int64_t>(i));
+        }
+        benchmark::DoNotOptimize(properties.TryGetLevel());
+    }
+    allocs.Report();
+}
+BENCHMARK(BM_EventProperties_SetProperties)->Arg(20)->Arg(60);
@@ -0,0 +1,339 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+
+#include "AllocationCounter.hpp"
+
+#include "common/HttpServer.hpp"
+
+#include "IHttpClient.hpp"
+#include "api/LogManagerFactory.hpp"
+#include "mat.h"
+#include "utils/Utils.hpp"
+
+#ifndef _WIN32
+#include "pal/posix/sysinfo_sources_impl.hpp"
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using namespace MAT;
+using testing::HttpServer;
+
+namespace
+{
+    /// <summary>
+    /// Accepts every request as soon as it is sent, so that uploads cost
+    /// only what the SDK itself does.
+    /// </summary>
+    class NullHttpClient : public IHttpClient
+    {
+       public:
+        IHttpRequest* CreateRequest() override
+        {
+            return new SimpleHttpRequest(std::to_string(++m_requestId));
+        }
+
+        void SendRequestAsync(IHttpRequest* request, IHttpResponseCallback* callback) override
+        {
+            SimpleHttpResponse* response = new SimpleHttpResponse(request->GetId());
+            response->m_result = HttpResult_OK;
+            response->m_statusCode = 200;
+            callback->OnHttpResponse(response);
+        }
+
+        void CancelRequestAsync(std::string const&) override {}
+
+       protected:
+        std::atomic<uint64_t> m_requestId { 0 };
+    };
+
+    /// <summary>
+    /// Counts events handed to the HTTP stack and requests that completed.
+    /// </summary>
+    class UploadListener : public DebugEventListener
+    {
+       public:
+        void OnDebugEvent(DebugEvent& evt) override
+        {
+            switch (evt.type)
+            {
+            case EVT_SENDING:
+                sendingRequests++;
+                sendingEvents += evt.param1;
+                break;
+            case EVT_HTTP_OK:
+            case EVT_HTTP_ERROR:
+            case EVT_HTTP_FAILURE:
+                completedRequests++;
+                break;
+            default:
+                break;
+            }
+        }
+
+        bool IsDrained(size_t events) const
+        {
+            size_t requests = sendingRequests;
+            return sendingEvents >= events && completedRequests >= requests;
+        }
+
+        std::atomic<size_t> sendingRequests { 0 };
+        std::atomic<size_t> sendingEvents { 0 };
+        std::atomic<size_t> completedRequests { 0 };
+    };
+
+    class CollectorHandler : public HttpServer::Callback
+    {
+       public:
+        int onHttpRequest(HttpServer::Request const& request, HttpServer::Response&) override
+        {
+            bytes += request.content.size();
+            return 200;
+        }
+
+        std::atomic<size_t> bytes { 0 };
+    };
+
+    EventProperties MakeEvent(size_t count)
+    {
+        EventProperties props("Contoso.Benchmark.Event");
+        for (size_t i = 0; i < count; i++)
+        {
+            std::string name = "Contoso.Prop" + std::to_string(i);
+            if (i % 2)
+            {
+                props.SetProperty(name, static_cast<int64_t>(i));
+            }
+            else
+            {
+                props.SetProperty(name, "string value of moderate length");
+            }
+        }
+        return props;
+    }
+
+    /// <summary>
+    /// A LogManager without periodic stats events, caching to a fresh file
+    /// in the temp directory that is removed afterwards.
+    /// </summary>
+    class LogManagerFixture
+    {
+       public:
+        explicit LogManagerFixture(std::shared_ptr<IHttpClient> const& httpClient, std::string const& collectorUrl = std::string())
+        {
+            m_path = GetAppLocalTempDirectory() + "LogManagerBenchmarks.db";
+            std::remove(m_path.c_str());
+            config[CFG_STR_CACHE_FILE_PATH] = m_path;
+            config[CFG_MAP_METASTATS_CONFIG][CFG_INT_METASTATS_INTERVAL] = 0;
+            config[CFG_INT_MAX_TEARDOWN_TIME] = 0;
+            if (httpClient)
+            {
+                config.AddModule(CFG_MODULE_HTTP_CLIENT, httpClient);
+            }
+            if (!collectorUrl.empty())
+            {
+                config[CFG_STR_COLLECTOR_URL] = collectorUrl;
+            }
+            logManager.reset(LogManagerFactory::Create(config));
+        }
+
+        ~LogManagerFixture()
+        {
+            logManager.reset();
+            std::remove(m_path.c_str());
+        }
+
+        ILogConfiguration config;
+        std::unique_ptr<ILogManager> logManager;
+
+       protected:
+        std::string m_path;
+    };
+}
+
+/// ILogger::LogEvent for an event with state.range(0) properties, with the
+/// SDK uploading in the background to an HTTP client that accepts
+/// everything. Allocations are counted on the logging thread only.
+static void BM_Logger_LogEvent(benchmark::State& state)
+{
+    LogManagerFixture fixture(std::make_shared<NullHttpClient>());
+    ILogger* logger = fixture.logManager->GetLogger("tenant1-token");
+    EventProperties props = MakeEvent(static_cast<size_t>(state.range(0)));
+
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        logger->LogEvent(props);
+    }
+    allocs.Report();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_Logger_LogEvent)->Arg(10)->Arg(40);
+
+/// ILogger::LogEvent for an event dropped by a CFG_MAP_EVENT_RULES rule,
+/// among state.range(0) prefix rules.
+static void BM_Logger_LogEvent_DroppedByRule(benchmark::State& state)
+{
+    LogManagerFixture fixture(std::make_shared<NullHttpClient>());
+    fixture.logManager.reset();
+    for (int64_t i = 0; i < state.range(0); i++)
+    {
+        std::string name = "rule" + std::to_string(i);
+        fixture.config[CFG_MAP_EVENT_RULES][name.c_str()][CFG_STR_EVENT_RULE_NAME] = "Contoso.Noisy" + std::to_string(i) + ".*";
+    }
+    fixture.logManager.reset(LogManagerFactory::Create(fixture.config));
+    ILogger* logger = fixture.logManager->GetLogger("tenant1-token");
+    EventProperties props = MakeEvent(10);
+    props.SetName("Contoso.Noisy0.Event");
+
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        logger->LogEvent(props);
+    }
+    allocs.Report();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_Logger_LogEvent_DroppedByRule)->Arg(1)->Arg(100);
+
+#ifdef HAVE_MAT_JSONHPP
+/// A C API event with ten Part C properties, logged with evt_log when
+/// state.range(0) is 0, and through a handle from evt_get_logger otherwise.
+/// Transmission is paused, as the C API cannot swap the HTTP client.
+static void BM_CAPI_Log(benchmark::State& state)
+{
+    std::string path = GetAppLocalTempDirectory() + "CAPIBenchmarks.db";
+    std::remove(path.c_str());
+    std::string config = "{ \"name\": \"CAPI-Benchmark\", \"primaryToken\": \"tenant1-token\", \"cacheFilePath\": \"" + path +
+                         "\", \"stats\": { \"interval\": 0 }, \"maxTeardownUploadTimeInSec\": 0 }";
+    evt_handle_t handle = evt_open(config.c_str());
+    evt_pause(handle);
+
+    evt_prop event[] = TELEMETRY_EVENT(
+        _STR(COMMONFIELDS_EVENT_NAME, "Contoso.Benchmark.Event"),
+        _STR(COMMONFIELDS_IKEY, "tenant1-token"),
+        _STR(COMMONFIELDS_EVENT_SOURCE, "benchmark"),
+        _STR("Contoso.Prop0", "string value of moderate length"),
+        _INT("Contoso.Prop1", 1),
+        _STR("Contoso.Prop2", "string value of moderate length"),
+        _INT("Contoso.Prop3", 3),
+        _STR("Contoso.Prop4", "string value of moderate length"),
+        _INT("Contoso.Prop5", 5),
+        _STR("Contoso.Prop6", "string value of moderate length"),
+        _INT("Contoso.Prop7", 7),
+        _STR("Contoso.Prop8", "string value of moderate length"),
+        _INT("Contoso.Prop9", 9));
+    evt_handle_t logger = state.range(0) ? evt_get_logger(handle, "tenant1-token", "benchmark") : 0;
+
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        if (logger != 0)
+        {
+            evt_log_with_logger(logger, event);
+        }
+        else
+        {
+            evt_log(handle, event);
+        }
+    }
+    allocs.Report();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+
+    evt_close(handle);
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_CAPI_Log)->Arg(0)->Arg(1);
+#endif
+
+/// LogManager creation with an existing offline storage file, as on every
+/// start of an app after its first one. Teardown is not timed.
+static void BM_LogManager_Start(benchmark::State& state)
+{
+    LogManagerFixture fixture(std::make_shared<NullHttpClient>());
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        fixture.logManager.reset();
+        state.ResumeTiming();
+        fixture.logManager.reset(LogManagerFactory::Create(fixture.config));
+    }
+}
+BENCHMARK(BM_LogManager_Start)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+#ifndef _WIN32
+/// Uncached lookup of every system information field filled into the
+/// semantic context, as done once per process on the first start.
+static void BM_SysInfo_Probe(benchmark::State& state)
+{
+    static const char* const keys[] = { "devId", "devMake", "devModel", "osName", "osVer", "osRel", "osBuild", "appId", "tz", "devClass" };
+    for (auto _ : state)
+    {
+        sysinfo_sources_impl sysInfo;
+        for (const char* key : keys)
+        {
+            benchmark::DoNotOptimize(sysInfo.get(key).size());
+        }
+    }
+}
+BENCHMARK(BM_SysInfo_Probe)->Unit(benchmark::kMicrosecond);
+#endif
+
+#ifdef HAVE_MAT_DEFAULT_HTTP_CLIENT
+/// Logs state.range(0) events and uploads them to a local HttpServer with
+/// the default HTTP client, waiting until every request has completed.
+/// Bytes are counted as received by the server, after compression.
+static void BM_Upload_Cycle(benchmark::State& state)
+{
+    HttpServer server;
+    CollectorHandler handler;
+    int port = server.addListeningPort(0);
+    std::string host = "localhost:" + std::to_string(port);
+    server.setServerName(host);
+    server.addHandler("/collector/", handler);
+    server.start();
+
+    UploadListener listener;
+    LogManagerFixture fixture(nullptr, "http://" + host + "/collector/");
+    fixture.logManager->AddEventListener(EVT_SENDING, listener);
+    fixture.logManager->AddEventListener(EVT_HTTP_OK, listener);
+    fixture.logManager->AddEventListener(EVT_HTTP_ERROR, listener);
+    fixture.logManager->AddEventListener(EVT_HTTP_FAILURE, listener);
+    ILogger* logger = fixture.logManager->GetLogger("tenant1-token");
+    EventProperties props = MakeEvent(20);
+    size_t const count = static_cast<size_t>(state.range(0));
+
+    size_t logged = 0;
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            logger->LogEvent(props);
+        }
+        logged += count;
+        while (!listener.IsDrained(logged))
+        {
+            fixture.logManager->GetLogController()->UploadNow();
+            PAL::sleep(1);
+        }
+    }
+    allocs.Report(static_cast<double>(count));
+    state.SetItemsProcessed(static_cast<int64_t>(logged));
+    state.SetBytesProcessed(static_cast<int64_t>(handler.bytes.load()));
+
+    fixture.logManager->RemoveEventListener(EVT_SENDING, listener);
+    fixture.logManager->RemoveEventListener(EVT_HTTP_OK, listener);
+    fixture.logManager->RemoveEventListener(EVT_HTTP_ERROR, listener);
+    fixture.logManager->RemoveEventListener(EVT_HTTP_FAILURE, listener);
+    fixture.logManager.reset();
+    server.stop();
+}
+BENCHMARK(BM_Upload_Cycle)->Arg(1)->Arg(100)->Unit(benchmark::kMillisecond)->UseRealTime();
+#endif
@@ -0,0 +1,196 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "AllocationCounter.hpp"
+
+#include "NullObjects.hpp"
+#include "config/RuntimeConfig_Default.hpp"
+#include "offline/MemoryStorage.hpp"
+#include "offline/OfflineStorage_SQLite.hpp"
+#include "offline/OfflineStorage_Segments.hpp"
+#include "utils/EventId.hpp"
+#include "utils/Utils.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace MAT;
+
+namespace
+{
+    class NullStorageObserver : public IOfflineStorageObserver
+    {
+       public:
+        void OnStorageOpened(std::string const&) override {}
+        void OnStorageFailed(std::string const&) override {}
+        void OnStorageOpenFailed(std::string const&) override {}
+        void OnStorageTrimmed(DroppedMap const&) override {}
+        void OnStorageRecordsDropped(std::map<std::string, size_t> const&) override {}
+        void OnStorageRecordsRejected(std::map<std::string, size_t> const&) override {}
+        void OnStorageRecordsSaved(size_t) override {}
+    };
+
+    char const* const kBackends[] = { "sqlite", "segments", "memory", "memory+journal" };
+
+    /// <summary>
+    /// An offline storage of the backend selected by state.range(0), on a
+    /// fresh file in the temp directory that is removed afterwards.
+    /// </summary>
+    class StorageFixture
+    {
+       public:
+        explicit StorageFixture(benchmark::State& state) :
+            m_config(m_logConfig)
+        {
+            m_path = GetAppLocalTempDirectory() + "OfflineStorageBenchmarks.db";
+            removeFiles();
+            m_config[CFG_STR_CACHE_FILE_PATH] = m_path;
+            m_config[CFG_INT_CACHE_FILE_SIZE] = 0;
+            state.SetLabel(kBackends[state.range(0)]);
+            if (state.range(0) == 0)
+            {
+                storage.reset(new OfflineStorage_SQLite(m_logManager, m_config));
+            }
+            else if (state.range(0) == 1)
+            {
+                storage.reset(new OfflineStorage_Segments(m_logManager, m_config));
+            }
+            else
+            {
+                if (state.range(0) == 3)
+                {
+                    m_config[CFG_INT_RAM_QUEUE_JOURNAL_SIZE] = 4 * 1024 * 1024;
+                }
+                storage.reset(new MemoryStorage(m_logManager, m_config));
+            }
+            storage->Initialize(m_observer);
+        }
+
+        ~StorageFixture()
+        {
+            storage->Shutdown();
+            storage.reset();
+            removeFiles();
+        }
+
+        std::unique_ptr<IOfflineStorage> storage;
+
+       protected:
+        void removeFiles()
+        {
+            std::remove(m_path.c_str());
+            std::remove((m_path + "-journal").c_str());
+            std::remove((m_path + "-wal").c_str());
+            std::remove((m_path + ".idx").c_str());
+            std::remove((m_path + ".settings").c_str());
+            std::remove((m_path + ".ramq0").c_str());
+            std::remove((m_path + ".ramq1").c_str());
+            for (int i = 0; i < 8; i++)
+            {
+                std::remove((m_path + ".seg" + std::to_string(i)).c_str());
+            }
+        }
+
+        ILogConfiguration m_logConfig;
+        RuntimeConfig_Default m_config;
+        NullLogManager m_logManager;
+        NullStorageObserver m_observer;
+        std::string m_path;
+    };
+
+    /// <summary>
+    /// Serialized events of a few hundred bytes, as the RAM queue flushes them.
+    /// </summary>
+    std::vector<StorageRecord> MakeRecords(size_t count)
+    {
+        std::vector<StorageRecord> records;
+        for (size_t i = 0; i < count; i++)
+        {
+            std::vector<uint8_t> blob(300 + (i * 37) % 400);
+            for (size_t j = 0; j < blob.size(); j++)
+            {
+                blob[j] = static_cast<uint8_t>(i * 131 + j);
+            }
+            records.emplace_back(EventId::Generate(), (i % 3) ? "tenant1-token" : "tenant2-token",
+                                 EventLatency_Normal, EventPersistence_Normal, 1234567890 + static_cast<int64_t>(i), std::move(blob));
+        }
+        return records;
+    }
+
+    size_t PayloadSize(std::vector<StorageRecord> const& records)
+    {
+        size_t size = 0;
+        for (auto const& record : records)
+        {
+            size += record.blob.size();
+        }
+        return size;
+    }
+}
+
+/// Stores a batch of state.range(1) records, reserves it for upload and
+/// deletes it as acknowledged: the steady state of the disk queue.
+static void BM_OfflineStorage_Cycle(benchmark::State& state)
+{
+    StorageFixture fixture(state);
+    auto const records = MakeRecords(static_cast<size_t>(state.range(1)));
+    std::vector<StorageRecordId> ids;
+    for (auto const& record : records)
+    {
+        ids.push_back(record.id);
+    }
+    HttpHeaders headers;
+    bool fromMemory = false;
+
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        std::vector<StorageRecord> batch = records;
+        fixture.storage->StoreRecords(batch);
+        size_t reserved = 0;
+        fixture.storage->GetAndReserveRecords([&reserved](StorageRecord const& record) {
+            benchmark::DoNotOptimize(record.blob.data());
+            reserved++;
+            return true;
+        }, 60000, EventLatency_Normal, 0);
+        fixture.storage->DeleteRecords(ids, headers, fromMemory);
+        benchmark::DoNotOptimize(reserved);
+    }
+    allocs.Report(static_cast<double>(records.size()));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * records.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * PayloadSize(records)));
+}
+BENCHMARK(BM_OfflineStorage_Cycle)->ArgsProduct({{0, 1, 2, 3}, {1, 100, 500}});
+
+/// Reserves state.range(1) records out of a backlog of 5000 and releases
+/// them again, as an upload that failed and will be retried.
+static void BM_OfflineStorage_ReserveRelease(benchmark::State& state)
+{
+    StorageFixture fixture(state);
+    auto backlog = MakeRecords(5000);
+    size_t const payload = PayloadSize(backlog) * static_cast<size_t>(state.range(1)) / backlog.size();
+    fixture.storage->StoreRecords(backlog);
+    unsigned const count = static_cast<unsigned>(state.range(1));
+    std::vector<StorageRecordId> ids;
+    HttpHeaders headers;
+    bool fromMemory = false;
+
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        ids.clear();
+        fixture.storage->GetAndReserveRecords([&ids](StorageRecord const& record) {
+            ids.push_back(record.id);
+            return true;
+        }, 60000, EventLatency_Normal, count);
+        fixture.storage->ReleaseRecords(ids, false, headers, fromMemory);
+    }
+    allocs.Report(static_cast<double>(count));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload));
+}
+BENCHMARK(BM_OfflineStorage_ReserveRelease)->ArgsProduct({{0, 1, 2, 3}, {100, 500}});
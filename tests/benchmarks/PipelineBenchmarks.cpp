@@ -0,0 +1,163 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "AllocationCounter.hpp"
+
+#include "NullObjects.hpp"
+#include "bond/BondSerializer.hpp"
+#include "decorators/EventPropertiesDecorator.hpp"
+#include "packager/BondSplicer.hpp"
+#include "system/Contexts.hpp"
+#include "utils/EventId.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace MAT;
+
+namespace
+{
+    EventProperties MakeEvent(size_t count)
+    {
+        EventProperties props("Contoso.Benchmark.Event");
+        for (size_t i = 0; i < count; i++)
+        {
+            std::string name = "Contoso.Prop" + std::to_string(i);
+            if (i % 2)
+            {
+                props.SetProperty(name, static_cast<int64_t>(i));
+            }
+            else
+            {
+                props.SetProperty(name, "string value of moderate length");
+            }
+        }
+        return props;
+    }
+
+    class TestBondSerializer : public BondSerializer
+    {
+       public:
+        using BondSerializer::handleSerialize;
+    };
+
+    /// <summary>
+    /// Record blobs as BondSerializer produces them for events with 10 to
+    /// 40 properties.
+    /// </summary>
+    std::vector<std::vector<uint8_t>> MakeRecordBlobs(size_t count)
+    {
+        NullLogManager logManager;
+        EventPropertiesDecorator decorator(logManager);
+        TestBondSerializer serializer;
+        std::vector<std::vector<uint8_t>> blobs;
+        for (size_t i = 0; i < count; i++)
+        {
+            EventProperties props = MakeEvent(10 + i % 31);
+            ::CsProtocol::Record record;
+            EventLatency latency = EventLatency_Normal;
+            decorator.decorate(record, latency, props);
+            IncomingEventContext ctx(EventId::Generate(), "tenant1-token", latency, EventPersistence_Normal, &record);
+            serializer.handleSerialize(&ctx);
+            blobs.push_back(std::move(ctx.record.blob));
+        }
+        return blobs;
+    }
+}
+
+/// Copies the name, common fields and state.range(0) properties of an event
+/// into an empty record, as Logger does for every LogEvent call.
+static void BM_Pipeline_Decorate(benchmark::State& state)
+{
+    NullLogManager logManager;
+    EventPropertiesDecorator decorator(logManager);
+    EventProperties props = MakeEvent(static_cast<size_t>(state.range(0)));
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        ::CsProtocol::Record record;
+        EventLatency latency = EventLatency_Normal;
+        decorator.decorate(record, latency, props);
+        benchmark::DoNotOptimize(record.data.data());
+    }
+    allocs.Report();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_Pipeline_Decorate)->Arg(10)->Arg(40);
+
+/// Serializes a decorated record with state.range(0) properties. With
+/// state.range(1) set the properties are left in EventProperties and
+/// encoded directly, as Logger does when deferring them.
+static void BM_Pipeline_Serialize(benchmark::State& state)
+{
+    bool deferred = state.range(1) != 0;
+    state.SetLabel(deferred ? "deferred" : "copied");
+    NullLogManager logManager;
+    EventPropertiesDecorator decorator(logManager);
+    TestBondSerializer serializer;
+    EventProperties props = MakeEvent(static_cast<size_t>(state.range(0)));
+    ::CsProtocol::Record record;
+    EventLatency latency = EventLatency_Normal;
+    decorator.decorate(record, latency, props, deferred);
+    IncomingEventContext ctx(EventId::Generate(), "tenant1-token", latency, EventPersistence_Normal, &record);
+    if (deferred)
+    {
+        ctx.properties = &props;
+    }
+
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        ctx.record.blob.clear();
+        serializer.handleSerialize(&ctx);
+        benchmark::DoNotOptimize(ctx.record.blob.data());
+    }
+    allocs.Report();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * ctx.record.blob.size()));
+}
+BENCHMARK(BM_Pipeline_Serialize)->ArgsProduct({{10, 40}, {0, 1}});
+
+/// Adds state.range(0) records of two tenants to a BondSplicer and splices
+/// them into an upload body, copied into one vector (state.range(1) == 0)
+/// or as views into the splicer chunks.
+static void BM_Pipeline_Splice(benchmark::State& state)
+{
+    bool scatterGather = state.range(1) != 0;
+    state.SetLabel(scatterGather ? "scatter-gather" : "contiguous");
+    auto const blobs = MakeRecordBlobs(static_cast<size_t>(state.range(0)));
+    size_t payload = 0;
+    for (auto const& blob : blobs)
+    {
+        payload += blob.size();
+    }
+
+    BondSplicer splicer;
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        size_t const tenants[] = { splicer.addTenantToken("tenant1-token"), splicer.addTenantToken("tenant2-token") };
+        for (size_t i = 0; i < blobs.size(); i++)
+        {
+            splicer.addRecord(tenants[i % 3 == 0], blobs[i]);
+        }
+        if (scatterGather)
+        {
+            ScatterGatherBuffer body;
+            splicer.splice(body);
+            benchmark::DoNotOptimize(body.size());
+        }
+        else
+        {
+            std::vector<uint8_t> body = splicer.splice();
+            benchmark::DoNotOptimize(body.data());
+        }
+        splicer.clear();
+    }
+    allocs.Report(static_cast<double>(blobs.size()));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * blobs.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload));
+}
+BENCHMARK(BM_Pipeline_Splice)->ArgsProduct({{10, 500}, {0, 1}});
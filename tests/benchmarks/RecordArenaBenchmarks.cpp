@@ -0,0 +1,102 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "AllocationCounter.hpp"
+
+#include "api/RecordArena.hpp"
+
+using namespace MAT;
+
+namespace
+{
+    /// <summary>
+    /// Populates a record the way BaseDecorator, ContextFieldsProvider and
+    /// EventPropertiesDecorator do for a typical custom event.
+    /// </summary>
+    void DecorateRecord(::CsProtocol::Record& record)
+    {
+        record.name = "Contoso.Benchmark.SampleEvent";
+        record.baseType = "custom.SampleEvent";
+        record.iKey = "o:0c21c15bdccc48c99678a748488bb87f";
+        record.ver = "3.0";
+        record.time = 637000000000000000;
+
+        if (record.extSdk.size() == 0)
+        {
+            record.extSdk.push_back(::CsProtocol::Sdk());
+        }
+        record.extSdk[0].installId = "c5bd0f45-0e37-4c02-9e3c-1f8e0e2f5b8a";
+        record.extSdk[0].epoch = "1b0ed9d1-1b94-4aa5-9d50-93db4ea8ca1f";
+        record.extSdk[0].seq = 42;
+        if (record.extProtocol.size() == 0)
+        {
+            record.extProtocol.push_back(::CsProtocol::Protocol());
+        }
+        if (record.extApp.size() == 0)
+        {
+            record.extApp.push_back(::CsProtocol::App());
+        }
+        record.extApp[0].id = "Contoso.Benchmarks";
+        if (record.extDevice.size() == 0)
+        {
+            record.extDevice.push_back(::CsProtocol::Device());
+        }
+        record.extDevice[0].localId = "c:4f5e6d7c-8b9a-0f1e-2d3c-4b5a69788796";
+        if (record.extOs.size() == 0)
+        {
+            record.extOs.push_back(::CsProtocol::Os());
+        }
+        record.extOs[0].name = "Linux";
+        if (record.extUser.size() == 0)
+        {
+            record.extUser.push_back(::CsProtocol::User());
+        }
+        if (record.extLoc.size() == 0)
+        {
+            record.extLoc.push_back(::CsProtocol::Loc());
+        }
+        if (record.extNet.size() == 0)
+        {
+            record.extNet.push_back(::CsProtocol::Net());
+        }
+        if (record.data.size() == 0)
+        {
+            record.data.push_back(::CsProtocol::Data());
+        }
+        auto& properties = record.data[0].properties;
+        properties["Name"].stringValue = "value";
+        properties["Count"].longValue = 12345;
+    }
+}
+
+static void BM_Record_NewPerEvent(benchmark::State& state)
+{
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        ::CsProtocol::Record record;
+        DecorateRecord(record);
+        benchmark::DoNotOptimize(&record);
+    }
+    allocs.Report();
+}
+BENCHMARK(BM_Record_NewPerEvent);
+
+static void BM_Record_ArenaPerEvent(benchmark::State& state)
+{
+    uint64_t avoidedBefore = RecordArena::GetAllocationsAvoided();
+    benchmarks::ScopedAllocationCounter allocs(state);
+    for (auto _ : state)
+    {
+        RecordArena::Lease lease;
+        DecorateRecord(*lease);
+        benchmark::DoNotOptimize(&*lease);
+    }
+    allocs.Report();
+    state.counters["avoided/event"] = benchmark::Counter(
+        static_cast<double>(RecordArena::GetAllocationsAvoided() - avoidedBefore),
+        benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_Record_ArenaPerEvent);
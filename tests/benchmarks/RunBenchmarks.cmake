@@ -0,0 +1,52 @@
+# Runs the Benchmarks executable and writes a JSON report named after the
+# current commit. Repetitions are aggregated so that two reports can be
+# compared without the noise of a single run.
+#
+# Variables: BENCHMARKS, SOURCE_DIR, REPORT_DIR, BUILD_TYPE
+# Optional:  BENCHMARK_FILTER, BENCHMARK_REPETITIONS
+
+set(COMMIT "unknown")
+find_package(Git QUIET)
+if(GIT_FOUND)
+  execute_process(
+    COMMAND ${GIT_EXECUTABLE} rev-parse --short HEAD
+    WORKING_DIRECTORY ${SOURCE_DIR}
+    OUTPUT_VARIABLE COMMIT
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+    ERROR_QUIET)
+  execute_process(
+    COMMAND ${GIT_EXECUTABLE} status --porcelain --untracked-files=no
+    WORKING_DIRECTORY ${SOURCE_DIR}
+    OUTPUT_VARIABLE DIRTY
+    ERROR_QUIET)
+  if(DIRTY)
+    set(COMMIT "${COMMIT}-dirty")
+  endif()
+endif()
+
+if(NOT BENCHMARK_FILTER)
+  set(BENCHMARK_FILTER ".")
+endif()
+if(NOT BENCHMARK_REPETITIONS)
+  set(BENCHMARK_REPETITIONS 5)
+endif()
+if(NOT BUILD_TYPE)
+  set(BUILD_TYPE "unspecified")
+endif()
+
+file(MAKE_DIRECTORY ${REPORT_DIR})
+set(REPORT ${REPORT_DIR}/Benchmarks-${COMMIT}.json)
+message("Writing ${REPORT}")
+
+execute_process(
+  COMMAND ${BENCHMARKS}
+    --benchmark_filter=${BENCHMARK_FILTER}
+    --benchmark_repetitions=${BENCHMARK_REPETITIONS}
+    --benchmark_report_aggregates_only=true
+    --benchmark_out=${REPORT}
+    --benchmark_out_format=json
+    --benchmark_context=commit=${COMMIT},sdk_build_type=${BUILD_TYPE}
+  RESULT_VARIABLE RESULT)
+if(NOT RESULT EQUAL 0)
+  message(FATAL_ERROR "Benchmarks failed: ${RESULT}")
+endif()
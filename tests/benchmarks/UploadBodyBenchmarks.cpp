@@ -0,0 +1,130 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "AllocationCounter.hpp"
+
+#include "compression/HttpDeflateCompression.hpp"
+#include "config/RuntimeConfig_Default.hpp"
+#include "packager/Packager.hpp"
+
+using namespace MAT;
+
+namespace
+{
+    /// <summary>
+    /// Stored records worth a 3 MB upload, as OfflineStorage hands them out.
+    /// </summary>
+    std::vector<StorageRecord> const& GetStoredRecords()
+    {
+        static std::vector<StorageRecord> records = [] {
+            std::vector<StorageRecord> result;
+            for (int i = 0; i < 1000; i++)
+            {
+                std::vector<uint8_t> blob(3000);
+                for (size_t j = 0; j < blob.size(); j++)
+                {
+                    blob[j] = static_cast<uint8_t>((i * 31 + j * 7) % 61);
+                }
+                blob.back() = 0;
+                result.emplace_back("r" + std::to_string(i), (i % 3) ? "tenant1-token" : "tenant2-token",
+                                    EventLatency_Normal, EventPersistence_Normal, 1234567890 + i, std::move(blob));
+            }
+            return result;
+        }();
+        return records;
+    }
+
+    class UploadPipeline : public Packager, public HttpDeflateCompression
+    {
+       public:
+        UploadPipeline(IRuntimeConfig& config) :
+            Packager(config),
+            HttpDeflateCompression(config)
+        {
+        }
+
+        using HttpDeflateCompression::handleCompress;
+        using Packager::handleAddEventToPackage;
+        using Packager::handleFinalizePackage;
+    };
+
+    /// <summary>
+    /// Packages and compresses one upload. With contiguous set the records
+    /// are spliced into one vector first, as the pipeline used to do.
+    /// </summary>
+    void RunUploadBenchmark(benchmark::State& state, bool compress, bool contiguous)
+    {
+        ILogConfiguration logConfig;
+        RuntimeConfig_Default config(logConfig);
+        config[CFG_MAP_HTTP][CFG_BOOL_HTTP_COMPRESSION] = compress;
+        UploadPipeline pipeline(config);
+        auto const& records = GetStoredRecords();
+
+        size_t payload = 0;
+        int64_t peak = 0;
+        benchmarks::ScopedAllocationCounter allocs(state);
+        for (auto _ : state)
+        {
+            int64_t baseline = benchmarks::GetLiveBytes();
+            benchmarks::ResetPeakBytes();
+
+            auto ctx = std::make_shared<EventsUploadContext>();
+            for (auto const& record : records)
+            {
+                bool wantMore = true;
+                pipeline.handleAddEventToPackage(ctx, record, wantMore);
+            }
+            if (contiguous)
+            {
+                ctx->body = ctx->splicer->splice();
+                ctx->splicer->clear();
+                payload = ctx->body.size();
+            }
+            else
+            {
+                pipeline.handleFinalizePackage(ctx);
+                payload = ctx->splicedBody.size();
+            }
+            pipeline.handleCompress(ctx);
+            if (!ctx->splicedBody.empty())
+            {
+                // What HttpRequestEncoder does for uncompressed uploads
+                ctx->splicedBody.gather(ctx->body);
+                ctx->splicedBody.clear();
+            }
+            benchmark::DoNotOptimize(ctx->body.data());
+
+            peak = std::max(peak, benchmarks::GetPeakBytes() - baseline);
+        }
+        allocs.Report(static_cast<double>(records.size()));
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * records.size()));
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload));
+        state.counters["peak/payload"] = static_cast<double>(peak) / static_cast<double>(payload);
+    }
+}
+
+static void BM_Upload_ContiguousDeflate(benchmark::State& state)
+{
+    RunUploadBenchmark(state, true, true);
+}
+BENCHMARK(BM_Upload_ContiguousDeflate)->Unit(benchmark::kMillisecond);
+
+static void BM_Upload_ScatterGatherDeflate(benchmark::State& state)
+{
+    RunUploadBenchmark(state, true, false);
+}
+BENCHMARK(BM_Upload_ScatterGatherDeflate)->Unit(benchmark::kMillisecond);
+
+static void BM_Upload_ContiguousUncompressed(benchmark::State& state)
+{
+    RunUploadBenchmark(state, false, true);
+}
+BENCHMARK(BM_Upload_ContiguousUncompressed)->Unit(benchmark::kMillisecond);
+
+static void BM_Upload_ScatterGatherUncompressed(benchmark::State& state)
+{
+    RunUploadBenchmark(state, false, false);
+}
+BENCHMARK(BM_Upload_ScatterGatherUncompressed)->Unit(benchmark::kMillisecond);
@@ -9,6 +9,9 @@
 #include "Common.hpp"
 #include "zlib.h"
 #include "utils/Utils.hpp"
+#ifdef HAVE_MAT_ZSTD
+#include <zstd.h>
+#endif
 #ifdef _WIN32
 #include <windows.h>
 #include <stdio.h>
@@ -124,6 +127,43 @@ namespace testing {
         return false;
     }
 
+#ifdef HAVE_MAT_ZSTD
+    /// <summary>
+    /// Decodes a complete zstd frame, as sent with Content-Encoding: zstd.
+    /// </summary>
+    /// <param name="input">Compressed frame</param>
+    /// <param name="output">Decompressed bytes</param>
+    /// <returns>false if the frame is corrupt or truncated</returns>
+    bool ZstdDecompress(std::vector<uint8_t> const& input, std::vector<uint8_t>& output)
+    {
+        std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx*)> dctx(ZSTD_createDCtx(), ZSTD_freeDCtx);
+        if (!dctx)
+            return false;
+
+        output.resize(std::max<size_t>(input.size() * 4, 1024));
+        ZSTD_inBuffer source { input.data(), input.size(), 0 };
+        ZSTD_outBuffer buffer { output.data(), output.size(), 0 };
+        size_t result = 1;
+        while (result != 0)
+        {
+            if (buffer.pos == buffer.size)
+            {
+                output.resize(output.size() * 2);
+                buffer.dst = output.data();
+                buffer.size = output.size();
+            }
+            result = ZSTD_decompressStream(dctx.get(), &buffer, &source);
+            if (ZSTD_isError(result) || (result != 0 && source.pos == source.size && buffer.pos < buffer.size))
+            {
+                // Corrupt or truncated frame
+                return false;
+            }
+        }
+        output.resize(buffer.pos);
+        return source.pos == source.size;
+    }
+#endif
+
     /// <summary>
     /// Expand buffer from source to dest.
     /// </summary>
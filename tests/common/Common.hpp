@@ -67,6 +67,10 @@ namespace testing {
 
     bool Expand(const char* source, size_t sourceLen, char** dest, size_t& destLen, bool sizeAtZeroIndex);
 
+#ifdef HAVE_MAT_ZSTD
+    bool ZstdDecompress(std::vector<uint8_t> const& input, std::vector<uint8_t>& output);
+#endif
+
     EventProperties CreateSampleEvent(const char *name, EventPriority prio);
 
     std::string GetUniqueDBFileName();
@@ -8,6 +8,8 @@
 #include "Common.hpp"
 #include "SocketTools.hpp"
 #include "Reactor.hpp"
+#include "compression/PresetDictionary.hpp"
+#include "utils/ZlibUtils.hpp"
 
 // #define ENABLE_HTTP_DEBUG
 
@@ -156,6 +158,35 @@ class HttpServer : private Reactor::Callback
         m_reactor.stop();
     }
 
+    // Decodes the request body according to its Content-Encoding header.
+    // Requests without the header are returned as they are.
+    static bool decodeContent(Request const& request, std::vector<uint8_t>& output)
+    {
+        std::vector<uint8_t> content(request.content.begin(), request.content.end());
+        auto const it = request.headers.find("Content-Encoding");
+        if (it == request.headers.end()) {
+            output = std::move(content);
+            return true;
+        }
+        output.clear();
+        if (it->second == "deflate") {
+            return MAT::ZlibUtils::InflateVector(content, output, false);
+        }
+        if (it->second == "gzip") {
+            return MAT::ZlibUtils::InflateVector(content, output, true);
+        }
+        if (it->second == "deflate-dict") {
+            return MAT::ZlibUtils::InflateVector(content, output, MAT::PresetDictionary::CsProtocol());
+        }
+#ifdef HAVE_MAT_ZSTD
+        if (it->second == "zstd") {
+            return ZstdDecompress(content, output);
+        }
+#endif
+        LOG_WARN("HttpServer: unsupported Content-Encoding %s", it->second.c_str());
+        return false;
+    }
+
   protected:
     virtual void onSocketAcceptable(Socket socket) override
     {
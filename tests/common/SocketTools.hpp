@@ -326,7 +326,12 @@ class Socket
     int send(void const* buffer, unsigned size)
     {
         assert(m_sock != Invalid);
-        return static_cast<int>(::send(m_sock, reinterpret_cast<char const*>(buffer), size, 0));
+        int flags = 0;
+#ifdef MSG_NOSIGNAL
+        // A peer that went away must not raise SIGPIPE in the test process
+        flags |= MSG_NOSIGNAL;
+#endif
+        return static_cast<int>(::send(m_sock, reinterpret_cast<char const*>(buffer), size, flags));
     }
 
     bool bind(SocketAddr const& addr)
@@ -35,6 +35,7 @@
 #include "http/HttpClientFactory.hpp"
 
 #include <list>
+#include <thread>
 
 using namespace MAT;
 
@@ -740,6 +741,145 @@ TEST(APITest, C_API_Test)
     ASSERT_EQ(capi_get_client(handle), nullptr);
 }
 
+TEST(APITest, C_API_LoggerHandle_Test)
+{
+    TestDebugEventListener debugListener;
+
+    const char* config = JSON_CONFIG(
+        {
+            "cacheFilePath": "MyOfflineStorage.db",
+            "config" : {
+                "host": "*"
+            },
+            "stats" : {
+                "interval": 0
+            },
+            "name" : "C-API-Client-1",
+            "version" : "1.0.0",
+            "primaryToken" : "7c8b1796cbc44bd5a03803c01c2b9d61-b6e370dd-28d9-4a52-9556-762543cf7aa7-6991",
+            "maxTeardownUploadTimeInSec" : 5,
+            "hostMode" : false,
+            "minimumTraceLevel" : 0,
+            "sdkmode" : 0
+        }
+    );
+
+    evt_prop event[] = TELEMETRY_EVENT
+    (
+        _STR(COMMONFIELDS_EVENT_NAME, EVENT_NAME_PURE_C),
+        _STR(COMMONFIELDS_IKEY, TEST_TOKEN2),                              // Ignored: the logger handle decides
+        _INT(COMMONFIELDS_EVENT_LEVEL, DIAG_LEVEL_REQUIRED),
+        _STR("strKey", "value1"),
+        _INT("intKey", 12345)
+    );
+
+    unsigned totalEvents = 0;
+    debugListener.OnLogX = [&](::CsProtocol::Record&  record)
+    {
+        totalEvents++;
+        EXPECT_EQ(record.name, EVENT_NAME_PURE_C);
+        std::string iToken_o = "o:";
+        iToken_o += TEST_TOKEN;
+        EXPECT_THAT(iToken_o, testing::HasSubstr(record.iKey));
+        EXPECT_EQ(record.data[0].properties.count(COMMONFIELDS_IKEY), 0u);
+        EXPECT_STREQ(record.data[0].properties["strKey"].stringValue.c_str(), "value1");
+        EXPECT_EQ(record.data[0].properties["intKey"].longValue, 12345);
+    };
+
+    evt_handle_t handle = evt_open(config);
+    ASSERT_NE(handle, 0);
+    capi_client *client = capi_get_client(handle);
+    ASSERT_NE(client, nullptr);
+    client->logmanager->AddEventListener(EVT_LOG_EVENT, debugListener);
+
+    evt_handle_t logger = evt_get_logger(handle, TEST_TOKEN, "my_source");
+    ASSERT_NE(logger, 0);
+    // Resolving the same logger again yields the same handle
+    EXPECT_EQ(evt_get_logger(handle, TEST_TOKEN, "my_source"), logger);
+    EXPECT_NE(evt_get_logger(handle, TEST_TOKEN, "other_source"), logger);
+    EXPECT_EQ(evt_get_logger(handle + 1, TEST_TOKEN, "my_source"), 0);
+
+    for (size_t i = 0; i < 5; i++)
+    {
+        EXPECT_EQ(evt_log_with_logger(logger, event), EOK);
+    }
+    EXPECT_EQ(totalEvents, 5u);
+    EXPECT_EQ(evt_log_with_logger(logger + 100, event), ENOENT);
+
+    client->logmanager->RemoveEventListener(EVT_LOG_EVENT, debugListener);
+    evt_close(handle);
+
+    // Logger handles do not outlive their SDK instance
+    EXPECT_EQ(evt_log_with_logger(logger, event), ENOENT);
+}
+
+TEST(APITest, C_API_LoggerHandle_CloseWhileLogging_Test)
+{
+    const char* config = JSON_CONFIG(
+        {
+            "cacheFilePath": "MyOfflineStorage.db",
+            "config" : {
+                "host": "*"
+            },
+            "stats" : {
+                "interval": 0
+            },
+            "name" : "C-API-Client-2",
+            "version" : "1.0.0",
+            "primaryToken" : "7c8b1796cbc44bd5a03803c01c2b9d61-b6e370dd-28d9-4a52-9556-762543cf7aa7-6991",
+            "maxTeardownUploadTimeInSec" : 0,
+            "hostMode" : false,
+            "minimumTraceLevel" : 0,
+            "sdkmode" : 0
+        }
+    );
+
+    evt_prop event[] = TELEMETRY_EVENT
+    (
+        _STR(COMMONFIELDS_EVENT_NAME, EVENT_NAME_PURE_C),
+        _INT(COMMONFIELDS_EVENT_LEVEL, DIAG_LEVEL_REQUIRED)
+    );
+
+    evt_handle_t handle = evt_open(config);
+    ASSERT_NE(handle, 0);
+    evt_handle_t logger = evt_get_logger(handle, TEST_TOKEN, "my_source");
+    ASSERT_NE(logger, 0);
+
+    // Every call either logs or finds the handle gone, none uses a destroyed logger
+    std::atomic<unsigned> logged(0);
+    std::atomic<unsigned> rejected(0);
+    std::atomic<bool> started(false);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&]() {
+            for (;;)
+            {
+                evt_status_t result = evt_log_with_logger(logger, event);
+                started = true;
+                if (result != EOK)
+                {
+                    EXPECT_EQ(result, ENOENT);
+                    rejected++;
+                    return;
+                }
+                logged++;
+            }
+        });
+    }
+    while (!started)
+    {
+        std::this_thread::yield();
+    }
+    evt_close(handle);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_GT(logged.load(), 0u);
+    EXPECT_EQ(rejected.load(), 4u);
+}
+
 #ifdef HAVE_MAT_JSONHPP
 #if defined(_WIN32)
 TEST(APITest, UTC_Callback_Test)
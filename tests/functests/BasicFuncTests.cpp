@@ -134,6 +134,9 @@ protected:
     ILogger* logger;
     ILogger* logger2;
 
+    // Upload compression used by Initialize(), none when empty
+    std::string contentEncoding;
+
     std::atomic<bool> isSetup;
     std::atomic<bool> isRunning;
 
@@ -198,7 +201,8 @@ public:
         configuration[CFG_STR_CACHE_FILE_PATH] = TEST_STORAGE_FILENAME;
         configuration[CFG_INT_MAX_TEARDOWN_TIME] = 2;   // 2 seconds wait on shutdown
         configuration[CFG_STR_COLLECTOR_URL] = serverAddress.c_str();
-        configuration[CFG_MAP_HTTP][CFG_BOOL_HTTP_COMPRESSION] = false;      // disable compression for now
+        configuration[CFG_MAP_HTTP][CFG_BOOL_HTTP_COMPRESSION] = !contentEncoding.empty();
+        configuration[CFG_MAP_HTTP][CFG_STR_HTTP_CONTENT_ENCODING] = contentEncoding.empty() ? "deflate" : contentEncoding.c_str();
         configuration[CFG_MAP_METASTATS_CONFIG][CFG_INT_METASTATS_INTERVAL] = 30 * 60;   // 30 mins
 
         configuration["name"] = __FILE__;
@@ -269,7 +273,7 @@ public:
                     for (size_t index = lastIdx; index < size; index++)
                     {
                         auto request = receivedRequests.at(index);
-                        auto payload = decodeRequest(request, false);
+                        auto payload = decodeRequest(request, true);
                         receivedEvents+= (unsigned)payload.size();
                     }
                     lastIdx = size;
@@ -281,18 +285,25 @@ public:
 
     std::vector<CsProtocol::Record> decodeRequest(HttpServer::Request const& request, bool decompress)
     {
-        UNREFERENCED_PARAMETER(decompress);
-        // TODO: [MG] - implement decompression
+        std::vector<uint8_t> content;
+        if (decompress)
+        {
+            EXPECT_THAT(HttpServer::decodeContent(request, content), true);
+        }
+        else
+        {
+            content.assign(request.content.begin(), request.content.end());
+        }
 
         std::vector<CsProtocol::Record> vector;
 
         size_t data = 0;
         size_t length = 0;
-        while (data < request.content.size())
+        while (data < content.size())
         {
             CsProtocol::Record result;
-            length = request.content.size() - data;
-            std::vector<uint8_t> test(request.content.data() + data, request.content.data() + data + length);
+            length = content.size() - data;
+            std::vector<uint8_t> test(content.data() + data, content.data() + data + length);
             size_t index = 3;
             bool found = false;
             while (index < length)
@@ -320,7 +331,7 @@ public:
             {
                 index += 1;
             }
-            std::vector<uint8_t> input(request.content.data() + data, request.content.data() + data + index - 1);
+            std::vector<uint8_t> input(content.data() + data, content.data() + data + index - 1);
 
             bond_lite::CompactBinaryProtocolReader reader(input);
             EXPECT_THAT(bond_lite::Deserialize(reader, result), true);
@@ -495,8 +506,7 @@ public:
         {
             for (auto &request : receivedRequests)
             {
-                // TODO: [MG] - add compression support
-                auto payload = decodeRequest(request, false);
+                auto payload = decodeRequest(request, true);
                 for (auto &record : payload)
                 {
                     result.push_back(std::move(record));
@@ -515,8 +525,7 @@ public:
         {
             for (auto &request : receivedRequests)
             {
-                // TODO: [MG] - add compression support
-                auto payload = decodeRequest(request, false);
+                auto payload = decodeRequest(request, true);
                 for (auto &record : payload)
                 {
                     if (record.name == name)
@@ -630,6 +639,46 @@ TEST_F(BasicFuncTests, sendSamePriorityNormalEvents)
     FlushAndTeardown();
 }
 
+TEST_F(BasicFuncTests, sendCompressedEvents)
+{
+    std::vector<std::string> encodings = { "deflate", "gzip", "deflate-dict" };
+#ifdef HAVE_MAT_ZSTD
+    encodings.push_back("zstd");
+#endif
+    for (auto const& encoding : encodings)
+    {
+        CleanStorage();
+        contentEncoding = encoding;
+        Initialize();
+
+        EventProperties event("compressed_event");
+        event.SetPriority(EventPriority_Normal);
+        event.SetProperty("property", "value");
+        event.SetProperty("encoding", encoding);
+        logger->LogEvent(event);
+
+        EventProperties event2("compressed_event2");
+        event2.SetPriority(EventPriority_Normal);
+        event2.SetProperty("property", "value2");
+        event2.SetProperty("property2", "another value");
+        logger->LogEvent(event2);
+
+        waitForEvents(3, 3);
+        {
+            LOCKGUARD(mtx_requests);
+            ASSERT_THAT(receivedRequests, Not(IsEmpty()));
+            EXPECT_THAT(receivedRequests[0].headers["Content-Encoding"], encoding);
+        }
+        for (const auto &evt : { event, event2 })
+        {
+            verifyEvent(evt, find(evt.GetName()));
+        }
+
+        FlushAndTeardown();
+        contentEncoding.clear();
+    }
+}
+
 TEST_F(BasicFuncTests, sendDifferentPriorityEvents)
 {
     CleanStorage();
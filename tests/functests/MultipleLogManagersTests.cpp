@@ -229,6 +229,53 @@ TEST_F(MultipleLogManagersTests, MultiProcessesLogManager)
     CAPTURE_PERF_STATS("Log Manager deleted");
 }
 
+TEST_F(MultipleLogManagersTests, StageTimingIsPerInstance)
+{
+    config1[CFG_MAP_METASTATS_CONFIG][CFG_BOOL_METASTATS_STAGE_TIMING] = true;
+    std::unique_ptr<ILogManager> lm1(LogManagerFactory::Create(config1));
+    std::unique_ptr<ILogManager> lm2(LogManagerFactory::Create(config2));
+
+    ILogger* logger1 = lm1->GetLogger("aaa");
+    ILogger* logger2 = lm2->GetLogger("bbb");
+    for (int i = 0; i < 10; i++)
+    {
+        logger1->LogEvent("event1");
+        logger2->LogEvent("event2");
+    }
+    lm1->GetLogController()->UploadNow();
+    waitForRequestsMultipleLogManager(10000, 1, 0, 0);
+
+    auto findStage = [&lm1](std::string const& name)
+    {
+        for (auto const& stage : lm1->GetStageLatencies())
+        {
+            if (stage.name == name)
+            {
+                return stage;
+            }
+        }
+        return StageLatency {};
+    };
+    // The response is decoded after the collector has counted the request
+    auto start = PAL::getUtcSystemTimeMs();
+    while (findStage("decode").count == 0 && PAL::getUtcSystemTimeMs() - start < 10000)
+    {
+        PAL::sleep(100);
+    }
+
+    EXPECT_GE(findStage("serialize").count, 10u);
+    EXPECT_GE(findStage("storeRecord").count, 10u);
+    EXPECT_GE(findStage("addEventToPackage").count, 10u);
+    EXPECT_GE(findStage("sendRequest").count, 1u);
+    EXPECT_GE(findStage("http").count, 1u);
+    EXPECT_GE(findStage("decode").count, 1u);
+    EXPECT_GE(findStage("http").maxNs, findStage("http").p50Ns);
+    EXPECT_TRUE(lm2->GetStageLatencies().empty());
+
+    lm1.reset();
+    lm2.reset();
+}
+
 #ifdef HAVE_MAT_PRIVACYGUARD
 class MockLogger : public NullLogger
 {
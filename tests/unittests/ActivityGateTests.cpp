@@ -0,0 +1,113 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "utils/ActivityGate.hpp"
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace MAT;
+
+TEST(ActivityGateTests, OpenInitially)
+{
+    ActivityGate gate;
+    EXPECT_FALSE(gate.IsClosed());
+    ASSERT_TRUE(gate.Enter());
+    EXPECT_THAT(gate.ActiveCount(), Eq(1u));
+    gate.Leave();
+    EXPECT_THAT(gate.ActiveCount(), Eq(0u));
+}
+
+TEST(ActivityGateTests, ClosedGateRefusesEnter)
+{
+    ActivityGate gate;
+    EXPECT_TRUE(gate.Close());
+    EXPECT_FALSE(gate.Close());
+    EXPECT_FALSE(gate.Enter());
+    EXPECT_THAT(gate.ActiveCount(), Eq(0u));
+    EXPECT_TRUE(gate.Open());
+    EXPECT_FALSE(gate.Open());
+    EXPECT_TRUE(gate.Enter());
+    gate.Leave();
+}
+
+TEST(ActivityGateTests, ExtraLeaveIsIgnored)
+{
+    ActivityGate gate;
+    gate.Leave();
+    EXPECT_THAT(gate.ActiveCount(), Eq(0u));
+    gate.Close();
+    gate.Leave();
+    EXPECT_THAT(gate.ActiveCount(), Eq(0u));
+}
+
+TEST(ActivityGateTests, WaitDrainedBlocksUntilLastLeave)
+{
+    ActivityGate gate;
+    ASSERT_TRUE(gate.Enter());
+    ASSERT_TRUE(gate.Enter());
+    gate.Close();
+    auto waiter = std::async(std::launch::async, [&gate]() { gate.WaitDrained(); });
+    EXPECT_THAT(waiter.wait_for(std::chrono::milliseconds(50)), Eq(std::future_status::timeout));
+    gate.Leave();
+    EXPECT_THAT(waiter.wait_for(std::chrono::milliseconds(50)), Eq(std::future_status::timeout));
+    gate.Leave();
+    EXPECT_THAT(waiter.wait_for(std::chrono::seconds(5)), Eq(std::future_status::ready));
+}
+
+TEST(ActivityGateTests, OpenReleasesWaiters)
+{
+    ActivityGate gate;
+    ASSERT_TRUE(gate.Enter());
+    gate.Close();
+    auto waiter = std::async(std::launch::async, [&gate]() { gate.WaitDrained(); });
+    EXPECT_THAT(waiter.wait_for(std::chrono::milliseconds(50)), Eq(std::future_status::timeout));
+    gate.Open();
+    EXPECT_THAT(waiter.wait_for(std::chrono::seconds(5)), Eq(std::future_status::ready));
+    gate.Leave();
+}
+
+TEST(ActivityGateTests, NoCallInsideAfterWaitDrained)
+{
+    ActivityGate gate;
+    std::atomic<int> inside { 0 };
+    std::atomic<bool> done { false };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&]() {
+            while (!done)
+            {
+                if (gate.Enter())
+                {
+                    inside++;
+                    std::this_thread::yield();
+                    inside--;
+                    gate.Leave();
+                }
+            }
+        });
+    }
+
+    for (int round = 0; round < 100; round++)
+    {
+        gate.Close();
+        gate.WaitDrained();
+        EXPECT_THAT(inside.load(), Eq(0));
+        EXPECT_THAT(gate.ActiveCount(), Eq(0u));
+        gate.Open();
+        std::this_thread::yield();
+    }
+
+    done = true;
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
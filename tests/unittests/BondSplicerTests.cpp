@@ -17,6 +17,8 @@ class ShadowBondSplicer : protected MAT::BondSplicer
 {
   public:
     using MAT::BondSplicer::addTenantToken;
+    using MAT::BondSplicer::addRecord;
+    using MAT::BondSplicer::clear;
 
     void addCsRecord(size_t dataPackageIndex, ::CsProtocol::Record& record)
     {
@@ -28,6 +30,8 @@ class ShadowBondSplicer : protected MAT::BondSplicer
         MAT::BondSplicer::addRecord(dataPackageIndex, recordBlob);
     }
 
+    using MAT::BondSplicer::splice;
+
     std::vector<uint8_t> splice() const override
     {
         FullDumpBinaryBlob output;
@@ -143,3 +147,33 @@ TEST_F(BondSplicerTests, splice_TwoDataPackagesWithOneNonEmptyRecordEach_SizeTwe
 
    EXPECT_THAT(bs.splice().size(), size_t { 20 });
 }
+
+TEST_F(BondSplicerTests, splice_Views_MatchContiguousSpliceAndOutliveSplicer)
+{
+   // Interleaved packages, enough data to span several chunks, one record larger than a chunk
+   auto first = bs.addTenantToken("tenant1");
+   auto second = bs.addTenantToken("tenant2");
+   std::vector<uint8_t> expectedFirst, expectedSecond;
+   for (size_t i = 0; i < 40; i++)
+   {
+      size_t size = (i == 17) ? BondSplicer::ChunkSize + 100 : 5000 + i;
+      std::vector<uint8_t> blob(size, static_cast<uint8_t>(i + 1));
+      blob.back() = bond_lite::BT_STOP;
+      auto& expected = (i % 3 == 0) ? expectedSecond : expectedFirst;
+      expected.insert(expected.end(), blob.begin(), blob.end());
+      bs.addRecord((i % 3 == 0) ? second : first, blob);
+   }
+   std::vector<uint8_t> expected = expectedFirst;
+   expected.insert(expected.end(), expectedSecond.begin(), expectedSecond.end());
+
+   ScatterGatherBuffer views;
+   bs.splice(views);
+   EXPECT_THAT(views.size(), Eq(expected.size()));
+   EXPECT_THAT(views.views().size(), Lt(size_t { 40 }));
+   EXPECT_TRUE(bs.splice() == expected);
+
+   bs.clear();
+   std::vector<uint8_t> gathered;
+   views.gather(gathered);
+   EXPECT_TRUE(gathered == expected);
+}
@@ -5,6 +5,8 @@
 
 #include "common/Common.hpp"
 #include "api/ContextFieldsProvider.hpp"
+#include "bond/All.hpp"
+#include "bond/generated/CsProtocol_writers.hpp"
 
 using namespace testing;
 using namespace MAT;
@@ -180,3 +182,167 @@ TEST(ContextFieldsProviderTests, SetEventExperimentIds_EmptyExperimentIdsRemoves
 	provider.SetEventExperimentIds("Rodgers", "");
 	EXPECT_THAT(provider.GetCommonContextEventToConfigIds().size(), 0);
 }
+
+static void PopulateContext(ContextFieldsProvider& ctx)
+{
+    ctx.SetAppId("appId");
+    ctx.SetAppExperimentIds("appExperimentIds");
+    ctx.SetDeviceId("{deviceId}");
+    ctx.SetDeviceMake("deviceMake");
+    ctx.SetDeviceModel("deviceModel");
+    ctx.SetOsName("osName");
+    ctx.SetUserId("userId", PiiKind_Identity);
+    ctx.SetUserTimeZone("timeZone");
+    ctx.SetNetworkProvider("networkProvider");
+    ctx.SetCommercialId("commercialId");
+    ctx.SetTicket(TicketType_AAD_User, "ticket");
+    ctx.SetCustomField("custom", "value");
+    ctx.SetCustomField("customInt", static_cast<int64_t>(5));
+}
+
+/// <summary>
+/// Decorates a record through the cached snapshot and a record that
+/// already carries an (empty) extension, which takes the field-by-field path.
+/// </summary>
+static void ExpectSameAsFieldByField(ContextFieldsProvider& ctx, std::string const& name, bool commonOnly = false)
+{
+    ::CsProtocol::Record cached;
+    cached.name = name;
+    cached.extM365a.push_back(::CsProtocol::M365a());
+    ::CsProtocol::Record expected = cached;
+    cached.extM365a.clear();
+
+    ctx.writeToRecord(cached, commonOnly);
+    ctx.writeToRecord(expected, commonOnly);
+    EXPECT_TRUE(cached == expected);
+}
+
+TEST(ContextFieldsProviderTests, Snapshot_MatchesFieldByFieldDecoration)
+{
+    ContextFieldsProvider ctx(nullptr);
+    ContextFieldsProvider loggerCtx(&ctx);
+    PopulateContext(ctx);
+    loggerCtx.SetCustomField("custom", "child");
+    loggerCtx.SetDeviceMake("childMake");
+    loggerCtx.SetTicket(TicketType_MSA_Device, "childTicket");
+
+    ExpectSameAsFieldByField(ctx, "event");
+    ExpectSameAsFieldByField(loggerCtx, "event");
+    ExpectSameAsFieldByField(loggerCtx, "event", true);
+}
+
+TEST(ContextFieldsProviderTests, Snapshot_MergesIntoExistingProtocolAndData)
+{
+    ContextFieldsProvider ctx(nullptr);
+    PopulateContext(ctx);
+
+    ::CsProtocol::Record cached;
+    cached.extProtocol.push_back(::CsProtocol::Protocol());
+    cached.extProtocol[0].metadataCrc = 7;
+    cached.data.push_back(::CsProtocol::Data());
+    cached.data[0].properties["existing"].stringValue = "kept";
+    cached.data[0].properties["custom"].stringValue = "replaced";
+    ::CsProtocol::Record expected = cached;
+    expected.extM365a.push_back(::CsProtocol::M365a());
+
+    ctx.writeToRecord(cached);
+    ctx.writeToRecord(expected);
+    EXPECT_TRUE(cached == expected);
+    EXPECT_THAT(cached.extProtocol[0].metadataCrc, Eq(7));
+    EXPECT_THAT(cached.extProtocol[0].devMake, Eq("deviceMake"));
+    EXPECT_THAT(cached.data[0].properties["existing"].stringValue, Eq("kept"));
+    EXPECT_THAT(cached.data[0].properties["custom"].stringValue, Eq("value"));
+}
+
+TEST(ContextFieldsProviderTests, Snapshot_ReusedUntilContextChanges)
+{
+    ContextFieldsProvider ctx(nullptr);
+    ContextFieldsProvider loggerCtx(&ctx);
+    PopulateContext(ctx);
+
+    auto first = loggerCtx.GetSnapshot();
+    EXPECT_THAT(loggerCtx.GetSnapshot(), Eq(first));
+
+    loggerCtx.SetCustomField("child", "value");
+    auto second = loggerCtx.GetSnapshot();
+    EXPECT_THAT(second, Ne(first));
+    EXPECT_THAT(second->record.data[0].properties.at("child").stringValue, Eq("value"));
+
+    // Changes to the parent invalidate the child snapshot too
+    ctx.SetAppVersion("2.0");
+    auto third = loggerCtx.GetSnapshot();
+    EXPECT_THAT(third, Ne(second));
+    EXPECT_THAT(third->record.extApp[0].ver, Eq("2.0"));
+
+    loggerCtx.SetParentContext(nullptr);
+    EXPECT_THAT(loggerCtx.GetSnapshot()->record.extApp[0].ver, Eq(""));
+}
+
+TEST(ContextFieldsProviderTests, Snapshot_EventExperimentIds)
+{
+    ContextFieldsProvider ctx(nullptr);
+    PopulateContext(ctx);
+    ctx.SetEventExperimentIds("special", "specialIds");
+
+    ::CsProtocol::Record record;
+    record.name = "special";
+    // The cached encoding carries the default ids, so it must not be used for this event
+    EXPECT_THAT(ctx.writeToRecord(record, false, true), IsNull());
+    EXPECT_THAT(record.extApp[0].expId, Eq("specialIds"));
+
+    ::CsProtocol::Record other;
+    other.name = "other";
+    EXPECT_THAT(ctx.writeToRecord(other), Eq(ctx.GetSnapshot()));
+    EXPECT_THAT(other.extApp[0].expId, Eq("appExperimentIds"));
+
+    ExpectSameAsFieldByField(ctx, "special");
+    ctx.ClearExperimentIds();
+    ExpectSameAsFieldByField(ctx, "special");
+}
+
+TEST(ContextFieldsProviderTests, Snapshot_SplicedEncodingMatchesSerializer)
+{
+    ContextFieldsProvider ctx(nullptr);
+    PopulateContext(ctx);
+
+    ::CsProtocol::Record record;
+    record.ver = "3.0";
+    record.name = "event";
+    record.iKey = "o:0123456789abcdef";
+    record.extSdk.push_back(::CsProtocol::Sdk());
+    record.extSdk[0].seq = 3;
+    ::CsProtocol::Record deferred = record;
+    auto snapshot = ctx.writeToRecord(record);
+    ASSERT_THAT(snapshot, NotNull());
+    // Deferred extensions are left to the encoder
+    EXPECT_THAT(ctx.writeToRecord(deferred, false, true), Eq(snapshot));
+    EXPECT_THAT(deferred.extApp, IsEmpty());
+    EXPECT_THAT(deferred.extUser, IsEmpty());
+
+    std::vector<uint8_t> expected;
+    {
+        bond_lite::CompactBinaryProtocolWriter writer(expected);
+        bond_lite::Serialize(writer, record);
+    }
+    for (auto const* source : { &record, &deferred })
+    {
+        std::vector<uint8_t> spliced;
+        bond_lite::CompactBinaryProtocolWriter writer(spliced);
+        bond_lite::Serialize(writer, *source, false, &snapshot->encodedExtensions);
+        EXPECT_TRUE(spliced == expected);
+    }
+
+    snapshot->WriteExtensions(deferred);
+    EXPECT_TRUE(deferred == record);
+}
+
+TEST(ContextFieldsProviderTests, Snapshot_NotReturnedForRecordWithOwnExtensions)
+{
+    ContextFieldsProvider ctx(nullptr);
+    PopulateContext(ctx);
+
+    ::CsProtocol::Record record;
+    record.extM365a.push_back(::CsProtocol::M365a());
+    EXPECT_THAT(ctx.writeToRecord(record, false, true), IsNull());
+    EXPECT_THAT(record.extApp, SizeIs(1));
+}
@@ -5,7 +5,9 @@
 
 #include "common/Common.hpp"
 #include <DebugEvents.hpp>
+#include <atomic>
 #include <functional>
+#include <thread>
 
 using namespace testing;
 using namespace MAT;
@@ -15,7 +17,7 @@ class TestDebugEventSource : public DebugEventSource
 public:
    using DebugEventSource::listeners;
    using DebugEventSource::cascaded;
-   using DebugEventSource::seq;
+   using DebugEventSource::lastSeq;
 };
 
 class TestDebugEventListener : public DebugEventListener
@@ -38,7 +40,7 @@ TEST(DebugEventSourceTests, Constructor_ZeroListeners)
 TEST(DebugEventSourceTests, Constructor_SeqZero)
 {
    TestDebugEventSource source;
-   ASSERT_EQ(source.seq, size_t { 0 });
+   ASSERT_EQ(source.lastSeq(), uint64_t { 0 });
 }
 
 TEST(DebugEventSourceTests, Constructor_ZeroCascaded)
@@ -218,3 +220,107 @@ TEST(DebugEventSourceTests, DispatchEvent_OneEventToCascadedAndToSource_Listener
 }
 
 
+
+TEST(DebugEventSourceTests, DispatchEvent_ListenerOfOtherType_DoesNotIncrementSequenceNumber)
+{
+   TestDebugEventSource source;
+   TestDebugEventListener listener;
+   source.AddEventListener(EVT_LOG_EVENT, listener);
+
+   EXPECT_FALSE(source.DispatchEvent(DebugEvent { EVT_LOG_LIFECYCLE }));
+   EXPECT_TRUE(source.DispatchEvent(DebugEvent { EVT_LOG_EVENT }));
+   ASSERT_EQ(source.lastSeq(), uint64_t { 1 });
+}
+
+TEST(DebugEventSourceTests, DispatchEvent_ListenerAddedToCascadedAfterAttach_ListenerSeesEvent)
+{
+   TestDebugEventSource source;
+   TestDebugEventSource anotherSource;
+   TestDebugEventListener listener;
+   uint64_t countOfEventsSeen {};
+   listener.OnDebugEventOverride = [&countOfEventsSeen](DebugEvent&) noexcept { countOfEventsSeen++; };
+   source.AttachEventSource(anotherSource);
+   anotherSource.AddEventListener(EVT_LOG_EVENT, listener);
+
+   source.DispatchEvent(DebugEvent { EVT_LOG_EVENT });
+   anotherSource.RemoveEventListener(EVT_LOG_EVENT, listener);
+   source.DispatchEvent(DebugEvent { EVT_LOG_EVENT });
+   ASSERT_EQ(countOfEventsSeen, uint64_t { 1 });
+}
+
+TEST(DebugEventSourceTests, DispatchEvent_CascadedSourceDestroyed_SourceStopsForwarding)
+{
+   TestDebugEventSource source;
+   {
+      TestDebugEventSource anotherSource;
+      TestDebugEventListener listener;
+      anotherSource.AddEventListener(EVT_LOG_EVENT, listener);
+      source.AttachEventSource(anotherSource);
+   }
+   ASSERT_EQ(source.cascaded.size(), size_t { 0 });
+   EXPECT_FALSE(source.DispatchEvent(DebugEvent { EVT_LOG_EVENT }));
+}
+
+TEST(DebugEventSourceTests, DispatchEvent_ListenerRemovesItself_NotCalledAgain)
+{
+   TestDebugEventSource source;
+   TestDebugEventListener listener;
+   uint64_t countOfEventsSeen {};
+   listener.OnDebugEventOverride = [&](DebugEvent&) {
+      countOfEventsSeen++;
+      source.RemoveEventListener(EVT_LOG_EVENT, listener);
+   };
+   source.AddEventListener(EVT_LOG_EVENT, listener);
+
+   source.DispatchEvent(DebugEvent { EVT_LOG_EVENT });
+   source.DispatchEvent(DebugEvent { EVT_LOG_EVENT });
+   ASSERT_EQ(countOfEventsSeen, uint64_t { 1 });
+}
+
+TEST(DebugEventSourceTests, DispatchEvent_ListenersAddedAndRemovedConcurrently_RemovedListenerNeverCalled)
+{
+   TestDebugEventSource source;
+   TestDebugEventListener steadyListener;
+   std::atomic<uint64_t> steadyCount { 0 };
+   steadyListener.OnDebugEventOverride = [&steadyCount](DebugEvent&) { steadyCount++; };
+   source.AddEventListener(EVT_LOG_EVENT, steadyListener);
+
+   std::atomic<bool> done { false };
+   std::atomic<uint64_t> dispatchCount { 0 };
+   std::vector<std::thread> dispatchers;
+   for (int i = 0; i < 4; i++)
+   {
+      dispatchers.emplace_back([&]() {
+         while (!done)
+         {
+            source.DispatchEvent(DebugEvent { EVT_LOG_EVENT });
+            dispatchCount++;
+         }
+      });
+   }
+
+   for (int i = 0; i < 50; i++)
+   {
+      std::atomic<bool> removed { false };
+      std::atomic<bool> calledAfterRemove { false };
+      TestDebugEventListener listener;
+      listener.OnDebugEventOverride = [&](DebugEvent&) {
+         if (removed)
+            calledAfterRemove = true;
+      };
+      source.AddEventListener(EVT_LOG_EVENT, listener);
+      std::this_thread::yield();
+      source.RemoveEventListener(EVT_LOG_EVENT, listener);
+      removed = true;
+      std::this_thread::yield();
+      EXPECT_FALSE(calledAfterRemove);
+   }
+
+   done = true;
+   for (auto& dispatcher : dispatchers)
+   {
+      dispatcher.join();
+   }
+   EXPECT_EQ(steadyCount.load(), dispatchCount.load());
+   EXPECT_EQ(source.lastSeq(), dispatchCount.load());
+}
@@ -0,0 +1,74 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "utils/EventId.hpp"
+
+#include <set>
+#include <thread>
+
+using namespace testing;
+using namespace MAT;
+
+TEST(EventIdTests, GeneratesUniqueBinaryIds)
+{
+    std::set<std::string> ids;
+    for (int i = 0; i < 10000; i++)
+    {
+        std::string id = EventId::Generate();
+        EXPECT_THAT(id.size(), Eq(size_t { 16 }));
+        EXPECT_TRUE(ids.insert(id).second);
+    }
+}
+
+TEST(EventIdTests, ThreadsGenerateDistinctIds)
+{
+    std::vector<std::string> ids[4];
+    std::vector<std::thread> threads;
+    for (auto& generated : ids)
+    {
+        threads.emplace_back([&generated]() {
+            for (int i = 0; i < 1000; i++)
+            {
+                generated.push_back(EventId::Generate());
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::set<std::string> all;
+    for (auto const& generated : ids)
+    {
+        all.insert(generated.begin(), generated.end());
+    }
+    EXPECT_THAT(all.size(), Eq(size_t { 4000 }));
+}
+
+TEST(EventIdTests, TextRoundTrip)
+{
+    std::string const id("\x00\x01\x7f\x80\xff\x10\x20\x30\x40\x50\x60\x70\x80\x90\xa0\xb0", 16);
+    std::string text = EventId::ToText(id);
+    EXPECT_THAT(text, Eq("00017f80ff102030405060708090a0b0"));
+    EventId::FromText(text);
+    EXPECT_THAT(text, Eq(id));
+}
+
+TEST(EventIdTests, OtherIdsAreKeptAsText)
+{
+    // Textual UUIDs stored by older versions and IDs chosen by tests
+    std::string uuid = "D8B3C4A2-5E6F-4A1B-9C0D-1E2F3A4B5C6D";
+    EXPECT_THAT(EventId::ToText(uuid), Eq(uuid));
+    EventId::FromText(uuid);
+    EXPECT_THAT(uuid, Eq("D8B3C4A2-5E6F-4A1B-9C0D-1E2F3A4B5C6D"));
+
+    std::string upper = "00017F80FF102030405060708090A0B0";
+    EventId::FromText(upper);
+    EXPECT_THAT(upper, Eq("00017F80FF102030405060708090A0B0"));
+
+    EXPECT_THAT(EventId::ToText("guid1"), Eq("guid1"));
+}
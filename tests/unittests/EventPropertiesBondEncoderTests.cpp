@@ -0,0 +1,236 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "common/Common.hpp"
+#include "bond/All.hpp"
+#include "bond/EventPropertiesBondEncoder.hpp"
+#include "bond/generated/CsProtocol_writers.hpp"
+#include "decorators/EventPropertiesDecorator.hpp"
+#include "CorrelationVector.hpp"
+#include "NullObjects.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace testing;
+using namespace MAT;
+
+class EventPropertiesBondEncoderTests : public ::testing::Test
+{
+protected:
+    NullLogManager logManager;
+    EventPropertiesDecorator decorator{logManager};
+
+    /// <summary>
+    /// Record as it looks after the base and semantic context decorators ran.
+    /// </summary>
+    static ::CsProtocol::Record MakeRecord()
+    {
+        ::CsProtocol::Record record;
+        record.ver = "3.0";
+        record.name = "EncoderTest";
+        record.time = 637000000000000000LL;
+        record.iKey = "o:0123456789abcdef";
+        record.baseType = "custom.type";
+        record.extSdk.push_back(::CsProtocol::Sdk());
+        record.extSdk[0].epoch = "epoch";
+        record.extSdk[0].installId = "installId";
+        record.extSdk[0].seq = 42;
+        record.extDevice.push_back(::CsProtocol::Device());
+        record.extDevice[0].localId = "c:localId";
+        record.extUser.push_back(::CsProtocol::User());
+        record.extProtocol.push_back(::CsProtocol::Protocol());
+        record.tags["tag"] = "value";
+
+        record.data.push_back(::CsProtocol::Data());
+        auto& context = record.data[0].properties;
+        context["AppInfo.Language"].stringValue = "en-US";
+        context["DeviceInfo.OsBuild"].stringValue = "19041";
+        context["Shared"].stringValue = "from context";
+        context["zz.Context.Int"].type = ::CsProtocol::ValueKind::ValueInt64;
+        context["zz.Context.Int"].longValue = 7;
+        ::CsProtocol::PII pii;
+        pii.Kind = ::CsProtocol::PIIKind::Identity;
+        ::CsProtocol::Attributes attributes;
+        attributes.pii.push_back(pii);
+        context["UserInfo.Id"].attributes.push_back(attributes);
+        context["UserInfo.Id"].stringValue = "user@contoso.com";
+        return record;
+    }
+
+    static std::vector<uint8_t> Serialize(::CsProtocol::Record const& record)
+    {
+        std::vector<uint8_t> blob;
+        bond_lite::CompactBinaryProtocolWriter writer(blob);
+        bond_lite::Serialize(writer, record);
+        return blob;
+    }
+
+    /// <summary>
+    /// Decorates two copies of the record, with and without deferred properties,
+    /// and checks that the direct encoder and the record-based serializer
+    /// produce the same bytes. The deferred record is also completed with
+    /// addDeferredProperties and compared to the fully decorated one.
+    /// </summary>
+    void ExpectIdenticalBlobs(::CsProtocol::Record const& source, EventProperties const& props)
+    {
+        ::CsProtocol::Record expectedRecord = source;
+        EventLatency latency = EventLatency_Normal;
+        ASSERT_TRUE(decorator.decorate(expectedRecord, latency, props));
+        std::vector<uint8_t> expected = Serialize(expectedRecord);
+
+        ::CsProtocol::Record deferredRecord = source;
+        latency = EventLatency_Normal;
+        ASSERT_TRUE(decorator.decorate(deferredRecord, latency, props, true));
+        std::vector<uint8_t> actual;
+        EventPropertiesBondEncoder::Encode(actual, deferredRecord, props);
+
+        EXPECT_THAT(deferredRecord.cV, Eq(expectedRecord.cV));
+        EXPECT_THAT(deferredRecord.flags, Eq(expectedRecord.flags));
+        EXPECT_THAT(actual.size(), Eq(expected.size()));
+        EXPECT_TRUE(actual == expected);
+
+        EventPropertiesDecorator::addDeferredProperties(deferredRecord, props);
+        EXPECT_TRUE(Serialize(deferredRecord) == expected);
+    }
+};
+
+TEST_F(EventPropertiesBondEncoderTests, NoProperties)
+{
+    EventProperties props("EncoderTest");
+    ExpectIdenticalBlobs(MakeRecord(), props);
+    ExpectIdenticalBlobs(::CsProtocol::Record(), props);
+}
+
+TEST_F(EventPropertiesBondEncoderTests, AllPropertyTypes)
+{
+    EventProperties props("EncoderTest");
+    props.SetProperty("String", "value");
+    props.SetProperty("EmptyString", "");
+    props.SetProperty("Int64", static_cast<int64_t>(-1234567890123LL));
+    props.SetProperty("ZeroInt64", static_cast<int64_t>(0));
+    props.SetProperty("Double", 3.25);
+    props.SetProperty("ZeroDouble", 0.0);
+    props.SetProperty("True", true);
+    props.SetProperty("False", false);
+    props.SetProperty("Time", time_ticks_t(static_cast<uint64_t>(636000000000000000ULL)));
+    props.SetProperty("Guid", GUID_t("{c4d4ff8c-4f6e-4a45-8e7b-0b4c4b6b7f01}"));
+
+    std::vector<int64_t> longs = {1, -2, 300000000000LL};
+    std::vector<double> doubles = {0.5, -1.25};
+    std::vector<std::string> strings = {"a", "", "ccc"};
+    std::vector<GUID_t> guids = {GUID_t("{00000000-0000-0000-0000-000000000001}"), GUID_t("{ffffffff-ffff-ffff-ffff-ffffffffffff}")};
+    std::vector<int64_t> noLongs;
+    props.SetProperty("LongArray", longs);
+    props.SetProperty("DoubleArray", doubles);
+    props.SetProperty("StringArray", strings);
+    props.SetProperty("GuidArray", guids);
+    props.SetProperty("EmptyLongArray", noLongs);
+
+    ExpectIdenticalBlobs(MakeRecord(), props);
+}
+
+TEST_F(EventPropertiesBondEncoderTests, PiiAndCustomerContent)
+{
+    EventProperties props("EncoderTest");
+    props.SetProperty("Identity", "user@contoso.com", PiiKind_Identity);
+    props.SetProperty("Uri", "https://contoso.com/a", PiiKind_Uri);
+    props.SetProperty("IPv4", "10.0.0.1", PiiKind_IPv4Address);
+    props.SetProperty("PiiInt", static_cast<int64_t>(42), PiiKind_GenericData);
+    props.SetProperty("PiiEmpty", "", PiiKind_Fqdn);
+    props.SetProperty("Content", "customer text", CustomerContentKind_GenericData);
+    props.SetProperty("PartB.Identity", "someone", PiiKind_Identity, DataCategory_PartB);
+    props.SetProperty("PartB.Content", "more text", CustomerContentKind_GenericData, DataCategory_PartB);
+
+    ExpectIdenticalBlobs(MakeRecord(), props);
+}
+
+TEST_F(EventPropertiesBondEncoderTests, PartBProperties)
+{
+    EventProperties props("EncoderTest");
+    props.SetProperty("b.String", "value", PiiKind_None, DataCategory_PartB);
+    props.SetProperty("b.Int64", static_cast<int64_t>(5), PiiKind_None, DataCategory_PartB);
+    props.SetProperty("a.Double", 1.5, PiiKind_None, DataCategory_PartB);
+    props.SetProperty("c.PartC", "value");
+
+    ExpectIdenticalBlobs(MakeRecord(), props);
+
+    // Part B is appended after baseData entries added by earlier decorators
+    ::CsProtocol::Record record = MakeRecord();
+    record.baseData.push_back(::CsProtocol::Data());
+    record.baseData[0].properties["Existing"].stringValue = "base";
+    ExpectIdenticalBlobs(record, props);
+}
+
+TEST_F(EventPropertiesBondEncoderTests, EventPropertiesOverrideContext)
+{
+    EventProperties props("EncoderTest");
+    props.SetProperty("Shared", static_cast<int64_t>(1));
+    props.SetProperty("AppInfo.Language", "fr-FR");
+    props.SetProperty("0.First", "sorts before all context fields");
+    props.SetProperty("zzz.Last", "sorts after all context fields");
+    props.SetProperty("M.Middle", "between context fields");
+
+    ExpectIdenticalBlobs(MakeRecord(), props);
+}
+
+TEST_F(EventPropertiesBondEncoderTests, ManyPropertiesInInsertionOrder)
+{
+    EventProperties props("EncoderTest");
+    for (int i = 40; i > 0; i--)
+    {
+        std::string name = "Property" + std::to_string(i * 7 % 41);
+        if (i % 3 == 0)
+        {
+            props.SetProperty(name, static_cast<int64_t>(i));
+        }
+        else
+        {
+            props.SetProperty(name, name);
+        }
+    }
+
+    ExpectIdenticalBlobs(MakeRecord(), props);
+}
+
+TEST_F(EventPropertiesBondEncoderTests, CorrelationVector)
+{
+    {
+        EventProperties props("EncoderTest");
+        props.SetProperty(CorrelationVector::PropertyName, "cv.1.2");
+        props.SetProperty("Other", "value");
+        ExpectIdenticalBlobs(MakeRecord(), props);
+    }
+    {
+        // Not a string: dropped without setting record.cV
+        EventProperties props("EncoderTest");
+        props.SetProperty(CorrelationVector::PropertyName, static_cast<int64_t>(3));
+        ExpectIdenticalBlobs(MakeRecord(), props);
+    }
+    {
+        // Context value is overridden by the event property
+        ::CsProtocol::Record record = MakeRecord();
+        record.data[0].properties[CorrelationVector::PropertyName].stringValue = "cv.context";
+        EventProperties props("EncoderTest");
+        ExpectIdenticalBlobs(record, props);
+        props.SetProperty(CorrelationVector::PropertyName, "cv.event");
+        ExpectIdenticalBlobs(record, props);
+    }
+    {
+        // Part B correlation vector is sent as a regular Part B property
+        EventProperties props("EncoderTest");
+        props.SetProperty(CorrelationVector::PropertyName, "cv.partb", PiiKind_None, DataCategory_PartB);
+        ExpectIdenticalBlobs(MakeRecord(), props);
+    }
+}
+
+TEST_F(EventPropertiesBondEncoderTests, DropPiiTag)
+{
+    EventProperties props("EncoderTest");
+    props.SetPolicyBitFlags(MICROSOFT_EVENTTAG_DROP_PII);
+    props.SetProperty(CorrelationVector::PropertyName, "cv.1");
+    props.SetProperty("Value", "x");
+
+    ExpectIdenticalBlobs(MakeRecord(), props);
+}
@@ -76,3 +76,22 @@ TEST(EventPropertiesStorageTests, AssignmentOperator)
     EXPECT_THAT(secondStorage.eventPolicyBitflags, storage.eventPolicyBitflags);
     EXPECT_THAT(secondStorage.timestampInMillis, storage.timestampInMillis);
 }
+
+TEST(EventPropertiesStorageTests, GetMapView_TracksFlatStorageChanges)
+{
+    EventPropertiesStorage storage;
+    storage.properties["b"] = EventProperty("two");
+    storage.properties["a"] = EventProperty(1);
+    storage.propertiesPartB["c"] = EventProperty(true);
+
+    const auto& view = storage.GetMapView(DataCategory_PartC);
+    EXPECT_THAT(view, ElementsAre(Pair("a", EventProperty(1)), Pair("b", EventProperty("two"))));
+    EXPECT_THAT(storage.GetMapView(DataCategory_PartB), ElementsAre(Pair("c", EventProperty(true))));
+
+    storage.properties.erase("b");
+    storage.properties["d"] = EventProperty(4.0);
+    EXPECT_THAT(storage.GetMapView(DataCategory_PartC), ElementsAre(Pair("a", EventProperty(1)), Pair("d", EventProperty(4.0))));
+
+    EventPropertiesStorage storageCopy{storage};
+    EXPECT_THAT(storageCopy.GetMapView(DataCategory_PartC), ElementsAre(Pair("a", EventProperty(1)), Pair("d", EventProperty(4.0))));
+}
@@ -241,3 +241,34 @@ TEST(EventPropertiesTests, TryGetLevel_ValueSetBySetLevel_ReturnsTrueAndCorrectV
     EXPECT_TRUE(std::get<0>(result));
     EXPECT_EQ(std::get<1>(result), 42);
 }
+
+TEST(EventPropertiesTests, GetProperties_ReflectsLaterChanges)
+{
+    EventProperties ep("test");
+    for (int i = 0; i < 40; i++)
+    {
+        ep.SetProperty("prop" + std::to_string(i), static_cast<int64_t>(i));
+    }
+    EXPECT_THAT(ep.GetProperties(), SizeIs(41));
+    EXPECT_THAT(ep.GetProperties(), Contains(Pair("prop39", EventProperty(static_cast<int64_t>(39)))));
+
+    ep.erase("prop39");
+    ep.SetProperty("prop0", "replaced");
+    EXPECT_THAT(ep.GetProperties(), SizeIs(40));
+    EXPECT_THAT(ep.GetProperties(), Not(Contains(Key("prop39"))));
+    EXPECT_THAT(ep.GetProperties(), Contains(Pair("prop0", EventProperty("replaced"))));
+}
+
+TEST(EventPropertiesTests, GetProperties_AfterAssignment_ReturnsAssignedProperties)
+{
+    // Same number of changes on both sides, so that the flat maps are at the same version
+    EventProperties source("source");
+    source.SetProperty("fromSource", "yes");
+    EventProperties target("target");
+    target.SetProperty("fromTarget", "yes");
+    EXPECT_THAT(target.GetProperties(), Contains(Key("fromTarget")));
+
+    target = source;
+    EXPECT_THAT(target.GetProperties(), Contains(Key("fromSource")));
+    EXPECT_THAT(target.GetProperties(), Not(Contains(Key("fromTarget"))));
+}
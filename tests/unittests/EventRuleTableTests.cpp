@@ -0,0 +1,188 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "common/MockIRuntimeConfig.hpp"
+#include "filter/EventRuleTable.hpp"
+#include "stats/MetaStats.hpp"
+
+using namespace testing;
+using namespace MAT;
+
+namespace
+{
+    VariantMap Rule(const char* name, const char* action = "drop", int64_t rate = 0)
+    {
+        VariantMap rule;
+        rule[CFG_STR_EVENT_RULE_NAME] = name;
+        rule[CFG_STR_EVENT_RULE_ACTION] = action;
+        if (rate != 0)
+        {
+            rule[CFG_INT_EVENT_RULE_RATE] = rate;
+        }
+        return rule;
+    }
+
+    size_t CountAllowed(EventRuleTable& table, std::string const& name, size_t events, TenantHandle tenant = InvalidTenantHandle, int level = EventRuleTable::AnyLevel)
+    {
+        size_t allowed = 0;
+        for (size_t i = 0; i < events; i++)
+        {
+            allowed += table.Allow(name, tenant, level) ? 1 : 0;
+        }
+        return allowed;
+    }
+}
+
+TEST(EventRuleTableTests, EmptyTableAllowsEverything)
+{
+    VariantMap rules;
+    EventRuleTable table(rules);
+    EXPECT_TRUE(table.Empty());
+    EXPECT_TRUE(table.Allow("Any.Event", InvalidTenantHandle, EventRuleTable::AnyLevel));
+}
+
+TEST(EventRuleTableTests, ExactAndPrefixNamesIgnoreCase)
+{
+    VariantMap rules;
+    rules["exact"] = Rule("Contoso.Noisy");
+    rules["prefix"] = Rule("Fabrikam.Debug.*");
+    EventRuleTable table(rules);
+
+    EXPECT_FALSE(table.Allow("contoso.NOISY", InvalidTenantHandle, EventRuleTable::AnyLevel));
+    EXPECT_TRUE(table.Allow("Contoso.Noisy2", InvalidTenantHandle, EventRuleTable::AnyLevel));
+    EXPECT_TRUE(table.Allow("Contoso.Nois", InvalidTenantHandle, EventRuleTable::AnyLevel));
+    EXPECT_FALSE(table.Allow("Fabrikam.Debug.", InvalidTenantHandle, EventRuleTable::AnyLevel));
+    EXPECT_FALSE(table.Allow("fabrikam.debug.trace", InvalidTenantHandle, EventRuleTable::AnyLevel));
+    EXPECT_TRUE(table.Allow("Fabrikam.Debu", InvalidTenantHandle, EventRuleTable::AnyLevel));
+
+    auto drops = table.GetDropCounts();
+    ASSERT_THAT(drops, SizeIs(2));
+    EXPECT_THAT(drops[0].name, Eq("exact"));
+    EXPECT_THAT(drops[0].dropped, Eq(1u));
+    EXPECT_THAT(drops[1].name, Eq("prefix"));
+    EXPECT_THAT(drops[1].dropped, Eq(2u));
+}
+
+TEST(EventRuleTableTests, MostSpecificRuleWins)
+{
+    VariantMap rules;
+    rules["all"] = Rule("*");
+    rules["keepPrefix"] = Rule("Contoso.*", "sample", 1);
+    rules["dropLonger"] = Rule("Contoso.Noisy.*");
+    rules["keepExact"] = Rule("Contoso.Noisy.Wanted", "sample", 1);
+    EventRuleTable table(rules);
+
+    EXPECT_FALSE(table.Allow("Other", InvalidTenantHandle, EventRuleTable::AnyLevel));
+    EXPECT_TRUE(table.Allow("Contoso.Event", InvalidTenantHandle, EventRuleTable::AnyLevel));
+    EXPECT_FALSE(table.Allow("Contoso.Noisy.Event", InvalidTenantHandle, EventRuleTable::AnyLevel));
+    EXPECT_TRUE(table.Allow("Contoso.Noisy.Wanted", InvalidTenantHandle, EventRuleTable::AnyLevel));
+}
+
+TEST(EventRuleTableTests, TenantAndLevelConditions)
+{
+    TenantHandle tenant1 = TenantRegistry::instance().Register("rules-tenant1-token");
+    TenantHandle tenant2 = TenantRegistry::instance().Register("rules-tenant2-token");
+    VariantMap rules;
+    rules["tenant"] = Rule("Contoso.*");
+    rules["tenant"][CFG_STR_EVENT_RULE_TENANT] = "rules-tenant1-token";
+    rules["level"] = Rule("*");
+    rules["level"][CFG_INT_EVENT_RULE_LEVEL] = 3;
+    EventRuleTable table(rules);
+    EXPECT_TRUE(table.UsesLevel());
+
+    EXPECT_FALSE(table.Allow("Contoso.Event", tenant1, 1));
+    EXPECT_TRUE(table.Allow("Contoso.Event", tenant2, 1));
+    EXPECT_FALSE(table.Allow("Contoso.Event", tenant2, 3));
+    EXPECT_TRUE(table.Allow("Other", tenant1, 2));
+    EXPECT_FALSE(table.Allow("Other", tenant1, 3));
+}
+
+TEST(EventRuleTableTests, LevelIsResolvedOnlyForRulesWithLevel)
+{
+    VariantMap rules;
+    rules["name"] = Rule("Contoso.*");
+    rules["level"] = Rule("Fabrikam.*");
+    rules["level"][CFG_INT_EVENT_RULE_LEVEL] = 3;
+    EventRuleTable table(rules);
+
+    int resolved = 0;
+    auto getLevel = [&resolved]() {
+        resolved++;
+        return 3;
+    };
+    EXPECT_TRUE(table.Allow("Other", InvalidTenantHandle, getLevel));
+    EXPECT_FALSE(table.Allow("Contoso.Event", InvalidTenantHandle, getLevel));
+    EXPECT_THAT(resolved, Eq(0));
+    EXPECT_FALSE(table.Allow("Fabrikam.Event", InvalidTenantHandle, getLevel));
+    EXPECT_THAT(resolved, Eq(1));
+}
+
+TEST(EventRuleTableTests, SampleKeepsOneInN)
+{
+    VariantMap rules;
+    rules["sample"] = Rule("Sampled", "sample", 10);
+    EventRuleTable table(rules);
+    EXPECT_THAT(CountAllowed(table, "Sampled", 100), Eq(10u));
+    EXPECT_THAT(table.GetDropCounts()[0].dropped, Eq(90u));
+}
+
+TEST(EventRuleTableTests, RateLimitKeepsNPerSecond)
+{
+    VariantMap rules;
+    rules["limit"] = Rule("Limited", "rateLimit", 5);
+    EventRuleTable table(rules);
+    // Retry across a second boundary
+    size_t allowed = 0;
+    for (int attempt = 0; attempt < 3; attempt++)
+    {
+        allowed = CountAllowed(table, "Limited", 20);
+        if (allowed == 5)
+        {
+            break;
+        }
+    }
+    EXPECT_THAT(allowed, Eq(5u));
+}
+
+TEST(EventRuleTableTests, InvalidRulesAreSkipped)
+{
+    VariantMap rules;
+    rules["badAction"] = Rule("A", "explode");
+    rules["noRate"] = Rule("B", "sample");
+    rules["notAMap"] = "C";
+    rules["good"] = Rule("D");
+    EventRuleTable table(rules);
+
+    auto drops = table.GetDropCounts();
+    ASSERT_THAT(drops, SizeIs(1));
+    EXPECT_THAT(drops[0].name, Eq("good"));
+    EXPECT_TRUE(table.Allow("A", InvalidTenantHandle, EventRuleTable::AnyLevel));
+    EXPECT_TRUE(table.Allow("B", InvalidTenantHandle, EventRuleTable::AnyLevel));
+    EXPECT_FALSE(table.Allow("D", InvalidTenantHandle, EventRuleTable::AnyLevel));
+}
+
+TEST(EventRuleTableTests, MetaStatsReportsDropsSinceLastEvent)
+{
+    NiceMock<MockIRuntimeConfig> config;
+    EXPECT_CALL(config, GetMetaStatsSendIntervalSec()).WillRepeatedly(Return(0));
+    EXPECT_CALL(config, GetMetaStatsTenantToken()).WillRepeatedly(Return("metastats-tenant-token"));
+    MetaStats metaStats(config);
+    VariantMap rules;
+    rules["noisy"] = Rule("Noisy");
+    EventRuleTable table(rules);
+    CountAllowed(table, "Noisy", 7);
+
+    metaStats.updateOnEventRuleDrops(table.GetDropCounts());
+    auto records = metaStats.generateStatsEvent(ACT_STATS_ROLLUP_KIND_START);
+    ASSERT_THAT(records, SizeIs(1));
+    EXPECT_THAT(records[0].data[0].properties.at("rule_noisy_drp").stringValue, Eq("7"));
+
+    CountAllowed(table, "Noisy", 2);
+    metaStats.updateOnEventRuleDrops(table.GetDropCounts());
+    records = metaStats.generateStatsEvent(ACT_STATS_ROLLUP_KIND_STOP);
+    ASSERT_THAT(records, SizeIs(1));
+    EXPECT_THAT(records[0].data[0].properties.at("rule_noisy_drp").stringValue, Eq("2"));
+}
@@ -0,0 +1,95 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "utils/FifoRing.hpp"
+
+#include <memory>
+#include <vector>
+
+using namespace testing;
+using namespace MAT;
+
+namespace
+{
+    std::vector<int> Drain(FifoRing<int>& ring)
+    {
+        std::vector<int> result;
+        while (!ring.Empty())
+        {
+            result.push_back(ring.PopFront());
+        }
+        return result;
+    }
+}
+
+TEST(FifoRingTests, PopFrontReturnsElementsInFifoOrderAcrossGrowth)
+{
+    FifoRing<int> ring;
+    // Wrap around before growing, so that growth has to unwrap the elements
+    for (int i = 0; i < 10; i++)
+    {
+        ring.PushBack(std::move(i));
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        EXPECT_THAT(ring.PopFront(), Eq(i));
+    }
+    for (int i = 10; i < 50; i++)
+    {
+        ring.PushBack(std::move(i));
+    }
+    EXPECT_THAT(ring.Size(), Eq(42u));
+    EXPECT_THAT(ring[0], Eq(8));
+    EXPECT_THAT(ring[41], Eq(49));
+
+    std::vector<int> expected;
+    for (int i = 8; i < 50; i++)
+    {
+        expected.push_back(i);
+    }
+    EXPECT_THAT(Drain(ring), ContainerEq(expected));
+}
+
+TEST(FifoRingTests, PushFrontGoesAheadOfQueuedElements)
+{
+    FifoRing<int> ring;
+    ring.PushBack(2);
+    ring.PushBack(3);
+    ring.PushFront(1);
+    ring.PushFront(0);
+    EXPECT_THAT(Drain(ring), ElementsAre(0, 1, 2, 3));
+}
+
+TEST(FifoRingTests, RemoveIfKeepsOrderAndReleasesRemovedElements)
+{
+    FifoRing<std::shared_ptr<int>> ring;
+    auto shared = std::make_shared<int>(-1);
+    for (int i = 0; i < 6; i++)
+    {
+        ring.PushBack((i % 2) ? std::shared_ptr<int>(shared) : std::make_shared<int>(i));
+    }
+    EXPECT_THAT(shared.use_count(), Eq(4));
+
+    EXPECT_THAT(ring.RemoveIf([](std::shared_ptr<int> const& value) { return *value < 0; }), Eq(3u));
+    EXPECT_THAT(shared.use_count(), Eq(1));
+    ASSERT_THAT(ring.Size(), Eq(3u));
+    EXPECT_THAT(*ring.PopFront(), Eq(0));
+    EXPECT_THAT(*ring.PopFront(), Eq(2));
+    EXPECT_THAT(*ring.PopFront(), Eq(4));
+}
+
+TEST(FifoRingTests, ClearEmptiesTheRing)
+{
+    FifoRing<int> ring;
+    for (int i = 0; i < 20; i++)
+    {
+        ring.PushBack(std::move(i));
+    }
+    ring.Clear();
+    EXPECT_TRUE(ring.Empty());
+    ring.PushBack(7);
+    EXPECT_THAT(Drain(ring), ElementsAre(7));
+}
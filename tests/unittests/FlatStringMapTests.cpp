@@ -0,0 +1,94 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "utils/FlatStringMap.hpp"
+
+#include <string>
+
+using namespace testing;
+using namespace MAT;
+
+TEST(FlatStringMapTests, Subscript_InsertsOnceAndKeepsInsertionOrder)
+{
+    FlatStringMap<int> map;
+    map["b"] = 1;
+    map["a"] = 2;
+    map["b"] = 3;
+
+    ASSERT_THAT(map.size(), Eq(2u));
+    auto it = map.cbegin();
+    EXPECT_THAT(it->first, Eq("b"));
+    EXPECT_THAT(it->second, Eq(3));
+    ++it;
+    EXPECT_THAT(it->first, Eq("a"));
+    EXPECT_THAT(it->second, Eq(2));
+}
+
+TEST(FlatStringMapTests, Find_WorksBelowAndAboveLinearScanLimit)
+{
+    FlatStringMap<int> map;
+    const int count = 100;
+    for (int i = 0; i < count; i++)
+    {
+        map["property_" + std::to_string(i)] = i;
+        for (int j = 0; j <= i; j++)
+        {
+            const auto& constMap = map;
+            auto it = constMap.find("property_" + std::to_string(j));
+            ASSERT_TRUE(it != constMap.cend());
+            ASSERT_THAT(it->second, Eq(j));
+        }
+    }
+    const auto& constMap = map;
+    EXPECT_TRUE(constMap.find("property_100") == constMap.cend());
+}
+
+TEST(FlatStringMapTests, Erase_RemovesEntryAndKeepsOthersReachable)
+{
+    FlatStringMap<int> map;
+    for (int i = 0; i < 20; i++)
+    {
+        map[std::to_string(i)] = i;
+    }
+    EXPECT_THAT(map.erase("7"), Eq(1u));
+    EXPECT_THAT(map.erase("7"), Eq(0u));
+    EXPECT_THAT(map.size(), Eq(19u));
+
+    const auto& constMap = map;
+    EXPECT_TRUE(constMap.find("7") == constMap.cend());
+    for (int i = 0; i < 20; i++)
+    {
+        if (i != 7)
+        {
+            ASSERT_THAT(constMap.find(std::to_string(i))->second, Eq(i));
+        }
+    }
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_TRUE(constMap.find("1") == constMap.cend());
+}
+
+TEST(FlatStringMapTests, Version_ChangesOnNonConstAccessOnly)
+{
+    FlatStringMap<int> map;
+    map["a"] = 1;
+    uint64_t version = map.Version();
+
+    const auto& constMap = map;
+    constMap.find("a");
+    for (auto& kv : constMap)
+    {
+        (void)kv;
+    }
+    EXPECT_THAT(map.Version(), Eq(version));
+
+    map["a"] = 2;
+    EXPECT_THAT(map.Version(), Ne(version));
+    version = map.Version();
+    map.erase("a");
+    EXPECT_THAT(map.Version(), Ne(version));
+}
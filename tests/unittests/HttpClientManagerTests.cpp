@@ -50,7 +50,7 @@ TEST_F(HttpClientManagerTests, HandlesRequestFlow)
     auto ctx = std::make_shared<EventsUploadContext>();
     ctx->httpRequestId = req->GetId();
     ctx->httpRequest = req;
-    ctx->recordIdsAndTenantIds["r1"] = "t1"; ctx->recordIdsAndTenantIds["r2"] = "t1";
+    ctx->recordIdsAndTenantIds["r1"] = TenantRegistry::instance().Register("t1"); ctx->recordIdsAndTenantIds["r2"] = ctx->recordIdsAndTenantIds["r1"];
     ctx->latency = EventLatency_Normal;
     ctx->packageIds["tenant1-token"] = 0;
 
@@ -2,6 +2,7 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 //
+#include "mat/config.h"
 #ifdef HAVE_MAT_DEFAULT_HTTP_CLIENT
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
@@ -10,6 +11,10 @@
 #include "common/HttpServer.hpp"
 #include "http/HttpClientFactory.hpp"
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
 using namespace testing;
 using namespace MAT;
 
@@ -30,6 +35,12 @@ class HttpClientTests : public ::testing::Test,
     std::vector<RequestState>            _countedRequests;
     std::mutex                           _lock;
 
+    // Requests to /wait/ are held by the server until ReleaseWaiting()
+    std::mutex                           _waitLock;
+    std::condition_variable              _waitChanged;
+    bool                                 _waitEntered = false;
+    bool                                 _waitReleased = false;
+
   public:
     HttpClientTests()
     {
@@ -49,6 +60,19 @@ class HttpClientTests : public ::testing::Test,
         return (_responses.size() > 0);
     }
 
+    bool WaitEntered()
+    {
+        std::unique_lock<std::mutex> lock(_waitLock);
+        return _waitChanged.wait_for(lock, std::chrono::seconds(20), [this]() { return _waitEntered; });
+    }
+
+    void ReleaseWaiting()
+    {
+        std::lock_guard<std::mutex> lock(_waitLock);
+        _waitReleased = true;
+        _waitChanged.notify_all();
+    }
+
     virtual void SetUp() override
     {
         _port = _server.addListeningPort(0);
@@ -59,6 +83,7 @@ class HttpClientTests : public ::testing::Test,
         _server.addHandler("/simple/", *this);
         _server.addHandler("/echo/",   *this);
         _server.addHandler("/count/",  *this);
+        _server.addHandler("/wait/",   *this);
         _server.start();
 
         Clear();
@@ -66,6 +91,7 @@ class HttpClientTests : public ::testing::Test,
 
     virtual void TearDown() override
     {
+        ReleaseWaiting();
         _server.stop();
         _client.reset();
         Clear();
@@ -87,6 +113,16 @@ class HttpClientTests : public ::testing::Test,
             return 200;
         }
 
+        if (request.uri == "/wait/") {
+            std::unique_lock<std::mutex> lock(_waitLock);
+            _waitEntered = true;
+            _waitChanged.notify_all();
+            _waitChanged.wait(lock, [this]() { return _waitReleased; });
+            inResponse.headers["Content-Type"] = "text/plain";
+            inResponse.content = "Released";
+            return 200;
+        }
+
         if (request.uri.substr(0, 7) == "/count/") {
             int id = atoi(request.uri.substr(7).c_str());
             if (id >= 0 && static_cast<size_t>(id) < _countedRequests.size()) {
@@ -276,6 +312,75 @@ TEST_F(HttpClientTests, HandlesCancellation)
     _response.release();
 }
 
+TEST_F(HttpClientTests, HandlesCancellationInFlight)
+{
+    Clear();
+    std::unique_ptr<IHttpRequest> request(_client->CreateRequest());
+    std::string requestId = request->GetId();
+    request->SetUrl("http://" + _hostname + "/wait/");
+    _client->SendRequestAsync(request.release(), this);
+    ASSERT_TRUE(WaitEntered());
+
+    // The server still holds the request: only the client can end it
+    _client->CancelRequestAsync(requestId);
+    for (int i = 0; i < 200 && !responseReceived(); i++) {
+        PAL::sleep(100);
+    }
+
+    ASSERT_THAT(_responses, SizeIs(1));
+    std::unique_ptr<IHttpResponse> _response(_responses[0]);
+    EXPECT_THAT(_response->GetId(), requestId);
+    EXPECT_THAT(_response->GetResult(), HttpResult_Aborted);
+    _response.release();
+}
+
+TEST_F(HttpClientTests, CompletesRequestsInParallel)
+{
+    Clear();
+    std::vector<std::string> requestIds;
+    for (int i = 0; i < 8; i++) {
+        IHttpRequest* request = _client->CreateRequest();
+        request->SetUrl("http://" + _hostname + "/simple/200");
+        requestIds.push_back(request->GetId());
+        _client->SendRequestAsync(request, this);
+    }
+
+    for (int i = 0; i < 200 && _responses.size() < requestIds.size(); i++) {
+        PAL::sleep(100);
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    std::vector<std::string> responseIds;
+    for (auto response : _responses) {
+        responseIds.push_back(response->GetId());
+        EXPECT_THAT(response->GetResult(), HttpResult_OK);
+        EXPECT_THAT(response->GetStatusCode(), 200u);
+    }
+    EXPECT_THAT(responseIds, UnorderedElementsAreArray(requestIds));
+}
+
+TEST_F(HttpClientTests, ShutsDownWithRequestInFlight)
+{
+    Clear();
+    IHttpRequest* request = _client->CreateRequest();
+    request->SetUrl("http://" + _hostname + "/wait/");
+    _client->SendRequestAsync(request, this);
+    ASSERT_TRUE(WaitEntered());
+
+    // The client goes away without waiting for the server. The request
+    // is dropped, or at most reported as aborted.
+    auto start = std::chrono::steady_clock::now();
+    _client.reset();
+    EXPECT_THAT(std::chrono::steady_clock::now() - start, Lt(std::chrono::seconds(10)));
+    ReleaseWaiting();
+    PAL::sleep(200);
+    std::lock_guard<std::mutex> lock(_lock);
+    for (auto response : _responses) {
+        EXPECT_THAT(response->GetResult(), HttpResult_Aborted);
+    }
+    delete request;
+}
+
 TEST_F(HttpClientTests, Handles100Continue)
 {
     Clear();
@@ -4,7 +4,11 @@
 //
 
 #include "common/Common.hpp"
+#include "bond/All.hpp"
+#include "bond/generated/CsProtocol_writers.hpp"
 #include "compression/HttpDeflateCompression.hpp"
+#include "compression/PresetDictionary.hpp"
+#include "compression/ZstdCompressor.hpp"
 #include "config/RuntimeConfig_Default.hpp"
 
 #include <utils/ZlibUtils.hpp>
@@ -175,3 +179,185 @@ TEST_F(HttpDeflateCompressionTests, CompressesGzipCorrectly)
     EXPECT_THAT(event->compressed, true);
     config[CFG_MAP_HTTP]["contentEncoding"] = "deflate";
 }
+
+TEST_F(HttpDeflateCompressionTests, CompressesSplicedBodyViews)
+{
+    config[CFG_MAP_HTTP][CFG_BOOL_HTTP_COMPRESSION] = true;
+    EventsUploadContextPtr event = std::make_shared<EventsUploadContext>();
+
+    std::vector<uint8_t> expected;
+    auto blob = std::make_shared<std::vector<uint8_t>>();
+    for (int i = 0; i < 100000; i++)
+    {
+        blob->push_back(static_cast<uint8_t>(i % 251));
+    }
+    // Views in a different order than the blob, plus a second blob
+    auto other = std::make_shared<const std::vector<uint8_t>>(testPayload);
+    event->splicedBody.append(BlobView { blob, 50000, 50000 });
+    event->splicedBody.append(BlobView { other, 0, other->size() });
+    event->splicedBody.append(BlobView { blob, 0, 50000 });
+    event->splicedBody.gather(expected);
+
+    EXPECT_CALL(*this, resultSucceeded(event)).Times(1);
+    input(event);
+
+    std::vector<uint8_t> inflated;
+    ZlibUtils::InflateVector(event->body, inflated, false);
+    EXPECT_TRUE(inflated == expected);
+    EXPECT_THAT(event->compressed, true);
+    EXPECT_TRUE(event->splicedBody.empty());
+}
+
+TEST_F(HttpDeflateCompressionTests, FinishesStreamingBody)
+{
+    config[CFG_MAP_HTTP][CFG_BOOL_HTTP_COMPRESSION] = true;
+    EventsUploadContextPtr event = std::make_shared<EventsUploadContext>();
+    event->deflate = DeflateStream::Acquire();
+    ASSERT_TRUE(event->deflate->begin(DeflateSettings::FromConfig(config), event->body, 0));
+    ASSERT_TRUE(event->deflate->write(testPayload.data(), 3));
+    ASSERT_TRUE(event->deflate->write(testPayload.data() + 3, testPayload.size() - 3));
+
+    EXPECT_CALL(*this, resultSucceeded(event)).Times(1);
+    input(event);
+
+    std::vector<uint8_t> inflated;
+    ZlibUtils::InflateVector(event->body, inflated, false);
+    EXPECT_THAT(inflated, Eq(testPayload));
+    EXPECT_THAT(event->compressed, true);
+    EXPECT_FALSE(event->deflate);
+}
+
+TEST_F(HttpDeflateCompressionTests, HonorsCompressionLevelAndStrategy)
+{
+    config[CFG_MAP_HTTP][CFG_BOOL_HTTP_COMPRESSION] = true;
+    std::vector<uint8_t> payload(4096, 7);
+
+    config[CFG_MAP_HTTP][CFG_INT_HTTP_COMPRESSION_LEVEL] = 0;
+    {
+        HttpDeflateCompression stored(config);
+        EventsUploadContextPtr event = std::make_shared<EventsUploadContext>();
+        event->body = payload;
+        stored.compress(event);
+
+        // Level 0 only wraps the input into stored blocks
+        EXPECT_THAT(event->body, SizeIs(Gt(payload.size())));
+        std::vector<uint8_t> inflated;
+        ZlibUtils::InflateVector(event->body, inflated, false);
+        EXPECT_THAT(inflated, Eq(payload));
+    }
+
+    config[CFG_MAP_HTTP][CFG_INT_HTTP_COMPRESSION_LEVEL] = 9;
+    config[CFG_MAP_HTTP][CFG_STR_HTTP_COMPRESSION_STRATEGY] = "huffman";
+    {
+        HttpDeflateCompression huffman(config);
+        EventsUploadContextPtr event = std::make_shared<EventsUploadContext>();
+        event->body = payload;
+        huffman.compress(event);
+
+        // Huffman-only coding cannot use matches: about one bit per byte
+        EXPECT_THAT(event->body, SizeIs(Gt(payload.size() / 10)));
+        std::vector<uint8_t> inflated;
+        ZlibUtils::InflateVector(event->body, inflated, false);
+        EXPECT_THAT(inflated, Eq(payload));
+        EXPECT_THAT(event->compressed, true);
+    }
+
+    config[CFG_MAP_HTTP][CFG_INT_HTTP_COMPRESSION_LEVEL] = -1;
+    config[CFG_MAP_HTTP][CFG_STR_HTTP_COMPRESSION_STRATEGY] = "default";
+}
+
+TEST_F(HttpDeflateCompressionTests, ReusesThreadStream)
+{
+    DeflateSettings settings = DeflateSettings::FromConfig(config);
+    std::vector<uint8_t> first;
+    std::vector<uint8_t> second;
+
+    std::unique_ptr<DeflateStream> stream = DeflateStream::Acquire();
+    DeflateStream* raw = stream.get();
+    ASSERT_TRUE(stream->begin(settings, first, testPayload.size()));
+    ASSERT_TRUE(stream->write(testPayload.data(), testPayload.size()));
+    ASSERT_TRUE(stream->finish());
+    DeflateStream::Release(std::move(stream));
+
+    // The reset stream produces the same output as a fresh one
+    stream = DeflateStream::Acquire();
+    EXPECT_THAT(stream.get(), Eq(raw));
+    ASSERT_TRUE(stream->begin(settings, second, testPayload.size()));
+    ASSERT_TRUE(stream->write(testPayload.data(), testPayload.size()));
+    ASSERT_TRUE(stream->finish());
+    EXPECT_THAT(second, Eq(first));
+    EXPECT_FALSE(stream->active());
+    DeflateStream::Release(std::move(stream));
+}
+
+TEST_F(HttpDeflateCompressionTests, CompressesWithPresetDictionary)
+{
+    config[CFG_MAP_HTTP][CFG_BOOL_HTTP_COMPRESSION] = true;
+
+    // A single small event, where plain deflate has nothing to match against
+    ::CsProtocol::Record record;
+    record.ver = "3.0";
+    record.name = "Contoso.Product.FeatureUsed";
+    record.iKey = "o:7c8b1796cbc44bd5a03803c01c2b9d61";
+    record.extSdk.push_back(::CsProtocol::Sdk());
+    record.extSdk[0].libVer = "EVT-Linux-C++-No-3.7.62.1";
+    record.extDevice.push_back(::CsProtocol::Device());
+    record.extDevice[0].localId = "c:67e3d13727e94486a0cd8c0d55eeb41b";
+    record.extNet.push_back(::CsProtocol::Net());
+    record.extNet[0].cost = "Unmetered";
+    record.extNet[0].type = "Wired";
+    record.data.push_back(::CsProtocol::Data());
+    record.data[0].properties["Session.Id"].stringValue = "39d9160f-396d-4427-ad76-9dedc5dea386";
+    std::vector<uint8_t> payload;
+    bond_lite::CompactBinaryProtocolWriter writer(payload);
+    bond_lite::Serialize(writer, record);
+
+    EventsUploadContextPtr plain = std::make_shared<EventsUploadContext>();
+    plain->body = payload;
+    compression.compress(plain);
+    EXPECT_THAT(plain->contentEncoding, Eq("deflate"));
+
+    config[CFG_MAP_HTTP][CFG_STR_HTTP_CONTENT_ENCODING] = "deflate-dict";
+    HttpDeflateCompression dictCompression(config);
+    EventsUploadContextPtr event = std::make_shared<EventsUploadContext>();
+    event->body = payload;
+    dictCompression.compress(event);
+    config[CFG_MAP_HTTP][CFG_STR_HTTP_CONTENT_ENCODING] = "deflate";
+
+    EXPECT_THAT(event->compressed, true);
+    EXPECT_THAT(event->contentEncoding, Eq("deflate-dict"));
+    EXPECT_THAT(event->body.size(), Lt(plain->body.size()));
+
+    std::vector<uint8_t> inflated;
+    EXPECT_TRUE(ZlibUtils::InflateVector(event->body, inflated, PresetDictionary::CsProtocol()));
+    EXPECT_THAT(inflated, Eq(payload));
+}
+
+#ifdef HAVE_MAT_ZSTD
+TEST_F(HttpDeflateCompressionTests, CompressesZstdCorrectly)
+{
+    config[CFG_MAP_HTTP][CFG_BOOL_HTTP_COMPRESSION] = true;
+    config[CFG_MAP_HTTP][CFG_STR_HTTP_CONTENT_ENCODING] = "zstd";
+    HttpDeflateCompression zstdCompression(config);
+    config[CFG_MAP_HTTP][CFG_STR_HTTP_CONTENT_ENCODING] = "deflate";
+
+    std::vector<uint8_t> payload(100000);
+    for (size_t i = 0; i < payload.size(); i++)
+    {
+        payload[i] = static_cast<uint8_t>(i % 251);
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        EventsUploadContextPtr event = std::make_shared<EventsUploadContext>();
+        event->body = payload;
+        zstdCompression.compress(event);
+
+        EXPECT_THAT(event->compressed, true);
+        EXPECT_THAT(event->contentEncoding, Eq("zstd"));
+        EXPECT_THAT(event->body, SizeIs(Lt(payload.size() / 10)));
+        std::vector<uint8_t> decompressed;
+        EXPECT_TRUE(ZstdDecompress(event->body, decompressed));
+        EXPECT_THAT(decompressed, Eq(payload));
+    }
+}
+#endif
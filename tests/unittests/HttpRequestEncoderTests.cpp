@@ -75,6 +75,20 @@ TEST_F(HttpRequestEncoderTests, SetsAllParameters)
     EXPECT_THAT(req->m_latency, Eq(EventLatency_RealTime));
 }
 
+TEST_F(HttpRequestEncoderTests, GathersUncompressedSplicedBody)
+{
+    EventsUploadContextPtr ctx = std::make_shared<EventsUploadContext>();
+    auto blob = std::make_shared<const std::vector<uint8_t>>(std::vector<uint8_t>{1, 2, 3, 4, 5});
+    ctx->splicedBody.append(BlobView { blob, 3, 2 });
+    ctx->splicedBody.append(BlobView { blob, 0, 3 });
+
+    encoder.encode(ctx);
+
+    SimpleHttpRequest const* req = static_cast<SimpleHttpRequest*>(ctx->httpRequest);
+    EXPECT_THAT(req->m_body, Eq(std::vector<uint8_t>{4, 5, 1, 2, 3}));
+    EXPECT_TRUE(ctx->splicedBody.empty());
+}
+
 TEST_F(HttpRequestEncoderTests, AddsCompressionHeader)
 {
     EventsUploadContextPtr ctx = std::make_shared<EventsUploadContext>();
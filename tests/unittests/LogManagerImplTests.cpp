@@ -4,7 +4,12 @@
 //
 #include "api/LogManagerImpl.hpp"
 #include "common/Common.hpp"
+#include <atomic>
+#include <condition_variable>
 #include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 using namespace testing;
 using namespace MAT;
@@ -143,6 +148,60 @@ TEST(LogManagerImplTests, WaitOnResume)
     logManager.EndActivity();
 }
 
+TEST(LogManagerImplTests, PauseWhileLogging)
+{
+    ILogConfiguration configuration;
+    auto httpClient = std::make_shared<TestHttpClient>();
+    configuration.AddModule(CFG_MODULE_HTTP_CLIENT, httpClient);
+    TestLogManagerImpl logManager{configuration};
+    logManager.PauseTransmission();
+    ILogger* logger = logManager.GetLogger("stress");
+
+    std::atomic<bool> done{false};
+    std::atomic<int> inside{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&, i]() {
+            while (!done)
+            {
+                if (i % 2)
+                {
+                    logger->LogEvent("PauseWhileLogging");
+                }
+                else if (logManager.StartActivity())
+                {
+                    inside++;
+                    std::this_thread::yield();
+                    inside--;
+                    logManager.EndActivity();
+                }
+            }
+        });
+    }
+
+    for (int round = 0; round < 50; round++)
+    {
+        logManager.PauseActivity();
+        logManager.WaitPause();
+        EXPECT_EQ(0, inside.load());
+        EXPECT_FALSE(logManager.StartActivity());
+        std::this_thread::yield();
+        EXPECT_EQ(0, inside.load());
+        logManager.ResumeActivity();
+        std::this_thread::yield();
+    }
+
+    // Tear down while the loggers are still in use: their calls become no-ops
+    logManager.FlushAndTeardown();
+    EXPECT_EQ(0, inside.load());
+    done = true;
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
 class LogManagerModuleTests : public ::testing::Test
 {
    public:
@@ -214,3 +273,415 @@ TEST(LogManagerImplTests, Constructor_DataViewerCollectionIsNotNullptr_DataViewe
     TestLogManagerImpl logManager{configuration, true};
     ASSERT_NO_THROW(logManager.GetDataViewerCollection());
 }
+
+class BlockingDataInspector : public IDataInspector
+{
+   public:
+    void SetEnabled(bool) noexcept override {}
+    bool IsEnabled() const noexcept override { return true; }
+    void InspectSemanticContext(const std::string&, const std::string&, bool, const std::string&) noexcept override {}
+    void InspectSemanticContext(const std::string&, GUID_t, bool, const std::string&) noexcept override {}
+    const char* GetName() const noexcept override { return "BlockingDataInspector"; }
+
+    bool InspectRecord(::CsProtocol::Record& record) noexcept override
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_names.push_back(record.name);
+        m_entered.notify_all();
+        m_released.wait(lock, [this]() { return m_isReleased; });
+        return true;
+    }
+
+    void WaitEntered()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_entered.wait(lock, [this]() { return !m_names.empty(); });
+    }
+
+    void Release()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isReleased = true;
+        m_released.notify_all();
+    }
+
+    std::vector<std::string> GetNames()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_names;
+    }
+
+   protected:
+    std::mutex m_mutex;
+    std::condition_variable m_entered;
+    std::condition_variable m_released;
+    bool m_isReleased = false;
+    std::vector<std::string> m_names;
+};
+
+class DroppedEventListener : public DebugEventListener
+{
+   public:
+    std::atomic<size_t> dropped{0};
+    void OnDebugEvent(DebugEvent& evt) override
+    {
+        if (evt.type == EVT_DROPPED)
+        {
+            dropped += evt.param1;
+        }
+    }
+};
+
+class LogManagerIngestionQueueTests : public ::testing::Test
+{
+   public:
+    ILogConfiguration configuration;
+    std::shared_ptr<BlockingDataInspector> inspector = std::make_shared<BlockingDataInspector>();
+    DroppedEventListener listener;
+
+    void RunOverflowScenario(const char* policy)
+    {
+        configuration[CFG_INT_INGESTION_QUEUE_SIZE] = 2;
+        configuration[CFG_STR_INGESTION_QUEUE_OVERFLOW] = policy;
+        configuration[CFG_INT_INGESTION_QUEUE_BLOCK_TIME] = 10;
+        TestLogManagerImpl logManager{configuration};
+        logManager.AddEventListener(EVT_DROPPED, listener);
+        logManager.SetDataInspector(inspector);
+        auto logger = logManager.GetLogger("ingestion-token");
+
+        // The first event is picked up by the dispatcher thread and parks
+        // in the inspector, so the following ones stay in the queue.
+        logger->LogEvent("Event1");
+        inspector->WaitEntered();
+        logger->LogEvent("Event2");
+        logger->LogEvent("Event3");
+        logger->LogEvent("Event4");
+        EXPECT_THAT(listener.dropped.load(), Eq(1u));
+
+        inspector->Release();
+        logManager.Flush();
+        logManager.RemoveEventListener(EVT_DROPPED, listener);
+        logManager.FlushAndTeardown();
+    }
+};
+
+TEST_F(LogManagerIngestionQueueTests, DropNewest_FullQueue_DiscardsIncomingEvent)
+{
+    RunOverflowScenario("dropNewest");
+    EXPECT_THAT(inspector->GetNames(), ElementsAre("Event1", "Event2", "Event3"));
+}
+
+TEST_F(LogManagerIngestionQueueTests, DropOldest_FullQueue_EvictsQueuedEvent)
+{
+    RunOverflowScenario("dropOldest");
+    EXPECT_THAT(inspector->GetNames(), ElementsAre("Event1", "Event3", "Event4"));
+}
+
+TEST_F(LogManagerIngestionQueueTests, Block_FullQueue_DiscardsIncomingEventAfterTimeout)
+{
+    RunOverflowScenario("block");
+    EXPECT_THAT(inspector->GetNames(), ElementsAre("Event1", "Event2", "Event3"));
+}
+
+TEST_F(LogManagerIngestionQueueTests, Block_FullQueue_WaitsForRoom)
+{
+    configuration[CFG_INT_INGESTION_QUEUE_SIZE] = 2;
+    configuration[CFG_STR_INGESTION_QUEUE_OVERFLOW] = "block";
+    configuration[CFG_INT_INGESTION_QUEUE_BLOCK_TIME] = 60000;
+    TestLogManagerImpl logManager{configuration};
+    logManager.AddEventListener(EVT_DROPPED, listener);
+    logManager.SetDataInspector(inspector);
+    auto logger = logManager.GetLogger("ingestion-token");
+
+    logger->LogEvent("Event1");
+    inspector->WaitEntered();
+    logger->LogEvent("Event2");
+    logger->LogEvent("Event3");
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([logger]() { logger->LogEvent("Event4"); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    inspector->Release();
+    producer.join();
+    EXPECT_THAT(std::chrono::steady_clock::now() - start, Lt(std::chrono::seconds(30)));
+    EXPECT_THAT(listener.dropped.load(), Eq(0u));
+
+    logManager.Flush();
+    logManager.RemoveEventListener(EVT_DROPPED, listener);
+    logManager.FlushAndTeardown();
+    EXPECT_THAT(inspector->GetNames(), ElementsAre("Event1", "Event2", "Event3", "Event4"));
+}
+
+/// <summary>
+/// Logs more events than the queue holds from within the drain, on the dispatcher thread.
+/// </summary>
+class ReentrantDataInspector : public BlockingDataInspector
+{
+   public:
+    ILogger* logger = nullptr;
+
+    bool InspectRecord(::CsProtocol::Record& record) noexcept override
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_names.push_back(record.name);
+        }
+        if (record.name == "Event1")
+        {
+            for (auto name : { "Inner1", "Inner2", "Inner3" })
+            {
+                logger->LogEvent(name);
+            }
+        }
+        return true;
+    }
+};
+
+TEST_F(LogManagerIngestionQueueTests, Block_ProducerOnDispatcherThread_DrainsInline)
+{
+    configuration[CFG_INT_INGESTION_QUEUE_SIZE] = 2;
+    configuration[CFG_STR_INGESTION_QUEUE_OVERFLOW] = "block";
+    configuration[CFG_INT_INGESTION_QUEUE_BLOCK_TIME] = 60000;
+    TestLogManagerImpl logManager{configuration};
+    logManager.AddEventListener(EVT_DROPPED, listener);
+    auto reentrant = std::make_shared<ReentrantDataInspector>();
+    reentrant->logger = logManager.GetLogger("ingestion-token");
+    logManager.SetDataInspector(reentrant);
+
+    auto start = std::chrono::steady_clock::now();
+    reentrant->logger->LogEvent("Event1");
+    logManager.Flush();
+    EXPECT_THAT(std::chrono::steady_clock::now() - start, Lt(std::chrono::seconds(30)));
+    EXPECT_THAT(listener.dropped.load(), Eq(0u));
+
+    logManager.RemoveEventListener(EVT_DROPPED, listener);
+    logManager.FlushAndTeardown();
+    EXPECT_THAT(reentrant->GetNames(), ElementsAre("Event1", "Inner1", "Inner2", "Inner3"));
+}
+
+/// <summary>
+/// Task dispatcher that never runs the tasks queued to it.
+/// </summary>
+class StalledTaskDispatcher : public ITaskDispatcher
+{
+   public:
+    ~StalledTaskDispatcher() noexcept
+    {
+        for (auto task : m_tasks)
+        {
+            delete task;
+        }
+    }
+    void Join() override {}
+    void Queue(Task* task) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(task);
+    }
+    bool Cancel(Task*, uint64_t) override
+    {
+        return false;
+    }
+
+   protected:
+    std::mutex m_mutex;
+    std::vector<Task*> m_tasks;
+};
+
+TEST_F(LogManagerIngestionQueueTests, Teardown_DispatcherNotRunningDrains_DrainsInline)
+{
+    configuration[CFG_INT_INGESTION_QUEUE_SIZE] = 16;
+    configuration.AddModule(CFG_MODULE_TASK_DISPATCHER, std::make_shared<StalledTaskDispatcher>());
+    TestLogManagerImpl logManager{configuration};
+    inspector->Release();
+    logManager.SetDataInspector(inspector);
+    auto logger = logManager.GetLogger("ingestion-token");
+    logger->LogEvent("Event1");
+    logger->LogEvent("Event2");
+    EXPECT_THAT(inspector->GetNames(), IsEmpty());
+
+    logManager.FlushAndTeardown();
+    EXPECT_THAT(inspector->GetNames(), ElementsAre("Event1", "Event2"));
+}
+
+TEST_F(LogManagerIngestionQueueTests, EventsFromManyThreadsAreAllProcessed)
+{
+    configuration[CFG_INT_INGESTION_QUEUE_SIZE] = 4096;
+    TestLogManagerImpl logManager{configuration};
+    inspector->Release();
+    logManager.SetDataInspector(inspector);
+    auto logger = logManager.GetLogger("ingestion-token");
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++)
+    {
+        threads.emplace_back([logger]() {
+            for (int i = 0; i < 100; i++)
+            {
+                logger->LogEvent("ThreadedEvent");
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    logManager.FlushAndTeardown();
+    EXPECT_THAT(inspector->GetNames().size(), Eq(800u));
+}
+
+class PropertyCapturingDataInspector : public BlockingDataInspector
+{
+   public:
+    bool InspectRecord(::CsProtocol::Record& record) noexcept override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!record.data.empty())
+        {
+            auto it = record.data[0].properties.find("Inspected");
+            m_values.push_back((it != record.data[0].properties.end()) ? it->second.stringValue : "");
+        }
+        m_partBCount += record.baseData.size();
+        m_extAppCount += record.extApp.size();
+        return true;
+    }
+
+    std::vector<std::string> m_values;
+    size_t m_partBCount = 0;
+    size_t m_extAppCount = 0;
+};
+
+TEST(LogManagerImplTests, DirectBondEncoding_DataInspectorSeesEventProperties)
+{
+    for (uint32_t queueSize : {0u, 64u})
+    {
+        ILogConfiguration configuration;
+        configuration[CFG_BOOL_DIRECT_BOND_ENCODING] = true;
+        configuration[CFG_INT_INGESTION_QUEUE_SIZE] = queueSize;
+        TestLogManagerImpl logManager{configuration};
+        EXPECT_TRUE(logManager.IsDirectBondEncodingEnabled());
+        auto inspector = std::make_shared<PropertyCapturingDataInspector>();
+        logManager.SetDataInspector(inspector);
+
+        EventProperties props("DirectEvent");
+        props.SetProperty("Inspected", "value");
+        props.SetProperty("PartB", "value", PiiKind_None, DataCategory_PartB);
+        logManager.GetLogger("direct-token")->LogEvent(props);
+        logManager.FlushAndTeardown();
+
+        EXPECT_THAT(inspector->m_values, ElementsAre("value"));
+        EXPECT_THAT(inspector->m_partBCount, Eq(1u));
+        EXPECT_THAT(inspector->m_extAppCount, Eq(1u));
+    }
+}
+
+class LoggedRecordListener : public DebugEventListener
+{
+   public:
+    std::vector<std::string> deviceIds;
+    void OnDebugEvent(DebugEvent& evt) override
+    {
+        auto const& record = *static_cast<::CsProtocol::Record*>(evt.data);
+        deviceIds.push_back(record.extDevice.empty() ? "<deferred>" : record.extDevice[0].localId);
+    }
+};
+
+TEST(LogManagerImplTests, DirectBondEncoding_DropPiiScrubsContextExtensions)
+{
+    ILogConfiguration configuration;
+    configuration[CFG_BOOL_DIRECT_BOND_ENCODING] = true;
+    TestLogManagerImpl logManager{configuration};
+    logManager.GetSemanticContext().SetDeviceId("device");
+    LoggedRecordListener listener;
+    logManager.AddEventListener(EVT_LOG_EVENT, listener);
+
+    auto logger = logManager.GetLogger("direct-token");
+    logger->LogEvent("Deferred");
+    EventProperties props("Scrubbed");
+    props.SetPolicyBitFlags(MICROSOFT_EVENTTAG_DROP_PII);
+    logger->LogEvent(props);
+
+    logManager.RemoveEventListener(EVT_LOG_EVENT, listener);
+    logManager.FlushAndTeardown();
+    ASSERT_THAT(listener.deviceIds, SizeIs(2));
+    EXPECT_THAT(listener.deviceIds[0], Eq("<deferred>"));
+    EXPECT_THAT(listener.deviceIds[1], StartsWith("r:"));
+}
+
+class LoggedEventListener : public DebugEventListener
+{
+   public:
+    std::atomic<size_t> logged{0};
+    std::atomic<size_t> filtered{0};
+    std::atomic<size_t> added{0};
+    void OnDebugEvent(DebugEvent& evt) override
+    {
+        if (evt.type == EVT_LOG_EVENT)
+        {
+            logged++;
+        }
+        else if (evt.type == EVT_FILTERED)
+        {
+            filtered++;
+        }
+        else if (evt.type == EVT_ADDED)
+        {
+            added++;
+        }
+    }
+};
+
+TEST(LogManagerImplTests, LogEvents_StoresEventsInOrder)
+{
+    for (uint32_t queueSize : {0u, 64u})
+    {
+        for (bool batch : {true, false})
+        {
+            ILogConfiguration configuration;
+            configuration[CFG_INT_INGESTION_QUEUE_SIZE] = queueSize;
+            auto httpClient = std::make_shared<TestHttpClient>();
+            configuration.AddModule(CFG_MODULE_HTTP_CLIENT, httpClient);
+            TestLogManagerImpl logManager{configuration};
+            logManager.PauseTransmission();
+            logManager.SetLevelFilter(DIAG_LEVEL_OPTIONAL, DIAG_LEVEL_OPTIONAL, DIAG_LEVEL_OPTIONAL);
+            auto inspector = std::make_shared<BlockingDataInspector>();
+            inspector->Release();
+            logManager.SetDataInspector(inspector);
+            LoggedEventListener listener;
+            logManager.AddEventListener(EVT_LOG_EVENT, listener);
+            logManager.AddEventListener(EVT_FILTERED, listener);
+            logManager.AddEventListener(EVT_ADDED, listener);
+
+            std::vector<EventProperties> events;
+            for (auto name : {"Batch1", "Batch2", "Dropped", "Filtered", "Batch3"})
+            {
+                events.emplace_back(name);
+            }
+            events[2].SetLatency(EventLatency_Off);
+            events[3].SetLevel(DIAG_LEVEL_REQUIRED);
+            auto logger = logManager.GetLogger("batch-token");
+            if (batch)
+            {
+                logger->LogEvents(events);
+            }
+            else
+            {
+                for (auto const& event : events)
+                {
+                    logger->LogEvent(event);
+                }
+            }
+            logManager.Flush();
+
+            // Both paths raise the same debug events
+            EXPECT_THAT(inspector->GetNames(), ElementsAre("Batch1", "Batch2", "Batch3"));
+            EXPECT_THAT(listener.logged.load(), Eq(5u));
+            EXPECT_THAT(listener.filtered.load(), Eq(1u));
+            EXPECT_THAT(listener.added.load(), Eq(3u));
+
+            logManager.RemoveEventListener(EVT_LOG_EVENT, listener);
+            logManager.RemoveEventListener(EVT_FILTERED, listener);
+            logManager.RemoveEventListener(EVT_ADDED, listener);
+            logManager.FlushAndTeardown();
+        }
+    }
+}
@@ -21,7 +21,7 @@ public:
     using Logger::CanEventPropertiesBeSent;
 
     bool SubmitCalled = {};
-    void submit(::CsProtocol::Record&, const EventProperties&) override
+    void submit(::CsProtocol::Record&, const EventProperties&, std::shared_ptr<const ContextFieldsSnapshot> const&, bool) override
     {
         SubmitCalled = true;
     }
@@ -325,3 +325,32 @@ TEST_F(LoggerTests, LogSession_CanEventPropertiesBeSentReturnsTrue_CallsSubmit)
 }
 
 
+
+TEST(LoggerEventRulesTests, RuleDropsEventBeforeSubmit)
+{
+    ILogConfiguration configuration;
+    configuration[CFG_MAP_EVENT_RULES]["noisy"][CFG_STR_EVENT_RULE_NAME] = "Contoso.Noisy.*";
+    configuration[CFG_MAP_EVENT_RULES]["verbose"][CFG_INT_EVENT_RULE_LEVEL] = DIAG_LEVEL_FULL;
+    LogManagerImpl logManager(configuration);
+    ContextFieldsProvider contextFieldsProvider;
+    RuntimeConfig_Default runtimeConfig(configuration);
+    TestLogger logger("", "", "", logManager, contextFieldsProvider, runtimeConfig);
+
+    logger.LogEvent("Contoso.Noisy.Event");
+    EXPECT_FALSE(logger.SubmitCalled);
+
+    EventProperties full("Contoso.Quiet.Event", DIAG_LEVEL_FULL);
+    logger.LogEvent(full);
+    EXPECT_FALSE(logger.SubmitCalled);
+
+    // Named events default to DIAG_LEVEL_OPTIONAL
+    logger.LogEvent("Contoso.Quiet.Event");
+    EXPECT_TRUE(logger.SubmitCalled);
+
+    auto drops = logManager.GetEventRules()->GetDropCounts();
+    ASSERT_THAT(drops, SizeIs(2));
+    EXPECT_THAT(drops[0].name, Eq("noisy"));
+    EXPECT_THAT(drops[0].dropped, Eq(1u));
+    EXPECT_THAT(drops[1].name, Eq("verbose"));
+    EXPECT_THAT(drops[1].dropped, Eq(1u));
+}
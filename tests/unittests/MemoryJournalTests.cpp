@@ -0,0 +1,345 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "common/Common.hpp"
+#include "common/MockIOfflineStorage.hpp"
+#include "common/MockIOfflineStorageObserver.hpp"
+#include "common/MockIRuntimeConfig.hpp"
+#include "utils/Utils.hpp"
+#include "offline/MemoryJournal.hpp"
+#include "offline/MemoryStorage.hpp"
+#include "offline/OfflineStorageHandler.hpp"
+#include "system/TenantRegistry.hpp"
+#include <fstream>
+#include <iterator>
+#include <stdio.h>
+
+#include "NullObjects.hpp"
+
+using namespace testing;
+using namespace MAT;
+
+char const* const TEST_JOURNAL_FILENAME = "MemoryJournalTests.db";
+
+class NullTaskDispatcher : public ITaskDispatcher
+{
+   public:
+    virtual void Join() override {}
+    virtual void Queue(Task* task) override
+    {
+        delete task;
+    }
+    virtual bool Cancel(Task* task, uint64_t waitTime = 0) override
+    {
+        UNREFERENCED_PARAMETER(task);
+        UNREFERENCED_PARAMETER(waitTime);
+        return true;
+    }
+};
+
+// Handler with a journaled RAM queue in front of a mocked disk storage
+class JournaledStorageHandler : public OfflineStorageHandler
+{
+   public:
+    JournaledStorageHandler(ILogManager& logManager, IRuntimeConfig& config, ITaskDispatcher& taskDispatcher,
+        IOfflineStorageObserver& observer, std::shared_ptr<IOfflineStorage> const& disk) :
+        OfflineStorageHandler(logManager, config, taskDispatcher)
+    {
+        m_observer = &observer;
+        m_offlineStorageDisk = disk;
+        m_offlineStorageMemory.reset(new MemoryStorage(m_logManager, m_config));
+        m_offlineStorageMemory->Initialize(*this);
+    }
+
+    IOfflineStorage& Memory()
+    {
+        return *m_offlineStorageMemory;
+    }
+};
+
+struct MemoryJournalTests : public Test
+{
+    NiceMock<MockIRuntimeConfig>                    configMock;
+    NiceMock<MockIOfflineStorageObserver>           observerMock;
+    NullLogManager                                  logManager;
+    std::string                                     path;
+    HttpHeaders                                     headers;
+    bool                                            fromMemory = true;
+
+    virtual void SetUp() override
+    {
+        path = MAT::GetAppLocalTempDirectory() + TEST_JOURNAL_FILENAME;
+        configMock[CFG_STR_CACHE_FILE_PATH] = path;
+        configMock[CFG_INT_RAM_QUEUE_JOURNAL_SIZE] = 64 * 1024;
+        removeFiles();
+    }
+
+    virtual void TearDown() override
+    {
+        removeFiles();
+    }
+
+    void removeFiles()
+    {
+        ::remove((path + ".ramq0").c_str());
+        ::remove((path + ".ramq1").c_str());
+    }
+
+    static StorageRecord makeRecord(int i, EventLatency latency = EventLatency_Normal)
+    {
+        return StorageRecord("guid" + std::to_string(i), "token", latency, EventPersistence_Normal, 1 + i, StorageBlob(100, static_cast<uint8_t>(i)));
+    }
+
+    // What a crash at this point would leave on disk
+    std::vector<std::string> journalFiles()
+    {
+        std::vector<std::string> contents;
+        for (char const* suffix : { ".ramq0", ".ramq1" })
+        {
+            std::ifstream file(path + suffix, std::ios::binary);
+            contents.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        return contents;
+    }
+
+    void restoreJournalFiles(std::vector<std::string> const& contents)
+    {
+        char const* const suffixes[] = { ".ramq0", ".ramq1" };
+        for (size_t i = 0; i < contents.size(); i++)
+        {
+            std::ofstream file(path + suffixes[i], std::ios::binary | std::ios::trunc);
+            file.write(contents[i].data(), static_cast<std::streamsize>(contents[i].size()));
+        }
+    }
+
+    std::vector<std::string> recoveredIds()
+    {
+        MemoryJournal journal(path, 64 * 1024);
+        std::vector<StorageRecord> recovered;
+        EXPECT_TRUE(journal.Open(recovered));
+        return idsOf(recovered);
+    }
+
+    static std::vector<std::string> idsOf(std::vector<StorageRecord> const& records)
+    {
+        std::vector<std::string> ids;
+        for (auto const& record : records)
+        {
+            ids.push_back(record.id);
+        }
+        return ids;
+    }
+};
+
+TEST_F(MemoryJournalTests, StoredRecordsAreRecoveredWithAllFields)
+{
+    {
+        MemoryJournal journal(path, 64 * 1024);
+        std::vector<StorageRecord> recovered;
+        ASSERT_TRUE(journal.Open(recovered));
+        EXPECT_THAT(recovered, IsEmpty());
+        StorageRecord record = makeRecord(1, EventLatency_RealTime);
+        record.retryCount = 2;
+        ASSERT_TRUE(journal.Append(record));
+        ASSERT_TRUE(journal.Append(makeRecord(2)));
+        journal.Delete("guid2");
+        ASSERT_TRUE(journal.Append(makeRecord(3)));
+    }
+
+    MemoryJournal journal(path, 64 * 1024);
+    std::vector<StorageRecord> recovered;
+    ASSERT_TRUE(journal.Open(recovered));
+    ASSERT_THAT(idsOf(recovered), ElementsAre("guid1", "guid3"));
+    EXPECT_THAT(recovered[0].tenantToken, Eq("token"));
+    EXPECT_THAT(recovered[0].latency, Eq(EventLatency_RealTime));
+    EXPECT_THAT(recovered[0].timestamp, Eq(2));
+    EXPECT_THAT(recovered[0].retryCount, Eq(2));
+    EXPECT_THAT(recovered[0].blob, Eq(StorageBlob(100, 1)));
+}
+
+TEST_F(MemoryJournalTests, RewriteKeepsOnlyGivenRecords)
+{
+    {
+        MemoryJournal journal(path, 64 * 1024);
+        std::vector<StorageRecord> recovered;
+        ASSERT_TRUE(journal.Open(recovered));
+        std::vector<StorageRecord> records = { makeRecord(0), makeRecord(1), makeRecord(2) };
+        for (auto const& record : records)
+        {
+            ASSERT_TRUE(journal.Append(record));
+        }
+        EXPECT_THAT(journal.Rewrite({ &records[2] }), Eq(1u));
+        ASSERT_TRUE(journal.Append(makeRecord(3)));
+    }
+    EXPECT_THAT(recoveredIds(), ElementsAre("guid2", "guid3"));
+
+    {
+        // Once more, back into the first file, over its older entries
+        MemoryJournal journal(path, 64 * 1024);
+        std::vector<StorageRecord> recovered;
+        ASSERT_TRUE(journal.Open(recovered));
+        EXPECT_THAT(journal.Rewrite({}), Eq(0u));
+    }
+    EXPECT_THAT(recoveredIds(), IsEmpty());
+}
+
+TEST_F(MemoryJournalTests, FullJournalNeedsRewrite)
+{
+    MemoryJournal journal(path, 4096);
+    std::vector<StorageRecord> recovered;
+    ASSERT_TRUE(journal.Open(recovered));
+    EXPECT_FALSE(journal.NeedsRewrite());
+
+    int stored = 0;
+    while (journal.Append(makeRecord(stored)))
+    {
+        stored++;
+    }
+    EXPECT_THAT(stored, Gt(10));
+    EXPECT_TRUE(journal.NeedsRewrite());
+
+    StorageRecord last = makeRecord(stored);
+    EXPECT_THAT(journal.Rewrite({ &last }), Eq(1u));
+    EXPECT_FALSE(journal.NeedsRewrite());
+    EXPECT_THAT(journal.GetUsedSize(), Lt(200u));
+}
+
+TEST_F(MemoryJournalTests, MemoryStorageRecoversUndeliveredRecordsAfterCrash)
+{
+    {
+        MemoryStorage storage(logManager, configMock);
+        storage.Initialize(observerMock);
+        for (int i = 0; i < 4; i++)
+        {
+            ASSERT_TRUE(storage.StoreRecord(makeRecord(i)));
+        }
+        // guid0 is uploaded, guid1 is in flight when the process dies
+        std::vector<StorageRecordId> reserved;
+        storage.GetAndReserveRecords([&reserved](StorageRecord const& record) {
+            reserved.push_back(record.id);
+            return true;
+        }, 100000, EventLatency_Unspecified, 2);
+        ASSERT_THAT(reserved, ElementsAre("guid0", "guid1"));
+        storage.DeleteRecords({ "guid0" }, headers, fromMemory);
+        // No Shutdown: the storage goes away as in a crash
+    }
+
+    MemoryStorage storage(logManager, configMock);
+    storage.Initialize(observerMock);
+    EXPECT_THAT(storage.GetRecordCount(), Eq(3u));
+    EXPECT_THAT(idsOf(storage.GetRecords()), UnorderedElementsAre("guid1", "guid2", "guid3"));
+}
+
+TEST_F(MemoryJournalTests, MemoryStorageFlushStopsJournalingFlushedRecords)
+{
+    {
+        MemoryStorage storage(logManager, configMock);
+        storage.Initialize(observerMock);
+        for (int i = 0; i < 3; i++)
+        {
+            ASSERT_TRUE(storage.StoreRecord(makeRecord(i)));
+        }
+        // As OfflineStorageHandler::Flush does once the records are on disk
+        std::vector<StorageRecordId> flushed;
+        storage.GetAndReserveRecords([&flushed](StorageRecord const& record) {
+            flushed.push_back(record.id);
+            return true;
+        }, 100000);
+        EXPECT_THAT(flushed, SizeIs(3));
+        ASSERT_TRUE(storage.StoreRecord(makeRecord(3)));
+        storage.DeleteRecords(flushed, headers, fromMemory);
+        storage.Flush();
+    }
+
+    MemoryStorage storage(logManager, configMock);
+    storage.Initialize(observerMock);
+    EXPECT_THAT(idsOf(storage.GetRecords()), ElementsAre("guid3"));
+}
+
+TEST_F(MemoryJournalTests, MemoryStorageWithoutJournalSizeDoesNotCreateFiles)
+{
+    configMock[CFG_INT_RAM_QUEUE_JOURNAL_SIZE] = 0;
+    MemoryStorage storage(logManager, configMock);
+    storage.Initialize(observerMock);
+    ASSERT_TRUE(storage.StoreRecord(makeRecord(0)));
+    FILE* file = fopen((path + ".ramq0").c_str(), "rb");
+    EXPECT_THAT(file, IsNull());
+    if (file != nullptr)
+    {
+        fclose(file);
+    }
+}
+
+TEST_F(MemoryJournalTests, HandlerFlushKeepsBatchJournaledUntilItIsOnDisk)
+{
+    NullTaskDispatcher taskDispatcher;
+    auto disk = std::make_shared<StrictMock<MockIOfflineStorage>>();
+    std::vector<std::string> crashed;
+    {
+        JournaledStorageHandler handler(logManager, configMock, taskDispatcher, observerMock, disk);
+        for (int i = 0; i < 3; i++)
+        {
+            ASSERT_TRUE(handler.Memory().StoreRecord(makeRecord(i)));
+        }
+        EXPECT_CALL(*disk, StoreRecords(SizeIs(3)))
+            .WillOnce(Invoke([&](std::vector<StorageRecord>& records) {
+                // A record stored meanwhile gets the journal rewritten, then the process dies
+                EXPECT_TRUE(handler.Memory().StoreRecord(makeRecord(3)));
+                handler.Memory().Flush();
+                crashed = journalFiles();
+                return records.size();
+            }));
+        handler.Flush();
+        EXPECT_THAT(handler.Memory().GetRecordCount(), Eq(1u));
+        EXPECT_THAT(recoveredIds(), ElementsAre("guid3"));
+    }
+
+    restoreJournalFiles(crashed);
+    EXPECT_THAT(recoveredIds(), UnorderedElementsAre("guid0", "guid1", "guid2", "guid3"));
+}
+
+TEST_F(MemoryJournalTests, HandlerFlushKeepsRecordsTheDiskFailedToSave)
+{
+    NullTaskDispatcher taskDispatcher;
+    auto disk = std::make_shared<StrictMock<MockIOfflineStorage>>();
+    {
+        JournaledStorageHandler handler(logManager, configMock, taskDispatcher, observerMock, disk);
+        for (int i = 0; i < 3; i++)
+        {
+            ASSERT_TRUE(handler.Memory().StoreRecord(makeRecord(i)));
+        }
+        EXPECT_CALL(*disk, StoreRecords(SizeIs(3)))
+            .WillOnce(Invoke([](std::vector<StorageRecord>& records) {
+                // Saves the first and last records only, and moves them to the front
+                std::swap(records[1], records[2]);
+                return 2u;
+            }));
+        handler.Flush();
+        EXPECT_THAT(handler.Memory().GetRecordCount(), Eq(1u));
+    }
+    EXPECT_THAT(recoveredIds(), ElementsAre("guid1"));
+}
+
+TEST_F(MemoryJournalTests, RecordsWithTenantHandleOnlyAreJournaledAndFlushedWithToken)
+{
+    NullTaskDispatcher taskDispatcher;
+    auto disk = std::make_shared<StrictMock<MockIOfflineStorage>>();
+    JournaledStorageHandler handler(logManager, configMock, taskDispatcher, observerMock, disk);
+    // As logged: the record carries the tenant handle, not the token
+    StorageRecord record = makeRecord(0);
+    record.tenantToken.clear();
+    record.tenantHandle = TenantRegistry::instance().Register("tenant1-token");
+    ASSERT_TRUE(handler.Memory().StoreRecord(record));
+    {
+        MemoryJournal journal(path, 64 * 1024);
+        std::vector<StorageRecord> recovered;
+        ASSERT_TRUE(journal.Open(recovered));
+        ASSERT_THAT(recovered, SizeIs(1));
+        EXPECT_THAT(recovered[0].tenantToken, Eq("tenant1-token"));
+    }
+
+    EXPECT_CALL(*disk, StoreRecords(ElementsAre(Field(&StorageRecord::tenantToken, Eq("tenant1-token")))))
+        .WillOnce(Return(1u));
+    handler.Flush();
+}
@@ -220,8 +220,8 @@ TEST(MemoryStorageTests, ReleaseRecords)
     // Retrieve those into records
     std::vector<StorageRecord> records;
 
-    auto consumer = [&records](StorageRecord&& record) -> bool {
-        records.push_back(std::move(record));
+    auto consumer = [&records](StorageRecord const& record) -> bool {
+        records.push_back(record);
         return true; // want more
     };
 
@@ -263,12 +263,12 @@ TEST(MemoryStorageTests, GetAndReserveSome)
 #pragma warning(disable : 5258)  // warning C5258: explicit capture of 'howMany' is not required for this use
 #endif
     storage.GetAndReserveRecords(
-        [&someRecords, howMany] (StorageRecord && record)->bool
+        [&someRecords, howMany] (StorageRecord const& record)->bool
         {
             if (someRecords.size() >= howMany) {
                 return false;
             }
-            someRecords.emplace_back(std::move(record));
+            someRecords.emplace_back(record);
             return true;
         },
         EventLatency_Normal
@@ -284,6 +284,71 @@ TEST(MemoryStorageTests, GetAndReserveSome)
     EXPECT_EQ(totalCount - howMany, storage.GetRecordCount());
 }
 
+TEST(MemoryStorageTests, GetAndReserveRecordsIsFifo)
+{
+    MemoryStorage storage(testLogManager, testConfig);
+    for (uint8_t i = 0; i < 40; i++)
+    {
+        StorageRecord record{ std::to_string(i), "token", (i % 2) ? EventLatency_RealTime : EventLatency_Normal, EventPersistence_Normal, i, { i } };
+        storage.StoreRecord(record);
+    }
+
+    std::vector<std::string> ids;
+    storage.GetAndReserveRecords([&ids](StorageRecord const& record) -> bool {
+        ids.push_back(record.id);
+        return ids.size() < 4;
+    }, 1000);
+    // Higher latency first, oldest first; the declined fourth record stays queued
+    EXPECT_THAT(ids, ElementsAre("1", "3", "5", "7"));
+    EXPECT_THAT(storage.GetReservedCount(), 3u);
+
+    // Released records go back ahead of those queued after them
+    HttpHeaders headers;
+    bool fromMemory = true;
+    storage.ReleaseRecords({ "1", "3" }, true, headers, fromMemory);
+    auto records = storage.GetRecords(false, EventLatency_RealTime, 3);
+    ASSERT_THAT(records.size(), 3u);
+    EXPECT_THAT(records[0].id, Eq("1"));
+    EXPECT_THAT(records[0].retryCount, Eq(1));
+    EXPECT_THAT(records[0].reservedUntil, Eq(0));
+    EXPECT_THAT(records[1].id, Eq("3"));
+    EXPECT_THAT(records[2].id, Eq("7"));
+    EXPECT_THAT(storage.GetReservedCount(), 1u);
+}
+
+TEST(MemoryStorageTests, GetAndReserveRecordsLendsStoredRecords)
+{
+    MemoryStorage storage(testLogManager, testConfig);
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        StorageRecord record{ std::to_string(i), "token", EventLatency_Normal, EventPersistence_Normal, i, { i, 2, 3 } };
+        storage.StoreRecord(record);
+    }
+
+    // The consumer is lent the stored records themselves, and declines the second one
+    std::vector<uint8_t const*> lent;
+    storage.GetAndReserveRecords([&lent](StorageRecord const& record) -> bool {
+        lent.push_back(record.blob.data());
+        return (lent.size() < 2) && (record.reservedUntil > 0);
+    }, 1000);
+    EXPECT_THAT(storage.GetReservedCount(), 1u);
+
+    // Released and declined records are back in order, intact, and not copied
+    HttpHeaders headers;
+    bool fromMemory = true;
+    storage.ReleaseRecords({ "0" }, false, headers, fromMemory);
+    auto records = storage.GetRecords();
+    ASSERT_THAT(records.size(), 2u);
+    EXPECT_THAT(records[0].id, Eq("0"));
+    EXPECT_THAT(records[0].blob, ElementsAre(0, 2, 3));
+    EXPECT_THAT(records[0].blob.data(), Eq(lent[0]));
+    EXPECT_THAT(records[0].reservedUntil, Eq(0));
+    EXPECT_THAT(records[1].id, Eq("1"));
+    EXPECT_THAT(records[1].blob, ElementsAre(1, 2, 3));
+    EXPECT_THAT(records[1].blob.data(), Eq(lent[1]));
+    EXPECT_THAT(records[1].reservedUntil, Eq(0));
+}
+
 // This method is not implemented for RAM storage
 TEST(MemoryStorageTests, StoreSetting)
 {
@@ -41,8 +41,8 @@ TEST_F(MetaStatsTests, GenerateStartEvent)
     stats.updateOnStorageOpened("MyStorage/Normal");
     stats.updateOnPostData(postDataLength, false);
 
-    std::map<std::string, std::string> recordIdAndTenantid;
-    recordIdAndTenantid["r"] = "t";
+    std::map<std::string, TenantHandle> recordIdAndTenantid;
+    recordIdAndTenantid["r"] = TenantRegistry::instance().Register("t");
     stats.updateOnPackageSentSucceeded(recordIdAndTenantid, EventLatency_Normal,        0,   333, std::vector<unsigned>{ 1333 },          false);
     stats.updateOnPackageSentSucceeded(recordIdAndTenantid, EventLatency_Normal,     1,   444, std::vector<unsigned>{ 1444, 2444 },    false);
     stats.updateOnPackageSentSucceeded(recordIdAndTenantid, EventLatency_RealTime,       3,  5555, std::vector<unsigned>{ 15, 255, 3555 }, false);
@@ -69,8 +69,8 @@ TEST_F(MetaStatsTests, GenerateStopEvent)
     EXPECT_CALL(runtimeConfigMock, GetMetaStatsSendIntervalSec()).WillRepeatedly(Return(0));
     EXPECT_CALL(runtimeConfigMock, GetMetaStatsTenantToken()).WillRepeatedly(Return("metastats-tenant-token"));
     stats.updateOnPostData(16, false);
-    std::map<std::string, std::string> recordIdAndTenantid;
-    recordIdAndTenantid["r"] = "t";
+    std::map<std::string, TenantHandle> recordIdAndTenantid;
+    recordIdAndTenantid["r"] = TenantRegistry::instance().Register("t");
     stats.updateOnPackageSentSucceeded(recordIdAndTenantid, EventLatency_RealTime, 1, 99, std::vector<unsigned>{ 100, 101, 102, 103, 104, 105, 106 }, false);
     stats.updateOnPackageFailed(501);
     stats.updateOnPackageFailed(403);
@@ -87,7 +87,7 @@ TEST_F(MetaStatsTests, NoNewDataOrMetastatsOnlyGenerateNoEvents)
     EXPECT_CALL(runtimeConfigMock, GetMetaStatsTenantToken()).WillRepeatedly(Return("metastats-tenant-token"));
 
     // Send one normal event first to verify that stats are reset on generation.
-    stats.updateOnEventIncoming("t1", 123, EventLatency_RealTime, false);
+    stats.updateOnEventIncoming(TenantRegistry::instance().Register("t1"), 123, EventLatency_RealTime, false);
     auto events = stats.generateStatsEvent(ACT_STATS_ROLLUP_KIND_ONGOING);
     EXPECT_THAT(events, SizeIs(1));
 
@@ -99,11 +99,11 @@ TEST_F(MetaStatsTests, NoNewDataOrMetastatsOnlyGenerateNoEvents)
     EXPECT_THAT(events, SizeIs(0));
 
     // Simulate logging and uploading some metastats events only. Nothing should be generated either.
-    stats.updateOnEventIncoming("s",123, EventLatency_RealTime, true);
-    stats.updateOnEventIncoming("s",123, EventLatency_Normal, true);
+    stats.updateOnEventIncoming(TenantRegistry::instance().Register("s"), 123, EventLatency_RealTime, true);
+    stats.updateOnEventIncoming(TenantRegistry::instance().Register("s"), 123, EventLatency_Normal, true);
     stats.updateOnPostData(123, true);
-    std::map<std::string, std::string> recordIdAndTenantid;
-    recordIdAndTenantid["r"] = "t";
+    std::map<std::string, TenantHandle> recordIdAndTenantid;
+    recordIdAndTenantid["r"] = TenantRegistry::instance().Register("t");
     stats.updateOnPackageSentSucceeded(recordIdAndTenantid, EventLatency_RealTime, 0, 123, std::vector<unsigned>{ 1234 }, true);
     events = stats.generateStatsEvent(ACT_STATS_ROLLUP_KIND_ONGOING);
     //EXPECT_THAT(events, SizeIs(0));
@@ -111,9 +111,9 @@ TEST_F(MetaStatsTests, NoNewDataOrMetastatsOnlyGenerateNoEvents)
     //EXPECT_THAT(events, SizeIs(0));
 
     // Verify events are generated again once some normal event arrives.
-    stats.updateOnEventIncoming("t1",123, EventLatency_RealTime, false);
+    stats.updateOnEventIncoming(TenantRegistry::instance().Register("t1"), 123, EventLatency_RealTime, false);
     // Even if the last record is metastats.
-    stats.updateOnEventIncoming("t1",123, EventLatency_RealTime, true);
+    stats.updateOnEventIncoming(TenantRegistry::instance().Register("t1"), 123, EventLatency_RealTime, true);
     events = stats.generateStatsEvent(ACT_STATS_ROLLUP_KIND_ONGOING);
     //EXPECT_THAT(events, SizeIs(1));
     //EXPECT_THAT(events[0].Extension, Contains(Pair("records_received_count",   "4")));
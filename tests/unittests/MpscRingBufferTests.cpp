@@ -0,0 +1,117 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "utils/MpscRingBuffer.hpp"
+
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace MAT;
+
+TEST(MpscRingBufferTests, CapacityIsRoundedUpToPowerOfTwo)
+{
+    EXPECT_THAT(MpscRingBuffer<int>(0).Capacity(), Eq(2u));
+    EXPECT_THAT(MpscRingBuffer<int>(3).Capacity(), Eq(4u));
+    EXPECT_THAT(MpscRingBuffer<int>(64).Capacity(), Eq(64u));
+    EXPECT_THAT(MpscRingBuffer<int>(1000).Capacity(), Eq(1024u));
+}
+
+TEST(MpscRingBufferTests, PopReturnsElementsInFifoOrder)
+{
+    MpscRingBuffer<int> queue(8);
+    for (int i = 0; i < 5; i++)
+    {
+        ASSERT_TRUE(queue.Push(std::move(i)));
+    }
+    EXPECT_THAT(queue.Size(), Eq(5u));
+
+    int value = -1;
+    for (int i = 0; i < 5; i++)
+    {
+        ASSERT_TRUE(queue.Pop(value));
+        EXPECT_THAT(value, Eq(i));
+    }
+    EXPECT_FALSE(queue.Pop(value));
+    EXPECT_TRUE(queue.Empty());
+}
+
+TEST(MpscRingBufferTests, PushFailsWhenFullAndSucceedsAfterPop)
+{
+    MpscRingBuffer<int> queue(4);
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(queue.Push(std::move(i)));
+    }
+    int extra = 100;
+    EXPECT_FALSE(queue.Push(std::move(extra)));
+
+    int value = -1;
+    ASSERT_TRUE(queue.Pop(value));
+    EXPECT_THAT(value, Eq(0));
+    EXPECT_TRUE(queue.Push(std::move(extra)));
+
+    // Wrap around several times
+    for (int round = 0; round < 10; round++)
+    {
+        ASSERT_TRUE(queue.Pop(value));
+        int next = round + 1000;
+        ASSERT_TRUE(queue.Push(std::move(next)));
+    }
+    EXPECT_THAT(queue.Size(), Eq(4u));
+}
+
+TEST(MpscRingBufferTests, ConcurrentProducersDeliverEveryElementOnce)
+{
+    const int producers = 8;
+    const int perProducer = 20000;
+    MpscRingBuffer<int> queue(256);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&queue, p, perProducer]() {
+            for (int i = 0; i < perProducer; i++)
+            {
+                int value = p * perProducer + i;
+                while (!queue.Push(std::move(value)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> seen(producers * perProducer, 0);
+    std::vector<int> lastPerProducer(producers, -1);
+    int received = 0;
+    int value = 0;
+    while (received < producers * perProducer)
+    {
+        if (!queue.Pop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        seen[value]++;
+        // Elements from a single producer keep their relative order
+        int producer = value / perProducer;
+        EXPECT_GT(value, lastPerProducer[producer]);
+        lastPerProducer[producer] = value;
+        received++;
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_TRUE(queue.Empty());
+    for (int count : seen)
+    {
+        ASSERT_THAT(count, Eq(1));
+    }
+}
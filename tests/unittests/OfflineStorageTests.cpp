@@ -13,6 +13,7 @@ protected:
     StorageObserver         offlineStorage;
 
     RouteSink<OfflineStorageTests, IncomingEventContextPtr const&>                             storeRecordFailed{ this, &OfflineStorageTests::resultStoreRecordFailed };
+    RouteSink<OfflineStorageTests, IncomingEventContextPtr const&>                             recordStored{ this, &OfflineStorageTests::resultRecordStored };
     RouteSink<OfflineStorageTests, EventsUploadContextPtr const&, StorageRecord const&, bool&> retrievedEvent{ this, &OfflineStorageTests::resultRetrievedEvent };
     RouteSink<OfflineStorageTests, EventsUploadContextPtr const&>                              retrievalFinished{ this, &OfflineStorageTests::resultRetrievalFinished };
     RouteSink<OfflineStorageTests, EventsUploadContextPtr const&>                              retrievalFailed{ this, &OfflineStorageTests::resultRetrievalFailed };
@@ -27,6 +28,7 @@ protected:
         : offlineStorage(testing::getSystem(), offlineStorageMock)
     {
         offlineStorage.storeRecordFailed >> storeRecordFailed;
+        offlineStorage.recordStored >> recordStored;
         offlineStorage.retrievedEvent >> retrievedEvent;
         offlineStorage.retrievalFinished >> retrievalFinished;
         offlineStorage.retrievalFailed >> retrievalFailed;
@@ -38,6 +40,7 @@ protected:
     }
 
     MOCK_METHOD1(resultStoreRecordFailed, void(IncomingEventContextPtr const &));
+    MOCK_METHOD1(resultRecordStored, void(IncomingEventContextPtr const &));
     MOCK_METHOD3(resultRetrievedEvent, void(EventsUploadContextPtr const &, StorageRecord const &, bool&));
     MOCK_METHOD1(resultRetrievalFinished, void(EventsUploadContextPtr const &));
     MOCK_METHOD1(resultRetrievalFailed, void(EventsUploadContextPtr const &));
@@ -79,6 +82,66 @@ TEST_F(OfflineStorageTests, StoreRecordIsForwarded)
     EXPECT_THAT(offlineStorage.storeRecord(ctx), false);
 }
 
+TEST_F(OfflineStorageTests, StoreRecordsReportsEachEvent)
+{
+    std::vector<std::unique_ptr<IncomingEventContext>> owners;
+    std::vector<IncomingEventContextPtr> events;
+    for (auto const& id : {"a", "b", "c"})
+    {
+        owners.emplace_back(new IncomingEventContext(id, "tenant", EventLatency_Normal, EventPersistence_Normal, nullptr));
+        owners.back()->record.blob.assign(3, static_cast<uint8_t>(id[0]));
+        events.push_back(owners.back().get());
+    }
+
+    // Like OfflineStorageHandler with a killed tenant: "b" is not stored and moved to the end
+    EXPECT_CALL(offlineStorageMock, StoreRecords(SizeIs(3)))
+        .WillOnce(Invoke([](StorageRecordVector& records) -> size_t {
+            std::stable_partition(records.begin(), records.end(), [](StorageRecord const& record) { return record.blob[0] != 'b'; });
+            return 2;
+        }));
+    InSequence order;
+    EXPECT_CALL(*this, resultRecordStored(events[0]));
+    EXPECT_CALL(*this, resultStoreRecordFailed(events[1]));
+    EXPECT_CALL(*this, resultRecordStored(events[2]));
+    offlineStorage.storeRecords(events);
+
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        EXPECT_THAT(events[i]->record.blob, Each(Eq(static_cast<uint8_t>("abc"[i]))));
+        EXPECT_THAT(events[i]->record.timestamp, Near(PAL::getUtcSystemTimeMs(), 1000));
+    }
+}
+
+TEST_F(OfflineStorageTests, StoreRecordsMatchesEventsByRecordId)
+{
+    std::vector<std::unique_ptr<IncomingEventContext>> owners;
+    std::vector<IncomingEventContextPtr> events;
+    for (auto const& id : {"a", "b", "c"})
+    {
+        // Empty blobs: no buffer tells the records apart
+        owners.emplace_back(new IncomingEventContext(id, "tenant", EventLatency_Normal, EventPersistence_Normal, nullptr));
+        events.push_back(owners.back().get());
+    }
+
+    // A storage that hands back copies of the records it was given
+    EXPECT_CALL(offlineStorageMock, StoreRecords(SizeIs(3)))
+        .WillOnce(Invoke([](StorageRecordVector& records) -> size_t {
+            std::stable_partition(records.begin(), records.end(), [](StorageRecord const& record) { return record.id != "b"; });
+            StorageRecordVector copies(records);
+            records.swap(copies);
+            return 2;
+        }));
+    InSequence order;
+    EXPECT_CALL(*this, resultRecordStored(events[0]));
+    EXPECT_CALL(*this, resultStoreRecordFailed(events[1]));
+    EXPECT_CALL(*this, resultRecordStored(events[2]));
+    offlineStorage.storeRecords(events);
+
+    EXPECT_THAT(events[0]->record.id, Eq("a"));
+    EXPECT_THAT(events[1]->record.id, Eq("b"));
+    EXPECT_THAT(events[2]->record.id, Eq("c"));
+}
+
 TEST_F(OfflineStorageTests, RetrieveEventsPassesRecordsThrough)
 {
     auto ctx = std::make_shared<EventsUploadContext>();
@@ -89,9 +152,9 @@ TEST_F(OfflineStorageTests, RetrieveEventsPassesRecordsThrough)
     StorageRecord record2("r2", "tenant2-token", EventLatency_Normal, EventPersistence_Normal, 1234567891, std::vector<uint8_t>{2, 128, 0});
     EXPECT_CALL(offlineStorageMock, GetAndReserveRecords(_, Gt(1000u), ctx->requestedMinLatency, ctx->requestedMaxCount))
         .WillOnce(DoAll(
-            Invoke([&record1, &record2](std::function<bool(StorageRecord&&)> const& consumer, unsigned, EventLatency, unsigned) {
-        EXPECT_THAT(consumer(std::move(record1)), true);
-        EXPECT_THAT(consumer(std::move(record2)), false);
+            Invoke([&record1, &record2](std::function<bool(StorageRecord const&)> const& consumer, unsigned, EventLatency, unsigned) {
+        EXPECT_THAT(consumer(record1), true);
+        EXPECT_THAT(consumer(record2), false);
     }),
             Return(true)))
         .RetiresOnSaturation();
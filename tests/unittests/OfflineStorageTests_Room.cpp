@@ -202,7 +202,7 @@ TEST_P(OfflineStorageTestsRoom, TestBadFile)
     }
     badStorage->Initialize(observerMock);
     std::atomic<size_t> found(0);
-    EXPECT_FALSE(badStorage->GetAndReserveRecords( [&found](StorageRecord && record)->bool {
+    EXPECT_FALSE(badStorage->GetAndReserveRecords( [&found](StorageRecord const& record)->bool {
       found += 1;
       return true;
     }, 5));
@@ -279,7 +279,7 @@ TEST_P(OfflineStorageTestsRoom, TestGetAndReserveManyAcceptSome) {
         records.clear();
     }
     EXPECT_TRUE(offlineStorage->GetAndReserveRecords(
-            [&records](StorageRecord &&record) -> bool {
+            [&records](StorageRecord const& record) -> bool {
                 if (records.size() >= 256) {
                     return false;
                 }
@@ -294,7 +294,7 @@ TEST_P(OfflineStorageTestsRoom, TestGetAndReserveAcceptAll)
 {
     PopulateRecords();
     StorageRecordVector found;
-    EXPECT_TRUE(offlineStorage->GetAndReserveRecords( [&found](StorageRecord && record)->bool {
+    EXPECT_TRUE(offlineStorage->GetAndReserveRecords( [&found](StorageRecord const& record)->bool {
         found.push_back(record);
         return true;
     }, 5));
@@ -319,7 +319,7 @@ TEST_P(OfflineStorageTestsRoom, TestAcceptFunctor) {
     StorageRecordVector found;
     size_t calls = 0u;
     EXPECT_TRUE(offlineStorage->GetAndReserveRecords(
-            [&found, &calls](StorageRecord && record)->bool {
+            [&found, &calls](StorageRecord const& record)->bool {
                 ++calls;
                 if (record.latency == EventLatency_RealTime) {
                     found.push_back(record);
@@ -433,7 +433,7 @@ TEST_P(OfflineStorageTestsRoom, TestManyExpiredRecords) {
         manyRecords.clear();
         manyIds.clear();
         offlineStorage->GetAndReserveRecords(
-                [&manyRecords](StorageRecord &&record) -> bool {
+                [&manyRecords](StorageRecord const& record) -> bool {
                     manyRecords.emplace_back(record);
                     return true;
                 },
@@ -475,7 +475,7 @@ TEST_P(OfflineStorageTestsRoom, LastReadRecordCount) {
     offlineStorage->StoreRecords(records);
     records.clear();
     offlineStorage->GetAndReserveRecords(
-            [&records, consume](StorageRecord && record)->bool
+            [&records, consume](StorageRecord const& record)->bool
             {
                 if (records.size() >= consume) {
                     return false;
@@ -500,7 +500,7 @@ TEST_P(OfflineStorageTestsRoom, ReleaseActuallyReleases) {
             );
     offlineStorage->StoreRecord(r);
     offlineStorage->GetAndReserveRecords(
-            [](StorageRecord && record)->bool
+            [](StorageRecord const& record)->bool
             {
                 return false;
             },
@@ -509,16 +509,16 @@ TEST_P(OfflineStorageTestsRoom, ReleaseActuallyReleases) {
     EXPECT_EQ(unsigned { 0 }, offlineStorage->LastReadRecordCount());
     StorageRecordVector records;
     offlineStorage->GetAndReserveRecords(
-            [&records] (StorageRecord && record)->bool
+            [&records] (StorageRecord const& record)->bool
             {
-                records.emplace_back(std::move(record));
+                records.emplace_back(record);
                 return true;
             }, 5000
             );
     EXPECT_EQ(unsigned { 1 }, offlineStorage->LastReadRecordCount());
     EXPECT_EQ(size_t { 1 }, records.size());
     offlineStorage->GetAndReserveRecords(
-            [] (StorageRecord && record)->bool
+            [] (StorageRecord const& record)->bool
             {
                 ADD_FAILURE();
                 return false;
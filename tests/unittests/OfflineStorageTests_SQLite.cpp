@@ -101,10 +101,10 @@ struct OfflineStorageTests_SQLite : public Test
 
 class TestRecordConsumer {
   public:
-    operator std::function<bool(StorageRecord&&)>()
+    operator std::function<bool(StorageRecord const&)>()
     {
         // *INDENT-OFF* Uncrustify mangles this lambda's syntax a lot
-        return [=](StorageRecord&& record) -> bool {
+        return [=](StorageRecord const& record) -> bool {
             if (records.size() >= maxCount) {
                 return false;
             }
@@ -153,6 +153,65 @@ TEST_F(OfflineStorageTests_SQLite, GetAndReservedReturnsStoredRecord)
     EXPECT_THAT(consumer.records[0].reservedUntil, 0);
 }
 
+TEST_F(OfflineStorageTests_SQLite, StoreRecordsStoresWholeBatch)
+{
+    initializeStorage();
+    // Two full multi-row inserts plus a remainder stored row by row
+    std::vector<StorageRecord> records;
+    for (int i = 0; i < 150; i++)
+    {
+        records.emplace_back("guid" + std::to_string(i), (i % 2) ? "token1" : "token2", EventLatency_Normal, EventPersistence_Normal,
+                             1000 + i, StorageBlob(static_cast<size_t>(i % 7), static_cast<uint8_t>(i)));
+    }
+    records.emplace_back("invalid", "token1", EventLatency_Normal, EventPersistence_Normal, 0, StorageBlob());
+    records.emplace_back("realtime", "token1", EventLatency_RealTime, EventPersistence_Normal, 5000, StorageBlob {1, 2, 3});
+
+    EXPECT_CALL(observerMock, OnStorageFailed("Invalid parameters")).Times(1);
+    EXPECT_THAT(offlineStorage->StoreRecords(records), 151u);
+    EXPECT_THAT(offlineStorage->GetRecordCount(EventLatency_Unspecified), 151u);
+
+    TestRecordConsumer consumer;
+    EXPECT_THAT(offlineStorage->GetAndReserveRecords(consumer, 100000, EventLatency_RealTime), true);
+    ASSERT_THAT(consumer.records.size(), 1);
+    EXPECT_THAT(consumer.records[0].id, StrEq("realtime"));
+    EXPECT_THAT(consumer.records[0].blob, Eq(StorageBlob {1, 2, 3}));
+    consumer.records.clear();
+    EXPECT_THAT(offlineStorage->GetAndReserveRecords(consumer, 100000, EventLatency_Normal), true);
+    ASSERT_THAT(consumer.records.size(), 150);
+    for (auto const& record : consumer.records)
+    {
+        int i = atoi(record.id.c_str() + 4);
+        EXPECT_THAT(record.timestamp, 1000 + i);
+        EXPECT_THAT(record.tenantToken, StrEq((i % 2) ? "token1" : "token2"));
+        EXPECT_THAT(record.blob, Eq(StorageBlob(static_cast<size_t>(i % 7), static_cast<uint8_t>(i))));
+    }
+}
+
+TEST_F(OfflineStorageTests_SQLite, BinaryRecordIdsRoundTrip)
+{
+    initializeStorage();
+    std::string const id("\x00\x01\x02\x03\x04\x05\x06\x07\x00\x09\x0a\x0b\x0c\x0d\x0e\xff", 16);
+    ASSERT_THAT(offlineStorage->StoreRecord({id, "token", EventLatency_Normal, EventPersistence_Normal, 1, {1, 2}}), true);
+    ASSERT_THAT(offlineStorage->StoreRecord({"guid2", "token", EventLatency_Normal, EventPersistence_Normal, 2, {3}}), true);
+
+    TestRecordConsumer consumer;
+    EXPECT_THAT(offlineStorage->GetAndReserveRecords(consumer, 100000), true);
+    ASSERT_THAT(consumer.records.size(), 2);
+    EXPECT_THAT(consumer.records[0].id, Eq(id));
+    EXPECT_THAT(consumer.records[1].id, StrEq("guid2"));
+
+    // Releasing and deleting by the binary ID finds the stored record
+    HttpHeaders headers;
+    bool fromMemory = false;
+    offlineStorage->ReleaseRecords({id}, false, headers, fromMemory);
+    consumer.records.clear();
+    EXPECT_THAT(offlineStorage->GetAndReserveRecords(consumer, 100000), true);
+    ASSERT_THAT(consumer.records.size(), 1);
+    EXPECT_THAT(consumer.records[0].id, Eq(id));
+    offlineStorage->DeleteRecords({id, "guid2"}, headers, fromMemory);
+    EXPECT_THAT(offlineStorage->GetRecordCount(EventLatency_Unspecified), 0u);
+}
+
 TEST_F(OfflineStorageTests_SQLite, ReservedRecordIsNotReturned)
 {
     initializeStorage();
@@ -0,0 +1,388 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "mat/config.h"
+#ifdef HAVE_MAT_STORAGE
+
+#include "common/Common.hpp"
+#include "common/MockIOfflineStorageObserver.hpp"
+#include "common/MockIRuntimeConfig.hpp"
+#include "utils/FileUtils.hpp"
+#include "utils/Utils.hpp"
+#include "offline/OfflineStorage_Segments.hpp"
+#include <fstream>
+#include <iterator>
+#include <stdio.h>
+
+#include "NullObjects.hpp"
+
+using namespace testing;
+using namespace MAT;
+
+char const* const TEST_SEGMENTS_FILENAME = "OfflineStorageTests_Segments.db";
+
+struct OfflineStorageTests_Segments : public Test
+{
+    StrictMock<MockIRuntimeConfig>                  configMock;
+    StrictMock<MockIOfflineStorageObserver>         observerMock;
+    ILogManager *                                   logManager;
+    std::unique_ptr<OfflineStorage_Segments>        offlineStorage;
+    std::string                                     storageFilename;
+    HttpHeaders                                     headers;
+    bool                                            fromMemory = false;
+
+    virtual void SetUp() override
+    {
+        static NullLogManager nullLogManager;
+        logManager = &nullLogManager;
+
+        storageFilename = MAT::GetAppLocalTempDirectory() + TEST_SEGMENTS_FILENAME;
+        configMock["cacheFilePath"] = storageFilename;
+        removeFiles();
+    }
+
+    virtual void TearDown() override
+    {
+        if (offlineStorage)
+        {
+            offlineStorage->Shutdown();
+        }
+        removeFiles();
+    }
+
+    // 128 KiB make two slots of 64 KiB segments
+    void initializeStorage(unsigned maxSize = 128 * 1024)
+    {
+        EXPECT_CALL(configMock, GetOfflineStorageMaximumSizeBytes()).WillRepeatedly(Return(maxSize));
+        offlineStorage.reset(new OfflineStorage_Segments(*logManager, configMock));
+        reopen();
+    }
+
+    void reopen()
+    {
+        offlineStorage->Shutdown();
+        EXPECT_CALL(observerMock, OnStorageOpened("Segments/Default"))
+            .RetiresOnSaturation();
+        offlineStorage->Initialize(observerMock);
+    }
+
+    void removeFiles()
+    {
+        ::remove((storageFilename + ".idx").c_str());
+        ::remove((storageFilename + ".settings").c_str());
+        for (int i = 0; i < 8; i++)
+        {
+            ::remove((storageFilename + ".seg" + std::to_string(i)).c_str());
+        }
+    }
+
+    std::vector<StorageRecord> reserveAll(EventLatency minLatency = EventLatency_Unspecified, unsigned maxCount = 0)
+    {
+        std::vector<StorageRecord> records;
+        offlineStorage->GetAndReserveRecords([&records](StorageRecord const& record) {
+            records.push_back(record);
+            return true;
+        }, 100000, minLatency, maxCount);
+        return records;
+    }
+
+    std::vector<std::string> idsOf(std::vector<StorageRecord> const& records)
+    {
+        std::vector<std::string> ids;
+        for (auto const& record : records)
+        {
+            ids.push_back(record.id);
+        }
+        return ids;
+    }
+};
+
+TEST_F(OfflineStorageTests_Segments, StoredRecordIsReturnedWithAllFields)
+{
+    initializeStorage();
+    std::string const id("\x00\x01\x02\x03\x04\x05\x06\x07\x00\x09\x0a\x0b\x0c\x0d\x0e\xff", 16);
+    ASSERT_THAT(offlineStorage->StoreRecord({ id, "token", EventLatency_RealTime, EventPersistence_Critical, 1234, { 5, 4, 3, 2, 1 } }), true);
+
+    auto records = reserveAll();
+    ASSERT_THAT(records.size(), 1u);
+    EXPECT_THAT(records[0].id, Eq(id));
+    EXPECT_THAT(records[0].tenantToken, StrEq("token"));
+    EXPECT_THAT(records[0].latency, EventLatency_RealTime);
+    EXPECT_THAT(records[0].persistence, EventPersistence_Critical);
+    EXPECT_THAT(records[0].timestamp, 1234);
+    EXPECT_THAT(records[0].blob, StorageBlob({ 5, 4, 3, 2, 1 }));
+    EXPECT_THAT(records[0].retryCount, 0);
+    EXPECT_THAT(offlineStorage->GetRecordCount(EventLatency_RealTime), 1u);
+    EXPECT_THAT(offlineStorage->GetRecordCount(EventLatency_Normal), 0u);
+}
+
+TEST_F(OfflineStorageTests_Segments, RecordsAreReturnedByLatencyThenCriticalThenOldestFirst)
+{
+    initializeStorage();
+    ASSERT_THAT(offlineStorage->StoreRecord({ "n1", "token", EventLatency_Normal, EventPersistence_Normal, 1, {} }), true);
+    ASSERT_THAT(offlineStorage->StoreRecord({ "r1", "token", EventLatency_RealTime, EventPersistence_Normal, 2, {} }), true);
+    ASSERT_THAT(offlineStorage->StoreRecord({ "n2", "token", EventLatency_Normal, EventPersistence_Critical, 3, {} }), true);
+    ASSERT_THAT(offlineStorage->StoreRecord({ "n3", "token", EventLatency_Normal, EventPersistence_Normal, 4, {} }), true);
+    ASSERT_THAT(offlineStorage->StoreRecord({ "m1", "token", EventLatency_Max, EventPersistence_Normal, 5, {} }), true);
+
+    EXPECT_THAT(idsOf(reserveAll(EventLatency_RealTime)), ElementsAre("m1", "r1"));
+    EXPECT_THAT(idsOf(reserveAll(EventLatency_Normal, 2)), ElementsAre("n2", "n1"));
+    EXPECT_THAT(idsOf(reserveAll()), ElementsAre("n3"));
+    EXPECT_THAT(offlineStorage->LastReadRecordCount(), 1u);
+    EXPECT_THAT(reserveAll(), IsEmpty());
+}
+
+TEST_F(OfflineStorageTests_Segments, ReleasedAndExpiredRecordsAreReturnedAgainInOrder)
+{
+    initializeStorage();
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_THAT(offlineStorage->StoreRecord({ "guid" + std::to_string(i), "token", EventLatency_Normal, EventPersistence_Normal, 1 + i, {} }), true);
+    }
+    EXPECT_CALL(configMock, GetMaximumRetryCount()).WillRepeatedly(Return(5));
+
+    ASSERT_THAT(idsOf(reserveAll(EventLatency_Unspecified, 3)), ElementsAre("guid0", "guid1", "guid2"));
+    offlineStorage->ReleaseRecords({ "guid1" }, false, headers, fromMemory);
+    EXPECT_THAT(idsOf(reserveAll()), ElementsAre("guid1", "guid3"));
+
+    // A lease of 0 ms has run out by the next call
+    offlineStorage->ReleaseRecords({ "guid0", "guid1", "guid2", "guid3" }, false, headers, fromMemory);
+    std::vector<StorageRecord> leased;
+    offlineStorage->GetAndReserveRecords([&leased](StorageRecord const& record) {
+        leased.push_back(record);
+        return true;
+    }, 0, EventLatency_Unspecified, 2);
+    ASSERT_THAT(idsOf(leased), ElementsAre("guid0", "guid1"));
+    auto records = reserveAll();
+    ASSERT_THAT(idsOf(records), ElementsAre("guid0", "guid1", "guid2", "guid3"));
+    EXPECT_THAT(records[0].retryCount, 1);
+    EXPECT_THAT(records[2].retryCount, 0);
+}
+
+TEST_F(OfflineStorageTests_Segments, ReleasedRecordsCountRetriesAndAreDroppedOverMaximum)
+{
+    initializeStorage();
+    ASSERT_THAT(offlineStorage->StoreRecord({ "guid1", "token1", EventLatency_Normal, EventPersistence_Normal, 1, { 11 } }), true);
+    ASSERT_THAT(offlineStorage->StoreRecord({ "guid2", "token2", EventLatency_Normal, EventPersistence_Normal, 2, { 22 } }), true);
+
+    unsigned const MaxRetryCount = 2;
+    EXPECT_CALL(configMock, GetMaximumRetryCount()).WillRepeatedly(Return(MaxRetryCount));
+    for (unsigned i = 0; i <= MaxRetryCount; i++)
+    {
+        auto records = reserveAll(EventLatency_Unspecified, 1);
+        ASSERT_THAT(idsOf(records), ElementsAre("guid1"));
+        EXPECT_THAT(records[0].retryCount, static_cast<int>(i));
+        if (i == MaxRetryCount)
+        {
+            EXPECT_CALL(observerMock, OnStorageRecordsDropped(DroppedMap { { "token1", 1 } }));
+        }
+        offlineStorage->ReleaseRecords({ "guid1" }, true, headers, fromMemory);
+    }
+
+    // Releasing an unreserved record does not count as a retry
+    offlineStorage->ReleaseRecords({ "guid2" }, true, headers, fromMemory);
+    auto records = reserveAll();
+    ASSERT_THAT(idsOf(records), ElementsAre("guid2"));
+    EXPECT_THAT(records[0].retryCount, 0);
+    EXPECT_THAT(offlineStorage->GetRecordCount(EventLatency_Unspecified), 1u);
+}
+
+TEST_F(OfflineStorageTests_Segments, AcknowledgedSegmentsAreReclaimed)
+{
+    initializeStorage();
+    size_t const blobSize = offlineStorage->GetSegmentSize() / 4;
+    std::vector<StorageRecord> records;
+    for (int i = 0; i < 6; i++)
+    {
+        records.emplace_back("guid" + std::to_string(i), "token", EventLatency_Normal, EventPersistence_Normal, 1 + i, StorageBlob(blobSize, static_cast<uint8_t>(i)));
+    }
+    EXPECT_THAT(offlineStorage->StoreRecords(records), 6u);
+    EXPECT_THAT(offlineStorage->GetSegmentCount(), 2u);
+    EXPECT_THAT(offlineStorage->GetSize(), 2 * offlineStorage->GetSegmentSize());
+
+    // Emptying the older segment frees it, emptying the newest rewinds it
+    offlineStorage->DeleteRecords({ "guid0", "guid1", "guid2" }, headers, fromMemory);
+    EXPECT_THAT(offlineStorage->GetSegmentCount(), 1u);
+    offlineStorage->DeleteRecords({ "guid3", "guid4", "guid5" }, headers, fromMemory);
+    EXPECT_THAT(offlineStorage->GetSegmentCount(), 1u);
+    EXPECT_THAT(offlineStorage->GetRecordCount(EventLatency_Unspecified), 0u);
+
+    EXPECT_THAT(offlineStorage->StoreRecords(records), 6u);
+    EXPECT_THAT(offlineStorage->GetSegmentCount(), 2u);
+    EXPECT_THAT(offlineStorage->GetRecordCount(EventLatency_Unspecified), 6u);
+}
+
+TEST_F(OfflineStorageTests_Segments, StoreRecordsMovesStoredRecordsToFront)
+{
+    initializeStorage();
+    std::vector<StorageRecord> records;
+    for (int i = 0; i < 4; i++)
+    {
+        records.emplace_back("guid" + std::to_string(i), "token", EventLatency_Normal, EventPersistence_Normal, 1 + i, StorageBlob(10));
+    }
+    // Not storable without a tenant token
+    records[1].tenantToken.clear();
+    EXPECT_CALL(observerMock, OnStorageFailed("Invalid parameters"));
+    EXPECT_THAT(offlineStorage->StoreRecords(records), 3u);
+    EXPECT_THAT(idsOf(records), ElementsAre("guid0", "guid2", "guid3", "guid1"));
+}
+
+TEST_F(OfflineStorageTests_Segments, FullStorageDropsOldestSegment)
+{
+    initializeStorage();
+    // Three records per segment, both slots taken after six
+    size_t const blobSize = offlineStorage->GetSegmentSize() / 4;
+    for (int i = 0; i < 6; i++)
+    {
+        ASSERT_THAT(offlineStorage->StoreRecord({ "guid" + std::to_string(i), (i == 0) ? "token1" : "token2", EventLatency_Normal, EventPersistence_Normal, 1 + i, StorageBlob(blobSize) }), true);
+    }
+    EXPECT_THAT(offlineStorage->GetRecordCount(EventLatency_Unspecified), 6u);
+
+    EXPECT_CALL(observerMock, OnStorageTrimmed(DroppedMap { { "token1", 1 }, { "token2", 2 } }));
+    ASSERT_THAT(offlineStorage->StoreRecord({ "guid6", "token2", EventLatency_Normal, EventPersistence_Normal, 7, StorageBlob(blobSize) }), true);
+
+    EXPECT_THAT(idsOf(reserveAll()), ElementsAre("guid3", "guid4", "guid5", "guid6"));
+}
+
+TEST_F(OfflineStorageTests_Segments, OversizedRecordIsRejected)
+{
+    initializeStorage();
+    EXPECT_CALL(observerMock, OnStorageFailed("Event too large"));
+    EXPECT_THAT(offlineStorage->StoreRecord({ "guid", "token", EventLatency_Normal, EventPersistence_Normal, 1, StorageBlob(offlineStorage->GetSegmentSize()) }), false);
+    EXPECT_THAT(offlineStorage->GetRecordCount(EventLatency_Unspecified), 0u);
+}
+
+TEST_F(OfflineStorageTests_Segments, StoringSameIdReplacesRecord)
+{
+    initializeStorage();
+    ASSERT_THAT(offlineStorage->StoreRecord({ "guid", "token", EventLatency_Normal, EventPersistence_Normal, 1, { 1 } }), true);
+    ASSERT_THAT(offlineStorage->StoreRecord({ "guid", "token", EventLatency_Normal, EventPersistence_Normal, 2, { 2 } }), true);
+
+    auto records = reserveAll();
+    ASSERT_THAT(records.size(), 1u);
+    EXPECT_THAT(records[0].blob, StorageBlob({ 2 }));
+}
+
+TEST_F(OfflineStorageTests_Segments, RecordsAndRetryCountsSurviveReopen)
+{
+    initializeStorage();
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_THAT(offlineStorage->StoreRecord({ "guid" + std::to_string(i), "token", EventLatency_Normal, EventPersistence_Normal, 1 + i, StorageBlob(100, static_cast<uint8_t>(i)) }), true);
+    }
+    offlineStorage->DeleteRecords({ "guid1" }, headers, fromMemory);
+    EXPECT_CALL(configMock, GetMaximumRetryCount()).WillRepeatedly(Return(5));
+    ASSERT_THAT(idsOf(reserveAll(EventLatency_Unspecified, 1)), ElementsAre("guid0"));
+    offlineStorage->ReleaseRecords({ "guid0" }, true, headers, fromMemory);
+    // Reservations are not persisted
+    ASSERT_THAT(idsOf(reserveAll(EventLatency_Unspecified, 1)), ElementsAre("guid0"));
+
+    reopen();
+
+    auto records = reserveAll();
+    ASSERT_THAT(idsOf(records), ElementsAre("guid0", "guid2", "guid3"));
+    EXPECT_THAT(records[0].retryCount, 1);
+    EXPECT_THAT(records[1].blob, StorageBlob(100, 2));
+    EXPECT_THAT(records[2].timestamp, 4);
+}
+
+TEST_F(OfflineStorageTests_Segments, RewoundSegmentDoesNotResurrectAcknowledgedRecords)
+{
+    initializeStorage();
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_THAT(offlineStorage->StoreRecord({ "guid" + std::to_string(i), "token", EventLatency_Normal, EventPersistence_Normal, 1 + i, StorageBlob(100) }), true);
+    }
+    offlineStorage->Shutdown();
+    std::string const segmentPath = storageFilename + ".seg0";
+    std::string oldSegment;
+    {
+        std::ifstream file(segmentPath, std::ios::binary);
+        oldSegment.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    ASSERT_THAT(oldSegment.size(), offlineStorage->GetSegmentSize());
+
+    reopen();
+    offlineStorage->DeleteRecords({ "guid0", "guid1", "guid2" }, headers, fromMemory);
+    ASSERT_THAT(offlineStorage->StoreRecord({ "guid3", "token", EventLatency_Normal, EventPersistence_Normal, 4, {} }), true);
+    offlineStorage->Shutdown();
+
+    // A crash wrote back the index but not the rewritten segment page
+    {
+        std::ofstream file(segmentPath, std::ios::binary | std::ios::in | std::ios::out);
+        file.write(oldSegment.data(), static_cast<std::streamsize>(oldSegment.size()));
+    }
+    reopen();
+    EXPECT_THAT(reserveAll(), IsEmpty());
+    EXPECT_THAT(offlineStorage->GetRecordCount(EventLatency_Unspecified), 0u);
+}
+
+TEST_F(OfflineStorageTests_Segments, ChangedLayoutDeletesAllSegmentFiles)
+{
+    // 256 KiB make four slots of 64 KiB segments
+    initializeStorage(256 * 1024);
+    size_t const blobSize = offlineStorage->GetSegmentSize() / 2;
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_THAT(offlineStorage->StoreRecord({ "guid" + std::to_string(i), "token", EventLatency_Normal, EventPersistence_Normal, 1 + i, StorageBlob(blobSize) }), true);
+    }
+    ASSERT_THAT(offlineStorage->GetSegmentCount(), 4u);
+    offlineStorage->Shutdown();
+
+    initializeStorage();
+    EXPECT_THAT(offlineStorage->GetRecordCount(EventLatency_Unspecified), 0u);
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_THAT(MAT::FileExists((storageFilename + ".seg" + std::to_string(i)).c_str()), false);
+    }
+}
+
+TEST_F(OfflineStorageTests_Segments, DeleteRecordsMatchesFilter)
+{
+    initializeStorage();
+    ASSERT_THAT(offlineStorage->StoreRecord({ "guid1", "token1", EventLatency_Normal, EventPersistence_Normal, 1, {} }), true);
+    ASSERT_THAT(offlineStorage->StoreRecord({ "guid2", "token2", EventLatency_Normal, EventPersistence_Normal, 2, {} }), true);
+    ASSERT_THAT(offlineStorage->StoreRecord({ "guid3", "token1", EventLatency_RealTime, EventPersistence_Normal, 3, {} }), true);
+
+    offlineStorage->DeleteRecords(std::map<std::string, std::string> { { "tenant_token", "token1" }, { "latency", "1" } });
+    EXPECT_THAT(idsOf(reserveAll()), ElementsAre("guid3", "guid2"));
+
+    offlineStorage->DeleteAllRecords();
+    EXPECT_THAT(offlineStorage->GetRecordCount(EventLatency_Unspecified), 0u);
+    EXPECT_THAT(offlineStorage->GetSegmentCount(), 0u);
+}
+
+TEST_F(OfflineStorageTests_Segments, SettingsSurviveReopen)
+{
+    initializeStorage();
+    EXPECT_THAT(offlineStorage->GetSetting("absent"), StrEq(""));
+    EXPECT_THAT(offlineStorage->StoreSetting("setting 1", "Value for setting 1"), true);
+    EXPECT_THAT(offlineStorage->StoreSetting("key=with%odd\nchars", "value=with%odd\r\nchars"), true);
+    EXPECT_THAT(offlineStorage->StoreSetting("setting 2", "Value for setting 2"), true);
+    EXPECT_THAT(offlineStorage->DeleteSetting("setting 2"), true);
+
+    reopen();
+
+    EXPECT_THAT(offlineStorage->GetSetting("setting 1"), StrEq("Value for setting 1"));
+    EXPECT_THAT(offlineStorage->GetSetting("key=with%odd\nchars"), StrEq("value=with%odd\r\nchars"));
+    EXPECT_THAT(offlineStorage->GetSetting("setting 2"), StrEq(""));
+}
+
+TEST_F(OfflineStorageTests_Segments, APICallsAreHarmlessAfterStorageIsShutdown)
+{
+    initializeStorage();
+    offlineStorage->Shutdown();
+
+    EXPECT_CALL(observerMock, OnStorageOpenFailed("Storage is not open"));
+    offlineStorage->DeleteRecords({ "1", "2", "" }, headers, fromMemory);
+    EXPECT_THAT(reserveAll(), IsEmpty());
+    offlineStorage->ReleaseRecords({ "1", "2", "" }, false, headers, fromMemory);
+    EXPECT_THAT(offlineStorage->StoreRecord({ "guid", "token", EventLatency_Normal, EventPersistence_Normal, 1, {} }), false);
+    EXPECT_THAT(offlineStorage->StoreSetting("name", "value"), false);
+    EXPECT_THAT(offlineStorage->GetSetting("name"), StrEq(""));
+
+    reopen();
+}
+
+#endif // HAVE_MAT_STORAGE
@@ -4,6 +4,7 @@
 #include "common/MockIRuntimeConfig.hpp"
 #include "utils/StringUtils.hpp"
 #include "packager/Packager.hpp"
+#include "utils/ZlibUtils.hpp"
 #include "bond/All.hpp"
 #include "CsProtocol_types.hpp"
 #include "bond/generated/CsProtocol_readers.hpp"
@@ -56,7 +57,7 @@ TEST_F(PackagerTests, PackagesEventsByTenant)
         .WillOnce(Return());
     packager.finalizePackage(ctx);
 
-    EXPECT_THAT(ctx->body, Not(IsEmpty()));
+    EXPECT_FALSE(ctx->splicedBody.empty());
     EXPECT_THAT(ctx->recordIdsAndTenantIds, SizeIs(1));
     std::vector<std::string> recordIds;
     for (const auto& element : ctx->recordIdsAndTenantIds)
@@ -82,7 +83,7 @@ TEST_F(PackagerTests, PackagesEventsByTenant)
         .WillOnce(Return());
     packager.finalizePackage(ctx);
 
-    EXPECT_THAT(ctx->body, Not(IsEmpty()));
+    EXPECT_FALSE(ctx->splicedBody.empty());
     EXPECT_THAT(ctx->recordIdsAndTenantIds, SizeIs(2));
 
     recordIds.clear();
@@ -135,8 +136,8 @@ TEST_F(PackagerTests, HonorsMaximumPackageSize)
         .WillOnce(Return());
     packager.finalizePackage(ctx);
 
-    EXPECT_THAT(ctx->body, SizeIs(Eq(PartSize * 3)));
-    EXPECT_THAT(ctx->body, SizeIs(Lt(MaxSize)));
+    EXPECT_THAT(ctx->splicedBody.size(), Eq(PartSize * 3));
+    EXPECT_THAT(ctx->splicedBody.size(), Lt(MaxSize));
 }
 
 TEST_F(PackagerTests, PackagesAtLeastOneEventEvenIfOverSizeLimit)
@@ -157,7 +158,7 @@ TEST_F(PackagerTests, PackagesAtLeastOneEventEvenIfOverSizeLimit)
         .WillOnce(Return());
     packager.finalizePackage(ctx);
 
-    EXPECT_THAT(ctx->body, SizeIs(Eq(MaxSize)));
+    EXPECT_THAT(ctx->splicedBody.size(), Eq(MaxSize));
 }
 
 TEST_F(PackagerTests, SetsRequestBondFieldsCorrectly)
@@ -202,6 +203,41 @@ TEST_F(PackagerTests, SetsRequestBondFieldsCorrectly)
 */
 }
 
+TEST_F(PackagerTests, RecordsAreGroupedByTenantHandle)
+{
+    TenantHandle tenant1 = TenantRegistry::instance().Register("tenant1-token");
+    auto ctx = std::make_shared<EventsUploadContext>();
+    EXPECT_CALL(runtimeConfigMock, GetMaximumUploadSizeBytes())
+        .WillOnce(Return(100000))
+        .RetiresOnSaturation();
+
+    bool wantMore = true;
+    // Logged, with the handle only
+    StorageRecord record1("r1", "", EventLatency_Normal, EventPersistence_Normal, 1234567890, std::vector<uint8_t>{1, 0});
+    record1.tenantHandle = tenant1;
+    packager.addEventToPackage(ctx, record1, wantMore);
+    // Read back from the database, without a handle
+    StorageRecord record2("r2", "tenant1-token", EventLatency_Normal, EventPersistence_Normal, 1234567891, std::vector<uint8_t>{2, 0});
+    packager.addEventToPackage(ctx, record2, wantMore);
+    StorageRecord record3("r3", "tenant2-token", EventLatency_Normal, EventPersistence_Normal, 1234567892, std::vector<uint8_t>{3, 0});
+    packager.addEventToPackage(ctx, record3, wantMore);
+    StorageRecord record4("r4", "tenant2-token", EventLatency_Normal, EventPersistence_Normal, 1234567893, std::vector<uint8_t>{4, 0});
+    packager.addEventToPackage(ctx, record4, wantMore);
+
+    EXPECT_CALL(*this, resultPackagedEvents(ctx))
+        .WillOnce(Return());
+    packager.finalizePackage(ctx);
+
+    EXPECT_THAT(ctx->packageIds, SizeIs(2));
+    EXPECT_THAT(ctx->packageTenants, SizeIs(2));
+    EXPECT_THAT(ctx->recordIdsAndTenantIds["r1"], Eq(tenant1));
+    EXPECT_THAT(ctx->recordIdsAndTenantIds["r2"], Eq(tenant1));
+    EXPECT_THAT(TenantRegistry::instance().Token(ctx->recordIdsAndTenantIds["r3"]), Eq("tenant2-token"));
+    EXPECT_THAT(ctx->recordIdsAndTenantIds["r4"], Eq(ctx->recordIdsAndTenantIds["r3"]));
+    // Each token read back is looked up in the registry once per package
+    EXPECT_THAT(ctx->recordTenants, ElementsAre(tenant1, ctx->recordIdsAndTenantIds["r3"]));
+}
+
 TEST_F(PackagerTests, ForcedTenantIsForced)
 {
     runtimeConfigMock["forcedTenantToken"] = "forced-Tenant-Token";
@@ -238,3 +274,43 @@ TEST_F(PackagerTests, ForcedTenantIsForced)
     ASSERT_THAT(r.TokenToDataPackagesMap["forced-tenant-token"][0].Records, SizeIs(3));
 */
 }
+
+TEST_F(PackagerTests, StreamingCompressionDeflatesRecordsAsTheyAreAdded)
+{
+    runtimeConfigMock[CFG_MAP_HTTP][CFG_BOOL_HTTP_STREAMING_COMPRESSION] = true;
+    Packager packagerS(runtimeConfigMock);
+    packagerS.packagedEvents >> packagedEvents;
+
+    auto ctx = std::make_shared<EventsUploadContext>();
+    EXPECT_CALL(runtimeConfigMock, GetMaximumUploadSizeBytes())
+        .WillOnce(Return(100000))
+        .RetiresOnSaturation();
+    EXPECT_CALL(runtimeConfigMock, IsHttpRequestCompressionEnabled())
+        .WillOnce(Return(true))
+        .RetiresOnSaturation();
+
+    bool wantMore = true;
+    StorageRecord record1("r1", "tenant1-token", EventLatency_Normal, EventPersistence_Normal, 1234567890, std::vector<uint8_t>{1, 1, 1, 0});
+    packagerS.addEventToPackage(ctx, record1, wantMore);
+    StorageRecord record2("r2", "tenant2-token", EventLatency_Normal, EventPersistence_Normal, 1234567891, std::vector<uint8_t>{2, 2, 0});
+    packagerS.addEventToPackage(ctx, record2, wantMore);
+    StorageRecord record3("r3", "tenant1-token", EventLatency_Normal, EventPersistence_Normal, 1234567892, std::vector<uint8_t>{3, 0});
+    packagerS.addEventToPackage(ctx, record3, wantMore);
+    ASSERT_TRUE(ctx->deflate);
+
+    EXPECT_CALL(*this, resultPackagedEvents(ctx))
+        .WillOnce(Return());
+    packagerS.finalizePackage(ctx);
+
+    EXPECT_TRUE(ctx->splicedBody.empty());
+    EXPECT_THAT(ctx->recordIdsAndTenantIds, SizeIs(3));
+    EXPECT_THAT(ctx->packageIds, SizeIs(2));
+
+    // Records are compressed in retrieval order, not grouped by tenant
+    ASSERT_TRUE(ctx->deflate->finish());
+    std::vector<uint8_t> inflated;
+    ASSERT_TRUE(ZlibUtils::InflateVector(ctx->body, inflated, false));
+    EXPECT_THAT(inflated, Eq(std::vector<uint8_t>{1, 1, 1, 0, 2, 2, 0, 3, 0}));
+
+    runtimeConfigMock[CFG_MAP_HTTP][CFG_BOOL_HTTP_STREAMING_COMPRESSION] = false;
+}
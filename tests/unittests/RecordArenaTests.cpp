@@ -0,0 +1,129 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "api/RecordArena.hpp"
+
+#include <thread>
+
+using namespace testing;
+using namespace MAT;
+
+namespace
+{
+    void FillRecord(::CsProtocol::Record& record)
+    {
+        record.name = "Contoso.Event.With.A.Rather.Long.Name";
+        record.iKey = "o:0123456789abcdef0123456789abcdef";
+        record.time = 1234;
+        record.popSample = 50;
+        record.flags = 7;
+        record.extSdk.push_back(::CsProtocol::Sdk());
+        record.extSdk[0].epoch = "1b0ed9d1-1b94-4aa5-9d50-93db4ea8ca1f";
+        record.extApp.push_back(::CsProtocol::App());
+        record.extDevice.push_back(::CsProtocol::Device());
+        record.tags["tag"] = "value";
+        record.data.push_back(::CsProtocol::Data());
+        record.data[0].properties["key"].stringValue = "value";
+    }
+}
+
+TEST(RecordArenaTests, Reset_ClearsAllFields)
+{
+    ::CsProtocol::Record record;
+    FillRecord(record);
+    RecordArena::Reset(record);
+    EXPECT_THAT(record, Eq(::CsProtocol::Record()));
+}
+
+TEST(RecordArenaTests, Reset_KeepsContainerCapacity)
+{
+    ::CsProtocol::Record record;
+    FillRecord(record);
+    RecordArena::Reset(record);
+    EXPECT_THAT(record.extSdk.capacity(), Gt(0u));
+    EXPECT_THAT(record.data.capacity(), Gt(0u));
+    EXPECT_THAT(record.name.capacity(), Ge(std::string("Contoso.Event.With.A.Rather.Long.Name").size()));
+}
+
+TEST(RecordArenaTests, Lease_ReusesRecordOfPreviousLeaseOnSameThread)
+{
+    ::CsProtocol::Record* first = nullptr;
+    {
+        RecordArena::Lease lease;
+        first = &*lease;
+        FillRecord(*lease);
+    }
+    uint64_t avoidedBefore = RecordArena::GetAllocationsAvoided();
+    {
+        RecordArena::Lease lease;
+        EXPECT_THAT(&*lease, Eq(first));
+        EXPECT_THAT(*lease, Eq(::CsProtocol::Record()));
+    }
+    EXPECT_THAT(RecordArena::GetAllocationsAvoided(), Ge(avoidedBefore + 3));
+}
+
+TEST(RecordArenaTests, Lease_NestedLeasesGetDistinctRecords)
+{
+    RecordArena::Lease outer;
+    FillRecord(*outer);
+    {
+        RecordArena::Lease inner;
+        EXPECT_THAT(&*inner, Ne(&*outer));
+        EXPECT_THAT(*inner, Eq(::CsProtocol::Record()));
+    }
+    EXPECT_THAT(outer->name, Eq("Contoso.Event.With.A.Rather.Long.Name"));
+}
+
+TEST(RecordArenaTests, Lease_ThreadsDoNotShareRecords)
+{
+    ::CsProtocol::Record* mainRecord = nullptr;
+    {
+        RecordArena::Lease lease;
+        mainRecord = &*lease;
+    }
+    ::CsProtocol::Record* otherRecord = nullptr;
+    std::thread([&otherRecord]() {
+        RecordArena::Lease lease;
+        otherRecord = &*lease;
+    }).join();
+    EXPECT_THAT(otherRecord, Ne(mainRecord));
+}
+
+TEST(RecordArenaTests, BatchLease_ReusesRecordsOfPreviousBatchOnSameThread)
+{
+    ::CsProtocol::Record* first = nullptr;
+    {
+        RecordArena::BatchLease batch(3);
+        first = &batch[0];
+        for (size_t i = 0; i < 3; i++)
+        {
+            FillRecord(batch[i]);
+        }
+    }
+    uint64_t avoidedBefore = RecordArena::GetAllocationsAvoided();
+    {
+        RecordArena::BatchLease batch(5);
+        EXPECT_THAT(&batch[0], Eq(first));
+        for (size_t i = 0; i < 5; i++)
+        {
+            EXPECT_THAT(batch[i], Eq(::CsProtocol::Record()));
+        }
+    }
+    EXPECT_THAT(RecordArena::GetAllocationsAvoided(), Ge(avoidedBefore + 3 * 3));
+}
+
+TEST(RecordArenaTests, BatchLease_NestedBatchesGetDistinctRecords)
+{
+    RecordArena::BatchLease outer(2);
+    FillRecord(outer[0]);
+    {
+        RecordArena::BatchLease inner(2);
+        EXPECT_THAT(&inner[0], Ne(&outer[0]));
+        EXPECT_THAT(&inner[0], Ne(&outer[1]));
+        EXPECT_THAT(inner[0], Eq(::CsProtocol::Record()));
+    }
+    EXPECT_THAT(outer[0].name, Eq("Contoso.Event.With.A.Rather.Long.Name"));
+}
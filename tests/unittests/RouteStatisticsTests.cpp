@@ -0,0 +1,187 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "common/MockIRuntimeConfig.hpp"
+#include "stats/MetaStats.hpp"
+#include "system/Route.hpp"
+#include "system/RouteStatistics.hpp"
+
+#include <thread>
+
+using namespace testing;
+using namespace MAT;
+
+
+TEST(LatencyHistogramTests, BucketBoundsContainTheirValues)
+{
+    uint64_t const values[] = { 0, 1, 7, 8, 9, 15, 16, 17, 100, 1000, 123456, 1000000007ull, (uint64_t(1) << 40) - 1 };
+    for (uint64_t value : values)
+    {
+        size_t index = LatencyHistogram::BucketIndex(value);
+        ASSERT_THAT(index, Lt(LatencyHistogram::BucketCount));
+        EXPECT_THAT(LatencyHistogram::BucketLowerBound(index), Le(value)) << value;
+        EXPECT_THAT(LatencyHistogram::BucketUpperBound(index), Ge(value)) << value;
+        // Within 1/8 of the value
+        EXPECT_THAT(LatencyHistogram::BucketUpperBound(index) - LatencyHistogram::BucketLowerBound(index), Le(value / 8)) << value;
+    }
+    EXPECT_THAT(LatencyHistogram::BucketIndex(UINT64_MAX), Eq(LatencyHistogram::BucketCount - 1));
+}
+
+TEST(LatencyHistogramTests, BucketsAreContiguous)
+{
+    for (size_t i = 0; i + 2 < LatencyHistogram::BucketCount; i++)
+    {
+        ASSERT_THAT(LatencyHistogram::BucketLowerBound(i + 1), Eq(LatencyHistogram::BucketUpperBound(i) + 1)) << i;
+        ASSERT_THAT(LatencyHistogram::BucketIndex(LatencyHistogram::BucketLowerBound(i)), Eq(i)) << i;
+    }
+}
+
+TEST(LatencyHistogramTests, Percentiles)
+{
+    LatencyHistogram histogram;
+    EXPECT_THAT(histogram.GetSnapshot().Percentile(0.5), Eq(0u));
+
+    for (uint64_t value = 1; value <= 1000; value++)
+    {
+        histogram.Record(value * 1000);
+    }
+    auto snapshot = histogram.GetSnapshot();
+    EXPECT_THAT(snapshot.count, Eq(1000u));
+    EXPECT_THAT(snapshot.total, Eq(500500000u));
+    EXPECT_THAT(snapshot.max, Eq(1000000u));
+    EXPECT_THAT(snapshot.Percentile(0.5), AllOf(Ge(500000u), Le(500000u * 9 / 8)));
+    EXPECT_THAT(snapshot.Percentile(0.99), AllOf(Ge(990000u), Le(1000000u)));
+    EXPECT_THAT(snapshot.Percentile(1.0), Eq(1000000u));
+}
+
+TEST(LatencyHistogramTests, SinceSubtractsEarlierSnapshot)
+{
+    LatencyHistogram histogram;
+    for (int i = 0; i < 100; i++)
+    {
+        histogram.Record(1000000);
+    }
+    auto earlier = histogram.GetSnapshot();
+    for (int i = 0; i < 10; i++)
+    {
+        histogram.Record(100);
+    }
+    auto delta = histogram.GetSnapshot().Since(earlier);
+    EXPECT_THAT(delta.count, Eq(10u));
+    EXPECT_THAT(delta.total, Eq(1000u));
+    EXPECT_THAT(delta.max, AllOf(Ge(100u), Le(LatencyHistogram::BucketUpperBound(LatencyHistogram::BucketIndex(100)))));
+    EXPECT_THAT(delta.Percentile(0.99), Le(delta.max));
+
+    EXPECT_THAT(earlier.Since(earlier).count, Eq(0u));
+    EXPECT_THAT(earlier.Since(earlier).max, Eq(0u));
+}
+
+TEST(RouteStatisticsTests, DisabledAddsNoStages)
+{
+    RouteStatistics stats(false);
+    EXPECT_THAT(stats.AddStage("stage"), IsNull());
+    EXPECT_THAT(stats.GetStageLatencies(), IsEmpty());
+}
+
+TEST(RouteStatisticsTests, NestedTimerExcludesChildTime)
+{
+    RouteStatistics stats(true);
+    LatencyHistogram* outer = stats.AddStage("outer");
+    LatencyHistogram* inner = stats.AddStage("inner");
+    ASSERT_THAT(outer, NotNull());
+    ASSERT_THAT(inner, NotNull());
+    {
+        RouteStageTimer outerTimer(*outer);
+        RouteStageTimer innerTimer(*inner);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    auto latencies = stats.GetStageLatencies();
+    ASSERT_THAT(latencies, SizeIs(2));
+    EXPECT_THAT(latencies[0].name, Eq("outer"));
+    EXPECT_THAT(latencies[0].count, Eq(1u));
+    EXPECT_THAT(latencies[0].totalNs, Lt(25000000u));
+    EXPECT_THAT(latencies[1].name, Eq("inner"));
+    EXPECT_THAT(latencies[1].count, Eq(1u));
+    EXPECT_THAT(latencies[1].totalNs, Ge(50000000u));
+    EXPECT_THAT(latencies[1].maxNs, Eq(latencies[1].totalNs));
+}
+
+class TimedRouteTests : public Test {
+  public:
+    RouteSink<TimedRouteTests, int>        sink{this, &TimedRouteTests::handleSink};
+    RoutePassThrough<TimedRouteTests, int> passThrough{this, &TimedRouteTests::handlePassThrough};
+    RouteSource<int>                       source;
+    int                                    received = 0;
+
+    void handleSink(int)
+    {
+        received++;
+    }
+
+    bool handlePassThrough(int value)
+    {
+        return value > 0;
+    }
+};
+
+TEST_F(TimedRouteTests, AttachedHandlersCountCalls)
+{
+    RouteStatistics stats(true);
+    stats.Attach(passThrough, "passThrough");
+    stats.Attach(sink, "sink");
+    source >> passThrough >> sink;
+
+    source(1);
+    source(2);
+    source(0);
+
+    auto latencies = stats.GetStageLatencies();
+    ASSERT_THAT(latencies, SizeIs(2));
+    EXPECT_THAT(latencies[0].count, Eq(3u));
+    EXPECT_THAT(latencies[1].count, Eq(2u));
+    EXPECT_THAT(received, Eq(2));
+}
+
+TEST_F(TimedRouteTests, DisabledStatisticsLeaveHandlersUntimed)
+{
+    RouteStatistics stats(false);
+    stats.Attach(sink, "sink");
+    source >> sink;
+    source(1);
+    EXPECT_THAT(received, Eq(1));
+    EXPECT_THAT(stats.GetStageLatencies(), IsEmpty());
+}
+
+TEST(RouteStatisticsTests, MetaStatsReportsStagesSinceLastEvent)
+{
+    NiceMock<MockIRuntimeConfig> config;
+    EXPECT_CALL(config, GetMetaStatsSendIntervalSec()).WillRepeatedly(Return(0));
+    EXPECT_CALL(config, GetMetaStatsTenantToken()).WillRepeatedly(Return("metastats-tenant-token"));
+    MetaStats metaStats(config);
+    RouteStatistics stats(true);
+    LatencyHistogram* stage = stats.AddStage("store");
+    for (int i = 0; i < 5; i++)
+    {
+        stage->Record(2000000);
+    }
+
+    metaStats.updateOnStageLatencies(stats.GetSnapshots());
+    auto records = metaStats.generateStatsEvent(ACT_STATS_ROLLUP_KIND_START);
+    ASSERT_THAT(records, SizeIs(1));
+    auto const& props = records[0].data[0].properties;
+    ASSERT_THAT(props.count("stg_store_cnt"), Eq(1u));
+    EXPECT_THAT(props.at("stg_store_cnt").stringValue, Eq("5"));
+    EXPECT_THAT(props.at("stg_store_max").stringValue, Eq("2000"));
+
+    stage->Record(3000);
+    metaStats.updateOnStageLatencies(stats.GetSnapshots());
+    records = metaStats.generateStatsEvent(ACT_STATS_ROLLUP_KIND_STOP);
+    ASSERT_THAT(records, SizeIs(1));
+    auto const& next = records[0].data[0].properties;
+    EXPECT_THAT(next.at("stg_store_cnt").stringValue, Eq("1"));
+    EXPECT_THAT(next.at("stg_store_max").stringValue, Eq("3"));
+}
@@ -0,0 +1,98 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "pal/posix/sysinfo_sources_impl.hpp"
+#include "utils/Utils.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace testing;
+using namespace MAT;
+
+namespace
+{
+    class TestSysInfoSources : public sysinfo_sources
+    {
+       public:
+        TestSysInfoSources()
+        {
+            m_path = GetTempDirectory() + "SysInfoSourcesTests.txt";
+        }
+
+        ~TestSysInfoSources()
+        {
+            std::remove(m_path.c_str());
+        }
+
+        void Write(std::string const& contents)
+        {
+            std::ofstream file(m_path, std::ios::binary);
+            file << contents;
+        }
+
+        std::string m_path;
+    };
+}
+
+TEST(SysInfoSourcesTests, SelectorsPickLineValues)
+{
+    TestSysInfoSources sources;
+    sources.Write("NAME=\"Debian GNU/Linux\"\nVERSION_ID=\"12\"\nVERSION=\"12 (bookworm)\"\nID=debian\nID_LIKE='rhel fedora'\n");
+    sources.add("all", { sources.m_path.c_str(), "*" });
+    sources.add("first", { sources.m_path.c_str(), "\n" });
+    sources.add("id", { sources.m_path.c_str(), "ID=" });
+    sources.add("ver", { sources.m_path.c_str(), "VERSION_ID=" });
+    sources.add("rel", { sources.m_path.c_str(), "VERSION=" });
+    sources.add("like", { sources.m_path.c_str(), "ID_LIKE=" });
+    sources.add("missing", { sources.m_path.c_str(), "BUILD_ID=" });
+
+    EXPECT_THAT(sources.get("all"), StartsWith("NAME="));
+    EXPECT_THAT(sources.get("first"), Eq("NAME=\"Debian GNU/Linux\""));
+    EXPECT_THAT(sources.get("id"), Eq("debian"));
+    EXPECT_THAT(sources.get("ver"), Eq("12"));
+    EXPECT_THAT(sources.get("rel"), Eq("12 (bookworm)"));
+    EXPECT_THAT(sources.get("like"), Eq("rhel fedora"));
+    EXPECT_THAT(sources.get("missing"), IsEmpty());
+}
+
+TEST(SysInfoSourcesTests, FirstFieldOfNulSeparatedFile)
+{
+    TestSysInfoSources sources;
+    sources.Write(std::string("/usr/bin/app\0--flag\0", 20));
+    sources.add("appId", { sources.m_path.c_str(), "\n" });
+    EXPECT_THAT(sources.get("appId"), Eq("/usr/bin/app"));
+}
+
+TEST(SysInfoSourcesTests, LaterSourceUsedWhenEarlierIsEmpty)
+{
+    TestSysInfoSources sources;
+    sources.Write("0123456789abcdef\n");
+    sources.add("devId", { "/nonexistent/machine-id", "*" });
+    sources.add("devId", { sources.m_path.c_str(), "*" });
+    EXPECT_THAT(sources.get("devId"), Eq("0123456789abcdef\n"));
+}
+
+TEST(SysInfoSourcesTests, ValuesAreReadOnceOnFirstLookup)
+{
+    TestSysInfoSources sources;
+    sources.add("value", { sources.m_path.c_str(), "*" });
+    sources.Write("first");
+    EXPECT_THAT(sources.get("value"), Eq("first"));
+    sources.Write("second");
+    EXPECT_THAT(sources.get("value"), Eq("first"));
+}
+
+TEST(SysInfoSourcesTests, LinuxFieldsAreResolved)
+{
+    sysinfo_sources_impl sysInfo;
+    EXPECT_THAT(sysInfo.get("osName"), Not(IsEmpty()));
+    EXPECT_THAT(sysInfo.get("osVer"), Not(IsEmpty()));
+    EXPECT_THAT(sysInfo.get("osRel"), Not(IsEmpty()));
+    EXPECT_THAT(sysInfo.get("appId"), HasSubstr("UnitTests"));
+    EXPECT_THAT(sysInfo.get("tz"), MatchesRegex("[+-][0-9][0-9]:[0-9][0-9]"));
+    EXPECT_THAT(sysInfo.get("devId"), Not(IsEmpty()));
+}
@@ -0,0 +1,76 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "common/Common.hpp"
+#include "system/TenantRegistry.hpp"
+
+using namespace testing;
+using namespace MAT;
+
+TEST(TenantRegistryTests, RegisterReturnsTheSameHandleForTheSameToken)
+{
+    TenantRegistry registry;
+    TenantHandle first = registry.Register("6d084bbf6a9644ef83f40a77c9e34580-c2d379e0-4408-4325-9b4d-2a7d78131e14-7322");
+    TenantHandle second = registry.Register("0ae6cd22d8264818933f4857dd3c1472-eea5f30e-e0ed-4ab0-8ed0-4dc0f5e156e0-7385");
+
+    EXPECT_THAT(first, Ne(InvalidTenantHandle));
+    EXPECT_THAT(second, Ne(InvalidTenantHandle));
+    EXPECT_THAT(second, Ne(first));
+    EXPECT_THAT(registry.Register(std::string("6d084bbf6a9644ef83f40a77c9e34580-c2d379e0-4408-4325-9b4d-2a7d78131e14-7322")), Eq(first));
+    EXPECT_THAT(registry.Size(), Eq(2u));
+}
+
+TEST(TenantRegistryTests, HandleResolvesToTokenAndTenantId)
+{
+    TenantRegistry registry;
+    TenantHandle handle = registry.Register("6d084bbf6a9644ef83f40a77c9e34580-c2d379e0-4408-4325-9b4d-2a7d78131e14-7322");
+
+    EXPECT_THAT(registry.Find("6d084bbf6a9644ef83f40a77c9e34580-c2d379e0-4408-4325-9b4d-2a7d78131e14-7322"), Eq(handle));
+    EXPECT_THAT(registry.Token(handle), Eq("6d084bbf6a9644ef83f40a77c9e34580-c2d379e0-4408-4325-9b4d-2a7d78131e14-7322"));
+    EXPECT_THAT(registry.TenantId(handle), Eq("6d084bbf6a9644ef83f40a77c9e34580"));
+}
+
+TEST(TenantRegistryTests, UnknownTokensAndHandlesResolveToNothing)
+{
+    TenantRegistry registry;
+    registry.Register("tenant1-token");
+
+    EXPECT_THAT(registry.Find("tenant2-token"), Eq(InvalidTenantHandle));
+    EXPECT_THAT(registry.Token(InvalidTenantHandle), IsEmpty());
+    EXPECT_THAT(registry.Token(42), IsEmpty());
+    EXPECT_THAT(registry.TenantId(42), IsEmpty());
+}
+
+TEST(TenantRegistryTests, HandlesStayValidAsTheRegistryGrows)
+{
+    TenantRegistry registry;
+    std::vector<TenantHandle> handles;
+    std::vector<std::string const*> tokens;
+    for (int i = 0; i < 1000; i++)
+    {
+        handles.push_back(registry.Register("tenant" + std::to_string(i) + "-token"));
+        tokens.push_back(&registry.Token(handles.back()));
+    }
+
+    ASSERT_THAT(registry.Size(), Eq(1000u));
+    for (int i = 0; i < 1000; i++)
+    {
+        EXPECT_THAT(handles[i], Eq(static_cast<TenantHandle>(i + 1)));
+        EXPECT_THAT(&registry.Token(handles[i]), Eq(tokens[i]));
+        EXPECT_THAT(registry.TenantId(handles[i]), Eq("tenant" + std::to_string(i)));
+    }
+    EXPECT_THAT(registry.Token(1001), IsEmpty());
+}
+
+TEST(TenantRegistryTests, RecordTokenFallsBackToItsHandle)
+{
+    TenantRegistry registry;
+    StorageRecord record;
+    record.tenantHandle = registry.Register("tenant1-token");
+    EXPECT_THAT(registry.Token(record), Eq("tenant1-token"));
+
+    record.tenantToken = "tenant2-token";
+    EXPECT_THAT(registry.Token(record), Eq("tenant2-token"));
+}
@@ -248,6 +248,57 @@ TEST_F(TransmissionPolicyManagerTests, ImmediateIncomingEventStartsUploadImmedia
     EXPECT_THAT(upload->requestedMinLatency, EventLatency_Max);
 }
 
+TEST_F(TransmissionPolicyManagerTests, ImmediateIncomingEventsShareCoalescingWindow)
+{
+    auto& config = testing::getSystem().getConfig();
+    config[CFG_MAP_TPM][CFG_INT_TPM_IMMEDIATE_WINDOW_MS] = 20;
+    tpm.paused(false);
+
+    IncomingEventContext event;
+    event.record.latency = EventLatency_Max;
+    std::atomic<bool> uploaded(false);
+    EventsUploadContextPtr upload;
+    EXPECT_CALL(*this, resultInitiateUpload(_))
+        .WillOnce(Invoke([&](EventsUploadContextPtr const& ctx) { upload = ctx; uploaded = true; }));
+    for (int i = 0; i < 5; i++)
+    {
+        tpm.eventArrived(&event);
+    }
+    EXPECT_FALSE(uploaded);
+
+    for (int i = 0; i < 200 && !uploaded; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(uploaded);
+    EXPECT_THAT(upload->requestedMinLatency, EventLatency_Max);
+    config[CFG_MAP_TPM][CFG_INT_TPM_IMMEDIATE_WINDOW_MS] = 0;
+}
+
+TEST_F(TransmissionPolicyManagerTests, ImmediateIncomingEventsCloseFullCoalescingWindow)
+{
+    auto& config = testing::getSystem().getConfig();
+    config[CFG_MAP_TPM][CFG_INT_TPM_IMMEDIATE_WINDOW_MS] = 60000;
+    config[CFG_MAP_TPM][CFG_INT_TPM_IMMEDIATE_WINDOW_EVENTS] = 3;
+    tpm.paused(false);
+
+    IncomingEventContext event;
+    event.record.latency = EventLatency_Max;
+    tpm.eventArrived(&event);
+    tpm.eventArrived(&event);
+
+    EventsUploadContextPtr upload;
+    EXPECT_CALL(*this, resultInitiateUpload(_))
+        .WillOnce(SaveArg<0>(&upload));
+    tpm.eventArrived(&event);
+    ASSERT_THAT(upload, NotNull());
+    EXPECT_THAT(upload->requestedMinLatency, EventLatency_Max);
+
+    tpm.pause();
+    config[CFG_MAP_TPM][CFG_INT_TPM_IMMEDIATE_WINDOW_MS] = 0;
+    config[CFG_MAP_TPM][CFG_INT_TPM_IMMEDIATE_WINDOW_EVENTS] = 0;
+}
+
 TEST_F(TransmissionPolicyManagerTests, UploadDoesNothingWhenPaused)
 {
     tpm.uploadScheduled(true);
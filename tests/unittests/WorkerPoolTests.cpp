@@ -0,0 +1,217 @@
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+#include "common/Common.hpp"
+
+#include "pal/PAL.hpp"
+#include "pal/TaskDispatcher.hpp"
+#include "pal/WorkerPool.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+using namespace testing;
+using namespace MAT;
+using namespace PAL;
+
+namespace
+{
+    /// <summary>
+    /// Records the order of its calls and how many of them overlapped.
+    /// </summary>
+    class Recorder
+    {
+    public:
+        void Record(int value)
+        {
+            if (++m_running > 1)
+            {
+                m_overlapped = true;
+            }
+            PAL::sleep(value % 3 == 0 ? 1 : 0);
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_values.push_back(value);
+            }
+            --m_running;
+            m_done.post();
+        }
+
+        void Wait(PAL::Event* entered, PAL::Event* release)
+        {
+            entered->post();
+            release->wait(5000);
+        }
+
+        std::vector<int> Values()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_values;
+        }
+
+        bool WaitForCount(size_t count, unsigned timeoutMs = 5000)
+        {
+            auto start = PAL::getMonotonicTimeMs();
+            while (Values().size() < count)
+            {
+                if (PAL::getMonotonicTimeMs() - start > timeoutMs)
+                {
+                    return false;
+                }
+                m_done.wait(10);
+                m_done.Reset();
+            }
+            return true;
+        }
+
+        bool Overlapped() const
+        {
+            return m_overlapped;
+        }
+
+    protected:
+        std::mutex        m_lock;
+        std::vector<int>  m_values;
+        std::atomic<int>  m_running { 0 };
+        std::atomic<bool> m_overlapped { false };
+        PAL::Event        m_done;
+    };
+}
+
+TEST(WorkerPoolTests, SerialQueueRunsCallsInOrderOneAtATime)
+{
+    auto pool = WorkerPoolFactory::Create(4);
+    auto queue = pool->CreateSerialQueue();
+    ASSERT_THAT(queue, NotNull());
+
+    Recorder recorder;
+    for (int i = 0; i < 100; i++)
+    {
+        dispatchTask(queue.get(), &recorder, &Recorder::Record, i);
+    }
+    ASSERT_TRUE(recorder.WaitForCount(100));
+
+    std::vector<int> expected(100);
+    for (int i = 0; i < 100; i++)
+    {
+        expected[i] = i;
+    }
+    EXPECT_THAT(recorder.Values(), ContainerEq(expected));
+    EXPECT_FALSE(recorder.Overlapped());
+}
+
+TEST(WorkerPoolTests, SerialQueuesRunInParallel)
+{
+    auto pool = WorkerPoolFactory::Create(2);
+    auto queue1 = pool->CreateSerialQueue();
+    auto queue2 = pool->CreateSerialQueue();
+
+    Recorder recorder;
+    PAL::Event entered1, entered2, release;
+    dispatchTask(queue1.get(), &recorder, &Recorder::Wait, &entered1, &release);
+    dispatchTask(queue2.get(), &recorder, &Recorder::Wait, &entered2, &release);
+    EXPECT_TRUE(entered1.wait(5000));
+    EXPECT_TRUE(entered2.wait(5000));
+    release.post();
+}
+
+TEST(WorkerPoolTests, SingleWorkerSharesQueues)
+{
+    auto pool = WorkerPoolFactory::Create(1);
+    auto queue1 = pool->CreateSerialQueue();
+    auto queue2 = pool->CreateSerialQueue();
+
+    Recorder recorder;
+    for (int i = 0; i < 10; i++)
+    {
+        dispatchTask((i % 2) ? queue1.get() : queue2.get(), &recorder, &Recorder::Record, i);
+    }
+    dispatchTask(pool.get(), &recorder, &Recorder::Record, 10);
+    ASSERT_TRUE(recorder.WaitForCount(11));
+    EXPECT_FALSE(recorder.Overlapped());
+}
+
+TEST(WorkerPoolTests, TimedCallsRunByTargetTimeThenQueueingOrder)
+{
+    auto pool = WorkerPoolFactory::Create(2);
+    auto queue = pool->CreateSerialQueue();
+
+    Recorder recorder;
+    // Queued in one go so that equal delays share a target time
+    std::vector<DeferredCallbackHandle> handles;
+    handles.push_back(scheduleTask(queue.get(), 120, &recorder, &Recorder::Record, 4));
+    handles.push_back(scheduleTask(queue.get(), 40, &recorder, &Recorder::Record, 1));
+    handles.push_back(scheduleTask(queue.get(), 80, &recorder, &Recorder::Record, 3));
+    handles.push_back(scheduleTask(queue.get(), 40, &recorder, &Recorder::Record, 2));
+    auto start = PAL::getMonotonicTimeMs();
+    ASSERT_TRUE(recorder.WaitForCount(4));
+
+    EXPECT_THAT(recorder.Values(), ElementsAre(1, 2, 3, 4));
+    EXPECT_THAT(PAL::getMonotonicTimeMs() - start, Ge(100u));
+}
+
+TEST(WorkerPoolTests, CancelDropsPendingTimedCall)
+{
+    auto pool = WorkerPoolFactory::Create(1);
+    auto queue = pool->CreateSerialQueue();
+
+    Recorder recorder;
+    auto cancelled = scheduleTask(queue.get(), 50, &recorder, &Recorder::Record, 1);
+    auto kept = scheduleTask(queue.get(), 60, &recorder, &Recorder::Record, 2);
+    EXPECT_TRUE(cancelled.Cancel());
+    ASSERT_TRUE(recorder.WaitForCount(1));
+    PAL::sleep(50);
+    EXPECT_THAT(recorder.Values(), ElementsAre(2));
+}
+
+TEST(WorkerPoolTests, CancellingManyTimedCallsKeepsTheRestRunning)
+{
+    auto pool = WorkerPoolFactory::Create(2);
+    auto queue = pool->CreateSerialQueue();
+
+    Recorder recorder;
+    std::vector<DeferredCallbackHandle> handles;
+    for (int i = 0; i < 1000; i++)
+    {
+        handles.push_back(scheduleTask(queue.get(), 60000 + i, &recorder, &Recorder::Record, i));
+    }
+    auto kept = scheduleTask(queue.get(), 20, &recorder, &Recorder::Record, -1);
+    for (auto& handle : handles)
+    {
+        EXPECT_TRUE(handle.Cancel());
+    }
+    ASSERT_TRUE(recorder.WaitForCount(1));
+    EXPECT_THAT(recorder.Values(), ElementsAre(-1));
+}
+
+TEST(WorkerPoolTests, CancelWaitsForRunningCall)
+{
+    auto pool = WorkerPoolFactory::Create(1);
+
+    Recorder recorder;
+    PAL::Event entered, release;
+    auto handle = scheduleTask(pool.get(), 0, &recorder, &Recorder::Wait, &entered, &release);
+    ASSERT_TRUE(entered.wait(5000));
+    EXPECT_FALSE(handle.Cancel(10));
+    release.post();
+    EXPECT_TRUE(handle.Cancel(5000));
+}
+
+TEST(WorkerPoolTests, JoinRunsQueuedCallsAndDropsTimedCalls)
+{
+    auto pool = WorkerPoolFactory::Create(1);
+    auto queue = pool->CreateSerialQueue();
+
+    Recorder recorder;
+    auto handle = scheduleTask(queue.get(), 50, &recorder, &Recorder::Record, -1);
+    for (int i = 0; i < 5; i++)
+    {
+        dispatchTask(queue.get(), &recorder, &Recorder::Record, i);
+    }
+    queue->Join();
+    EXPECT_THAT(recorder.Values(), ElementsAre(0, 1, 2, 3, 4));
+    PAL::sleep(100);
+    EXPECT_THAT(recorder.Values(), SizeIs(5));
+}